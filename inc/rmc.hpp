@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * C++ (17 or later) interfaces of RMC for Linux user space, header-only on top
+ * of rmc_api.h and librmc.a.
+ *
+ * Fingerprint, Db and Blob own what they wrap and can only be moved. A query on
+ * a Db returns a BlobView referencing the mapped database without copying, which
+ * is valid as long as the Db lives. Errors in opening a database or getting a
+ * fingerprint are thrown as rmc::Error, a missing blob is an empty optional.
+ *
+ *     rmc::Db db("/lib/firmware/rmc.db");
+ *     auto fp = rmc::Fingerprint::board();
+ *
+ *     if (auto conf = db.query(fp, "audio.conf"))
+ *         use(conf->name, conf->data.as_string());
+ *
+ *     for (const rmc::BlobView &blob : db.blobs(fp))
+ *         list(blob.name, blob.data.size());
+ *
+ *     auto confs = db.query_all(fp, {"audio.conf", "bt.conf"});
+ */
+
+#ifndef INC_RMC_HPP_
+#define INC_RMC_HPP_
+
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
+
+#include <rmc_api.h>
+
+namespace rmc {
+
+class Error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/* read-only view of bytes, std::span<const std::byte> is not in C++17 */
+class Bytes {
+public:
+    constexpr Bytes() noexcept = default;
+    constexpr Bytes(const std::byte *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+    constexpr const std::byte *data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr const std::byte *begin() const noexcept { return data_; }
+    constexpr const std::byte *end() const noexcept { return data_ + size_; }
+    constexpr const std::byte &operator[](std::size_t i) const noexcept { return data_[i]; }
+
+    /* bytes as text, e.g. for a configuration file */
+    std::string_view as_string() const noexcept {
+        return std::string_view(reinterpret_cast<const char *>(data_), size_);
+    }
+
+#ifdef __cpp_lib_span
+    operator std::span<const std::byte>() const noexcept { return {data_, size_}; }
+#endif
+
+private:
+    const std::byte *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/* a blob in a mapped database */
+struct BlobView {
+    std::string_view name;
+    Bytes data;
+};
+
+/*
+ * Vector keeping up to N elements inline, it allocates (once per growth, not per
+ * element) only when there are more. T shall be default constructible and cheap
+ * to copy.
+ */
+template <typename T, std::size_t N>
+class SmallVector {
+    static_assert(N > 0, "SmallVector needs inline storage");
+
+public:
+    SmallVector() = default;
+    SmallVector(SmallVector &&) = default;
+    SmallVector &operator=(SmallVector &&) = default;
+
+    T *data() noexcept { return heap_ ? heap_.get() : inline_; }
+    const T *data() const noexcept { return heap_ ? heap_.get() : inline_; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    T *begin() noexcept { return data(); }
+    T *end() noexcept { return data() + size_; }
+    const T *begin() const noexcept { return data(); }
+    const T *end() const noexcept { return data() + size_; }
+    T &operator[](std::size_t i) noexcept { return data()[i]; }
+    const T &operator[](std::size_t i) const noexcept { return data()[i]; }
+
+    void reserve(std::size_t cap) {
+        if (cap <= cap_)
+            return;
+
+        std::unique_ptr<T[]> heap(new T[cap]);
+
+        for (std::size_t i = 0; i < size_; i++)
+            heap[i] = data()[i];
+
+        heap_ = std::move(heap);
+        cap_ = cap;
+    }
+
+    void push_back(const T &v) {
+        if (size_ == cap_)
+            reserve(cap_ * 2);
+
+        data()[size_++] = v;
+    }
+
+private:
+    T inline_[N] = {};
+    std::unique_ptr<T[]> heap_;
+    std::size_t size_ = 0;
+    std::size_t cap_ = N;
+};
+
+class Fingerprint {
+public:
+    /* fingerprint of the board we run on */
+    static Fingerprint board() {
+        Fingerprint fp;
+
+        if (rmc_get_fingerprint(&fp.fp_))
+            throw Error("rmc: cannot get fingerprint of board");
+
+        fp.valid_ = true;
+
+        return fp;
+    }
+
+    /* fingerprint of a board from a file generated by rmc -F */
+    static Fingerprint from_file(const std::string &pathname) {
+        Fingerprint fp;
+
+        if (read_fingerprint_from_file(pathname.c_str(), &fp.fp_, &fp.raw_))
+            throw Error("rmc: cannot read fingerprint file " + pathname);
+
+        fp.valid_ = true;
+
+        return fp;
+    }
+
+    Fingerprint(Fingerprint &&o) noexcept : fp_(o.fp_), raw_(o.raw_), valid_(o.valid_) {
+        o.raw_ = nullptr;
+        o.valid_ = false;
+    }
+
+    Fingerprint &operator=(Fingerprint &&o) noexcept {
+        if (this != &o) {
+            release();
+            fp_ = o.fp_;
+            raw_ = o.raw_;
+            valid_ = o.valid_;
+            o.raw_ = nullptr;
+            o.valid_ = false;
+        }
+
+        return *this;
+    }
+
+    Fingerprint(const Fingerprint &) = delete;
+    Fingerprint &operator=(const Fingerprint &) = delete;
+
+    ~Fingerprint() { release(); }
+
+    /* for C APIs, which never modify a fingerprint */
+    rmc_fingerprint_t *get() const noexcept { return const_cast<rmc_fingerprint_t *>(&fp_); }
+
+private:
+    Fingerprint() = default;
+
+    /* values of a fingerprint from a file are in its raw data */
+    void release() noexcept {
+        if (raw_)
+            std::free(raw_);
+        else if (valid_)
+            rmc_free_fingerprint(&fp_);
+
+        raw_ = nullptr;
+        valid_ = false;
+    }
+
+    rmc_fingerprint_t fp_ = {};
+    void *raw_ = nullptr;
+    bool valid_ = false;
+};
+
+/* a blob copied out of a database by C APIs, see query_file() */
+class Blob {
+public:
+    explicit Blob(rmc_file_t file) noexcept : file_(file) {}
+
+    Blob(Blob &&o) noexcept : file_(o.file_) { o.file_.blob = nullptr; }
+
+    Blob &operator=(Blob &&o) noexcept {
+        if (this != &o) {
+            rmc_free_file(&file_);
+            file_ = o.file_;
+            o.file_.blob = nullptr;
+        }
+
+        return *this;
+    }
+
+    Blob(const Blob &) = delete;
+    Blob &operator=(const Blob &) = delete;
+
+    ~Blob() { rmc_free_file(&file_); }
+
+    Bytes data() const noexcept {
+        return Bytes(reinterpret_cast<const std::byte *>(file_.blob), file_.blob_len);
+    }
+
+private:
+    rmc_file_t file_;
+};
+
+/* query a blob for a board in a database file and get a copy of it */
+inline std::optional<Blob> query_file(const Fingerprint &fp, const std::string &db_pathname,
+        const std::string &name) {
+    rmc_file_t file;
+
+    if (rmc_query_file_by_fp(fp.get(), const_cast<char *>(db_pathname.c_str()),
+            const_cast<char *>(name.c_str()), &file))
+        return std::nullopt;
+
+    return Blob(file);
+}
+
+/* a database file mapped and validated once, queries on it are not checked again */
+class Db {
+public:
+    explicit Db(const std::string &pathname) {
+        if (map_file(pathname.c_str(), &db_, &len_))
+            throw Error("rmc: cannot map database file " + pathname);
+
+        if (rmcl_open_db(db_, len_, &handle_)) {
+            unmap_file(db_, len_);
+            throw Error("rmc: invalid database file " + pathname);
+        }
+    }
+
+    Db(Db &&o) noexcept : db_(o.db_), len_(o.len_), handle_(o.handle_) {
+        o.db_ = nullptr;
+        o.len_ = 0;
+    }
+
+    Db &operator=(Db &&o) noexcept {
+        if (this != &o) {
+            unmap_file(db_, len_);
+            db_ = o.db_;
+            len_ = o.len_;
+            handle_ = o.handle_;
+            o.db_ = nullptr;
+            o.len_ = 0;
+        }
+
+        return *this;
+    }
+
+    Db(const Db &) = delete;
+    Db &operator=(const Db &) = delete;
+
+    ~Db() { unmap_file(db_, len_); }
+
+    /* blob with a name for a board, as rmc_query_file_by_fp() returns */
+    std::optional<BlobView> query(const Fingerprint &fp, const char *name) const noexcept {
+        rmc_file_t file;
+
+        if (query_policy_from_handle(fp.get(), &handle_, RMC_GENERIC_FILE,
+                const_cast<char *>(name), &file))
+            return std::nullopt;
+
+        return view(file);
+    }
+
+    std::optional<BlobView> query(const Fingerprint &fp, const std::string &name) const noexcept {
+        return query(fp, name.c_str());
+    }
+
+    /* blobs with names for a board, in order of names. Results of up to N names
+     * don't allocate memory.
+     */
+    template <std::size_t N = 8, typename Names>
+    SmallVector<std::optional<BlobView>, N> query_all(const Fingerprint &fp, const Names &names) const {
+        SmallVector<std::optional<BlobView>, N> results;
+
+        for (const auto &name : names)
+            results.push_back(query(fp, name));
+
+        return results;
+    }
+
+    template <std::size_t N = 8>
+    SmallVector<std::optional<BlobView>, N> query_all(const Fingerprint &fp,
+            std::initializer_list<const char *> names) const {
+        return query_all<N, std::initializer_list<const char *>>(fp, names);
+    }
+
+    class Blobs;
+
+    /* all blobs a board gets from the database, for range-for */
+    Blobs blobs(const Fingerprint &fp) const noexcept;
+
+    const rmc_db_handle_t &handle() const noexcept { return handle_; }
+
+private:
+    static BlobView view(const rmc_file_t &file) noexcept {
+        return BlobView{file.blob_name,
+            Bytes(reinterpret_cast<const std::byte *>(file.blob), file.blob_len)};
+    }
+
+    rmc_uint8_t *db_ = nullptr;
+    rmc_size_t len_ = 0;
+    rmc_db_handle_t handle_ = {};
+};
+
+/*
+ * Blobs of a board in all records matching it, from the most specific record.
+ * A blob overridden by one with the same name in a more specific record (or
+ * earlier in the same record) is skipped, so every name appears once with the
+ * blob a query returns. Nothing is allocated.
+ */
+class Db::Blobs {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = BlobView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const BlobView *;
+        using reference = const BlobView &;
+
+        iterator() noexcept = default;
+
+        reference operator*() const noexcept { return cur_; }
+        pointer operator->() const noexcept { return &cur_; }
+
+        iterator &operator++() noexcept {
+            advance();
+            return *this;
+        }
+
+        bool operator==(const iterator &o) const noexcept {
+            return db_ == o.db_ && (!db_ || (record_idx_ == o.record_idx_ &&
+                iter_.meta_idx == o.iter_.meta_idx));
+        }
+
+        bool operator!=(const iterator &o) const noexcept { return !(*this == o); }
+
+    private:
+        friend class Blobs;
+
+        iterator(const Db *db, const Fingerprint *fp) noexcept : db_(db), fp_(fp) {
+            if (query_record_from_db(fp_->get(), db_->db_, &record_idx_) ||
+                init_record_iter(db_->db_, record_idx_, &iter_))
+                db_ = nullptr;
+            else
+                advance();
+        }
+
+        void advance() noexcept {
+            rmc_file_t file;
+            rmc_file_t winner;
+
+            while (db_) {
+                if (next_policy_in_record(&iter_, &file)) {
+                    if (query_record_from_db(fp_->get(), db_->db_, &record_idx_) ||
+                        init_record_iter(db_->db_, record_idx_, &iter_))
+                        db_ = nullptr;
+                    continue;
+                }
+
+                /* match rules of pattern records are not blobs */
+                if (file.type != RMC_GENERIC_FILE)
+                    continue;
+
+                if (query_policy_from_handle(fp_->get(), &db_->handle_, RMC_GENERIC_FILE,
+                        file.blob_name, &winner) || winner.blob != file.blob)
+                    continue;
+
+                cur_ = view(file);
+                return;
+            }
+        }
+
+        const Db *db_ = nullptr;
+        const Fingerprint *fp_ = nullptr;
+        rmc_uint64_t record_idx_ = 0;
+        rmc_record_iter_t iter_ = {};
+        BlobView cur_;
+    };
+
+    iterator begin() const noexcept { return iterator(db_, fp_); }
+    iterator end() const noexcept { return iterator(); }
+
+private:
+    friend class Db;
+
+    Blobs(const Db *db, const Fingerprint *fp) noexcept : db_(db), fp_(fp) {}
+
+    const Db *db_;
+    const Fingerprint *fp_;
+};
+
+inline Db::Blobs Db::blobs(const Fingerprint &fp) const noexcept {
+    return Blobs(this, &fp);
+}
+
+} /* namespace rmc */
+
+#endif /* INC_RMC_HPP_ */
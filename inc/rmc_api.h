@@ -28,9 +28,17 @@
 #ifndef INC_RMC_API_H_
 #define INC_RMC_API_H_
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include <rmcl.h>
 #include <rsmp.h>
 
+#ifndef RMC_EFI
+#include <rmcd.h>
+#endif
+
 /*
  * Introduction: RMC APIs
  *
@@ -64,7 +72,8 @@
 
 /* 1.1 - Single-action APIs */
 
-/* get board's RMC fingerprint
+/* get board's RMC fingerprint, from the handoff of bootloader when there is one (see
+ * read_fingerprint_from_handoff()) or SMBIOS
  * (out) fp: fingerprint data to be filled. Allocated internal data in
  *           the returned fp can be freed with rmc_free_fingerprint()
  *           if the call successes (ret = 0)
@@ -73,6 +82,14 @@
  */
 extern int rmc_get_fingerprint(rmc_fingerprint_t *fp);
 
+/* get board's RMC fingerprint without allocating any memory
+ * (out) buf: fingerprint data to be filled, use buf->fp in queries. Nothing needs to
+ *            be freed.
+ * return: 0 for success, non-zero for failures (including a finger value longer than
+ *         RMC_FINGER_VALUE_LEN - 1).
+ */
+extern int rmc_get_fingerprint_buf(rmc_fingerprint_buf_t *buf);
+
 /* query a file in a RMC database file associated to a provided fingerprint
  * (in) fp: fingerprint generated by rmc_get_fingerprint() for the running board
  * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
@@ -84,6 +101,57 @@ extern int rmc_get_fingerprint(rmc_fingerprint_t *fp);
  */
 extern int rmc_query_file_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *file_name, rmc_file_t *file);
 
+/* query a file in a RMC database file associated to a provided fingerprint and get it as
+ * a sealed memfd, which can be passed to other processes or kernel interfaces without a
+ * temporary file. Blob is copied from database file in kernel when possible.
+ * (in) fp: fingerprint generated by rmc_get_fingerprint() for the running board
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (out) fd: sealed memfd holding content of the file, caller is responsible to close it
+ * (out) len: length of the file
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_fd_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *file_name, int *fd, rmc_size_t *len);
+
+/* query a file in a RMC database file associated to a provided fingerprint and write it
+ * to a file descriptor, e.g. a regular file, a pipe or stdout. Blob is copied from database
+ * file in kernel when possible and never buffered in user space then.
+ * (in) fp: fingerprint generated by rmc_get_fingerprint() for the running board
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (in) fd: file descriptor opened for writing. Blob is written at its current position
+ * (out) len: length of the file
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_write_file_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *file_name, int fd, rmc_size_t *len);
+
+/* query a file in a RMC database file associated to a provided fingerprint and copy it
+ * into a buffer provided by caller. Database file is mapped and no memory is allocated.
+ * (in) fp: fingerprint generated by rmc_get_fingerprint() or rmc_get_fingerprint_buf()
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (out) buf: buffer to hold content of the file
+ * (in) buf_len: size of buffer, could be 0 (buf can be NULL then) to get size of file
+ * (out) len: length of the file, or 0 when file is not found
+ * return: 0 for success, non-zero for failures. When buffer is too small, nothing is
+ *         copied, non-zero is returned and len is the size required.
+ */
+extern int rmc_query_file_to_buffer(rmc_fingerprint_t *fp, char *db_pathname, char *file_name,
+        void *buf, rmc_size_t buf_len, rmc_size_t *len);
+
+/* query all files with names matching a glob pattern in a RMC database file associated
+ * to a provided fingerprint. '*' in pattern matches any string and '?' matches any single
+ * character, e.g. "audio*" for all files with names starting with "audio". Queries are
+ * served by a range scan of name IDs when database has RMC_SECTION_NAMES (version 2).
+ * (in) fp: fingerprint generated by rmc_get_fingerprint() for the running board
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) pattern: The pattern of names of file blobs to be queried in the database
+ * (out) files: A list of matched files linked by next. Caller is responsible to free the
+ *              list by calling rmc_free_file_list()
+ * return: 0 for success, non-zero for failures or no file matched.
+ */
+extern int rmc_query_files_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *pattern, rmc_file_t **files);
+
 /* 1.2 - Double-action API */
 
 /* query a file in a RMC database file associated to the board we run on
@@ -96,6 +164,24 @@ extern int rmc_query_file_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *
  */
 extern int rmc_gimme_file(char* db_pathname, char *file_name, rmc_file_t *file);
 
+/* query a file in a RMC database file associated to the board we run on and get it as a
+ * sealed memfd, see rmc_query_fd_by_fp()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_gimme_fd(char *db_pathname, char *file_name, int *fd, rmc_size_t *len);
+
+/* query a file in a RMC database file associated to the board we run on and copy it into
+ * a buffer provided by caller, without allocating any memory. See rmc_query_file_to_buffer()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_gimme_file_to_buffer(char *db_pathname, char *file_name, void *buf, rmc_size_t buf_len, rmc_size_t *len);
+
+/* query all files with names matching a pattern in a RMC database file associated to the
+ * board we run on, see rmc_query_files_by_fp()
+ * return: 0 for success, non-zero for failures or no file matched.
+ */
+extern int rmc_gimme_files(char *db_pathname, char *pattern, rmc_file_t **files);
+
 /* 1.3 - Helper APIs */
 
 /* Free allocated data referred in a fingerprint
@@ -110,6 +196,12 @@ extern void rmc_free_fingerprint(rmc_fingerprint_t *fp);
  */
 extern void rmc_free_file(rmc_file_t *fp);
 
+/* Free a list of RMC files returned by rmc_query_files_by_fp() or rmc_gimme_files(),
+ * including structures of files.
+ * (in) files: head of list
+ */
+extern void rmc_free_file_list(rmc_file_t *files);
+
 /*
  * utility function to read a file into mem. This function allocates memory
  * (in)  pathname   : file pathname to read
@@ -131,6 +223,88 @@ extern int read_file(const char *pathname, char **data, rmc_size_t* len);
  */
 int write_file(const char *pathname, void *data, rmc_size_t len, int append);
 
+/*
+ * utility function to map a file read-only into mem. Data is not copied.
+ * (in)  pathname   : file pathname to map
+ * (out) data       : address of pointer that points to the mapped data
+ * (out) len        : pointer of total number of bytes mapped
+ *
+ * return           : 0 for success, non-zero for failures. Caller shall release
+ *                    the mapping with unmap_file()
+ */
+extern int map_file(const char *pathname, rmc_uint8_t **data, rmc_size_t *len);
+
+/*
+ * release a mapping returned by map_file()
+ * (in) data       : mapped data
+ * (in) len        : number of bytes mapped
+ */
+extern void unmap_file(rmc_uint8_t *data, rmc_size_t len);
+
+/*
+ * utility function to copy data into a sealed memfd which can be passed
+ * to other processes. Content cannot be modified, shrunk or grown after it
+ * is returned.
+ * (in) name       : name of memfd, only for debug purposes
+ * (in) data       : pointer of data buffer
+ * (in) len        : total number of bytes to write
+ *
+ * return          : file descriptor of memfd, or -1 for failures
+ */
+extern int write_memfd(const char *name, void *data, rmc_size_t len);
+
+/*
+ * utility function like write_memfd(), but data is copied from a file in
+ * kernel when possible (copy_file_range() or sendfile()), and from the data
+ * buffer in user space otherwise.
+ * (in) name       : name of memfd, only for debug purposes
+ * (in) src_fd     : file descriptor of file holding data
+ * (in) offset     : offset of data in file
+ * (in) data       : the same data in memory, e.g. a mapping of the file
+ * (in) len        : total number of bytes to copy
+ *
+ * return          : file descriptor of memfd, or -1 for failures
+ */
+extern int copy_memfd(const char *name, int src_fd, rmc_uint64_t offset, void *data, rmc_size_t len);
+
+/*
+ * utility function to copy data from a file to another file descriptor, in
+ * kernel when possible (copy_file_range() or sendfile()), and from the data
+ * buffer in user space otherwise.
+ * (in) dst_fd     : file descriptor to write data at its current position
+ * (in) src_fd     : file descriptor of file holding data
+ * (in) offset     : offset of data in file
+ * (in) data       : the same data in memory, e.g. a mapping of the file
+ * (in) len        : total number of bytes to copy
+ *
+ * return          : 0 for success, non-zero for failures
+ */
+extern int copy_fd(int dst_fd, int src_fd, rmc_uint64_t offset, void *data, rmc_size_t len);
+
+/*
+ * read fingerprint from a file generated by rmc tool (rmc -F)
+ * (in) pathname        : path and name of file to read
+ * (out) fp             : pointer of fingerprint structure to hold read fingerprint
+ * (out) raw            : pointer of a pointer which points to raw file blob allocated.
+ *                        caller shall use it to free mem. It is NULL for failures.
+ *                        Values in fp reference this blob, do NOT call
+ *                        rmc_free_fingerprint() on fp.
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+extern int read_fingerprint_from_file(const char* pathname, rmc_fingerprint_t *fp, void **raw);
+
+/*
+ * read fingerprint handed off by bootloader in a volatile EFI variable, see rmc_handoff_t
+ * in rmcl.h. rmc_get_fingerprint() and rmc_get_fingerprint_buf() take it before SMBIOS
+ * when it is intact and consistent.
+ * (in) pathname        : path of variable in efivarfs, or NULL for the default one
+ * (out) fp             : fingerprint, values can be freed with rmc_free_fingerprint()
+ *
+ * return: 0 for success, non-zero when there is no handoff or it can't be trusted.
+ */
+extern int read_fingerprint_from_handoff(const char *pathname, rmc_fingerprint_t *fp);
+
 /* extract the contents of a database file and store the files corresponding to
  * each record in a separate directory. The name of each directory is the signature
  * of the fingerpring for that record with all non-alphanumeric characters stripped
@@ -140,6 +314,407 @@ int write_file(const char *pathname, void *data, rmc_size_t len, int append);
  */
 int dump_db(char *db_pathname, char *output_path) ;
 
+/* 1.4 - rmcd client APIs
+ *
+ * rmcd fingerprints the board and indexes a database once, then serves queries
+ * over a UNIX socket. These APIs ask rmcd first, and fall back to querying the
+ * database file directly when rmcd is not running or serves another database.
+ */
+
+/* query a file blob as a sealed memfd
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (out) fd: sealed memfd holding the blob, with a file offset of its own (not shared
+ *          with other clients of rmcd). Caller shall close it.
+ * (out) len: length of the blob
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmcd_query_fd(char *db_pathname, char *file_name, int *fd, rmc_size_t *len);
+
+/* query a file blob associated to the board we run on
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (out) file: Holds the content mapped from the returned memfd. Caller is responsible
+ *             to release it by calling rmcd_free_file(), NOT rmc_free_file()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmcd_gimme_file(char *db_pathname, char *file_name, rmc_file_t *file);
+
+/* Release data referenced in a RMC file structure returned by rmcd_gimme_file()
+ * (in) file: RMC file structure
+ */
+extern void rmcd_free_file(rmc_file_t *file);
+
+/* get counters of running rmcd
+ * (out) stats: counters
+ * return: 0 for success, non-zero when rmcd is not reachable.
+ */
+extern int rmcd_get_stats(rmcd_stats_t *stats);
+
+/* 1.5 - Database overlay APIs
+ *
+ * An overlay is an ordered stack of database files, from the bottom (e.g. a base
+ * database in rootfs) to the top (e.g. OEM or field-fix databases). A blob in a
+ * higher layer overrides a blob with the same name for the same board in lower
+ * layers. Blobs of the board in all layers are indexed once when an overlay is
+ * opened.
+ */
+
+/* an indexed blob in overlay */
+typedef struct rmc_overlay_entry {
+    char *name;                     /* name of blob, in mapped database */
+    rmc_uint8_t *blob;              /* blob, in mapped database */
+    rmc_size_t blob_len;
+    int layer;                      /* index of database providing this blob */
+} rmc_overlay_entry_t;
+
+typedef struct rmc_overlay {
+    int db_num;
+    rmc_uint8_t **dbs;              /* mapped databases, from bottom to top */
+    rmc_size_t *db_lens;
+    int *db_fds;                    /* open database files the mappings are made from */
+    rmc_overlay_entry_t *entries;   /* merged index of board's blobs, sorted by name */
+    rmc_size_t entry_num;
+} rmc_overlay_t;
+
+/* map database files and index blobs of a board
+ * (in) fp: fingerprint of board
+ * (in) db_pathnames: pathnames of database files, from bottom to top
+ * (in) db_num: number of database files
+ * (out) overlay: overlay structure provided by caller. Release it with rmc_close_overlay()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_open_overlay(rmc_fingerprint_t *fp, char **db_pathnames, int db_num, rmc_overlay_t *overlay);
+
+/* look up a blob in overlay
+ * (in) overlay: overlay opened by rmc_open_overlay()
+ * (in) file_name: The name of a file blob
+ * return: indexed blob, or NULL if board doesn't have such blob in any layer
+ */
+extern rmc_overlay_entry_t *rmc_lookup_overlay(rmc_overlay_t *overlay, char *file_name);
+
+/* query a file blob in overlay
+ * (in) overlay: overlay opened by rmc_open_overlay()
+ * (in) file_name: The name of a file blob to be queried
+ * (out) file: Holds the blob which references mapped database. It is valid until
+ *             overlay is closed. Do NOT call rmc_free_file() on it.
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_overlay(rmc_overlay_t *overlay, char *file_name, rmc_file_t *file);
+
+/* unmap and close databases and release index of overlay
+ * Note: It does NOT free memory of overlay structure itself
+ */
+extern void rmc_close_overlay(rmc_overlay_t *overlay);
+
+/* query a file in a stack of RMC database files associated to a provided fingerprint
+ * (in) fp: fingerprint of board
+ * (in) db_pathnames: pathnames of database files, from bottom to top
+ * (in) db_num: number of database files
+ * (in) file_name: The name of a file blob to be queried
+ * (out) file: same as rmc_query_file_by_fp(). Free it by calling rmc_free_file()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_fp_overlay(rmc_fingerprint_t *fp, char **db_pathnames, int db_num, char *file_name, rmc_file_t *file);
+
+/* query a file in a stack of RMC database files associated to a provided fingerprint and
+ * write it to a file descriptor, see rmc_write_file_by_fp()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_write_file_by_fp_overlay(rmc_fingerprint_t *fp, char **db_pathnames, int db_num, char *file_name, int fd, rmc_size_t *len);
+
+/* 1.6 - Shared database APIs
+ *
+ * A shared database is a handle which many threads can query at the same time
+ * without locks. The handle watches its database files and reloads them when
+ * they are changed. A new version is validated before it is published, and
+ * threads still using the old version keep it until they release it.
+ *
+ * Database files should be updated by renaming a new file over the old one.
+ * Writing a mapped file in place can crash readers.
+ *
+ * Link with -pthread.
+ */
+
+/* maximum number of threads which can use shared databases at the same time */
+#define RMC_SHARED_MAX_READERS 256
+
+typedef struct rmc_shared_db rmc_shared_db_t;
+
+/* open a shared database
+ * (in) fp: fingerprint of board, copied into handle
+ * (in) db_pathnames: pathnames of database files, from bottom to top (see overlay APIs)
+ * (in) db_num: number of database files
+ * return: handle, or NULL for failures. Release it with rmc_close_shared_db()
+ */
+extern rmc_shared_db_t *rmc_open_shared_db(rmc_fingerprint_t *fp, char **db_pathnames, int db_num);
+
+/* get the current version of a shared database for calling thread
+ * A thread can hold only one version of a handle at a time, and must release it
+ * with rmc_release_shared_db(). Don't block in between, reloading waits for it.
+ * (in) db: handle
+ * return: overlay of the current version, or NULL for failures. Data returned by
+ *         overlay APIs are valid until the version is released.
+ */
+extern rmc_overlay_t *rmc_acquire_shared_db(rmc_shared_db_t *db);
+
+/* release a version got by rmc_acquire_shared_db() in calling thread */
+extern void rmc_release_shared_db(rmc_shared_db_t *db);
+
+/* query a file blob in a shared database
+ * (in) db: handle
+ * (in) file_name: The name of a file blob to be queried
+ * (out) file: same as rmc_query_file_by_fp(). Free it by calling rmc_free_file()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_shared(rmc_shared_db_t *db, char *file_name, rmc_file_t *file);
+
+/* get generation of the current version, which starts from 0 and increases by
+ * 1 every time database files are reloaded
+ */
+extern rmc_uint64_t rmc_get_shared_db_generation(rmc_shared_db_t *db);
+
+/* stop watching and release a shared database. No thread shall use it after. */
+extern void rmc_close_shared_db(rmc_shared_db_t *db);
+
+/* 1.7 - Database verification APIs
+ *
+ * Verify a database file before deploying it. Layout is checked with bounds, CRCs
+ * of database and records are checked, and every blob is hashed with SHA-256 in
+ * parallel and compared with its digest stored in database (version 2), and with
+ * its source file when provided.
+ *
+ * Link with -pthread.
+ */
+
+#define RMC_VERIFY_OK               0
+#define RMC_VERIFY_CORRUPTED        1   /* CRC or digest doesn't match data */
+#define RMC_VERIFY_NO_DIGEST        2   /* no digest in database, blob is not verified */
+#define RMC_VERIFY_SOURCE_MISMATCH  3   /* blob is intact but different from its source */
+
+typedef struct rmc_verify_entry {
+    rmc_uint64_t record_idx;    /* offset of record holding blob in database */
+    char *name;                 /* name of blob, referencing database mapping */
+    rmc_uint8_t *blob;          /* blob, referencing database mapping */
+    rmc_size_t blob_len;
+    int status;                 /* RMC_VERIFY_*, by digest and source of blob */
+    int record_status;          /* RMC_VERIFY_OK or RMC_VERIFY_CORRUPTED by CRC of record */
+} rmc_verify_entry_t;
+
+typedef struct rmc_verify_report {
+    int db_status;                  /* RMC_VERIFY_OK or RMC_VERIFY_CORRUPTED for database */
+    rmc_uint64_t entry_num;         /* number of blobs in database */
+    rmc_verify_entry_t *entries;    /* each blob in the order of database */
+    rmc_uint64_t bad_num;           /* number of blobs corrupted or mismatched */
+    rmc_uint64_t unverified_num;    /* number of blobs without digest */
+    rmc_uint64_t bad_record_num;    /* number of records failing CRC */
+    rmc_uint8_t *db;                /* mapping of database file */
+    rmc_size_t db_len;
+} rmc_verify_report_t;
+
+/* verify a database file
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) sources: optional list of source files, a blob is compared with the source file
+ *               having the same name. NULL to skip.
+ * (in) thread_num: number of threads hashing blobs, 0 for number of online CPUs
+ * (out) report: result of verification. Release it with rmc_free_verify_report().
+ *               When layout of database is broken, db_status is RMC_VERIFY_CORRUPTED
+ *               and there is no entry.
+ * return: 0 when verification is done (check report for result), non-zero for failures.
+ */
+extern int rmc_verify_db(char *db_pathname, rmc_file_t *sources, int thread_num, rmc_verify_report_t *report);
+
+/* release data of a report from rmc_verify_db(), NOT the report structure itself */
+extern void rmc_free_verify_report(rmc_verify_report_t *report);
+
+/* 1.8 - Batch query APIs
+ *
+ * Query blobs for many boards from a database file offline, e.g. on a build
+ * server producing images for different boards. Boards are given with their
+ * fingerprints instead of fingerprinting the running machine. Database is mapped
+ * and validated once, and boards are queried in parallel.
+ *
+ * Link with -pthread.
+ */
+
+typedef struct rmc_batch_report {
+    int board_num;
+    int name_num;
+    rmc_file_t *results;    /* result of board b and name n at [b * name_num + n], blob is
+                             * NULL when board doesn't have the blob, otherwise blob and
+                             * blob_name reference database mapping.
+                             */
+    rmc_uint64_t missing_num;   /* number of results without blob */
+    rmc_uint8_t *db;            /* mapping of database file */
+    rmc_size_t db_len;
+} rmc_batch_report_t;
+
+/* query blobs with names for boards with fingerprints
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) fps: fingerprints of boards
+ * (in) board_num: number of fingerprints
+ * (in) names: names of blobs to query for each board
+ * (in) name_num: number of names
+ * (in) thread_num: number of threads querying boards, 0 for number of online CPUs
+ * (out) report: results of all boards and names. Release it with rmc_free_batch_report().
+ * return: 0 when database is queried (check report for missing blobs), non-zero for failures.
+ */
+extern int rmc_batch_query(char *db_pathname, rmc_fingerprint_t *fps, int board_num,
+        char **names, int name_num, int thread_num, rmc_batch_report_t *report);
+
+/* release data of a report from rmc_batch_query(), NOT the report structure itself */
+extern void rmc_free_batch_report(rmc_batch_report_t *report);
+
+/* 1.9 - Database merge and reorder APIs
+ *
+ * Merge database files from different sources into one. Records of the same board
+ * (same signature, and same fingers for pattern records) are merged into a single
+ * record, and blobs with the same name in them are resolved with a policy. Identical
+ * blobs are stored once. Input files are mapped and merged records are streamed into
+ * output file without intermediate files.
+ *
+ * Records of a database file can be reordered by population of boards, so that readers
+ * scanning records (version 1) find common boards first.
+ */
+
+#define RMC_MERGE_LAST      0   /* blob in a later database wins, same as overlay */
+#define RMC_MERGE_FIRST     1   /* blob in an earlier database wins */
+#define RMC_MERGE_ERROR     2   /* fail when blobs with the same name are different */
+
+/* merge database files into a new database file
+ * (in) db_pathnames: database files to merge, boards in output are in the order they
+ *                    first appear in files
+ * (in) db_num: number of database files
+ * (in) policy: RMC_MERGE_* to resolve blobs with the same name for a board
+ * (in) version: version of output database, RMC_DB_VERSION_1 or RMC_DB_VERSION_2
+ * (in) output_pathname: output database file, must not be any of input files
+ * return: 0 for success, non-zero for failures. No output file is left for failures.
+ */
+extern int rmc_merge_db(char **db_pathnames, int db_num, int policy, int version, char *output_pathname);
+
+/* reorder records of a database file by population of boards, records matching more
+ * boards in population come first. Records of the same board keep their order, so
+ * results of queries don't change. Format and version of database are not changed,
+ * extensions of a version 2 database are rebuilt for new offsets.
+ * (in) db_pathname: database file to reorder, must not have pattern records
+ * (in) fps: fingerprints of boards in population, boards without record are ignored
+ * (in) counts: number of machines of each board in population
+ * (in) board_num: number of fingerprints
+ * (in) output_pathname: output database file, must not be input file
+ * return: 0 for success, non-zero for failures. No output file is left for failures.
+ */
+extern int rmc_reorder_db(char *db_pathname, rmc_fingerprint_t *fps, rmc_uint64_t *counts, int board_num,
+        char *output_pathname);
+
+/* 1.10 - Static database APIs
+ *
+ * A database file can be compiled into C source and header (rmc -C), to be linked into
+ * a program like a bootloader. Blobs are located with a perfect hash table computed at
+ * compile time, no file is read at run time. Databases with pattern records cannot be
+ * compiled.
+ */
+
+/* compile a database file into C source and header defining a rmc_static_db_t
+ * (in) db_pathname: database file
+ * (in) output_prefix: pathname of output without suffix, ".c" and ".h" are appended.
+ *                     Static database is named after its base name, with characters
+ *                     not allowed in C identifiers replaced by '_'.
+ * return: 0 for success, non-zero for failures. No output file is left for failures.
+ */
+extern int rmc_compile_db(char *db_pathname, char *output_prefix);
+
+/* query a file in a static database associated to a provided fingerprint
+ * (in) fp: fingerprint of board
+ * (in) db: static database defined in source generated by rmc_compile_db()
+ * (in) file_name: The name of a file blob to be queried
+ * (out) file: Holds the blob which references data of static database, do NOT call
+ *             rmc_free_file() on it.
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_static_db(rmc_fingerprint_t *fp, const rmc_static_db_t *db, char *file_name, rmc_file_t *file);
+
+/* 1.11 - Board and name ID APIs
+ *
+ * A version 2 database numbers its boards and blob names with dense IDs from 0, see
+ * RMC_SECTION_BOARD and RMC_SECTION_NAMES in rmcl.h. A client resolves the board and
+ * names once and indexes its own arrays with IDs, and queries files by IDs without
+ * fingerprint or name compares. Blobs of pattern records are not queried by board ID,
+ * and a board matching only pattern records has no ID.
+ */
+
+/* resolve a board to its ID in a RMC database file
+ * (in) fp: fingerprint of board
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (out) board_id: ID of board, from 0 to board_num - 1
+ * (out) board_num: number of boards in database, could be NULL
+ * return: 0 for success, non-zero for failures or when board has no ID.
+ */
+extern int rmc_get_board_id(rmc_fingerprint_t *fp, char *db_pathname, rmc_uint32_t *board_id, rmc_uint32_t *board_num);
+
+/* query a file in a RMC database file associated to a board ID from rmc_get_board_id()
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) board_id: ID of board in the same database file
+ * (in) file_name: The name of a file blob to be queried
+ * (out) file: Holds the content of successfully retrieved from the database.
+ *             Caller shall call rmc_free_file() on it.
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_board_id(char *db_pathname, rmc_uint32_t board_id, char *file_name, rmc_file_t *file);
+
+/* resolve a blob name to its ID in a RMC database file
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) file_name: The name of a file blob
+ * (out) name_id: ID of name, from 0 to name_num - 1
+ * (out) name_num: number of names in database, could be NULL
+ * return: 0 for success, non-zero for failures or when no blob has the name.
+ */
+extern int rmc_get_name_id(char *db_pathname, char *file_name, rmc_uint32_t *name_id, rmc_uint32_t *name_num);
+
+/* query a file in a RMC database file by IDs of board and name
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) board_id: ID from rmc_get_board_id() on the same database file
+ * (in) name_id: ID from rmc_get_name_id() on the same database file
+ * (out) file: Holds the content of successfully retrieved from the database.
+ *             Caller shall call rmc_free_file() on it.
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_ids(char *db_pathname, rmc_uint32_t board_id, rmc_uint32_t name_id, rmc_file_t *file);
+
+/* 1.12 - Inverse query APIs
+ *
+ * Find all records carrying a blob name, e.g. for rollout planning of a config file.
+ * A version 2 database has a posting list of records for each name (see
+ * RMC_SECTION_POSTINGS in rmcl.h) and only records in it are read. Records of a
+ * version 1 database are scanned.
+ */
+
+/* a record carrying the blob */
+typedef struct rmc_carrier {
+    rmc_uint64_t record_idx;        /* offset of record in database */
+    rmc_signature_t signature;      /* signature of record */
+    int pattern;                    /* non-zero for a pattern record matching a family of boards */
+    rmc_uint8_t *blob;              /* blob of record, referencing database mapping */
+    rmc_size_t blob_len;
+} rmc_carrier_t;
+
+typedef struct rmc_carrier_report {
+    rmc_uint64_t carrier_num;
+    rmc_carrier_t *carriers;        /* in the order of records */
+    rmc_uint8_t *db;                /* mapping of database file */
+    rmc_size_t db_len;
+} rmc_carrier_report_t;
+
+/* find records carrying a file blob
+ * (in) db_pathname: The path and file name of a RMC database file generated by RMC tool
+ * (in) file_name: The name of a file blob
+ * (out) report: records having the blob, could be none. Release it with rmc_free_carrier_report().
+ * return: 0 when database is queried, non-zero for failures.
+ */
+extern int rmc_query_carriers(char *db_pathname, char *file_name, rmc_carrier_report_t *report);
+
+/* release data of a report from rmc_query_carriers(), NOT the report structure itself */
+extern void rmc_free_carrier_report(rmc_carrier_report_t *report);
+
 #else
 /* 2 - API for UEFI context */
 
@@ -173,6 +748,109 @@ extern int rmc_get_fingerprint(void *sys_table, rmc_fingerprint_t *fp);
  */
 extern int rmc_query_file_by_fp(rmc_fingerprint_t *fp, unsigned char *db_blob, char *file_name, rmc_file_t *file);
 
+/* query a file in a database validated once by rmc_open_db(), on a fast path without
+ * any check. Use it for more than one query on a database.
+ * (in) handle: handle from rmc_open_db()
+ * Other parameters and return value are same as rmc_query_file_by_fp().
+ */
+extern int rmc_query_file_by_handle(rmc_fingerprint_t *fp, const rmc_db_handle_t *handle, char *file_name, rmc_file_t *file);
+
+/* query a file in a database not validated, every access is checked against len. Use
+ * it for a single query on a database read by caller.
+ * (in) len: number of bytes in db_blob
+ * Other parameters and return value are same as rmc_query_file_by_fp().
+ */
+extern int rmc_query_file_by_buffer(rmc_fingerprint_t *fp, unsigned char *db_blob, rmc_size_t len, char *file_name, rmc_file_t *file);
+
+/* query a file in a database compiled into program as C source by rmc -C, without any
+ * file to read
+ * (in) db: static database defined in generated source
+ * Other parameters and return value are same as rmc_query_file_by_fp().
+ */
+extern int rmc_query_file_by_static_db(rmc_fingerprint_t *fp, const rmc_static_db_t *db, char *file_name, rmc_file_t *file);
+
+/* prepare a context to query files for a board in a RMC database, signature and records
+ * matching the board are located once
+ * (in) fp: fingerprint from rmc_get_fingerprint(), referenced by ctx
+ * (in) db_blob: memory chunk of raw data of whole database provided by callers. It must
+ *               not be modified or freed while ctx is used.
+ * (out) ctx: context provided by caller, see rmc_query_ctx_t in rmcl.h
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_init_query_ctx_by_fp(rmc_fingerprint_t *fp, unsigned char *db_blob, rmc_query_ctx_t *ctx);
+
+/* query a file with a context prepared by rmc_init_query_ctx_by_fp() or rmc_init_query_ctx().
+ * Only metas of records matching the board are walked, use it for more than one query.
+ * (in) ctx: context of board and database
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (out) file: Holds the content of successfully retrieved from the database.
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_ctx(rmc_query_ctx_t *ctx, char *file_name, rmc_file_t *file);
+
+/* query a file in a database not read into memory, e.g. a file on disk, and copy it into a
+ * buffer provided by caller. Only headers and the file are read with read_at, instead of
+ * the whole database.
+ * (in) fp: fingerprint from rmc_get_fingerprint()
+ * (in) read_at: callback to read bytes at an offset of database, see rmc_read_at_t in rmcl.h
+ * (in) ctx: passed to read_at, e.g. a file handle
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (out) buf: buffer to hold content of the file
+ * (in) buf_len: size of buffer, could be 0 (buf can be NULL then) to get size of file
+ * (out) len: length of the file, or 0 when file is not found
+ *
+ * return: 0 for success, non-zero for failures. When buffer is too small, nothing is
+ *         copied, non-zero is returned and len is the size required.
+ */
+extern int rmc_query_file_by_read_at(rmc_fingerprint_t *fp, rmc_read_at_t read_at, void *ctx, char *file_name,
+        void *buf, rmc_size_t buf_len, rmc_size_t *len);
+
+/* resolve a board to its dense ID in a version 2 database, see RMC_SECTION_BOARD in rmcl.h.
+ * Caller could index its own arrays with the ID.
+ * (in) fp: fingerprint from rmc_get_fingerprint()
+ * (in) db_blob: memory chunk of raw data of whole database provided by callers.
+ * (out) board_id: ID of board, from 0 to board_num - 1
+ * (out) board_num: number of boards in database, could be NULL
+ *
+ * return: 0 for success, non-zero for failures or when board has no ID.
+ */
+extern int rmc_get_board_id(rmc_fingerprint_t *fp, unsigned char *db_blob, rmc_uint32_t *board_id, rmc_uint32_t *board_num);
+
+/* query a file for a board ID from rmc_get_board_id(). Records of board are located by
+ * index, no fingerprint is processed. Blobs of pattern records are not included.
+ * (in) db_blob: memory chunk of raw data of whole database provided by callers.
+ * (in) board_id: ID of board in the same database
+ * (in) file_name: The name of a file blob to be queried in the database
+ * (out) file: Holds the content of successfully retrieved from the database.
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_board_id(unsigned char *db_blob, rmc_uint32_t board_id, char *file_name, rmc_file_t *file);
+
+/* resolve a blob name to its dense ID in a version 2 database, see RMC_SECTION_NAMES in
+ * rmcl.h. Caller could index its own arrays with the ID.
+ * (in) db_blob: memory chunk of raw data of whole database provided by callers.
+ * (in) file_name: The name of a file blob
+ * (out) name_id: ID of name, from 0 to name_num - 1
+ * (out) name_num: number of names in database, could be NULL
+ *
+ * return: 0 for success, non-zero for failures or when no blob has the name.
+ */
+extern int rmc_get_name_id(unsigned char *db_blob, char *file_name, rmc_uint32_t *name_id, rmc_uint32_t *name_num);
+
+/* query a file by IDs from rmc_get_board_id() and rmc_get_name_id(), with integer
+ * compares only
+ * (in) db_blob: memory chunk of raw data of whole database provided by callers.
+ * (in) board_id: ID of board in the same database
+ * (in) name_id: ID of name in the same database
+ * (out) file: Holds the content of successfully retrieved from the database.
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_query_file_by_ids(unsigned char *db_blob, rmc_uint32_t board_id, rmc_uint32_t name_id, rmc_file_t *file);
+
 /* 2.2 Double-action APIs */
 
 /* query a file in a RMC database file associated to the board we run on
@@ -185,5 +863,63 @@ extern int rmc_query_file_by_fp(rmc_fingerprint_t *fp, unsigned char *db_blob, c
  */
 extern int rmc_gimme_file(void *sys_table, unsigned char *db_blob, char *file_name, rmc_file_t *file);
 
+/* query a file in a database compiled into program by rmc -C associated to the board we
+ * run on, see rmc_query_file_by_static_db()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_gimme_static_file(void *sys_table, const rmc_static_db_t *db, char *file_name, rmc_file_t *file);
+
+/* prepare a context to query files for the board we run on in a RMC database, see
+ * rmc_init_query_ctx_by_fp(). SMBIOS is parsed once here instead of in every query.
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_init_query_ctx(void *sys_table, unsigned char *db_blob, rmc_query_ctx_t *ctx);
+
+/* query a file in a database read with read_at associated to the board we run on and copy
+ * it into a buffer provided by caller, see rmc_query_file_by_read_at()
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_gimme_file_by_read_at(void *sys_table, rmc_read_at_t read_at, void *ctx, char *file_name,
+        void *buf, rmc_size_t buf_len, rmc_size_t *len);
+
+/* 2.3 Helper APIs */
+
+/* fill a handoff of board's fingerprint for OS, so that user space doesn't parse SMBIOS
+ * again. Bootloader shall store it with its UEFI implementation, e.g. SetVariable(), as a
+ * variable named RMC_HANDOFF_NAME with vendor GUID RMC_HANDOFF_GUID and attributes
+ * EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS, NOT non-volatile.
+ * (in) fp: fingerprint from rmc_get_fingerprint()
+ * (out) handoff: handoff provided by caller, store all sizeof(rmc_handoff_t) bytes
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+extern int rmc_get_handoff(rmc_fingerprint_t *fp, rmc_handoff_t *handoff);
+
+/* check a database read by caller before querying it. Other APIs trust the database,
+ * a torn or corrupted file could lead them to read beyond the end of db_blob.
+ * Bounds of all records and extensions are checked, and CRC of the whole database is
+ * checked when it is generated with CRC (version 2).
+ * (in) db_blob: memory chunk of raw data of whole database provided by callers.
+ * (in) len: number of bytes in db_blob
+ *
+ * return: 0 when database is good, non-zero otherwise.
+ */
+extern int rmc_check_db(unsigned char *db_blob, rmc_size_t len);
+
+/* check a database read by caller once, the same as rmc_check_db(), and get a handle
+ * to query it with rmc_query_file_by_handle() without checking it again.
+ * (in) db_blob: memory chunk of raw data of whole database provided by callers. It must
+ *               not be modified or freed while handle is used.
+ * (in) len: number of bytes in db_blob
+ * (out) handle: handle of database, referencing db_blob
+ *
+ * return: 0 when database is good, non-zero otherwise.
+ */
+extern int rmc_open_db(unsigned char *db_blob, rmc_size_t len, rmc_db_handle_t *handle);
+
+#endif
+
+#ifdef __cplusplus
+}
 #endif
 #endif /* INC_RMC_API_H_ */
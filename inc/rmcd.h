@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * rmcd - RMC query daemon
+ *
+ * Definitions shared by rmcd and its client library in librmc
+ */
+
+#ifndef INC_RMCD_H_
+#define INC_RMCD_H_
+
+#include <rmc_types.h>
+
+/* default path of rmcd's socket, clients can override it with environment
+ * variable RMCD_SOCKET
+ */
+#define RMCD_SOCKET_PATH        "/run/rmcd.sock"
+#define RMCD_SOCKET_ENV         "RMCD_SOCKET"
+
+#define RMCD_NAME_MAX           256
+
+/* operations */
+#define RMCD_OP_QUERY           1
+#define RMCD_OP_STATS           2
+
+/* status in reply */
+#define RMCD_STATUS_OK          0
+#define RMCD_STATUS_NOT_FOUND   1   /* no such blob for the board */
+#define RMCD_STATUS_OTHER_DB    2   /* rmcd serves a different database file */
+#define RMCD_STATUS_ERROR       3
+
+/*
+ * A request sent to rmcd. One request per SOCK_SEQPACKET message.
+ * db_dev and db_ino identify the database file client wants to query.
+ * When both are 0, client takes whatever database rmcd serves.
+ */
+typedef struct rmcd_request {
+    rmc_uint32_t op;
+    rmc_uint64_t db_dev;
+    rmc_uint64_t db_ino;
+    char name[RMCD_NAME_MAX];   /* null-terminated blob name for RMCD_OP_QUERY */
+} rmcd_request_t;
+
+/* counters maintained by rmcd since it starts */
+typedef struct rmcd_stats {
+    rmc_uint64_t queries;
+    rmc_uint64_t hits;
+    rmc_uint64_t misses;
+    rmc_uint64_t errors;
+    rmc_uint64_t latency_total_ns;  /* sum of time spent on all queries */
+    rmc_uint64_t latency_max_ns;
+} rmcd_stats_t;
+
+/*
+ * A reply from rmcd. For a successful RMCD_OP_QUERY, a sealed memfd holding
+ * the blob is passed along with the reply as SCM_RIGHTS ancillary data.
+ */
+typedef struct rmcd_reply {
+    rmc_uint32_t status;
+    rmc_uint64_t blob_len;
+    rmcd_stats_t stats;         /* only valid for RMCD_OP_STATS */
+} rmcd_reply_t;
+
+#endif /* INC_RMCD_H_ */
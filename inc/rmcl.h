@@ -71,6 +71,17 @@ typedef union rmc_fingerprint {
     } named_fingers;
 } rmc_fingerprint_t;
 
+/* maximum length of a finger value in rmc_fingerprint_buf_t, including terminator */
+#define RMC_FINGER_VALUE_LEN 128
+
+/* a fingerprint holding its finger values inline, for callers which can't use heap.
+ * Values in fp point to storage in the same structure, so do NOT copy it by value.
+ */
+typedef struct rmc_fingerprint_buf {
+    rmc_fingerprint_t fp;
+    char values[RMC_FINGER_NUM][RMC_FINGER_VALUE_LEN];
+} rmc_fingerprint_buf_t;
+
 /*
  * initialize fingerprint data
  */
@@ -78,24 +89,24 @@ typedef union rmc_fingerprint {
 static __inline__ void initialize_fingerprint(rmc_fingerprint_t *fp) {
     fp->named_fingers.thumb.type = 0x1;
     fp->named_fingers.thumb.offset = 0x5;
-    fp->named_fingers.thumb.name = "product_name";
-    fp->named_fingers.thumb.value = "";
+    fp->named_fingers.thumb.name = (char *)"product_name";
+    fp->named_fingers.thumb.value = (char *)"";
     fp->named_fingers.index.type = 0x2;
     fp->named_fingers.index.offset = 0x5;
-    fp->named_fingers.index.name = "product_name";
-    fp->named_fingers.index.value = "";
+    fp->named_fingers.index.name = (char *)"product_name";
+    fp->named_fingers.index.value = (char *)"";
     fp->named_fingers.middle.type = 0x4;
     fp->named_fingers.middle.offset = 0x10;
-    fp->named_fingers.middle.name = "version";
-    fp->named_fingers.middle.value = "";
+    fp->named_fingers.middle.name = (char *)"version";
+    fp->named_fingers.middle.value = (char *)"";
     fp->named_fingers.ring.type = 0x7f;
     fp->named_fingers.ring.offset = 0x0;
-    fp->named_fingers.ring.name = "reserved";
-    fp->named_fingers.ring.value = "";
+    fp->named_fingers.ring.name = (char *)"reserved";
+    fp->named_fingers.ring.value = (char *)"";
     fp->named_fingers.pink.type = 0x7f;
     fp->named_fingers.pink.offset = 0x0;
-    fp->named_fingers.pink.name = "reserved";
-    fp->named_fingers.pink.value = "";
+    fp->named_fingers.pink.name = (char *)"reserved";
+    fp->named_fingers.pink.value = (char *)"";
 }
 
 #define RMC_DB_SIG_LEN 5
@@ -131,9 +142,230 @@ typedef struct rmc_meta_header {
     /* rmc_uint8_t *blob : Invisible, binary packed in mem */
 } __attribute__ ((__packed__)) rmc_meta_header_t;
 
+/*
+ * RMC Database Extension (packed)
+ *
+ * A version 2 database has the same header and records as a version 1 database,
+ * except that a RMC_GENERIC_FILE meta has a rmc_uint32_t ID of its name in
+ * RMC_SECTION_NAMES in place of the name. Extensions follow the end of records
+ * (rmc_db_header_t.length), as an extension header, an array of section headers
+ * and data of sections.
+ */
+#define RMC_DB_VERSION_1 1
+#define RMC_DB_VERSION_2 2
+
+#define RMC_EXT_SIG_LEN 5
+
+typedef struct rmc_ext_header {
+    rmc_uint8_t signature[RMC_EXT_SIG_LEN];     /* "RMCEX" */
+    rmc_uint8_t reserved;
+    rmc_uint32_t section_num;
+    rmc_uint64_t length;                        /* length of whole extension area */
+} __attribute__ ((__packed__)) rmc_ext_header_t;
+
+typedef struct rmc_section_header {
+    rmc_uint32_t type;
+    rmc_uint64_t offset;    /* offset of section data from the start of database */
+    rmc_uint64_t length;
+} __attribute__ ((__packed__)) rmc_section_header_t;
+
+/*
+ * Section RMC_SECTION_SHA256: SHA-256 digests of blobs, to prove blobs are
+ * intact and identical to their sources. Section data starts with a
+ * rmc_uint64_t number of blobs, and then an array of rmc_blob_digest_t for
+ * each meta in the order of metas in database.
+ */
+#define RMC_SECTION_SHA256 3
+
+#define RMC_SHA256_LEN 32
+
+typedef struct rmc_blob_digest {
+    rmc_uint64_t meta_idx;                  /* offset of meta from the start of database */
+    rmc_uint8_t digest[RMC_SHA256_LEN];     /* SHA-256 of blob, excluding its name */
+} __attribute__ ((__packed__)) rmc_blob_digest_t;
+
+/*
+ * Section RMC_SECTION_TRIE: index of records by board.
+ *
+ * A record generated by rmcl_generate_record() matches boards with the same
+ * signature. A pattern record generated by rmcl_generate_pattern_record() matches
+ * boards with the same values of a subset of fingers (e.g. product_name only for a
+ * family of boards), and is not in the signature table.
+ *
+ * Signatures of records are sorted in a table for binary search. Pattern records
+ * are compiled into a decision trie with one level per finger, in the order of
+ * fingers. Each node at level i has edges for values of finger i, sorted byte by
+ * byte, and a wildcard child for any other value. A child of an edge also has all
+ * patterns not caring finger i, so a lookup walks down the trie once without
+ * backtracking. A leaf at level RMC_FINGER_NUM has all matched pattern records,
+ * sorted from the most specific one.
+ *
+ * Section data starts with a rmc_trie_header_t, offsets in it are from the start
+ * of section. The root of trie is node 0 if there is any node. A child always
+ * has a bigger index than its parent.
+ */
+#define RMC_SECTION_TRIE 4
+
+#define RMC_TRIE_NONE 0xffffffff
+
+typedef struct rmc_trie_header {
+    rmc_uint64_t sig_num;       /* number of rmc_sig_entry_t */
+    rmc_uint64_t sig_idx;       /* offset of rmc_sig_entry_t array sorted by signature */
+    rmc_uint64_t node_num;      /* number of rmc_trie_node_t */
+    rmc_uint64_t node_idx;      /* offset of rmc_trie_node_t array */
+    rmc_uint64_t item_idx;      /* offset of edges and leaf records of nodes */
+    rmc_uint64_t item_len;
+    rmc_uint64_t string_idx;    /* offset of null-terminated values of edges */
+    rmc_uint64_t string_len;
+} __attribute__ ((__packed__)) rmc_trie_header_t;
+
+typedef struct rmc_sig_entry {
+    rmc_signature_t signature;
+    rmc_uint64_t record_idx;    /* records with same signature are in the order of database */
+} __attribute__ ((__packed__)) rmc_sig_entry_t;
+
+typedef struct rmc_trie_node {
+    rmc_uint64_t items_idx;     /* offset of rmc_trie_edge_t or rmc_trie_record_t array from item_idx */
+    rmc_uint32_t item_num;
+    rmc_uint32_t wildcard;      /* child node for other values, or RMC_TRIE_NONE */
+    rmc_uint8_t level;          /* finger of node, RMC_FINGER_NUM for leaf */
+} __attribute__ ((__packed__)) rmc_trie_node_t;
+
+typedef struct rmc_trie_edge {
+    rmc_uint64_t value_idx;     /* offset of finger value from string_idx */
+    rmc_uint32_t child;
+} __attribute__ ((__packed__)) rmc_trie_edge_t;
+
+typedef struct rmc_trie_record {
+    rmc_uint64_t record_idx;
+    rmc_uint8_t finger_mask;    /* fingers matched by record, RMC_FINGER_BIT() */
+} __attribute__ ((__packed__)) rmc_trie_record_t;
+
+/*
+ * Section RMC_SECTION_BOARD: dense integer IDs of boards.
+ *
+ * Each distinct signature of records generated by rmcl_generate_record() is a
+ * board, and its ID is its index in a table of signatures sorted byte by byte, so
+ * IDs of a database are 0 to board_num - 1. A client resolves the board it runs
+ * on once and indexes its own arrays with the ID. Pattern records match families
+ * of boards and have no ID.
+ *
+ * Section data starts with a rmc_board_header_t, offsets in it are from the start
+ * of section. Records of board i are entries first[i] to first[i + 1] - 1 of the
+ * record table, in the order of database.
+ */
+#define RMC_SECTION_BOARD 5
+
+typedef struct rmc_board_header {
+    rmc_uint64_t board_num;     /* number of boards, no more than RMC_BOARD_NONE */
+    rmc_uint64_t sig_idx;       /* offset of rmc_signature_t array sorted by signature */
+    rmc_uint64_t first_idx;     /* offset of board_num + 1 rmc_uint64_t first entries of boards */
+    rmc_uint64_t record_num;    /* number of entries in record table */
+    rmc_uint64_t record_idx;    /* offset of record table, rmc_uint64_t offsets of records */
+} __attribute__ ((__packed__)) rmc_board_header_t;
+
+#define RMC_BOARD_NONE 0xffffffff
+
+/*
+ * Section RMC_SECTION_NAMES: integer IDs of blob names.
+ *
+ * Names of all RMC_GENERIC_FILE metas are interned in a table sorted byte by byte,
+ * and the ID of a name is its index in table. Metas store IDs instead of names, so
+ * a name shared by many records is stored once. A query resolves a name to its ID
+ * once and finds metas of records by integer compares. Every version 2 database
+ * has this section.
+ *
+ * IDs are in the order of names, so slots of a record sorted by IDs are also sorted
+ * by names, and names starting with a prefix have a range of IDs. A glob or prefix
+ * query scans slots of a record in that range.
+ *
+ * Section data starts with a rmc_names_header_t, offsets in it are from the start
+ * of section. Records have rmc_name_index_t entries in the order of records, and
+ * the table of an entry is an array of rmc_name_slot_t sorted by name ID and then
+ * by offset of meta.
+ */
+#define RMC_SECTION_NAMES 6
+
+#define RMC_NAME_NONE 0xffffffff
+
+typedef struct rmc_names_header {
+    rmc_uint64_t name_num;      /* number of names, no more than RMC_NAME_NONE */
+    rmc_uint64_t name_idx;      /* offset of name_num rmc_uint64_t offsets of names from string_idx */
+    rmc_uint64_t string_idx;    /* offset of null-terminated names */
+    rmc_uint64_t string_len;
+    rmc_uint64_t record_num;    /* number of rmc_name_index_t */
+    rmc_uint64_t record_idx;    /* offset of rmc_name_index_t array */
+} __attribute__ ((__packed__)) rmc_names_header_t;
+
+typedef struct rmc_name_index {
+    rmc_uint64_t record_idx;    /* offset of record from the start of database */
+    rmc_uint64_t table_idx;     /* offset of rmc_name_slot_t array from the start of section */
+    rmc_uint64_t meta_num;      /* number of RMC_GENERIC_FILE metas in record */
+} __attribute__ ((__packed__)) rmc_name_index_t;
+
+typedef struct rmc_name_slot {
+    rmc_uint32_t name_id;
+    rmc_uint64_t meta_idx;      /* offset of meta from the start of database */
+} __attribute__ ((__packed__)) rmc_name_slot_t;
+
+/*
+ * Section RMC_SECTION_POSTINGS: records having each blob name.
+ *
+ * A database with this section also has RMC_SECTION_NAMES, and the posting list
+ * of name ID i is entries first[i] to first[i + 1] - 1 of the posting table, in
+ * the order of records. A record has one entry for a name, the first meta with
+ * the name as queries return. An inverse query (which boards have a blob) reads
+ * the list of a name without touching any other record.
+ *
+ * Section data starts with a rmc_postings_header_t, offsets in it are from the
+ * start of section.
+ */
+#define RMC_SECTION_POSTINGS 7
+
+typedef struct rmc_postings_header {
+    rmc_uint64_t name_num;      /* same as name_num of RMC_SECTION_NAMES */
+    rmc_uint64_t first_idx;     /* offset of name_num + 1 rmc_uint64_t first entries of names */
+    rmc_uint64_t posting_num;   /* number of rmc_posting_t */
+    rmc_uint64_t posting_idx;   /* offset of rmc_posting_t array */
+} __attribute__ ((__packed__)) rmc_postings_header_t;
+
+typedef struct rmc_posting {
+    rmc_uint64_t record_idx;    /* offset of record from the start of database */
+    rmc_uint64_t meta_idx;      /* offset of meta from the start of database */
+} __attribute__ ((__packed__)) rmc_posting_t;
+
+/*
+ * Section RMC_SECTION_CRC32: CRC-32 (same as zlib) of records and database.
+ * Section data starts with a rmc_uint64_t number of records, and then an array
+ * of rmc_record_crc_t for each record in the order of records, and ends with a
+ * rmc_uint32_t CRC of all bytes of database before it. This section is always
+ * the last one so that the database CRC covers everything else. Every version 2
+ * database has it.
+ */
+#define RMC_SECTION_CRC32 2
+
+typedef struct rmc_record_crc {
+    rmc_uint64_t record_idx;    /* offset of record from the start of database */
+    rmc_uint32_t crc;           /* CRC of the whole record */
+} __attribute__ ((__packed__)) rmc_record_crc_t;
+
 /* We only have one type now but keep a type field internally for extensions in the future. */
 #define RMC_GENERIC_FILE 1
 
+/*
+ * Meta of fingers a pattern record matches, named RMC_MATCH_NAME. Its blob is
+ * a rmc_uint8_t finger mask followed by null-terminated values of fingers in the
+ * mask, in the order of fingers.
+ */
+#define RMC_MATCH_FILE 2
+#define RMC_MATCH_NAME "rmc.match"
+
+/* bit of a finger in a finger mask */
+#define RMC_FINGER_BIT(i) (1 << (i))
+
+/* fingers a record generated by rmcl_generate_record() matches with its signature */
+#define RMC_SIGNATURE_FINGERS (RMC_FINGER_BIT(0) | RMC_FINGER_BIT(1))
+
 typedef struct rmc_file {
     rmc_uint8_t type;              /* RMC_GENERIC_FILE or or any other types defined later */
     char *blob_name;               /* name of blob for type RMC_GENERIC_FILE */
@@ -152,8 +384,65 @@ typedef struct rmc_record_file {
     struct rmc_record_file *next;  /* next rmc record file, or null as terminator for the last element */
 } rmc_record_file_t;
 
+/*
+ * Handoff of a board's fingerprint from bootloader to OS, so that user space
+ * doesn't parse SMBIOS again. EFI library fills it with rmcl_fill_handoff(), and
+ * bootloader stores it in a volatile EFI variable named RMC_HANDOFF_NAME with
+ * vendor GUID RMC_HANDOFF_GUID, readable at runtime. It is only trusted when CRC
+ * is good and signature computed from values is board_signature.
+ */
+#define RMC_HANDOFF_SIG_LEN 5
+#define RMC_HANDOFF_VERSION 1
+#define RMC_HANDOFF_NAME "RmcHandoff"
+#define RMC_HANDOFF_GUID_STR "068272b0-93b8-401c-a35f-e3b50dd56977"
+#define RMC_HANDOFF_GUID {0x068272b0, 0x93b8, 0x401c, \
+                         {0xa3, 0x5f, 0xe3, 0xb5, 0x0d, 0xd5, 0x69, 0x77}}
+
+typedef struct rmc_handoff {
+    rmc_uint8_t signature[RMC_HANDOFF_SIG_LEN];     /* "RMCHO" */
+    rmc_uint8_t version;
+    rmc_uint16_t length;                            /* sizeof(rmc_handoff_t) */
+    rmc_uint32_t crc;                               /* CRC-32 of handoff with this field 0 */
+    rmc_signature_t board_signature;
+    char values[RMC_FINGER_NUM][RMC_FINGER_VALUE_LEN];  /* null-padded finger values */
+} __attribute__ ((__packed__)) rmc_handoff_t;
+
 #pragma pack(pop)
 
+/*
+ * Iterator of metas in a record, see init_record_iter()
+ */
+typedef struct rmc_record_iter {
+    rmc_uint8_t *rmc_db;
+    rmc_uint8_t *names;         /* section RMC_SECTION_NAMES resolving name IDs, NULL in version 1 */
+    rmc_uint64_t meta_idx;      /* offset of next meta in rmc_db */
+    rmc_uint64_t record_end;    /* offset of the end of record in rmc_db */
+} rmc_record_iter_t;
+
+/*
+ * Iterator of metas with names matching a pattern, see init_match_iter()
+ */
+typedef struct rmc_match_iter {
+    rmc_record_iter_t record_iter;  /* walk through metas when there is no table */
+    rmc_uint8_t *table;             /* name slots of record in RMC_SECTION_NAMES, NULL in version 1 */
+    rmc_uint64_t pos;               /* next position in table */
+    rmc_uint64_t end;               /* end of table */
+    rmc_uint32_t name_end;          /* end of name IDs starting with prefix */
+    char *pattern;
+    rmc_size_t prefix_len;          /* length of literal prefix in pattern */
+} rmc_match_iter_t;
+
+/*
+ * Iterator of records having a blob name, see init_name_iter()
+ */
+typedef struct rmc_name_iter {
+    rmc_uint8_t *rmc_db;
+    rmc_uint8_t *postings;          /* posting table of section, NULL when scanning records */
+    rmc_uint64_t pos;               /* next posting, or offset of next record to scan */
+    rmc_uint64_t end;               /* end of posting list, or end of records */
+    char *blob_name;
+} rmc_name_iter_t;
+
 /*
  * Generate RMC record file (This function allocate memory)
  * (in) fingerprint     : fingerprint of board, usually generated by rmc tool with rsmp.
@@ -163,6 +452,19 @@ typedef struct rmc_record_file {
  */
 extern int rmcl_generate_record(rmc_fingerprint_t *fingerprint, rmc_file_t *policy_files, rmc_record_file_t *record_file);
 
+/*
+ * Generate RMC pattern record file which matches boards with the same values of
+ * fingers in finger_mask, e.g. a fallback record for a family of boards. Other
+ * fingers are ignored. Only a version 2 database can match pattern records.
+ * When more than one record matches a board, a record matching more fingers is
+ * more specific, and then a record matching an earlier finger. Blobs in a more
+ * specific record hide ones with the same names in others.
+ * (in) finger_mask     : fingers to match, RMC_FINGER_BIT() of fingers
+ * Other parameters are same as rmcl_generate_record().
+ */
+extern int rmcl_generate_pattern_record(rmc_fingerprint_t *fingerprint, rmc_uint8_t finger_mask,
+        rmc_file_t *policy_files, rmc_record_file_t *record_file);
+
 /*
  * Generate RMC database blob (This function allocate memory)
  * (in) record_files    : head of a list of record files, 'next' of the last one must be NULL.
@@ -185,9 +487,162 @@ extern int rmcl_generate_db(rmc_record_file_t *record_files, rmc_uint8_t **rmc_d
  *
  * return               : 0 when rmcl found a meta in record which has matched signature of fingerprint. non-zero for failures. Content of
  *                        policy is not determined when non-zero is returned.
+ *
+ * Database is trusted, use query_policy_from_handle() or query_policy_from_buffer()
+ * for a database not known to be well-formed.
+ *
+ * When database has RMC_SECTION_NAMES, blob_name is resolved to its ID once and
+ * metas of records are found by ID.
  */
 extern int query_policy_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_uint8_t type, char *blob_name, rmc_file_t *policy);
 
+/*
+ * Locate a record for a board in a RMC database blob provided by caller
+ * (in) fingerprint     : fingerprint of board
+ * (in) rmc_db          : rmc database blob
+ * (in/out) record_idx  : 0 to locate the first matched record, or offset returned by
+ *                        a previous call to locate the next one, in case there are more
+ *                        records with the same signature.
+ *                        Output is offset of matched record in rmc_db. Callers can keep it
+ *                        and query metas with query_policy_from_record() later without
+ *                        scanning records again.
+ *
+ * When database has RMC_SECTION_TRIE, records are located with the index without
+ * scanning records, and pattern records matching the board are returned as well,
+ * from the most specific record to the least specific one.
+ *
+ * return               : 0 when rmcl found a record which has matched signature of fingerprint.
+ *                        non-zero for failures.
+ */
+extern int query_record_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_uint64_t *record_idx);
+
+/*
+ * Query a meta in a record located by query_record_from_db()
+ * (in) rmc_db          : rmc database blob
+ * (in) record_idx      : offset of record in rmc_db
+ * (in) type            : type of record
+ * (in) blob_name       : name of file blob to query
+ * (out) policy         : same as what query_policy_from_db() returns
+ *
+ * return               : 0 when rmcl found a meta in the record, non-zero for failures.
+ */
+extern int query_policy_from_record(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx, rmc_uint8_t type, char *blob_name, rmc_file_t *policy);
+
+/*
+ * Generate a version 2 RMC database blob with extensions (This function allocate memory)
+ * Parameters are same as rmcl_generate_db().
+ */
+extern int rmcl_generate_db_v2(rmc_record_file_t *record_files, rmc_uint8_t **rmc_db, rmc_size_t *len);
+
+/*
+ * Convert a version 1 RMC database already laid out in memory, e.g. records written
+ * into a file and mapped, to version 2. Names of metas are replaced by IDs and
+ * extensions are appended. (This function allocate memory)
+ * (in) rmc_db          : version 1 database blob with header and well-formed records
+ * (out) v2_db          : version 2 database blob (allocated)
+ * (out) v2_len         : length of v2_db
+ *
+ * return               : 0 for success, non-zero for failures.
+ */
+extern int rmcl_convert_db_v2(rmc_uint8_t *rmc_db, rmc_uint8_t **v2_db, rmc_size_t *v2_len);
+
+/*
+ * Locate a section in extensions of a database
+ * (in) rmc_db          : rmc database blob
+ * (in) type            : type of section, RMC_SECTION_*
+ * (out) section_idx    : offset of section data from the start of rmc_db
+ * (out) section_len    : length of section data
+ *
+ * return               : 0 when section is found, non-zero when database doesn't have it.
+ */
+extern int query_section_from_db(rmc_uint8_t *rmc_db, rmc_uint32_t type, rmc_uint64_t *section_idx, rmc_uint64_t *section_len);
+
+/*
+ * Initialize an iterator to walk through metas in a record with names matching a
+ * pattern. A pattern is a glob where '*' matches any string and '?' matches any
+ * single character. A prefix query is a pattern like "audio*".
+ * In a version 2 database, matches are found in one range scan of name slots of
+ * record with IDs of names starting with the literal prefix of pattern (characters
+ * before the first wildcard), and returned in order of names. Otherwise all metas
+ * in the record are checked and matches are returned in order of metas.
+ * (in) rmc_db          : rmc database blob
+ * (in) record_idx      : offset of record in rmc_db, from query_record_from_db()
+ * (in) pattern         : pattern of names, referenced by iter
+ * (out) iter           : iterator provided by caller
+ *
+ * return               : 0 for success, non-zero for failures.
+ */
+extern int init_match_iter(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx, char *pattern, rmc_match_iter_t *iter);
+
+/*
+ * Get the next meta with name matching the pattern
+ * (in) iter            : iterator initialized by init_match_iter()
+ * (out) policy         : same as next_policy_in_record()
+ *
+ * return               : 0 when a meta is returned, non-zero when there is no more match.
+ */
+extern int next_match_in_record(rmc_match_iter_t *iter, rmc_file_t *policy);
+
+/*
+ * Initialize an iterator to walk through metas in a record. Neither this function
+ * nor next_policy_in_record() allocates memory.
+ * (in) rmc_db          : rmc database blob
+ * (in) record_idx      : offset of record in rmc_db, from query_record_from_db()
+ * (out) iter           : iterator provided by caller
+ *
+ * return               : 0 for success, non-zero for failures.
+ */
+extern int init_record_iter(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx, rmc_record_iter_t *iter);
+
+/*
+ * Get the next meta in a record
+ * (in) iter            : iterator initialized by init_record_iter()
+ * (out) policy         : type, name, length and data of blob in the meta. Pointer members
+ *                        hold data location in rmc_db's memory region.
+ *
+ * return               : 0 when a meta is returned, non-zero at the end of record.
+ */
+extern int next_policy_in_record(rmc_record_iter_t *iter, rmc_file_t *policy);
+
+/*
+ * Compute CRC-32 of data, compatible with crc32() in zlib
+ * (in) crc             : 0 to start, or CRC of data before this chunk to continue
+ * (in) data            : data to compute
+ * (in) len             : number of bytes of data
+ *
+ * return               : CRC of all data so far
+ */
+extern rmc_uint32_t rmc_crc32(rmc_uint32_t crc, const void *data, rmc_size_t len);
+
+/*
+ * Compute SHA-256 digest of data
+ * (in) data            : data to compute
+ * (in) len             : number of bytes of data
+ * (out) digest         : RMC_SHA256_LEN bytes of digest
+ */
+extern void rmc_sha256(const void *data, rmc_size_t len, rmc_uint8_t digest[RMC_SHA256_LEN]);
+
+/*
+ * Get SHA-256 digest of a blob stored in database
+ * (in) rmc_db          : rmc database blob
+ * (in) meta_idx        : offset of meta of blob in rmc_db
+ *
+ * return               : RMC_SHA256_LEN bytes of digest in rmc_db, or NULL when
+ *                        database doesn't have a digest of the blob.
+ */
+extern rmc_uint8_t *query_digest_from_db(rmc_uint8_t *rmc_db, rmc_uint64_t meta_idx);
+
+/*
+ * Check CRC of a record, for callers which only read records they use from a
+ * database not checked by validate_rmcdb().
+ * (in) rmc_db          : rmc database blob
+ * (in) record_idx      : offset of record in rmc_db, from query_record_from_db()
+ *
+ * return               : 0 when record matches its CRC or database doesn't have
+ *                        CRC section, non-zero otherwise.
+ */
+extern int verify_record_crc(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx);
+
 /*
  * Check if db_blob has a valid rmc database signature
  *
@@ -195,4 +650,283 @@ extern int query_policy_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc
  */
 int is_rmcdb(rmc_uint8_t *db_blob);
 
+/*
+ * Check if db_blob is a well-formed rmc database, which means all records and
+ * metas are within len bytes and every blob name is null-terminated in its meta.
+ * Extensions of a version 2 database are checked as well, including name IDs of
+ * metas and CRC of the whole database in its CRC section, which must be present.
+ * Other APIs trust a database in memory. Call this on a database from an
+ * untrusted source before querying it.
+ * (in) db_blob         : rmc database blob
+ * (in) len             : number of bytes of db_blob available to read
+ *
+ * return 0 if db_blob is well-formed or non-zero otherwise
+ */
+int validate_rmcdb(rmc_uint8_t *db_blob, rmc_size_t len);
+
+/*
+ * Same as validate_rmcdb() but CRC of database is not checked, so that a
+ * database with corrupted data can still be walked safely to find where
+ * data is corrupted. Layout of CRC section is still checked, record CRCs
+ * can be looked up with verify_record_crc() after.
+ */
+int validate_rmcdb_layout(rmc_uint8_t *db_blob, rmc_size_t len);
+
+/*
+ * A database checked by validate_rmcdb(). Only rmcl_open_db() shall fill it, so
+ * that queries with a handle can skip all bounds checks.
+ */
+typedef struct rmc_db_handle {
+    rmc_uint8_t *db;
+    rmc_size_t len;
+} rmc_db_handle_t;
+
+/*
+ * Validate a database once and get a handle for queries on the fast path
+ * (in) db_blob         : rmc database blob, must not be modified while handle is used
+ * (in) len             : number of bytes of db_blob available to read
+ * (out) handle         : handle of validated database
+ *
+ * return 0 if db_blob is well-formed or non-zero otherwise
+ */
+int rmcl_open_db(rmc_uint8_t *db_blob, rmc_size_t len, rmc_db_handle_t *handle);
+
+/*
+ * Same as query_policy_from_db() on a database validated by rmcl_open_db(), no
+ * data is checked again.
+ */
+int query_policy_from_handle(rmc_fingerprint_t *fingerprint, const rmc_db_handle_t *handle,
+        rmc_uint8_t type, char *blob_name, rmc_file_t *policy);
+
+/*
+ * Same as query_policy_from_db() on a database not validated, every access is
+ * checked against len on the way. Records are scanned without using other
+ * extensions than RMC_SECTION_NAMES of a version 2 database, where blob_name is
+ * resolved to its ID once. So this is for a single query on a database from an
+ * untrusted source. Validate it with rmcl_open_db() for more queries.
+ * (in) len             : number of bytes of rmc_db available to read
+ *
+ * return               : 0 when a meta is found, non-zero for failures or when
+ *                        data on the way is malformed.
+ */
+int query_policy_from_buffer(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_size_t len,
+        rmc_uint8_t type, char *blob_name, rmc_file_t *policy);
+
+/*
+ * Context of queries for a board in a database, see rmcl_init_query_ctx(). It is
+ * provided by caller and holds no allocated memory.
+ */
+#define RMC_QUERY_CTX_RECORDS 8
+
+typedef struct rmc_query_ctx {
+    rmc_uint8_t *rmc_db;
+    rmc_fingerprint_t fingerprint;      /* finger values are referenced, not copied */
+    rmc_signature_t signature;
+    rmc_uint64_t section_idx;           /* section RMC_SECTION_TRIE, 0 when database has none */
+    rmc_uint32_t record_num;
+    rmc_uint32_t more;                  /* 1 when more records match than record_idx holds */
+    rmc_uint64_t record_idx[RMC_QUERY_CTX_RECORDS];    /* matched records in the order of queries */
+} rmc_query_ctx_t;
+
+/*
+ * Compute signature of a board and locate all records matching it in a database
+ * once, for more than one query with query_policy_from_ctx(). Records are in the
+ * same order query_record_from_db() returns them.
+ * (in) fingerprint     : fingerprint of board, finger values must be kept while
+ *                        ctx is used
+ * (in) rmc_db          : rmc database blob, trusted as query_policy_from_db() does
+ * (out) ctx            : context provided by caller
+ *
+ * return               : 0 for success, even when no record matches the board.
+ *                        non-zero for failures.
+ */
+int rmcl_init_query_ctx(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_query_ctx_t *ctx);
+
+/*
+ * Same as query_policy_from_db() with a context from rmcl_init_query_ctx(). Only
+ * metas of records in context are searched, neither fingerprint nor records are
+ * processed again.
+ * (in) ctx             : context of board and database
+ */
+int query_policy_from_ctx(rmc_query_ctx_t *ctx, rmc_uint8_t type, char *blob_name, rmc_file_t *policy);
+
+/*
+ * Resolve a board to its ID in section RMC_SECTION_BOARD of a database
+ * (in) fingerprint     : fingerprint of board
+ * (in) rmc_db          : rmc database blob, trusted as query_policy_from_db() does
+ * (out) board_id       : ID of board, from 0 to board_num - 1
+ * (out) board_num      : number of boards in database, could be NULL
+ *
+ * return               : 0 for success, non-zero when database has no board IDs or
+ *                        board has no record of its signature in database.
+ */
+int query_board_id_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_uint32_t *board_id,
+        rmc_uint32_t *board_num);
+
+/*
+ * Same as query_policy_from_db() for a board resolved by query_board_id_from_db().
+ * Records of board are located by index without any string compare. Blobs of
+ * pattern records are not included, query by fingerprint to fall back on them.
+ * (in) rmc_db          : rmc database blob
+ * (in) board_id        : ID of board in database
+ */
+int query_policy_by_board_id(rmc_uint8_t *rmc_db, rmc_uint32_t board_id, rmc_uint8_t type, char *blob_name,
+        rmc_file_t *policy);
+
+/*
+ * Resolve a blob name to its ID in section RMC_SECTION_NAMES of a database
+ * (in) rmc_db          : rmc database blob, trusted as query_policy_from_db() does
+ * (in) blob_name       : name of RMC_GENERIC_FILE blob
+ * (out) name_id        : ID of name, from 0 to name_num - 1
+ * (out) name_num       : number of names in database, could be NULL
+ *
+ * return               : 0 for success, non-zero when database has no name IDs or
+ *                        no blob has the name.
+ */
+int query_name_id_from_db(rmc_uint8_t *rmc_db, char *blob_name, rmc_uint32_t *name_id, rmc_uint32_t *name_num);
+
+/*
+ * Query a RMC_GENERIC_FILE blob by IDs of board and name, with integer compares only.
+ * Same as query_policy_by_board_id() for the name of name_id.
+ * (in) rmc_db          : rmc database blob
+ * (in) board_id        : ID from query_board_id_from_db()
+ * (in) name_id         : ID from query_name_id_from_db()
+ * (out) policy         : blob referencing database
+ *
+ * return               : 0 for success, non-zero when not found.
+ */
+int query_policy_by_ids(rmc_uint8_t *rmc_db, rmc_uint32_t board_id, rmc_uint32_t name_id, rmc_file_t *policy);
+
+/*
+ * Initialize an iterator to walk through records having a RMC_GENERIC_FILE blob
+ * with a name, in the order of records. Pattern records are included. When database
+ * has RMC_SECTION_POSTINGS, records are read from the posting list of name.
+ * Otherwise all records are scanned. Neither this function nor
+ * next_record_with_name() allocates memory.
+ * (in) rmc_db          : rmc database blob, trusted as query_policy_from_db() does
+ * (in) blob_name       : name of blob, referenced by iter
+ * (out) iter           : iterator provided by caller
+ *
+ * return               : 0 for success, even when no record has the name.
+ *                        non-zero for failures.
+ */
+int init_name_iter(rmc_uint8_t *rmc_db, char *blob_name, rmc_name_iter_t *iter);
+
+/*
+ * Get the next record having the blob name
+ * (in) iter            : iterator initialized by init_name_iter()
+ * (out) record_idx     : offset of record in rmc_db
+ * (out) policy         : blob of record, same as query_policy_from_record() returns
+ *
+ * return               : 0 when a record is returned, non-zero when there is no more.
+ */
+int next_record_with_name(rmc_name_iter_t *iter, rmc_uint64_t *record_idx, rmc_file_t *policy);
+
+/*
+ * Fill a handoff with fingerprint of board, see rmc_handoff_t
+ * (in) fingerprint     : fingerprint of board
+ * (out) handoff        : handoff provided by caller
+ *
+ * return               : 0 for success, non-zero for failures, including a finger
+ *                        value longer than RMC_FINGER_VALUE_LEN - 1.
+ */
+int rmcl_fill_handoff(rmc_fingerprint_t *fingerprint, rmc_handoff_t *handoff);
+
+/*
+ * Check a handoff read from bootloader and get fingerprint in it
+ * (in) handoff         : handoff read, CRC field is restored after check
+ * (in) len             : number of bytes read
+ * (out) fingerprint    : fingerprint with values referencing handoff
+ *
+ * return               : 0 when handoff is intact and consistent, non-zero otherwise.
+ */
+int rmcl_check_handoff(rmc_handoff_t *handoff, rmc_size_t len, rmc_fingerprint_t *fingerprint);
+
+/*
+ * Callback to read a database from storage, e.g. a file a bootloader has opened
+ * (in) ctx             : context of caller, passed through
+ * (in) offset          : offset in database
+ * (in) len             : number of bytes to read
+ * (out) buf            : buffer of at least len bytes
+ *
+ * return               : 0 when all len bytes are read, non-zero otherwise
+ */
+typedef int (*rmc_read_at_t)(void *ctx, rmc_uint64_t offset, rmc_size_t len, void *buf);
+
+/*
+ * Same as query_policy_from_buffer() on a database not in memory. Only headers of
+ * records, metas of records matching the board, names compared to resolve blob_name
+ * in a version 2 database and the blob found are read with read_at, and the blob is
+ * copied into a buffer provided by caller. Every offset and length read in records
+ * is checked against the end of records before it is used.
+ * (in) read_at         : callback to read database
+ * (in) ctx             : passed to read_at
+ * (out) buf            : buffer to hold the blob
+ * (in) buf_len         : size of buf, could be 0 (buf can be NULL then) to get size of blob
+ * (out) len            : length of blob, or 0 when blob is not found
+ *
+ * return               : 0 when a blob is found and copied, non-zero for failures. When
+ *                        buf is too small, nothing is copied and len is the size required.
+ */
+int query_policy_by_read_at(rmc_fingerprint_t *fingerprint, rmc_read_at_t read_at, void *ctx,
+        rmc_uint8_t type, char *blob_name, void *buf, rmc_size_t buf_len, rmc_size_t *len);
+
+/*
+ * A database compiled into a program as C source (rmc -C). Database file is in
+ * a const array, and blobs are located with a minimal perfect hash table over
+ * signatures and blob names of all blobs boards get, computed at build time.
+ * A key is hashed by rmcl_static_hash() into a bucket, the displacement of the
+ * bucket picks the slot of the key among the slots. A slot refers to the blob
+ * a query on database returns for the key, or is empty.
+ */
+typedef struct rmc_static_slot {
+    rmc_uint64_t record_idx;    /* offset of record in data */
+    rmc_uint64_t meta_idx;      /* offset of meta in data, 0 for an empty slot */
+} rmc_static_slot_t;
+
+typedef struct rmc_static_db {
+    const rmc_uint8_t *data;            /* database file */
+    rmc_size_t len;
+    rmc_uint32_t seed;                  /* seed of hash */
+    rmc_uint32_t bucket_num;
+    const rmc_uint32_t *displacements;  /* one per bucket */
+    rmc_uint32_t slot_num;
+    const rmc_static_slot_t *slots;
+} rmc_static_db_t;
+
+/*
+ * Hash a key of static database, signature is taken until its first '\0' as
+ * signatures are compared
+ * (in) seed            : seed of hash
+ * (in) signature       : signature of board
+ * (in) blob_name       : name of blob
+ *
+ * return               : 64-bit hash
+ */
+rmc_uint64_t rmcl_static_hash(rmc_uint32_t seed, const rmc_signature_t *signature, const char *blob_name);
+
+/*
+ * Slot of a key hashed by rmcl_static_hash() in a static database
+ */
+static __inline__ rmc_uint32_t rmcl_static_slot(rmc_uint64_t hash, rmc_uint32_t bucket_num,
+        const rmc_uint32_t *displacements, rmc_uint32_t slot_num) {
+    rmc_uint32_t h1 = (rmc_uint32_t)hash;
+    rmc_uint32_t h2 = (rmc_uint32_t)(hash >> 32);
+    rmc_uint32_t d = displacements[h2 % bucket_num];
+
+    /* all in 32 bits, no 64-bit division in EFI on 32-bit x86 */
+    return (h1 + d * ((h2 * 0x9e3779b1) | 1)) % slot_num;
+}
+
+/*
+ * Same as query_policy_from_db() on a static database generated by rmc -C. A
+ * query is a hash and a lookup in slots, records are not scanned. Database has
+ * no pattern records, which are never indexed by signatures.
+ * (in) db              : static database
+ *
+ * return               : 0 when a meta is found, non-zero for failures.
+ */
+int query_policy_from_static_db(rmc_fingerprint_t *fingerprint, const rmc_static_db_t *db,
+        char *blob_name, rmc_file_t *policy);
+
 #endif /* INC_RMCL_H_ */
@@ -33,6 +33,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <dirent.h>
 #include <ctype.h>
 #include <limits.h>
@@ -44,6 +45,11 @@
 #define SYSTAB_LEN       4096             /* assume 4kb is enough...*/
 #define DB_DUMP_DIR      "./rmc_db_dump"  /* directory to store db data dump */
 
+/* EFI variable of fingerprint handed off by bootloader, in efivarfs */
+#define RMC_HANDOFF_PATH "/sys/firmware/efi/efivars/" RMC_HANDOFF_NAME "-" RMC_HANDOFF_GUID_STR
+#define EFI_VARIABLE_NON_VOLATILE   0x1
+#define EFI_VARIABLE_RUNTIME_ACCESS 0x4
+
 int read_file(const char *pathname, char **data, rmc_size_t* len) {
     int fd = -1;
     struct stat s;
@@ -126,35 +132,183 @@ int write_file(const char *pathname, void *data, rmc_size_t len, int append) {
     return 0;
 }
 
+int map_file(const char *pathname, rmc_uint8_t **data, rmc_size_t *len) {
+    int fd = -1;
+    struct stat s;
+    void *map = NULL;
+
+    *data = NULL;
+    *len = 0;
+
+    if ((fd = open(pathname, O_RDONLY)) < 0) {
+        perror("rmc: failed to open file to map");
+        return 1;
+    }
+
+    if (fstat(fd, &s) < 0) {
+        perror("rmc: failed to get file stat");
+        close(fd);
+        return 1;
+    }
+
+    if (s.st_size == 0) {
+        fprintf(stderr, "rmc: cannot map empty file %s\n", pathname);
+        close(fd);
+        return 1;
+    }
+
+    map = mmap(NULL, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    /* mapping stays valid after the descriptor is closed */
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        perror("rmc: failed to map file");
+        return 1;
+    }
+
+    *data = map;
+    *len = s.st_size;
+
+    return 0;
+}
+
+void unmap_file(rmc_uint8_t *data, rmc_size_t len) {
+    if (data && munmap(data, len) < 0)
+        perror("rmc: munmap file failed, ignore");
+}
+
+static int create_memfd(const char *name) {
+    int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if (fd < 0)
+        perror("rmc: failed to create memfd");
+
+    return fd;
+}
+
+/* nobody can change the content once it leaves here */
+static int seal_memfd(int fd) {
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+        perror("rmc: failed to seal memfd");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* write data to fd, return number of bytes written before a failure */
+static rmc_size_t write_all(int fd, rmc_uint8_t *data, rmc_size_t len) {
+    rmc_ssize_t tmp = 0;
+    rmc_size_t total = 0;
+
+    while (total < len) {
+        if ((tmp = write(fd, data + total, len - total)) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("rmc: failed to write fd");
+            break;
+        }
+
+        total += (rmc_size_t)tmp;
+    }
+
+    return total;
+}
+
+int write_memfd(const char *name, void *data, rmc_size_t len) {
+    int fd = -1;
+
+    if ((fd = create_memfd(name)) < 0)
+        return -1;
+
+    if (write_all(fd, data, len) < len) {
+        close(fd);
+        return -1;
+    }
+
+    return seal_memfd(fd);
+}
+
+int copy_fd(int dst_fd, int src_fd, rmc_uint64_t offset, void *data, rmc_size_t len) {
+    rmc_ssize_t tmp = 0;
+    rmc_size_t total = 0;
+    off_t off = offset;
+
+    /* let kernel copy pages when filesystems support it */
+    while (total < len && (tmp = copy_file_range(src_fd, &off, dst_fd, NULL, len - total, 0)) > 0)
+        total += (rmc_size_t)tmp;
+
+    /* copy_file_range() refuses to copy across filesystems (EXDEV) and into
+     * pipes or sockets. sendfile() still copies in kernel without these
+     * restrictions, by splicing file pages into output.
+     */
+    while (total < len && (tmp = sendfile(dst_fd, src_fd, &off, len - total)) > 0)
+        total += (rmc_size_t)tmp;
+
+    /* copy the rest in user space, e.g. output is opened with O_APPEND */
+    if (total < len && write_all(dst_fd, (rmc_uint8_t *)data + total, len - total) < len - total)
+        return 1;
+
+    return 0;
+}
+
+int copy_memfd(const char *name, int src_fd, rmc_uint64_t offset, void *data, rmc_size_t len) {
+    int fd = -1;
+
+    if ((fd = create_memfd(name)) < 0)
+        return -1;
+
+    if (copy_fd(fd, src_fd, offset, data, len)) {
+        close(fd);
+        return -1;
+    }
+
+    return seal_memfd(fd);
+}
+
 /*
  * Read smbios entry table address from sysfs
  * return 0 when success
  */
 static int get_smbios_entry_table_addr(rmc_uint64_t* addr){
 
-    char *entry_buf = NULL;
+    char entry_buf[SYSTAB_LEN];
+    char *line;
+    char *next;
     char *tmp;
-    FILE *f;
+    rmc_ssize_t len;
+    int fd;
 
-    if ((f = fopen(EFI_SYSTAB_PATH, "r")) == NULL) {
+    /* systab is read on stack instead of with stdio, so that fingerprinting
+     * doesn't allocate memory
+     */
+    if ((fd = open(EFI_SYSTAB_PATH, O_RDONLY)) < 0) {
         perror("rmc: Cannot get systab");
         return 1;
     }
 
-    entry_buf = malloc(SYSTAB_LEN);
+    len = read(fd, entry_buf, SYSTAB_LEN - 1);
+    close(fd);
 
-    if (!entry_buf) {
-        perror("cannot allocate entry buffer");
-        goto malloc_err;
+    if (len < 0) {
+        perror("rmc: Cannot read systab");
+        return 1;
     }
 
-    while (fgets(entry_buf, SYSTAB_LEN, f) != NULL) {
+    entry_buf[len] = '\0';
+
+    for (line = entry_buf; line; line = next) {
 
-        if (strncmp(entry_buf, "SMBIOS", 6))
+        if ((next = strchr(line, '\n')) != NULL)
+            *next++ = '\0';
+
+        if (strncmp(line, "SMBIOS", 6))
             continue;
 
         /* found SMBIOS entry table */
-        if ((tmp = strstr(&entry_buf[6], "=")) == NULL)
+        if ((tmp = strstr(&line[6], "=")) == NULL)
             continue;
 
         errno = 0;
@@ -167,13 +321,114 @@ static int get_smbios_entry_table_addr(rmc_uint64_t* addr){
             break;
     }
 
-    free(entry_buf);
+    return 0;
 
-malloc_err:
-    fclose(f);
+}
 
-    return 0;
+typedef enum read_fingerprint_state {
+    TYPE = 1,
+    OFFSET,
+    NAME,
+    VALUE
+} read_fingerprint_state_t;
+
+/*
+ * read fingerprint from file
+ * (in) pathname        : path and name of file to read
+ * (out) fp             : pointer of fingerprint structure to hold read fingerprint
+ * (out) raw            : pointer of a pointer which points to raw file blob allocated.
+ *                        caller shall use it to free mem. It is NULL for failures.
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+int read_fingerprint_from_file(const char* pathname, rmc_fingerprint_t *fp, void **raw) {
+    char *file = NULL;
+    rmc_size_t len = 0;
+    rmc_size_t idx = 0;
+    int i = 0;
+    int ret = 1;
+    read_fingerprint_state_t state = TYPE;
+
+    if (read_file(pathname, &file, &len)) {
+        fprintf(stderr, "Failed to read fingerprint file: %s\n", pathname);
+        return 1;
+    }
+
+    /* NOTE: We haven't supported "bring your own SMBIOS fields as fingerprint", that means
+     * we still have a hard-coded selected fields when rmc generate a fingerprint for
+     * the board. This will be checked here for consistency, because rsmp always seeks same
+     * fields at run time on target. It simply gets these fields by calling the same function
+     * initialize_fingerprint().
+     *
+     * The rmcl actually doesn't care which fields are in fingerprint.
+     *
+     * In the future, we could release the constraint so that user can specify which five fields
+     * are the best to describe his board. But we should keep it in mind that same value of two
+     * different SMBIOS fields could bring a much higher chance of collision. e.g. a same vendor
+     * name in different SMBIOS tables.
+     *
+     */
+    initialize_fingerprint(fp);
+
+    for (idx = 0; idx < len; idx++) {
+        switch(state) {
+        case TYPE:
+            if (fp->rmc_fingers[i].type != file[idx]) {
+                fprintf(stderr,
+                        "Invalid Finger %d expected type 0x%02x, but got 0x%02x\n\n",
+                        i, fp->rmc_fingers[i].type, file[idx]);
+                goto read_fp_done;
+            }
+            state = OFFSET;
+            break;
+        case OFFSET:
+            if (fp->rmc_fingers[i].offset != file[idx]) {
+                fprintf(stderr, "Invalid Finger %d expected offset 0x%02x, but got 0x%02x\n\n",
+                        i, fp->rmc_fingers[i].offset, file[idx]);
+                goto read_fp_done;
+            }
+            fp->rmc_fingers[i].name = NULL;
+            state = NAME;
+            break;
+        case NAME:
+            if (fp->rmc_fingers[i].name == NULL)
+                fp->rmc_fingers[i].name = &file[idx];
+            if (file[idx] == '\0') {
+                fp->rmc_fingers[i].value = NULL;
+                state = VALUE;
+            }
+            break;
+        case VALUE:
+            if (fp->rmc_fingers[i].value == NULL)
+                fp->rmc_fingers[i].value = &file[idx];
+            if (file[idx] == '\0') {
+                /* next fingerprint */
+                i++;
+
+                if (!(i < RMC_FINGER_NUM)) {
+                    /* we have got all fingers' data, done */
+                    ret = 0;
+                    goto read_fp_done;
+                }
+                state = TYPE;
+            }
+            break;
+        default:
+            fprintf(stderr, "Internal error, invalid state when parsing fingerprint\n\n");
+            goto read_fp_done;
+        }
+    }
+read_fp_done:
+    if (ret) {
+        if (i != RMC_FINGER_NUM)
+            fprintf(stderr, "Internal error when parsing finger %d. file could be corrupted\n\n", i);
+
+        free(file);
+        *raw = NULL;
+    } else
+        *raw = file;
 
+    return ret;
 }
 
 void rmc_free_fingerprint(rmc_fingerprint_t *fp) {
@@ -190,7 +445,87 @@ void rmc_free_file(rmc_file_t *file) {
     free(file->blob);
 }
 
-int rmc_get_fingerprint(rmc_fingerprint_t *fp) {
+/* copy finger values not owned by fingerprint, into caller's storage or duplicated
+ * in heap so that caller can free them with rmc_free_fingerprint() later. The other
+ * fields are hardcoded in initialize_fingerprint(), so we don't copy them.
+ * (in) values  : storage of finger values, or NULL to duplicate values in heap
+ */
+static int copy_finger_values(rmc_fingerprint_t *fp, char (*values)[RMC_FINGER_VALUE_LEN]) {
+    int i;
+    int j;
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if (values) {
+            if (strlen(fp->rmc_fingers[i].value) >= RMC_FINGER_VALUE_LEN) {
+                fprintf(stderr, "Value of finger %d is too long\n", i);
+                return 1;
+            }
+
+            strcpy(values[i], fp->rmc_fingers[i].value);
+            fp->rmc_fingers[i].value = values[i];
+            continue;
+        }
+
+        fp->rmc_fingers[i].value = strdup(fp->rmc_fingers[i].value);
+        if (!fp->rmc_fingers[i].value) {
+            perror("insufficient memory for obtained fingerprint");
+            for (j = 0; j < i; j++)
+                free(fp->rmc_fingers[j].value);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* read fingerprint handed off by bootloader in an EFI variable from efivarfs, which
+ * is the attributes of variable followed by its data. Only a volatile variable is
+ * taken, so that it is always from the current boot.
+ * (in) values  : storage of finger values, or NULL to duplicate values in heap
+ * return: 0 when handoff is found and consistent, non-zero otherwise (silently)
+ */
+static int read_handoff(const char *pathname, rmc_fingerprint_t *fp, char (*values)[RMC_FINGER_VALUE_LEN]) {
+    rmc_uint8_t var[sizeof(rmc_uint32_t) + sizeof(rmc_handoff_t) + 1];
+    rmc_handoff_t handoff;
+    rmc_uint32_t attributes = 0;
+    rmc_ssize_t len;
+    int fd;
+
+    if ((fd = open(pathname, O_RDONLY)) < 0)
+        return 1;
+
+    /* one byte more to tell a longer variable */
+    len = read(fd, var, sizeof(var));
+    close(fd);
+
+    if (len != sizeof(var) - 1)
+        return 1;
+
+    memcpy(&attributes, var, sizeof(attributes));
+    memcpy(&handoff, var + sizeof(attributes), sizeof(handoff));
+
+    if ((attributes & EFI_VARIABLE_NON_VOLATILE) || !(attributes & EFI_VARIABLE_RUNTIME_ACCESS))
+        return 1;
+
+    if (rmcl_check_handoff(&handoff, sizeof(handoff), fp))
+        return 1;
+
+    /* values are in handoff on stack */
+    return copy_finger_values(fp, values);
+}
+
+int read_fingerprint_from_handoff(const char *pathname, rmc_fingerprint_t *fp) {
+    if (!fp)
+        return 1;
+
+    return read_handoff(pathname ? pathname : RMC_HANDOFF_PATH, fp, NULL);
+}
+
+/* get fingerprint of the running board
+ * (out) fp     : fingerprint
+ * (in) values  : storage of finger values, or NULL to duplicate values in heap
+ */
+static int get_board_fingerprint(rmc_fingerprint_t *fp, char (*values)[RMC_FINGER_VALUE_LEN]) {
 
     int fd = -1;
     rmc_uint64_t entry_addr = 0;
@@ -205,12 +540,14 @@ int rmc_get_fingerprint(rmc_fingerprint_t *fp) {
     rmc_uint8_t *smbios_struct_map = NULL;
     rmc_uint8_t *smbios_struct_start = NULL;
     int ret = 1;
-    int i;
-    int j;
 
     if (!fp)
         return 1;
 
+    /* bootloader could have fingerprinted the board already */
+    if (!read_handoff(RMC_HANDOFF_PATH, fp, values))
+        return 0;
+
     /* get SMBIOS entry address */
 
     if (get_smbios_entry_table_addr(&entry_addr)) {
@@ -271,21 +608,10 @@ int rmc_get_fingerprint(rmc_fingerprint_t *fp) {
         goto err_unmap;
     }
 
-    /* what rsmp returned for a finger's value is on stack. We duplicate them here
-     * before unmap the memory and caller can free them with rmc_free_fingerprint() later
-     * The other fields are hardcoded in initialize_fingerprint(), not in mapped region,
-     * so we don't copy them.
+    /* what rsmp returned for a finger's value is in mapped memory. We copy them here
+     * before unmap the memory.
      */
-    for (i = 0; i < RMC_FINGER_NUM; i++) {
-        fp->rmc_fingers[i].value = strdup(fp->rmc_fingers[i].value);
-        if (!fp->rmc_fingers[i].value) {
-            perror("insufficient memory for obtained fingerprint");
-            for (j = 0; j < i; j++)
-                free(fp->rmc_fingers[j].value);
-            ret = 1;
-            break;
-        }
-    }
+    ret = copy_finger_values(fp, values);
 
 err_unmap:
     if (munmap(smbios_struct_map, struct_map_len) < 0)
@@ -297,6 +623,17 @@ err:
     return ret;
 }
 
+int rmc_get_fingerprint(rmc_fingerprint_t *fp) {
+    return get_board_fingerprint(fp, NULL);
+}
+
+int rmc_get_fingerprint_buf(rmc_fingerprint_buf_t *buf) {
+    if (!buf)
+        return 1;
+
+    return get_board_fingerprint(&buf->fp, buf->values);
+}
+
 int rmc_query_file_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *file_name, rmc_file_t *file) {
     rmc_uint8_t *db = NULL;
     rmc_size_t db_len = 0;
@@ -313,8 +650,10 @@ int rmc_query_file_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *file_na
         return ret;
     }
 
-    /* query policy in database */
-    if(query_policy_from_db(fp, db, RMC_GENERIC_FILE, file_name, file))
+    /* query policy in database, file is read for a single query so that it is
+     * checked on the way instead of being validated as a whole
+     */
+    if (query_policy_from_buffer(fp, db, db_len, RMC_GENERIC_FILE, file_name, file))
         goto free_db;
 
     /* the returned file blob is actually in db memory region,
@@ -336,6 +675,150 @@ free_db:
     return ret;
 }
 
+/* open and map a database file, and query a blob in it. Descriptor is kept
+ * open for blob to be copied from it by offset in kernel. Caller shall unmap
+ * and close database file for success, nothing is left for failures.
+ */
+static int query_blob_in_file(rmc_fingerprint_t *fp, char *db_pathname, char *file_name,
+        int *db_fd, rmc_uint8_t **db, rmc_size_t *db_len, rmc_file_t *file) {
+    struct stat s;
+    rmc_uint8_t *map = MAP_FAILED;
+
+    if ((*db_fd = open(db_pathname, O_RDONLY | O_CLOEXEC)) < 0) {
+        perror("rmc: failed to open database file");
+        return 1;
+    }
+
+    if (fstat(*db_fd, &s) < 0 || s.st_size == 0) {
+        fprintf(stderr, "Failed to read database file\n\n");
+        goto close_db;
+    }
+
+    map = mmap(NULL, s.st_size, PROT_READ, MAP_PRIVATE, *db_fd, 0);
+
+    if (map == MAP_FAILED) {
+        perror("rmc: failed to map database file");
+        goto close_db;
+    }
+
+    if (query_policy_from_buffer(fp, map, s.st_size, RMC_GENERIC_FILE, file_name, file))
+        goto unmap_db;
+
+    *db = map;
+    *db_len = s.st_size;
+
+    return 0;
+
+unmap_db:
+    munmap(map, s.st_size);
+close_db:
+    close(*db_fd);
+    *db_fd = -1;
+
+    return 1;
+}
+
+int rmc_query_fd_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *file_name, int *fd, rmc_size_t *len) {
+    int db_fd = -1;
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    rmc_file_t file;
+    int ret = 1;
+
+    if (!fp || !db_pathname || !file_name || !fd || !len)
+        return ret;
+
+    *fd = -1;
+    *len = 0;
+
+    if (query_blob_in_file(fp, db_pathname, file_name, &db_fd, &db, &db_len, &file))
+        return ret;
+
+    *fd = copy_memfd(file_name, db_fd, file.blob - db, file.blob, file.blob_len);
+
+    if (*fd >= 0) {
+        *len = file.blob_len;
+        ret = 0;
+    }
+
+    munmap(db, db_len);
+    close(db_fd);
+
+    return ret;
+}
+
+int rmc_write_file_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *file_name, int fd, rmc_size_t *len) {
+    int db_fd = -1;
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    rmc_file_t file;
+    int ret = 1;
+
+    if (!fp || !db_pathname || !file_name || fd < 0 || !len)
+        return ret;
+
+    *len = 0;
+
+    if (query_blob_in_file(fp, db_pathname, file_name, &db_fd, &db, &db_len, &file))
+        return ret;
+
+    if (!copy_fd(fd, db_fd, file.blob - db, file.blob, file.blob_len)) {
+        *len = file.blob_len;
+        ret = 0;
+    }
+
+    munmap(db, db_len);
+    close(db_fd);
+
+    return ret;
+}
+
+int rmc_query_file_to_buffer(rmc_fingerprint_t *fp, char *db_pathname, char *file_name,
+        void *buf, rmc_size_t buf_len, rmc_size_t *len) {
+    int db_fd = -1;
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    rmc_file_t file;
+    int ret = 1;
+
+    if (!fp || !db_pathname || !file_name || !len || (!buf && buf_len))
+        return ret;
+
+    *len = 0;
+
+    /* database is mapped instead of read into heap */
+    if (query_blob_in_file(fp, db_pathname, file_name, &db_fd, &db, &db_len, &file))
+        return ret;
+
+    *len = file.blob_len;
+
+    if (file.blob_len <= buf_len) {
+        memcpy(buf, file.blob, file.blob_len);
+        ret = 0;
+    }
+
+    munmap(db, db_len);
+    close(db_fd);
+
+    return ret;
+}
+
+int rmc_gimme_fd(char *db_pathname, char *file_name, int *fd, rmc_size_t *len) {
+    rmc_fingerprint_t fp;
+    int ret = 1;
+
+    if (rmc_get_fingerprint(&fp)) {
+        fprintf(stderr, "-B Failed to generate fingerprint for this board\n\n");
+        return ret;
+    }
+
+    ret = rmc_query_fd_by_fp(&fp, db_pathname, file_name, fd, len);
+
+    rmc_free_fingerprint(&fp);
+
+    return ret;
+}
+
 int rmc_gimme_file(char* db_pathname, char *file_name, rmc_file_t *file) {
     rmc_fingerprint_t fp;
     int ret = 1;
@@ -353,6 +836,207 @@ int rmc_gimme_file(char* db_pathname, char *file_name, rmc_file_t *file) {
     return ret;
 }
 
+int rmc_gimme_file_to_buffer(char *db_pathname, char *file_name, void *buf, rmc_size_t buf_len, rmc_size_t *len) {
+    rmc_fingerprint_buf_t fp;
+
+    if (rmc_get_fingerprint_buf(&fp)) {
+        fprintf(stderr, "-B Failed to generate fingerprint for this board\n\n");
+        return 1;
+    }
+
+    return rmc_query_file_to_buffer(&fp.fp, db_pathname, file_name, buf, buf_len, len);
+}
+
+int rmc_get_board_id(rmc_fingerprint_t *fp, char *db_pathname, rmc_uint32_t *board_id, rmc_uint32_t *board_num) {
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    int ret = 1;
+
+    if (map_file(db_pathname, &db, &db_len))
+        return 1;
+
+    if (validate_rmcdb(db, db_len))
+        fprintf(stderr, "%s is not a valid rmc database\n\n", db_pathname);
+    else
+        ret = query_board_id_from_db(fp, db, board_id, board_num);
+
+    unmap_file(db, db_len);
+
+    return ret;
+}
+
+/* query a blob of a board ID by name, or by name ID when file_name is NULL, and copy it */
+static int query_file_by_ids(char *db_pathname, rmc_uint32_t board_id, char *file_name, rmc_uint32_t name_id,
+        rmc_file_t *file) {
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    rmc_uint8_t *blob = NULL;
+    int ret = 1;
+
+    if (!file || map_file(db_pathname, &db, &db_len))
+        return 1;
+
+    if (validate_rmcdb(db, db_len)) {
+        fprintf(stderr, "%s is not a valid rmc database\n\n", db_pathname);
+        goto unmap_db;
+    }
+
+    if (file_name ? query_policy_by_board_id(db, board_id, RMC_GENERIC_FILE, file_name, file) :
+        query_policy_by_ids(db, board_id, name_id, file))
+        goto unmap_db;
+
+    /* blob references database mapping, copy it for caller */
+    blob = malloc(file->blob_len);
+
+    if (blob) {
+        memcpy(blob, file->blob, file->blob_len);
+        file->blob = blob;
+        ret = 0;
+    } else
+        perror("insufficient memory for the queried file");
+
+unmap_db:
+    unmap_file(db, db_len);
+
+    return ret;
+}
+
+int rmc_query_file_by_board_id(char *db_pathname, rmc_uint32_t board_id, char *file_name, rmc_file_t *file) {
+    if (!file_name)
+        return 1;
+
+    return query_file_by_ids(db_pathname, board_id, file_name, 0, file);
+}
+
+int rmc_get_name_id(char *db_pathname, char *file_name, rmc_uint32_t *name_id, rmc_uint32_t *name_num) {
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    int ret = 1;
+
+    if (map_file(db_pathname, &db, &db_len))
+        return 1;
+
+    if (validate_rmcdb(db, db_len))
+        fprintf(stderr, "%s is not a valid rmc database\n\n", db_pathname);
+    else
+        ret = query_name_id_from_db(db, file_name, name_id, name_num);
+
+    unmap_file(db, db_len);
+
+    return ret;
+}
+
+int rmc_query_file_by_ids(char *db_pathname, rmc_uint32_t board_id, rmc_uint32_t name_id, rmc_file_t *file) {
+    return query_file_by_ids(db_pathname, board_id, NULL, name_id, file);
+}
+
+void rmc_free_file_list(rmc_file_t *files) {
+    rmc_file_t *tmp = NULL;
+
+    while (files) {
+        tmp = files->next;
+        free(files->blob_name);
+        free(files->blob);
+        free(files);
+        files = tmp;
+    }
+}
+
+/* check if a name is already in a list of files */
+static int is_file_in_list(rmc_file_t *files, char *file_name) {
+    while (files) {
+        if (!strcmp(files->blob_name, file_name))
+            return 1;
+        files = files->next;
+    }
+
+    return 0;
+}
+
+int rmc_query_files_by_fp(rmc_fingerprint_t *fp, char *db_pathname, char *pattern, rmc_file_t **files) {
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_match_iter_t iter;
+    rmc_file_t policy;
+    rmc_file_t *file = NULL;
+    rmc_file_t **tail = files;
+    int ret = 1;
+
+    if (!fp || !pattern || !files)
+        return ret;
+
+    *files = NULL;
+
+    if (map_file(db_pathname, &db, &db_len)) {
+        fprintf(stderr, "Failed to read database file\n\n");
+        return ret;
+    }
+
+    if (validate_rmcdb(db, db_len)) {
+        fprintf(stderr, "Invalid database file %s\n\n", db_pathname);
+        goto unmap_db;
+    }
+
+    /* a name in an earlier record hides the same name in later records */
+    while (!query_record_from_db(fp, db, &record_idx)) {
+        init_match_iter(db, record_idx, pattern, &iter);
+
+        while (!next_match_in_record(&iter, &policy)) {
+            if (policy.type != RMC_GENERIC_FILE || is_file_in_list(*files, policy.blob_name))
+                continue;
+
+            file = calloc(1, sizeof(rmc_file_t));
+
+            if (!file)
+                goto free_files;
+
+            *tail = file;
+            tail = &file->next;
+            file->type = policy.type;
+            file->blob_len = policy.blob_len;
+            file->blob_name = strdup(policy.blob_name);
+            /* allocate one byte at least for an empty blob */
+            file->blob = malloc(policy.blob_len ? policy.blob_len : 1);
+
+            if (!file->blob_name || !file->blob)
+                goto free_files;
+
+            memcpy(file->blob, policy.blob, policy.blob_len);
+        }
+    }
+
+    if (*files)
+        ret = 0;
+
+    goto unmap_db;
+
+free_files:
+    perror("insufficient memory for the queried files");
+    rmc_free_file_list(*files);
+    *files = NULL;
+unmap_db:
+    unmap_file(db, db_len);
+
+    return ret;
+}
+
+int rmc_gimme_files(char *db_pathname, char *pattern, rmc_file_t **files) {
+    rmc_fingerprint_t fp;
+    int ret = 1;
+
+    if (rmc_get_fingerprint(&fp)) {
+        fprintf(stderr, "-B Failed to generate fingerprint for this board\n\n");
+        return ret;
+    }
+
+    ret = rmc_query_files_by_fp(&fp, db_pathname, pattern, files);
+
+    rmc_free_fingerprint(&fp);
+
+    return ret;
+}
+
 static char *str2hex(const char *in) {
     int i , len = strlen(in);
     char *out = calloc(2*len+1, sizeof(char));
@@ -389,12 +1073,10 @@ static int mkpath(const char *dir) {
 }
 
 int dump_db(char *db_pathname, char *output_path) {
-    rmc_meta_header_t meta_header;
     rmc_db_header_t *db_header = NULL;
     rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
     rmc_uint64_t record_idx = 0;   /* offset of each reacord in db*/
-    rmc_uint64_t meta_idx = 0;     /* offset of each meta in a record */
-    rmc_uint64_t file_idx = 0;     /* offset of file in a meta */
     rmc_file_t file;
     char *out_dir = NULL, *out_name = NULL, *tmp_dir_name = NULL;
     rmc_size_t db_len = 0;
@@ -444,24 +1126,15 @@ int dump_db(char *db_pathname, char *output_path) {
             return 1;
         }
 
-        /* find meta */
-        for (meta_idx = record_idx + sizeof(rmc_record_header_t);
-            meta_idx < record_idx + record_header.length;) {
-            memcpy(&meta_header, rmc_db + meta_idx, sizeof(rmc_meta_header_t));
-            file_idx = meta_idx + sizeof(rmc_meta_header_t);
-            rmc_ssize_t name_len = strlen((char *)&rmc_db[file_idx]) + 1;
-            file.blob = &rmc_db[file_idx + name_len];
-            file.blob_len = meta_header.length - sizeof(rmc_meta_header_t) -
-                name_len;
-            file.next = NULL;
-            file.type = RMC_GENERIC_FILE;
-            asprintf(&out_name, "%s%s", out_dir, (char *)&rmc_db[file_idx]);
+        /* find meta, names of a version 2 database are resolved by iterator */
+        init_record_iter(rmc_db, record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &file)) {
+            asprintf(&out_name, "%s%s", out_dir, file.blob_name);
             /* write file to dump directory */
             if (write_file((const char *)out_name, file.blob, file.blob_len, 0))
                 return 1;
 
-            /* next meta */
-            meta_idx += meta_header.length;
             free(out_name);
         }
         /* next record */
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Batch query of RMC database files for Linux user space
+ *
+ * A build server needs blobs of many boards from a database. Database is mapped
+ * and validated once, and then a pool of threads, each taking the next board
+ * from a shared counter, looks up records of the board and resolves all names
+ * in them. Results reference the database mapping, nothing is copied.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rmc_api.h>
+#include "workers.h"
+
+typedef struct batch_job {
+    rmc_uint8_t *db;
+    rmc_fingerprint_t *fps;
+    char **names;
+    rmc_batch_report_t *report;
+} batch_job_t;
+
+/* resolve names for a board, blobs in an earlier (more specific) record win */
+static void query_board(void *arg, rmc_uint64_t board) {
+    batch_job_t *job = arg;
+    rmc_file_t *results = &job->report->results[board * job->report->name_num];
+    rmc_file_t policy;
+    rmc_uint64_t record_idx = 0;
+    int left = job->report->name_num;
+    int n;
+
+    while (left && !query_record_from_db(&job->fps[board], job->db, &record_idx)) {
+        for (n = 0; n < job->report->name_num; n++) {
+            if (results[n].blob ||
+                query_policy_from_record(job->db, record_idx, RMC_GENERIC_FILE, job->names[n], &policy))
+                continue;
+
+            results[n].blob = policy.blob;
+            results[n].blob_len = policy.blob_len;
+            left--;
+        }
+    }
+}
+
+int rmc_batch_query(char *db_pathname, rmc_fingerprint_t *fps, int board_num,
+        char **names, int name_num, int thread_num, rmc_batch_report_t *report) {
+    batch_job_t job;
+    int i;
+
+    if (!db_pathname || !fps || board_num <= 0 || !names || name_num <= 0 || !report)
+        return 1;
+
+    memset(report, 0, sizeof(*report));
+
+    if (map_file(db_pathname, &report->db, &report->db_len))
+        return 1;
+
+    if (validate_rmcdb(report->db, report->db_len)) {
+        fprintf(stderr, "%s is not a valid rmc database\n", db_pathname);
+        goto err;
+    }
+
+    report->board_num = board_num;
+    report->name_num = name_num;
+    report->results = calloc((rmc_size_t)board_num * name_num, sizeof(rmc_file_t));
+
+    if (!report->results) {
+        perror("rmc: insufficient memory for batch query");
+        goto err;
+    }
+
+    for (i = 0; i < board_num * name_num; i++) {
+        report->results[i].type = RMC_GENERIC_FILE;
+        report->results[i].blob_name = names[i % name_num];
+    }
+
+    job.db = report->db;
+    job.fps = fps;
+    job.names = names;
+    job.report = report;
+
+    if (run_workers(query_board, &job, thread_num, board_num)) {
+        perror("rmc: insufficient memory for batch query");
+        goto err;
+    }
+
+    for (i = 0; i < board_num * name_num; i++) {
+        if (!report->results[i].blob)
+            report->missing_num++;
+    }
+
+    return 0;
+
+err:
+    free(report->results);
+    unmap_file(report->db, report->db_len);
+    memset(report, 0, sizeof(*report));
+
+    return 1;
+}
+
+void rmc_free_batch_report(rmc_batch_report_t *report) {
+    if (!report)
+        return;
+
+    free(report->results);
+    unmap_file(report->db, report->db_len);
+    memset(report, 0, sizeof(*report));
+}
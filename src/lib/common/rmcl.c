@@ -33,6 +33,219 @@
 #endif
 
 static const rmc_uint8_t rmc_db_signature[RMC_DB_SIG_LEN] = {'R', 'M', 'C', 'D', 'B'};
+static const rmc_uint8_t rmc_ext_signature[RMC_EXT_SIG_LEN] = {'R', 'M', 'C', 'E', 'X'};
+static const rmc_uint8_t rmc_handoff_signature[RMC_HANDOFF_SIG_LEN] = {'R', 'M', 'C', 'H', 'O'};
+
+/* compare two null-terminated names byte by byte as unsigned values, so that
+ * results are same in all contexts.
+ * return: negative, 0 or positive like strcmp()
+ */
+static int compare_names(const rmc_uint8_t *a, const rmc_uint8_t *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+
+    return *a - *b;
+}
+
+/* compare signatures in the same way match_record() does, so that sorted
+ * signatures are found for the same records as scanning does.
+ */
+static int compare_signatures(const rmc_signature_t *a, const rmc_signature_t *b) {
+    return strncmp((const char *)a->raw, (const char *)b->raw, sizeof(a->raw));
+}
+
+/* order of slots in a table of section RMC_SECTION_NAMES */
+static int compare_name_slot(const void *a, const void *b) {
+    const rmc_name_slot_t *x = a;
+    const rmc_name_slot_t *y = b;
+
+    if (x->name_id != y->name_id)
+        return x->name_id < y->name_id ? -1 : 1;
+
+    return (x->meta_idx > y->meta_idx) - (x->meta_idx < y->meta_idx);
+}
+
+/*
+ * get section RMC_SECTION_NAMES of a database
+ * (out) header     : header of section
+ *
+ * return: start of section, or NULL when database has none
+ */
+static rmc_uint8_t *get_names(rmc_uint8_t *rmc_db, rmc_names_header_t *header) {
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+
+    if (query_section_from_db(rmc_db, RMC_SECTION_NAMES, &section_idx, &section_len))
+        return NULL;
+
+    memcpy(header, rmc_db + section_idx, sizeof(rmc_names_header_t));
+
+    return rmc_db + section_idx;
+}
+
+/* return: ID of blob name in section RMC_SECTION_NAMES, or RMC_NAME_NONE if not found */
+static rmc_uint32_t find_name_id(rmc_uint8_t *section, rmc_names_header_t *header, const char *blob_name) {
+    rmc_uint64_t offset = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+
+    for (low = 0, high = header->name_num; low < high;) {
+        mid = low + (high - low) / 2;
+        memcpy(&offset, section + header->name_idx + mid * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+        if (compare_names(section + header->string_idx + offset, (const rmc_uint8_t *)blob_name) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == header->name_num)
+        return RMC_NAME_NONE;
+
+    memcpy(&offset, section + header->name_idx + low * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+    if (compare_names(section + header->string_idx + offset, (const rmc_uint8_t *)blob_name))
+        return RMC_NAME_NONE;
+
+    return (rmc_uint32_t)low;
+}
+
+/* return: name of an ID in section RMC_SECTION_NAMES */
+static char *get_name_by_id(rmc_uint8_t *section, rmc_uint32_t name_id) {
+    rmc_names_header_t header;
+    rmc_uint64_t offset = 0;
+
+    memcpy(&header, section, sizeof(rmc_names_header_t));
+    memcpy(&offset, section + header.name_idx + name_id * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+    return (char *)section + header.string_idx + offset;
+}
+
+/* return: section RMC_SECTION_NAMES resolving name IDs of metas, or NULL for version 1 */
+static rmc_uint8_t *get_meta_names(rmc_uint8_t *rmc_db) {
+    rmc_names_header_t header;
+
+    if (((rmc_db_header_t *)rmc_db)->version < RMC_DB_VERSION_2)
+        return NULL;
+
+    return get_names(rmc_db, &header);
+}
+
+/*
+ * find the entry of a record in section RMC_SECTION_NAMES
+ * (out) entry      : entry of record, its table has name slots of record in the order of names
+ *
+ * return: 0 when record has an entry, non-zero otherwise
+ */
+static int find_name_entry(rmc_uint8_t *section, rmc_names_header_t *header, rmc_uint64_t record_idx,
+        rmc_name_index_t *entry) {
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+
+    /* entries are in the order of records */
+    for (low = 0, high = header->record_num; low < high;) {
+        mid = low + (high - low) / 2;
+        memcpy(entry, section + header->record_idx + mid * sizeof(rmc_name_index_t), sizeof(rmc_name_index_t));
+
+        if (entry->record_idx == record_idx)
+            return 0;
+        else if (entry->record_idx < record_idx)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return 1;
+}
+
+/* return: position of the first slot in table of an entry with name ID not less than name_id */
+static rmc_uint64_t lower_bound_slot(rmc_uint8_t *section, rmc_name_index_t *entry, rmc_uint32_t name_id) {
+    rmc_name_slot_t slot;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+
+    for (low = 0, high = entry->meta_num; low < high;) {
+        mid = low + (high - low) / 2;
+        memcpy(&slot, section + entry->table_idx + mid * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+        if (slot.name_id < name_id)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/*
+ * find the first meta of a record with a name ID in section RMC_SECTION_NAMES
+ * return: offset of meta, or 0 when record has no blob with the name
+ */
+static rmc_uint64_t find_meta_by_name_id(rmc_uint8_t *section, rmc_names_header_t *header,
+        rmc_uint64_t record_idx, rmc_uint32_t name_id) {
+    rmc_name_index_t entry;
+    rmc_name_slot_t slot;
+    rmc_uint64_t pos = 0;
+
+    if (find_name_entry(section, header, record_idx, &entry))
+        return 0;
+
+    if ((pos = lower_bound_slot(section, &entry, name_id)) == entry.meta_num)
+        return 0;
+
+    memcpy(&slot, section + entry.table_idx + pos * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+    return slot.name_id == name_id ? slot.meta_idx : 0;
+}
+
+/* rank of records matching a board by fingers they match, a record matching
+ * more fingers is more specific, and then one matching an earlier finger.
+ * return: a bigger value for a more specific record
+ */
+static rmc_uint32_t finger_priority(rmc_uint8_t finger_mask) {
+    rmc_uint32_t count = 0;
+    rmc_uint32_t order = 0;
+    int i;
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        order <<= 1;
+
+        if (finger_mask & RMC_FINGER_BIT(i)) {
+            order |= 1;
+            count++;
+        }
+    }
+
+    return count << RMC_FINGER_NUM | order;
+}
+
+rmc_uint64_t rmcl_static_hash(rmc_uint32_t seed, const rmc_signature_t *signature, const char *blob_name) {
+    rmc_uint64_t h = 0xcbf29ce484222325ULL ^ seed;   /* FNV-1a */
+    rmc_size_t i;
+
+    for (i = 0; i < sizeof(signature->raw) && signature->raw[i]; i++)
+        h = (h ^ signature->raw[i]) * 0x100000001b3ULL;
+
+    /* separator, so that keys can't move bytes between signature and name */
+    h *= 0x100000001b3ULL;
+
+    for (; *blob_name; blob_name++)
+        h = (h ^ (rmc_uint8_t)*blob_name) * 0x100000001b3ULL;
+
+    /* finalizer of splitmix64, FNV alone leaves high bits poorly mixed */
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+
+    return h;
+}
 
 /* compute a finger to signature which is stored in record
  * (in) fingerprint : of board, usually generated by rmc tool and rsmp
@@ -150,6 +363,54 @@ int rmcl_generate_record(rmc_fingerprint_t *fingerprint, rmc_file_t *policy_file
     return 0;
 }
 
+int rmcl_generate_pattern_record(rmc_fingerprint_t *fingerprint, rmc_uint8_t finger_mask,
+        rmc_file_t *policy_files, rmc_record_file_t *record_file) {
+    rmc_fingerprint_t masked;
+    rmc_file_t match;
+    rmc_size_t match_len = 1;
+    rmc_uint8_t *p = NULL;
+    int i;
+    int ret = 1;
+
+    if (!fingerprint || !finger_mask || finger_mask >= RMC_FINGER_BIT(RMC_FINGER_NUM))
+        return 1;
+
+    /* signature of a pattern record is computed with fingers in mask, it is only
+     * for readers knowing nothing about pattern records, and not used for matching
+     */
+    masked = *fingerprint;
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if (finger_mask & RMC_FINGER_BIT(i))
+            match_len += strlen(fingerprint->rmc_fingers[i].value) + 1;
+        else
+            masked.rmc_fingers[i].value = "";
+    }
+
+    match.type = RMC_MATCH_FILE;
+    match.blob_name = RMC_MATCH_NAME;
+    match.blob_len = match_len;
+    match.blob = p = malloc(match_len);
+    match.next = policy_files;
+
+    if (!p)
+        return 1;
+
+    *p++ = finger_mask;
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if (finger_mask & RMC_FINGER_BIT(i)) {
+            strcpy((char *)p, fingerprint->rmc_fingers[i].value);
+            p += strlen(fingerprint->rmc_fingers[i].value) + 1;
+        }
+    }
+
+    ret = rmcl_generate_record(&masked, &match, record_file);
+    free(match.blob);
+
+    return ret;
+}
+
 int rmcl_generate_db(rmc_record_file_t *record_files, rmc_uint8_t **rmc_db, rmc_size_t *len) {
 
     rmc_record_file_t *tmp = NULL;
@@ -184,7 +445,7 @@ int rmcl_generate_db(rmc_record_file_t *record_files, rmc_uint8_t **rmc_db, rmc_
     for (i = 0; i < RMC_DB_SIG_LEN; i++)
         db->signature[i] = rmc_db_signature[i];
 
-    db->version = 0x1;
+    db->version = RMC_DB_VERSION_1;
 
     db->length = db_len;
     idx = (rmc_uint8_t *)db;
@@ -205,91 +466,3253 @@ int rmcl_generate_db(rmc_record_file_t *record_files, rmc_uint8_t **rmc_db, rmc_
     return 0;
 }
 
-#endif /* RMC_EFI */
+/* a section to be packed into extensions of a database */
+typedef struct ext_section {
+    rmc_uint32_t type;
+    rmc_uint8_t *data;
+    rmc_uint64_t length;
+} ext_section_t;
+
+typedef struct named_meta {
+    const rmc_uint8_t *name;
+    rmc_uint64_t meta_idx;
+} named_meta_t;
+
+static int compare_named_meta(const void *a, const void *b) {
+    return compare_names(((const named_meta_t *)a)->name, ((const named_meta_t *)b)->name);
+}
+
 /*
- * Check if a record has signature matched with a given signature
+ * pack sections into an extension area following records of a database
+ * (in) ext_idx     : offset of extension area in database, length of records
+ * (in) sections    : sections to pack
+ * (in) num         : number of sections
+ * (out) ext        : extension area (allocated)
+ * (out) ext_len    : length of extension area
  *
- * return 0 if record has matched signature or non-zero in other cases
+ * return: 0 for success, non-zero for failures.
  */
-static int match_record(rmc_record_header_t *r, rmc_signature_t* sig) {
-    return strncmp((const char *)r->signature.raw, (const char *)sig->raw, sizeof(r->signature.raw));
-}
+static int pack_extensions(rmc_uint64_t ext_idx, ext_section_t *sections, rmc_uint32_t num,
+        rmc_uint8_t **ext, rmc_size_t *ext_len) {
+    rmc_ext_header_t ext_header;
+    rmc_section_header_t section_header;
+    rmc_uint64_t len = sizeof(rmc_ext_header_t) + num * sizeof(rmc_section_header_t);
+    rmc_uint64_t data_idx = 0;
+    rmc_uint8_t *p = NULL;
+    rmc_uint32_t i;
+    int j;
 
-int is_rmcdb(rmc_uint8_t *db_blob) {
-    rmc_db_header_t *db_header = NULL;
+    for (i = 0; i < num; i++)
+        len += sections[i].length;
 
-    if (db_blob == NULL)
+    p = malloc(len);
+
+    if (!p)
         return 1;
 
-    db_header = (rmc_db_header_t *)db_blob;
+    for (j = 0; j < RMC_EXT_SIG_LEN; j++)
+        ext_header.signature[j] = rmc_ext_signature[j];
 
-    /* sanity check of db */
-    if (strncmp((const char *)db_header->signature, (const char *)rmc_db_signature, RMC_DB_SIG_LEN))
-        return 1;
-    else
+    ext_header.reserved = 0;
+    ext_header.section_num = num;
+    ext_header.length = len;
+    memcpy(p, &ext_header, sizeof(rmc_ext_header_t));
+
+    data_idx = sizeof(rmc_ext_header_t) + num * sizeof(rmc_section_header_t);
+
+    for (i = 0; i < num; i++) {
+        section_header.type = sections[i].type;
+        section_header.offset = ext_idx + data_idx;
+        section_header.length = sections[i].length;
+        memcpy(p + sizeof(rmc_ext_header_t) + i * sizeof(rmc_section_header_t),
+            &section_header, sizeof(rmc_section_header_t));
+        memcpy(p + data_idx, sections[i].data, sections[i].length);
+        data_idx += sections[i].length;
+    }
+
+    *ext = p;
+    *ext_len = len;
+
+    return 0;
+}
+
+/* growable buffer for building a section */
+typedef struct build_buf {
+    rmc_uint8_t *data;
+    rmc_uint64_t len;
+    rmc_uint64_t size;
+} build_buf_t;
+
+/*
+ * append data to a buffer
+ * return: 0 for success, non-zero for failures
+ */
+static int buf_append(build_buf_t *buf, const void *data, rmc_uint64_t len) {
+    rmc_uint8_t *tmp = NULL;
+    rmc_uint64_t size = buf->size ? buf->size : 256;
+
+    while (size < buf->len + len)
+        size *= 2;
+
+    if (size != buf->size) {
+        if ((tmp = realloc(buf->data, size)) == NULL)
+            return 1;
+        buf->data = tmp;
+        buf->size = size;
+    }
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+
+    return 0;
+}
+
+/* a pattern record to be compiled into trie */
+typedef struct trie_pattern {
+    rmc_uint64_t record_idx;
+    rmc_uint8_t finger_mask;
+    const char *values[RMC_FINGER_NUM];   /* referencing database */
+} trie_pattern_t;
+
+typedef struct trie_build {
+    build_buf_t nodes;
+    build_buf_t items;
+    build_buf_t strings;
+} trie_build_t;
+
+/* values of a finger are sorted by themselves, qsort() has no context for a level */
+static int compare_finger_value(const void *a, const void *b) {
+    return compare_names(*(const rmc_uint8_t * const *)a, *(const rmc_uint8_t * const *)b);
+}
+
+static int compare_pattern_priority(const void *a, const void *b) {
+    const trie_pattern_t *x = *(trie_pattern_t * const *)a;
+    const trie_pattern_t *y = *(trie_pattern_t * const *)b;
+    rmc_uint32_t px = finger_priority(x->finger_mask);
+    rmc_uint32_t py = finger_priority(y->finger_mask);
+
+    if (px != py)
+        return px > py ? -1 : 1;
+
+    return (x->record_idx > y->record_idx) - (x->record_idx < y->record_idx);
+}
+
+/*
+ * compile patterns into a sub-trie at a level
+ * (in) patterns    : patterns of boards reaching this node
+ * (in) num         : number of patterns
+ * (out) node_id    : index of node, RMC_TRIE_NONE when num is 0
+ *
+ * return: 0 for success, non-zero for failures
+ */
+static int build_trie_node(trie_build_t *build, rmc_uint8_t level, trie_pattern_t **patterns,
+        rmc_uint64_t num, rmc_uint32_t *node_id) {
+    rmc_trie_node_t node;
+    rmc_trie_edge_t edge;
+    rmc_trie_record_t record;
+    const char **sorted = NULL;
+    trie_pattern_t **subset = NULL;
+    rmc_uint32_t *children = NULL;
+    rmc_uint32_t wildcard = RMC_TRIE_NONE;
+    rmc_uint64_t sorted_num = 0;
+    rmc_uint64_t subset_num = 0;
+    rmc_uint64_t value_num = 0;
+    rmc_uint64_t i, j, k;
+    int ret = 1;
+
+    *node_id = RMC_TRIE_NONE;
+
+    if (!num)
         return 0;
+
+    /* reserve node, children are appended after it */
+    *node_id = build->nodes.len / sizeof(rmc_trie_node_t);
+    memset(&node, 0, sizeof(node));
+    node.level = level;
+    node.wildcard = RMC_TRIE_NONE;
+
+    if (buf_append(&build->nodes, &node, sizeof(node)))
+        return 1;
+
+    sorted = malloc(num * sizeof(const char *));
+    subset = malloc(num * sizeof(trie_pattern_t *));
+    children = malloc(num * sizeof(rmc_uint32_t));
+
+    if (!sorted || !subset || !children)
+        goto out;
+
+    if (level == RMC_FINGER_NUM) {
+        memcpy(subset, patterns, num * sizeof(trie_pattern_t *));
+        qsort(subset, num, sizeof(trie_pattern_t *), compare_pattern_priority);
+        node.items_idx = build->items.len;
+        node.item_num = num;
+
+        for (i = 0; i < num; i++) {
+            record.record_idx = subset[i]->record_idx;
+            record.finger_mask = subset[i]->finger_mask;
+            if (buf_append(&build->items, &record, sizeof(record)))
+                goto out;
+        }
+
+        memcpy(build->nodes.data + *node_id * sizeof(rmc_trie_node_t), &node, sizeof(node));
+        ret = 0;
+        goto out;
+    }
+
+    /* values of patterns caring this finger, sorted */
+    for (i = 0; i < num; i++) {
+        if (patterns[i]->finger_mask & RMC_FINGER_BIT(level))
+            sorted[sorted_num++] = patterns[i]->values[level];
+    }
+
+    qsort(sorted, sorted_num, sizeof(const char *), compare_finger_value);
+
+    /* a child for each value with patterns of the value and ones not caring the finger */
+    for (i = 0; i < sorted_num; i = j) {
+        for (j = i; j < sorted_num && !compare_names((const rmc_uint8_t *)sorted[i],
+            (const rmc_uint8_t *)sorted[j]); j++)
+            ;
+
+        subset_num = 0;
+
+        for (k = 0; k < num; k++) {
+            if (!(patterns[k]->finger_mask & RMC_FINGER_BIT(level)) ||
+                !compare_names((const rmc_uint8_t *)patterns[k]->values[level],
+                    (const rmc_uint8_t *)sorted[i]))
+                subset[subset_num++] = patterns[k];
+        }
+
+        if (build_trie_node(build, level + 1, subset, subset_num, &children[value_num]))
+            goto out;
+
+        sorted[value_num++] = sorted[i];
+    }
+
+    subset_num = 0;
+
+    for (k = 0; k < num; k++) {
+        if (!(patterns[k]->finger_mask & RMC_FINGER_BIT(level)))
+            subset[subset_num++] = patterns[k];
+    }
+
+    if (build_trie_node(build, level + 1, subset, subset_num, &wildcard))
+        goto out;
+
+    node.wildcard = wildcard;
+
+    node.items_idx = build->items.len;
+    node.item_num = value_num;
+
+    for (i = 0; i < value_num; i++) {
+        edge.value_idx = build->strings.len;
+        edge.child = children[i];
+
+        if (buf_append(&build->strings, sorted[i], strlen(sorted[i]) + 1) ||
+            buf_append(&build->items, &edge, sizeof(edge)))
+            goto out;
+    }
+
+    memcpy(build->nodes.data + *node_id * sizeof(rmc_trie_node_t), &node, sizeof(node));
+    ret = 0;
+out:
+    free(sorted);
+    free(subset);
+    free(children);
+
+    return ret;
 }
 
-int query_policy_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_uint8_t type, char *blob_name, rmc_file_t *policy) {
-    rmc_meta_header_t meta_header;
-    rmc_db_header_t *db_header = NULL;
+static int compare_sig_entry(const void *a, const void *b) {
+    const rmc_sig_entry_t *x = a;
+    const rmc_sig_entry_t *y = b;
+    int ret = compare_signatures(&x->signature, &y->signature);
+
+    if (ret)
+        return ret;
+
+    return (x->record_idx > y->record_idx) - (x->record_idx < y->record_idx);
+}
+
+/*
+ * get match rule of a pattern record
+ * return: 0 when record is a pattern record, non-zero otherwise
+ */
+static int get_pattern(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx, trie_pattern_t *pattern) {
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    const char *value = NULL;
+    const char *end = NULL;
+    int i;
+
+    init_record_iter(rmc_db, record_idx, &iter);
+
+    while (!next_policy_in_record(&iter, &policy)) {
+        if (policy.type != RMC_MATCH_FILE || policy.blob_len < 1)
+            continue;
+
+        pattern->record_idx = record_idx;
+        pattern->finger_mask = policy.blob[0];
+        value = (const char *)policy.blob + 1;
+        end = (const char *)policy.blob + policy.blob_len;
+
+        for (i = 0; i < RMC_FINGER_NUM; i++) {
+            pattern->values[i] = "";
+
+            if (!(pattern->finger_mask & RMC_FINGER_BIT(i)))
+                continue;
+
+            if (value >= end || memchr(value, '\0', end - value) == NULL)
+                return 1;
+
+            pattern->values[i] = value;
+            value += strlen(value) + 1;
+        }
+
+        return !pattern->finger_mask || pattern->finger_mask >= RMC_FINGER_BIT(RMC_FINGER_NUM);
+    }
+
+    return 1;
+}
+
+/* build section RMC_SECTION_TRIE for a well-formed database */
+static int build_trie(rmc_uint8_t *rmc_db, ext_section_t *section) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
     rmc_record_header_t record_header;
-    rmc_signature_t signature;
-    rmc_uint64_t record_idx = 0;   /* offset of each reacord in db*/
-    rmc_uint64_t meta_idx = 0;     /* offset of each meta in a record */
-    rmc_uint64_t policy_idx = 0;   /* offset of policy in a meta */
+    rmc_trie_header_t trie_header;
+    trie_build_t build;
+    build_buf_t sigs;
+    rmc_sig_entry_t sig;
+    trie_pattern_t *patterns = NULL;
+    trie_pattern_t **pattern_ptrs = NULL;
+    rmc_uint64_t pattern_num = 0;
+    rmc_uint64_t record_num = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint32_t root;
+    int ret = 1;
 
-    if (!fingerprint || !rmc_db || !policy)
-        return 1;
+    memset(&build, 0, sizeof(build));
+    memset(&sigs, 0, sizeof(sigs));
+    section->data = NULL;
 
-    if (type != RMC_GENERIC_FILE || blob_name == NULL)
-        return 1;
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        record_num++;
+    }
 
-    db_header = (rmc_db_header_t *)rmc_db;
+    patterns = malloc((record_num ? record_num : 1) * sizeof(trie_pattern_t));
+    pattern_ptrs = malloc((record_num ? record_num : 1) * sizeof(trie_pattern_t *));
 
-    /* sanity check of db */
-    if (is_rmcdb(rmc_db))
-        return 1;
+    if (!patterns || !pattern_ptrs)
+        goto out;
 
-    /* calculate signature of fingerprint */
-    if(generate_signature_from_fingerprint(fingerprint, &signature))
-        return 1;
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
 
-    /* query the meta. idx: start of record */
-    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;) {
-        /* record data may not be aligned like db pointer does
-         * We align record header by copying
-         */
+        if (!get_pattern(rmc_db, record_idx, &patterns[pattern_num])) {
+            pattern_ptrs[pattern_num] = &patterns[pattern_num];
+            pattern_num++;
+            continue;
+        }
+
+        sig.signature = record_header.signature;
+        sig.record_idx = record_idx;
+
+        if (buf_append(&sigs, &sig, sizeof(sig)))
+            goto out;
+    }
+
+    if (sigs.len)
+        qsort(sigs.data, sigs.len / sizeof(rmc_sig_entry_t), sizeof(rmc_sig_entry_t), compare_sig_entry);
+
+    if (build_trie_node(&build, 0, pattern_ptrs, pattern_num, &root))
+        goto out;
+
+    trie_header.sig_num = sigs.len / sizeof(rmc_sig_entry_t);
+    trie_header.sig_idx = sizeof(rmc_trie_header_t);
+    trie_header.node_num = build.nodes.len / sizeof(rmc_trie_node_t);
+    trie_header.node_idx = trie_header.sig_idx + sigs.len;
+    trie_header.item_idx = trie_header.node_idx + build.nodes.len;
+    trie_header.item_len = build.items.len;
+    trie_header.string_idx = trie_header.item_idx + build.items.len;
+    trie_header.string_len = build.strings.len;
+
+    section->type = RMC_SECTION_TRIE;
+    section->length = trie_header.string_idx + build.strings.len;
+    section->data = malloc(section->length);
+
+    if (!section->data)
+        goto out;
+
+    memcpy(section->data, &trie_header, sizeof(trie_header));
+
+    /* empty buffers have NULL data */
+    if (sigs.len)
+        memcpy(section->data + trie_header.sig_idx, sigs.data, sigs.len);
+
+    if (build.nodes.len) {
+        memcpy(section->data + trie_header.node_idx, build.nodes.data, build.nodes.len);
+        memcpy(section->data + trie_header.item_idx, build.items.data, build.items.len);
+    }
+
+    if (build.strings.len)
+        memcpy(section->data + trie_header.string_idx, build.strings.data, build.strings.len);
+
+    ret = 0;
+out:
+    free(patterns);
+    free(pattern_ptrs);
+    free(sigs.data);
+    free(build.nodes.data);
+    free(build.items.data);
+    free(build.strings.data);
+
+    return ret;
+}
+
+/* build section RMC_SECTION_BOARD for a well-formed database */
+static int build_boards(rmc_uint8_t *rmc_db, ext_section_t *section) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
+    rmc_record_header_t record_header;
+    rmc_board_header_t board_header;
+    trie_pattern_t pattern;
+    build_buf_t sigs;
+    rmc_sig_entry_t sig;
+    rmc_sig_entry_t *entries = NULL;
+    rmc_uint64_t entry_num = 0;
+    rmc_uint64_t board_num = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t i;
+    int ret = 1;
+
+    memset(&sigs, 0, sizeof(sigs));
+    section->data = NULL;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
         memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
 
-        /* found matched record */
-        if (!match_record(&record_header, &signature)) {
-            /* find meta by type and name */
-            for (meta_idx = record_idx + sizeof(rmc_record_header_t); meta_idx < record_idx + record_header.length;) {
-                 /* re-align meta header struct by copying*/
-                memcpy(&meta_header, rmc_db + meta_idx, sizeof(rmc_meta_header_t));
+        if (!get_pattern(rmc_db, record_idx, &pattern))
+            continue;
 
-                if (meta_header.type == type) {
+        sig.signature = record_header.signature;
+        sig.record_idx = record_idx;
 
-                    policy_idx = meta_idx + sizeof(rmc_meta_header_t);
+        if (buf_append(&sigs, &sig, sizeof(sig)))
+            goto out;
+    }
 
-                    if (!strncmp(blob_name, (char *)&rmc_db[policy_idx], strlen(blob_name) + 1)) {
-                        rmc_ssize_t cmd_name_len = strlen((char *)&rmc_db[policy_idx]) + 1;
-                        policy->blob = &rmc_db[policy_idx + cmd_name_len];
-                        policy->blob_len = meta_header.length - sizeof(rmc_meta_header_t) - cmd_name_len;
-                        policy->next = NULL;
-                        policy->type = type;
+    entries = (rmc_sig_entry_t *)sigs.data;
+    entry_num = sigs.len / sizeof(rmc_sig_entry_t);
 
-                        return 0;
-                    }
-                }
+    /* records of a board are adjacent and in the order of database after sorting */
+    if (entry_num)
+        qsort(entries, entry_num, sizeof(rmc_sig_entry_t), compare_sig_entry);
+
+    for (i = 0; i < entry_num; i++) {
+        if (!i || compare_signatures(&entries[i - 1].signature, &entries[i].signature))
+            board_num++;
+    }
+
+    if (board_num > RMC_BOARD_NONE)
+        goto out;
+
+    board_header.board_num = board_num;
+    board_header.sig_idx = sizeof(rmc_board_header_t);
+    board_header.first_idx = board_header.sig_idx + board_num * sizeof(rmc_signature_t);
+    board_header.record_num = entry_num;
+    board_header.record_idx = board_header.first_idx + (board_num + 1) * sizeof(rmc_uint64_t);
 
-                meta_idx += meta_header.length;
-            } /* traverse in record */
+    section->type = RMC_SECTION_BOARD;
+    section->length = board_header.record_idx + entry_num * sizeof(rmc_uint64_t);
+    section->data = malloc(section->length);
+
+    if (!section->data)
+        goto out;
+
+    memcpy(section->data, &board_header, sizeof(rmc_board_header_t));
+
+    for (i = 0, board_num = 0; i < entry_num; i++) {
+        if (!i || compare_signatures(&entries[i - 1].signature, &entries[i].signature)) {
+            memcpy(section->data + board_header.sig_idx + board_num * sizeof(rmc_signature_t),
+                &entries[i].signature, sizeof(rmc_signature_t));
+            memcpy(section->data + board_header.first_idx + board_num * sizeof(rmc_uint64_t),
+                &i, sizeof(rmc_uint64_t));
+            board_num++;
         }
 
-        record_idx += record_header.length;
-    } /* traverse in db */
+        memcpy(section->data + board_header.record_idx + i * sizeof(rmc_uint64_t),
+            &entries[i].record_idx, sizeof(rmc_uint64_t));
+    }
 
-    return 1;
+    memcpy(section->data + board_header.first_idx + board_num * sizeof(rmc_uint64_t),
+        &entry_num, sizeof(rmc_uint64_t));
+    ret = 0;
+out:
+    free(sigs.data);
+
+    return ret;
+}
+
+/* build section RMC_SECTION_NAMES for a well-formed database */
+static int build_names(rmc_uint8_t *rmc_db, ext_section_t *section) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
+    rmc_record_header_t record_header;
+    rmc_names_header_t names_header;
+    rmc_name_index_t entry;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    build_buf_t names;
+    build_buf_t strings;
+    build_buf_t entries;
+    named_meta_t *metas = NULL;
+    rmc_name_slot_t *slots = NULL;
+    rmc_uint64_t meta_num = 0;
+    rmc_uint64_t name_num = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint64_t offset = 0;
+    rmc_uint64_t slot_idx = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    rmc_uint64_t i = 0;
+    int ret = 1;
+
+    memset(&names, 0, sizeof(names));
+    memset(&strings, 0, sizeof(strings));
+    memset(&entries, 0, sizeof(entries));
+    section->data = NULL;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(rmc_db, record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &policy)) {
+            if (policy.type == RMC_GENERIC_FILE)
+                meta_num++;
+        }
+    }
+
+    metas = malloc((meta_num ? meta_num : 1) * sizeof(named_meta_t));
+    slots = malloc((meta_num ? meta_num : 1) * sizeof(rmc_name_slot_t));
+
+    if (!metas || !slots)
+        goto out;
+
+    /* slots are in the order of metas in database, grouped by record */
+    meta_num = 0;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(rmc_db, record_idx, &iter);
+
+        for (meta_idx = iter.meta_idx; !next_policy_in_record(&iter, &policy); meta_idx = iter.meta_idx) {
+            if (policy.type != RMC_GENERIC_FILE)
+                continue;
+
+            metas[meta_num].name = (rmc_uint8_t *)policy.blob_name;
+            metas[meta_num].meta_idx = meta_idx;
+            slots[meta_num].meta_idx = meta_idx;
+            meta_num++;
+        }
+    }
+
+    /* intern names in sorted order */
+    if (meta_num)
+        qsort(metas, meta_num, sizeof(named_meta_t), compare_named_meta);
+
+    for (i = 0; i < meta_num; i++) {
+        if (!i || compare_names(metas[i - 1].name, metas[i].name)) {
+            offset = strings.len;
+
+            if (buf_append(&names, &offset, sizeof(rmc_uint64_t)) ||
+                buf_append(&strings, metas[i].name, strlen((const char *)metas[i].name) + 1))
+                goto out;
+
+            name_num++;
+        }
+
+        /* slots are still in the order of metas */
+        for (low = 0, high = meta_num; low < high;) {
+            mid = low + (high - low) / 2;
+
+            if (slots[mid].meta_idx < metas[i].meta_idx)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        slots[low].name_id = (rmc_uint32_t)(name_num - 1);
+    }
+
+    if (name_num > RMC_NAME_NONE)
+        goto out;
+
+    names_header.name_num = name_num;
+    names_header.name_idx = sizeof(rmc_names_header_t);
+    names_header.string_idx = names_header.name_idx + names.len;
+    names_header.string_len = strings.len;
+    names_header.record_num = 0;
+    names_header.record_idx = names_header.string_idx + strings.len;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        names_header.record_num++;
+    }
+
+    /* tables of records follow their entries */
+    offset = names_header.record_idx + names_header.record_num * sizeof(rmc_name_index_t);
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+
+        for (i = slot_idx; i < meta_num && slots[i].meta_idx < record_idx + record_header.length; i++)
+            ;
+
+        if (i > slot_idx)
+            qsort(slots + slot_idx, i - slot_idx, sizeof(rmc_name_slot_t), compare_name_slot);
+
+        entry.record_idx = record_idx;
+        entry.table_idx = offset + slot_idx * sizeof(rmc_name_slot_t);
+        entry.meta_num = i - slot_idx;
+        slot_idx = i;
+
+        if (buf_append(&entries, &entry, sizeof(entry)))
+            goto out;
+    }
+
+    section->type = RMC_SECTION_NAMES;
+    section->length = offset + meta_num * sizeof(rmc_name_slot_t);
+    section->data = malloc(section->length);
+
+    if (!section->data)
+        goto out;
+
+    memcpy(section->data, &names_header, sizeof(rmc_names_header_t));
+
+    /* empty buffers have NULL data */
+    if (name_num) {
+        memcpy(section->data + names_header.name_idx, names.data, names.len);
+        memcpy(section->data + names_header.string_idx, strings.data, strings.len);
+    }
+
+    if (entries.len)
+        memcpy(section->data + names_header.record_idx, entries.data, entries.len);
+
+    if (meta_num)
+        memcpy(section->data + offset, slots, meta_num * sizeof(rmc_name_slot_t));
+
+    ret = 0;
+out:
+    free(metas);
+    free(slots);
+    free(names.data);
+    free(strings.data);
+    free(entries.data);
+
+    return ret;
+}
+
+/* build section RMC_SECTION_POSTINGS with section RMC_SECTION_NAMES of the same database */
+static int build_postings(ext_section_t *names, ext_section_t *section) {
+    rmc_names_header_t names_header;
+    rmc_postings_header_t header;
+    rmc_name_index_t entry;
+    rmc_name_slot_t slot;
+    rmc_posting_t posting;
+    rmc_uint64_t *first = NULL;
+    rmc_uint32_t last_id = 0;
+    rmc_uint64_t i, j;
+
+    section->data = NULL;
+    memcpy(&names_header, names->data, sizeof(rmc_names_header_t));
+
+    first = calloc(names_header.name_num + 1, sizeof(rmc_uint64_t));
+
+    if (!first)
+        return 1;
+
+    /* count records of each name, slots of a record are sorted by name ID */
+    for (i = 0; i < names_header.record_num; i++) {
+        memcpy(&entry, names->data + names_header.record_idx + i * sizeof(rmc_name_index_t),
+            sizeof(rmc_name_index_t));
+
+        for (j = 0; j < entry.meta_num; j++) {
+            memcpy(&slot, names->data + entry.table_idx + j * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+            if (!j || slot.name_id != last_id)
+                first[slot.name_id + 1]++;
+
+            last_id = slot.name_id;
+        }
+    }
+
+    for (i = 0; i < names_header.name_num; i++)
+        first[i + 1] += first[i];
+
+    header.name_num = names_header.name_num;
+    header.first_idx = sizeof(rmc_postings_header_t);
+    header.posting_num = first[names_header.name_num];
+    header.posting_idx = header.first_idx + (names_header.name_num + 1) * sizeof(rmc_uint64_t);
+
+    section->type = RMC_SECTION_POSTINGS;
+    section->length = header.posting_idx + header.posting_num * sizeof(rmc_posting_t);
+    section->data = malloc(section->length);
+
+    if (!section->data) {
+        free(first);
+        return 1;
+    }
+
+    memcpy(section->data, &header, sizeof(rmc_postings_header_t));
+    memcpy(section->data + header.first_idx, first, (names_header.name_num + 1) * sizeof(rmc_uint64_t));
+
+    /* fill lists in the order of records, first[] is the next position of each name now */
+    for (i = 0; i < names_header.record_num; i++) {
+        memcpy(&entry, names->data + names_header.record_idx + i * sizeof(rmc_name_index_t),
+            sizeof(rmc_name_index_t));
+
+        for (j = 0; j < entry.meta_num; j++) {
+            memcpy(&slot, names->data + entry.table_idx + j * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+            /* the first meta with a name is what queries return */
+            if (!j || slot.name_id != last_id) {
+                posting.record_idx = entry.record_idx;
+                posting.meta_idx = slot.meta_idx;
+                memcpy(section->data + header.posting_idx + first[slot.name_id]++ * sizeof(rmc_posting_t),
+                    &posting, sizeof(rmc_posting_t));
+            }
+
+            last_id = slot.name_id;
+        }
+    }
+
+    free(first);
+
+    return 0;
+}
+
+/* build section RMC_SECTION_SHA256 for a well-formed database */
+static int build_digests(rmc_uint8_t *rmc_db, ext_section_t *section) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    rmc_blob_digest_t digest;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t blob_num = 0;
+    rmc_uint8_t *p = NULL;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(rmc_db, record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &policy))
+            blob_num++;
+    }
+
+    section->type = RMC_SECTION_SHA256;
+    section->length = sizeof(rmc_uint64_t) + blob_num * sizeof(rmc_blob_digest_t);
+    section->data = malloc(section->length);
+
+    if (!section->data)
+        return 1;
+
+    memcpy(section->data, &blob_num, sizeof(rmc_uint64_t));
+    p = section->data + sizeof(rmc_uint64_t);
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(rmc_db, record_idx, &iter);
+
+        for (digest.meta_idx = iter.meta_idx; !next_policy_in_record(&iter, &policy);
+            digest.meta_idx = iter.meta_idx) {
+            rmc_sha256(policy.blob, policy.blob_len, digest.digest);
+            memcpy(p, &digest, sizeof(rmc_blob_digest_t));
+            p += sizeof(rmc_blob_digest_t);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * allocate section RMC_SECTION_CRC32 for a well-formed database. CRCs are
+ * filled by fill_crc() once all extensions are in place.
+ */
+static int alloc_crc(rmc_uint8_t *rmc_db, ext_section_t *section) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
+    rmc_record_header_t record_header;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t record_num = 0;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        record_num++;
+    }
+
+    section->type = RMC_SECTION_CRC32;
+    section->length = sizeof(rmc_uint64_t) + record_num * sizeof(rmc_record_crc_t) +
+        sizeof(rmc_uint32_t);
+    section->data = calloc(1, section->length);
+
+    if (!section->data)
+        return 1;
+
+    memcpy(section->data, &record_num, sizeof(rmc_uint64_t));
+
+    return 0;
+}
+
+/* compute CRCs in section RMC_SECTION_CRC32, which is the last section in extensions */
+static void fill_crc(rmc_uint8_t *rmc_db, rmc_uint8_t *ext, rmc_size_t ext_len, ext_section_t *section) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
+    rmc_record_header_t record_header;
+    rmc_record_crc_t record_crc;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint8_t *p = NULL;
+    rmc_uint32_t crc = 0;
+
+    p = ext + ext_len - section->length + sizeof(rmc_uint64_t);
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        record_crc.record_idx = record_idx;
+        record_crc.crc = rmc_crc32(0, rmc_db + record_idx, record_header.length);
+        memcpy(p, &record_crc, sizeof(rmc_record_crc_t));
+        p += sizeof(rmc_record_crc_t);
+    }
+
+    /* records and extensions are not contiguous in memory */
+    crc = rmc_crc32(0, rmc_db, db_header->length);
+    crc = rmc_crc32(crc, ext, ext_len - sizeof(rmc_uint32_t));
+    memcpy(ext + ext_len - sizeof(rmc_uint32_t), &crc, sizeof(rmc_uint32_t));
+}
+
+/*
+ * generate extensions of a version 2 database for records laid out in memory
+ * (in) rmc_db      : records with name IDs, followed by extensions with at least
+ *                    section RMC_SECTION_NAMES resolving them
+ */
+static int generate_ext(rmc_uint8_t *rmc_db, rmc_uint8_t **ext, rmc_size_t *ext_len) {
+    ext_section_t sections[6];
+    ext_section_t *names = NULL;
+    rmc_uint32_t section_num = 0;
+    rmc_uint32_t i;
+    int ret = 1;
+
+    *ext = NULL;
+    *ext_len = 0;
+    memset(sections, 0, sizeof(sections));
+
+    if (build_trie(rmc_db, &sections[section_num++]))
+        goto err;
+
+    if (build_boards(rmc_db, &sections[section_num++]))
+        goto err;
+
+    if (build_names(rmc_db, &sections[section_num++]))
+        goto err;
+
+    /* posting lists are built from name IDs */
+    names = &sections[section_num - 1];
+
+    if (build_postings(names, &sections[section_num++]))
+        goto err;
+
+    if (build_digests(rmc_db, &sections[section_num++]))
+        goto err;
+
+    /* CRC section must be the last one */
+    if (alloc_crc(rmc_db, &sections[section_num++]))
+        goto err;
+
+    if (pack_extensions(((rmc_db_header_t *)rmc_db)->length, sections, section_num, ext, ext_len))
+        goto err;
+
+    fill_crc(rmc_db, *ext, *ext_len, &sections[section_num - 1]);
+    ret = 0;
+err:
+    for (i = 0; i < section_num; i++)
+        free(sections[i].data);
+
+    return ret;
+}
+
+/*
+ * encode records of a version 1 database with name IDs of version 2
+ * (in) names       : section RMC_SECTION_NAMES of names in rmc_db
+ * (out) v2_db      : database to write records after its header, NULL to get length only
+ *
+ * return: end of records in v2_db
+ */
+static rmc_uint64_t encode_records(rmc_uint8_t *rmc_db, rmc_uint8_t *names, rmc_uint8_t *v2_db) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
+    rmc_names_header_t names_header;
+    rmc_record_header_t record_header;
+    rmc_record_header_t v2_header;
+    rmc_meta_header_t meta_header;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t v2_idx = sizeof(rmc_db_header_t);
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint32_t name_id = 0;
+    rmc_size_t name_len = 0;
+
+    memcpy(&names_header, names, sizeof(rmc_names_header_t));
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(rmc_db, record_idx, &iter);
+        meta_idx = v2_idx + sizeof(rmc_record_header_t);
+
+        while (!next_policy_in_record(&iter, &policy)) {
+            name_len = policy.type == RMC_GENERIC_FILE ? sizeof(rmc_uint32_t) : strlen(policy.blob_name) + 1;
+            meta_header.type = policy.type;
+            meta_header.length = sizeof(rmc_meta_header_t) + name_len + policy.blob_len;
+
+            if (v2_db) {
+                name_id = find_name_id(names, &names_header, policy.blob_name);
+                memcpy(v2_db + meta_idx, &meta_header, sizeof(rmc_meta_header_t));
+                memcpy(v2_db + meta_idx + sizeof(rmc_meta_header_t),
+                    policy.type == RMC_GENERIC_FILE ? (void *)&name_id : (void *)policy.blob_name, name_len);
+                memcpy(v2_db + meta_idx + sizeof(rmc_meta_header_t) + name_len, policy.blob, policy.blob_len);
+            }
+
+            meta_idx += meta_header.length;
+        }
+
+        v2_header.signature = record_header.signature;
+        v2_header.length = meta_idx - v2_idx;
+
+        if (v2_db)
+            memcpy(v2_db + v2_idx, &v2_header, sizeof(rmc_record_header_t));
+
+        v2_idx = meta_idx;
+    }
+
+    return v2_idx;
+}
+
+int rmcl_convert_db_v2(rmc_uint8_t *rmc_db, rmc_uint8_t **v2_db, rmc_size_t *v2_len) {
+    rmc_db_header_t db_header;
+    rmc_names_header_t names_header;
+    ext_section_t names;
+    rmc_uint8_t *db = NULL;
+    rmc_uint8_t *ext = NULL;
+    rmc_uint8_t *tmp = NULL;
+    rmc_size_t ext_len = 0;
+    rmc_uint64_t records_len = 0;
+    int ret = 1;
+
+    if (!rmc_db || !v2_db || !v2_len || ((rmc_db_header_t *)rmc_db)->version != RMC_DB_VERSION_1)
+        return 1;
+
+    *v2_db = NULL;
+    *v2_len = 0;
+
+    if (build_names(rmc_db, &names))
+        return 1;
+
+    /* encoded records are read through a section of names only while other
+     * sections are built, with the same offsets as in the final database
+     */
+    memcpy(&names_header, names.data, sizeof(rmc_names_header_t));
+    names_header.record_num = 0;
+    memcpy(names.data, &names_header, sizeof(rmc_names_header_t));
+    names.length = names_header.record_idx;
+
+    records_len = encode_records(rmc_db, names.data, NULL);
+
+    if (pack_extensions(records_len, &names, 1, &ext, &ext_len))
+        goto out;
+
+    db = malloc(records_len + ext_len);
+
+    if (!db)
+        goto out;
+
+    memcpy(&db_header, rmc_db, sizeof(rmc_db_header_t));
+    db_header.version = RMC_DB_VERSION_2;
+    db_header.length = records_len;
+    memcpy(db, &db_header, sizeof(rmc_db_header_t));
+    encode_records(rmc_db, names.data, db);
+    memcpy(db + records_len, ext, ext_len);
+    free(ext);
+
+    if (generate_ext(db, &ext, &ext_len))
+        goto out;
+
+    tmp = realloc(db, records_len + ext_len);
+
+    if (!tmp)
+        goto out;
+
+    db = tmp;
+    memcpy(db + records_len, ext, ext_len);
+    *v2_db = db;
+    *v2_len = records_len + ext_len;
+    db = NULL;
+    ret = 0;
+out:
+    free(names.data);
+    free(ext);
+    free(db);
+
+    return ret;
+}
+
+int rmcl_generate_db_v2(rmc_record_file_t *record_files, rmc_uint8_t **rmc_db, rmc_size_t *len) {
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    int ret = 1;
+
+    if (!rmc_db || !len)
+        return 1;
+
+    *rmc_db = NULL;
+    *len = 0;
+
+    if (rmcl_generate_db(record_files, &db, &db_len))
+        return 1;
+
+    /* we walk records to convert them, they must be well-formed */
+    if (!validate_rmcdb(db, db_len))
+        ret = rmcl_convert_db_v2(db, rmc_db, len);
+
+    free(db);
+
+    return ret;
+}
+
+#endif /* RMC_EFI */
+/*
+ * Check if a record has signature matched with a given signature
+ *
+ * return 0 if record has matched signature or non-zero in other cases
+ */
+static int match_record(rmc_record_header_t *r, rmc_signature_t* sig) {
+    return strncmp((const char *)r->signature.raw, (const char *)sig->raw, sizeof(r->signature.raw));
+}
+
+int is_rmcdb(rmc_uint8_t *db_blob) {
+    rmc_db_header_t *db_header = NULL;
+
+    if (db_blob == NULL)
+        return 1;
+
+    db_header = (rmc_db_header_t *)db_blob;
+
+    /* sanity check of db */
+    if (strncmp((const char *)db_header->signature, (const char *)rmc_db_signature, RMC_DB_SIG_LEN))
+        return 1;
+    else
+        return 0;
+}
+
+static int validate_digests(rmc_uint8_t *db_blob, rmc_uint64_t section_idx, rmc_uint64_t section_len) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    rmc_blob_digest_t digest;
+    rmc_uint64_t blob_num = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t i = 0;
+
+    memcpy(&db_header, db_blob, sizeof(rmc_db_header_t));
+
+    if (section_len < sizeof(rmc_uint64_t))
+        return 1;
+
+    memcpy(&blob_num, db_blob + section_idx, sizeof(rmc_uint64_t));
+
+    if (blob_num != (section_len - sizeof(rmc_uint64_t)) / sizeof(rmc_blob_digest_t))
+        return 1;
+
+    /* entries are in the order of metas */
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header.length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, db_blob + record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(db_blob, record_idx, &iter);
+
+        for (; iter.meta_idx < iter.record_end; i++) {
+            if (i == blob_num)
+                return 1;
+
+            memcpy(&digest, db_blob + section_idx + sizeof(rmc_uint64_t) +
+                i * sizeof(rmc_blob_digest_t), sizeof(rmc_blob_digest_t));
+
+            if (digest.meta_idx != iter.meta_idx)
+                return 1;
+
+            next_policy_in_record(&iter, &policy);
+        }
+    }
+
+    return i != blob_num;
+}
+
+static void get_policy_in_meta(rmc_uint8_t *rmc_db, rmc_uint64_t meta_idx, rmc_file_t *policy);
+
+/*
+ * check if an offset is the start of a record, records and section
+ * RMC_SECTION_NAMES (when present) must have been validated.
+ * return: 0 when it is, non-zero otherwise
+ */
+static int is_record_start(rmc_uint8_t *db_blob, rmc_uint64_t record_idx) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_names_header_t names_header;
+    rmc_name_index_t entry;
+    rmc_uint8_t *names = NULL;
+    rmc_uint64_t idx = 0;
+
+    /* names section has an entry for each record */
+    if ((names = get_names(db_blob, &names_header)) != NULL)
+        return find_name_entry(names, &names_header, record_idx, &entry);
+
+    memcpy(&db_header, db_blob, sizeof(rmc_db_header_t));
+
+    for (idx = sizeof(rmc_db_header_t); idx < db_header.length && idx <= record_idx;
+        idx += record_header.length) {
+        if (idx == record_idx)
+            return 0;
+
+        memcpy(&record_header, db_blob + idx, sizeof(rmc_record_header_t));
+    }
+
+    return 1;
+}
+
+static int validate_trie(rmc_uint8_t *db_blob, rmc_uint64_t section_idx, rmc_uint64_t section_len) {
+    rmc_trie_header_t header;
+    rmc_sig_entry_t sig;
+    rmc_sig_entry_t last_sig;
+    rmc_trie_node_t node;
+    rmc_trie_edge_t edge;
+    rmc_trie_record_t record;
+    rmc_uint8_t *section = db_blob + section_idx;
+    rmc_uint8_t *last_value = NULL;
+    rmc_uint8_t *value = NULL;
+    rmc_uint64_t i, j;
+    rmc_uint64_t item_size = 0;
+
+    if (section_len < sizeof(rmc_trie_header_t))
+        return 1;
+
+    memcpy(&header, section, sizeof(rmc_trie_header_t));
+
+    /* arrays must be in section, sizes are checked by division to avoid overflow */
+    if (header.sig_idx > section_len ||
+        header.sig_num > (section_len - header.sig_idx) / sizeof(rmc_sig_entry_t) ||
+        header.node_idx > section_len ||
+        header.node_num > (section_len - header.node_idx) / sizeof(rmc_trie_node_t) ||
+        header.node_num > RMC_TRIE_NONE ||
+        header.item_idx > section_len || header.item_len > section_len - header.item_idx ||
+        header.string_idx > section_len || header.string_len > section_len - header.string_idx)
+        return 1;
+
+    for (i = 0; i < header.sig_num; i++) {
+        memcpy(&sig, section + header.sig_idx + i * sizeof(rmc_sig_entry_t), sizeof(rmc_sig_entry_t));
+
+        if (is_record_start(db_blob, sig.record_idx))
+            return 1;
+
+        if (i && (compare_signatures(&last_sig.signature, &sig.signature) > 0 ||
+            (!compare_signatures(&last_sig.signature, &sig.signature) &&
+            last_sig.record_idx >= sig.record_idx)))
+            return 1;
+
+        last_sig = sig;
+    }
+
+    /* last value must be terminated so that any value in strings is */
+    if (header.string_len && section[header.string_idx + header.string_len - 1])
+        return 1;
+
+    for (i = 0; i < header.node_num; i++) {
+        memcpy(&node, section + header.node_idx + i * sizeof(rmc_trie_node_t), sizeof(rmc_trie_node_t));
+
+        if (node.level > RMC_FINGER_NUM)
+            return 1;
+
+        item_size = node.level == RMC_FINGER_NUM ? sizeof(rmc_trie_record_t) : sizeof(rmc_trie_edge_t);
+
+        if (node.items_idx > header.item_len ||
+            node.item_num > (header.item_len - node.items_idx) / item_size)
+            return 1;
+
+        /* children after parent, so that walking down trie always terminates */
+        if (node.wildcard != RMC_TRIE_NONE &&
+            (node.level == RMC_FINGER_NUM || node.wildcard <= i || node.wildcard >= header.node_num))
+            return 1;
+
+        last_value = NULL;
+
+        for (j = 0; j < node.item_num; j++) {
+            if (node.level == RMC_FINGER_NUM) {
+                memcpy(&record, section + header.item_idx + node.items_idx + j * sizeof(rmc_trie_record_t),
+                    sizeof(rmc_trie_record_t));
+
+                if (!record.finger_mask || record.finger_mask >= RMC_FINGER_BIT(RMC_FINGER_NUM) ||
+                    is_record_start(db_blob, record.record_idx))
+                    return 1;
+
+                continue;
+            }
+
+            memcpy(&edge, section + header.item_idx + node.items_idx + j * sizeof(rmc_trie_edge_t),
+                sizeof(rmc_trie_edge_t));
+
+            if (edge.value_idx >= header.string_len || edge.child <= i || edge.child >= header.node_num)
+                return 1;
+
+            /* edges are sorted for binary search */
+            value = section + header.string_idx + edge.value_idx;
+
+            if (last_value && compare_names(last_value, value) >= 0)
+                return 1;
+
+            last_value = value;
+        }
+    }
+
+    return 0;
+}
+
+static int validate_boards(rmc_uint8_t *db_blob, rmc_uint64_t section_idx, rmc_uint64_t section_len) {
+    rmc_board_header_t header;
+    rmc_record_header_t record_header;
+    rmc_signature_t sig;
+    rmc_signature_t last_sig;
+    rmc_uint8_t *section = db_blob + section_idx;
+    rmc_uint64_t first = 0;
+    rmc_uint64_t next = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t last_idx = 0;
+    rmc_uint64_t i, j;
+
+    if (section_len < sizeof(rmc_board_header_t))
+        return 1;
+
+    memcpy(&header, section, sizeof(rmc_board_header_t));
+
+    /* arrays must be in section, first entries have board_num + 1 items */
+    if (header.board_num > RMC_BOARD_NONE ||
+        header.sig_idx > section_len ||
+        header.board_num > (section_len - header.sig_idx) / sizeof(rmc_signature_t) ||
+        header.first_idx > section_len ||
+        header.board_num >= (section_len - header.first_idx) / sizeof(rmc_uint64_t) ||
+        header.record_idx > section_len ||
+        header.record_num > (section_len - header.record_idx) / sizeof(rmc_uint64_t))
+        return 1;
+
+    memcpy(&next, section + header.first_idx, sizeof(rmc_uint64_t));
+
+    if (next)
+        return 1;
+
+    for (i = 0; i < header.board_num; i++) {
+        memcpy(&sig, section + header.sig_idx + i * sizeof(rmc_signature_t), sizeof(rmc_signature_t));
+
+        if (i && compare_signatures(&last_sig, &sig) >= 0)
+            return 1;
+
+        last_sig = sig;
+        first = next;
+        memcpy(&next, section + header.first_idx + (i + 1) * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+        /* a board has at least one record */
+        if (next <= first || next > header.record_num)
+            return 1;
+
+        for (j = first, last_idx = 0; j < next; j++) {
+            memcpy(&record_idx, section + header.record_idx + j * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+            if (record_idx <= last_idx || is_record_start(db_blob, record_idx))
+                return 1;
+
+            memcpy(&record_header, db_blob + record_idx, sizeof(rmc_record_header_t));
+
+            if (match_record(&record_header, &sig))
+                return 1;
+
+            last_idx = record_idx;
+        }
+    }
+
+    return next != header.record_num;
+}
+
+static int validate_names(rmc_uint8_t *db_blob, rmc_uint64_t section_idx, rmc_uint64_t section_len) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_names_header_t header;
+    rmc_name_index_t entry;
+    rmc_name_slot_t slot;
+    rmc_name_slot_t last_slot;
+    rmc_name_slot_t key;
+    rmc_meta_header_t meta_header;
+    rmc_uint8_t *section = db_blob + section_idx;
+    rmc_uint8_t *last_name = NULL;
+    rmc_uint8_t *name = NULL;
+    rmc_uint64_t offset = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint64_t meta_num = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    rmc_uint64_t i, j;
+    int cmp = 0;
+
+    if (section_len < sizeof(rmc_names_header_t))
+        return 1;
+
+    memcpy(&db_header, db_blob, sizeof(rmc_db_header_t));
+    memcpy(&header, section, sizeof(rmc_names_header_t));
+
+    if (header.name_num > RMC_NAME_NONE ||
+        header.name_idx > section_len ||
+        header.name_num > (section_len - header.name_idx) / sizeof(rmc_uint64_t) ||
+        header.string_idx > section_len || header.string_len > section_len - header.string_idx ||
+        header.record_idx > section_len ||
+        header.record_num > (section_len - header.record_idx) / sizeof(rmc_name_index_t))
+        return 1;
+
+    /* last name must be terminated so that any name in strings is */
+    if (header.string_len && section[header.string_idx + header.string_len - 1])
+        return 1;
+
+    for (i = 0; i < header.name_num; i++) {
+        memcpy(&offset, section + header.name_idx + i * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+        if (offset >= header.string_len)
+            return 1;
+
+        name = section + header.string_idx + offset;
+
+        if (last_name && compare_names(last_name, name) >= 0)
+            return 1;
+
+        last_name = name;
+    }
+
+    /* entries are in the order of records, and tables have all blobs of records, so
+     * that every ID in metas is checked
+     */
+    for (i = 0, record_idx = sizeof(rmc_db_header_t); i < header.record_num;
+        i++, record_idx += record_header.length) {
+        if (record_idx >= db_header.length)
+            return 1;
+
+        memcpy(&record_header, db_blob + record_idx, sizeof(rmc_record_header_t));
+        memcpy(&entry, section + header.record_idx + i * sizeof(rmc_name_index_t), sizeof(rmc_name_index_t));
+
+        if (entry.record_idx != record_idx || entry.table_idx > section_len ||
+            entry.meta_num > (section_len - entry.table_idx) / sizeof(rmc_name_slot_t))
+            return 1;
+
+        /* slots are distinct, so they are all metas of record when each meta has one */
+        for (j = 0; j < entry.meta_num; j++) {
+            memcpy(&slot, section + entry.table_idx + j * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+            if (slot.name_id >= header.name_num || (j && compare_name_slot(&last_slot, &slot) >= 0))
+                return 1;
+
+            last_slot = slot;
+        }
+
+        /* one pass over metas, each is searched in slots */
+        for (meta_num = 0, meta_idx = record_idx + sizeof(rmc_record_header_t);
+            meta_idx < record_idx + record_header.length; meta_idx += meta_header.length) {
+            memcpy(&meta_header, db_blob + meta_idx, sizeof(rmc_meta_header_t));
+
+            if (meta_header.type != RMC_GENERIC_FILE)
+                continue;
+
+            memcpy(&key.name_id, db_blob + meta_idx + sizeof(rmc_meta_header_t), sizeof(rmc_uint32_t));
+            key.meta_idx = meta_idx;
+            meta_num++;
+
+            for (low = 0, high = entry.meta_num, cmp = 1; low < high && cmp;) {
+                mid = low + (high - low) / 2;
+                memcpy(&slot, section + entry.table_idx + mid * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+                if ((cmp = compare_name_slot(&slot, &key)) < 0)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+
+            if (cmp)
+                return 1;
+        }
+
+        if (entry.meta_num != meta_num)
+            return 1;
+    }
+
+    return record_idx != db_header.length;
+}
+
+/* validate section RMC_SECTION_POSTINGS, section RMC_SECTION_NAMES must have been validated */
+static int validate_postings(rmc_uint8_t *db_blob, rmc_uint64_t section_idx, rmc_uint64_t section_len) {
+    rmc_postings_header_t header;
+    rmc_names_header_t names_header;
+    rmc_name_index_t entry;
+    rmc_name_slot_t slot;
+    rmc_posting_t posting;
+    rmc_uint8_t *section = db_blob + section_idx;
+    rmc_uint8_t *names = NULL;
+    rmc_uint64_t names_idx = 0;
+    rmc_uint64_t names_len = 0;
+    rmc_uint64_t first = 0;
+    rmc_uint64_t next = 0;
+    rmc_uint64_t last_idx = 0;
+    rmc_uint64_t pair_num = 0;
+    rmc_uint32_t last_id = 0;
+    rmc_uint64_t i, j;
+
+    if (section_len < sizeof(rmc_postings_header_t) ||
+        query_section_from_db(db_blob, RMC_SECTION_NAMES, &names_idx, &names_len))
+        return 1;
+
+    names = db_blob + names_idx;
+    memcpy(&names_header, names, sizeof(rmc_names_header_t));
+    memcpy(&header, section, sizeof(rmc_postings_header_t));
+
+    /* arrays must be in section, first entries have name_num + 1 items */
+    if (header.name_num != names_header.name_num ||
+        header.first_idx > section_len ||
+        header.name_num >= (section_len - header.first_idx) / sizeof(rmc_uint64_t) ||
+        header.posting_idx > section_len ||
+        header.posting_num > (section_len - header.posting_idx) / sizeof(rmc_posting_t))
+        return 1;
+
+    memcpy(&next, section + header.first_idx, sizeof(rmc_uint64_t));
+
+    if (next)
+        return 1;
+
+    /* each posting is the first meta with the name in a later record */
+    for (i = 0; i < header.name_num; i++) {
+        first = next;
+        memcpy(&next, section + header.first_idx + (i + 1) * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+        if (next < first || next > header.posting_num)
+            return 1;
+
+        for (j = first, last_idx = 0; j < next; j++) {
+            memcpy(&posting, section + header.posting_idx + j * sizeof(rmc_posting_t), sizeof(rmc_posting_t));
+
+            if (posting.record_idx <= last_idx || is_record_start(db_blob, posting.record_idx) ||
+                !posting.meta_idx ||
+                find_meta_by_name_id(names, &names_header, posting.record_idx, (rmc_uint32_t)i) != posting.meta_idx)
+                return 1;
+
+            last_idx = posting.record_idx;
+        }
+    }
+
+    if (next != header.posting_num)
+        return 1;
+
+    /* lists are complete when they have as many postings as records have names */
+    for (i = 0; i < names_header.record_num; i++) {
+        memcpy(&entry, names + names_header.record_idx + i * sizeof(rmc_name_index_t), sizeof(rmc_name_index_t));
+
+        for (j = 0; j < entry.meta_num; j++) {
+            memcpy(&slot, names + entry.table_idx + j * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+            if (!j || slot.name_id != last_id)
+                pair_num++;
+
+            last_id = slot.name_id;
+        }
+    }
+
+    return pair_num != header.posting_num;
+}
+
+/*
+ * validate CRC section, its layout is always checked so that record CRCs can
+ * be searched safely, CRC of database is compared only when check_crc is set
+ */
+static int validate_crc(rmc_uint8_t *db_blob, rmc_uint64_t section_idx, rmc_uint64_t section_len,
+        rmc_uint64_t ext_end, int check_crc) {
+    rmc_uint64_t record_num = 0;
+    rmc_uint32_t crc = 0;
+
+    if (section_len < sizeof(rmc_uint64_t) + sizeof(rmc_uint32_t) ||
+        section_idx + section_len != ext_end)
+        return 1;
+
+    memcpy(&record_num, db_blob + section_idx, sizeof(rmc_uint64_t));
+
+    if (record_num != (section_len - sizeof(rmc_uint64_t) - sizeof(rmc_uint32_t)) /
+        sizeof(rmc_record_crc_t))
+        return 1;
+
+    if (!check_crc)
+        return 0;
+
+    memcpy(&crc, db_blob + ext_end - sizeof(rmc_uint32_t), sizeof(rmc_uint32_t));
+
+    /* record CRCs are covered, no need to check them again */
+    return crc != rmc_crc32(0, db_blob, ext_end - sizeof(rmc_uint32_t));
+}
+
+/*
+ * validate extensions following records in a database, records must have
+ * been validated.
+ * return: 0 when extensions are well-formed or not present, non-zero otherwise
+ */
+static int validate_extensions(rmc_uint8_t *db_blob, rmc_size_t len, int check_crc) {
+    rmc_db_header_t db_header;
+    rmc_ext_header_t ext_header;
+    rmc_section_header_t section_header;
+    rmc_uint64_t ext_idx = 0;
+    rmc_uint64_t digests_idx = 0;
+    rmc_uint64_t digests_len = 0;
+    rmc_uint64_t trie_idx = 0;
+    rmc_uint64_t trie_len = 0;
+    rmc_uint64_t board_idx = 0;
+    rmc_uint64_t board_len = 0;
+    rmc_uint64_t names_idx = 0;
+    rmc_uint64_t names_len = 0;
+    rmc_uint64_t postings_idx = 0;
+    rmc_uint64_t postings_len = 0;
+    rmc_uint32_t i;
+    int has_crc = 0;
+
+    memcpy(&db_header, db_blob, sizeof(rmc_db_header_t));
+
+    if (db_header.version < RMC_DB_VERSION_2)
+        return 0;
+
+    ext_idx = db_header.length;
+
+    if (len - ext_idx < sizeof(rmc_ext_header_t))
+        return 1;
+
+    memcpy(&ext_header, db_blob + ext_idx, sizeof(rmc_ext_header_t));
+
+    if (strncmp((const char *)ext_header.signature, (const char *)rmc_ext_signature, RMC_EXT_SIG_LEN) ||
+        ext_header.length < sizeof(rmc_ext_header_t) || ext_header.length > len - ext_idx ||
+        ext_header.section_num > (ext_header.length - sizeof(rmc_ext_header_t)) / sizeof(rmc_section_header_t))
+        return 1;
+
+    for (i = 0; i < ext_header.section_num; i++) {
+        memcpy(&section_header, db_blob + ext_idx + sizeof(rmc_ext_header_t) +
+            i * sizeof(rmc_section_header_t), sizeof(rmc_section_header_t));
+
+        /* section data must be in extensions */
+        if (section_header.offset < ext_idx + sizeof(rmc_ext_header_t) ||
+            section_header.offset > ext_idx + ext_header.length ||
+            section_header.length > ext_idx + ext_header.length - section_header.offset)
+            return 1;
+
+        if (section_header.type == RMC_SECTION_CRC32) {
+            if (validate_crc(db_blob, section_header.offset, section_header.length,
+                ext_idx + ext_header.length, check_crc))
+                return 1;
+
+            has_crc = 1;
+        }
+    }
+
+    /* every version 2 database ends with CRC section, a damaged count or type of
+     * sections must not drop it from validation
+     */
+    if (!has_crc)
+        return 1;
+
+    /* names of metas are resolved through IDs in other sections, IDs must be checked first */
+    if (query_section_from_db(db_blob, RMC_SECTION_NAMES, &names_idx, &names_len) ||
+        validate_names(db_blob, names_idx, names_len))
+        return 1;
+
+    if (!query_section_from_db(db_blob, RMC_SECTION_SHA256, &digests_idx, &digests_len) &&
+        validate_digests(db_blob, digests_idx, digests_len))
+        return 1;
+
+    /* these sections refer to records, which are checked with names section validated above */
+    if (!query_section_from_db(db_blob, RMC_SECTION_TRIE, &trie_idx, &trie_len) &&
+        validate_trie(db_blob, trie_idx, trie_len))
+        return 1;
+
+    if (!query_section_from_db(db_blob, RMC_SECTION_BOARD, &board_idx, &board_len) &&
+        validate_boards(db_blob, board_idx, board_len))
+        return 1;
+
+    if (!query_section_from_db(db_blob, RMC_SECTION_POSTINGS, &postings_idx, &postings_len) &&
+        validate_postings(db_blob, postings_idx, postings_len))
+        return 1;
+
+    return 0;
+}
+
+static int check_rmcdb(rmc_uint8_t *db_blob, rmc_size_t len, int check_crc) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_meta_header_t meta_header;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t record_end = 0;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint64_t name_idx = 0;
+
+    if (db_blob == NULL || len < sizeof(rmc_db_header_t) || is_rmcdb(db_blob))
+        return 1;
+
+    memcpy(&db_header, db_blob, sizeof(rmc_db_header_t));
+
+    if (db_header.length < sizeof(rmc_db_header_t) || db_header.length > len)
+        return 1;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header.length;
+        record_idx = record_end) {
+        if (db_header.length - record_idx < sizeof(rmc_record_header_t))
+            return 1;
+
+        memcpy(&record_header, db_blob + record_idx, sizeof(rmc_record_header_t));
+
+        if (record_header.length < sizeof(rmc_record_header_t) ||
+            record_header.length > db_header.length - record_idx)
+            return 1;
+
+        record_end = record_idx + record_header.length;
+
+        for (meta_idx = record_idx + sizeof(rmc_record_header_t); meta_idx < record_end;
+            meta_idx += meta_header.length) {
+            if (record_end - meta_idx < sizeof(rmc_meta_header_t))
+                return 1;
+
+            memcpy(&meta_header, db_blob + meta_idx, sizeof(rmc_meta_header_t));
+
+            /* at least an empty name */
+            if (meta_header.length <= sizeof(rmc_meta_header_t) ||
+                meta_header.length > record_end - meta_idx)
+                return 1;
+
+            /* ID of name is checked with section RMC_SECTION_NAMES */
+            if (db_header.version >= RMC_DB_VERSION_2 && meta_header.type == RMC_GENERIC_FILE) {
+                if (meta_header.length - sizeof(rmc_meta_header_t) < sizeof(rmc_uint32_t))
+                    return 1;
+
+                continue;
+            }
+
+            /* name must be terminated within meta */
+            for (name_idx = meta_idx + sizeof(rmc_meta_header_t);
+                name_idx < meta_idx + meta_header.length && db_blob[name_idx]; name_idx++)
+                ;
+
+            if (name_idx == meta_idx + meta_header.length)
+                return 1;
+        }
+    }
+
+    return validate_extensions(db_blob, len, check_crc);
+}
+
+int validate_rmcdb(rmc_uint8_t *db_blob, rmc_size_t len) {
+    return check_rmcdb(db_blob, len, 1);
+}
+
+int validate_rmcdb_layout(rmc_uint8_t *db_blob, rmc_size_t len) {
+    return check_rmcdb(db_blob, len, 0);
+}
+
+int query_section_from_db(rmc_uint8_t *rmc_db, rmc_uint32_t type, rmc_uint64_t *section_idx, rmc_uint64_t *section_len) {
+    rmc_db_header_t db_header;
+    rmc_ext_header_t ext_header;
+    rmc_section_header_t section_header;
+    rmc_uint32_t i;
+
+    if (!rmc_db || !section_idx || !section_len)
+        return 1;
+
+    memcpy(&db_header, rmc_db, sizeof(rmc_db_header_t));
+
+    if (db_header.version < RMC_DB_VERSION_2)
+        return 1;
+
+    memcpy(&ext_header, rmc_db + db_header.length, sizeof(rmc_ext_header_t));
+
+    if (strncmp((const char *)ext_header.signature, (const char *)rmc_ext_signature, RMC_EXT_SIG_LEN))
+        return 1;
+
+    for (i = 0; i < ext_header.section_num; i++) {
+        memcpy(&section_header, rmc_db + db_header.length + sizeof(rmc_ext_header_t) +
+            i * sizeof(rmc_section_header_t), sizeof(rmc_section_header_t));
+
+        if (section_header.type == type) {
+            *section_idx = section_header.offset;
+            *section_len = section_header.length;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int verify_record_crc(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx) {
+    rmc_record_header_t record_header;
+    rmc_record_crc_t record_crc;
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t record_num = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+
+    if (!rmc_db)
+        return 1;
+
+    if (query_section_from_db(rmc_db, RMC_SECTION_CRC32, &section_idx, &section_len))
+        return 0;
+
+    memcpy(&record_num, rmc_db + section_idx, sizeof(rmc_uint64_t));
+    high = record_num;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        memcpy(&record_crc, rmc_db + section_idx + sizeof(rmc_uint64_t) +
+            mid * sizeof(rmc_record_crc_t), sizeof(rmc_record_crc_t));
+
+        if (record_crc.record_idx == record_idx) {
+            memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+            return record_crc.crc != rmc_crc32(0, rmc_db + record_idx, record_header.length);
+        } else if (record_crc.record_idx < record_idx)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    /* not a record in database */
+    return 1;
+}
+
+rmc_uint8_t *query_digest_from_db(rmc_uint8_t *rmc_db, rmc_uint64_t meta_idx) {
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t blob_num = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    rmc_blob_digest_t digest;
+    rmc_uint8_t *entry = NULL;
+
+    if (!rmc_db || query_section_from_db(rmc_db, RMC_SECTION_SHA256, &section_idx, &section_len))
+        return NULL;
+
+    memcpy(&blob_num, rmc_db + section_idx, sizeof(rmc_uint64_t));
+    high = blob_num;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        entry = rmc_db + section_idx + sizeof(rmc_uint64_t) + mid * sizeof(rmc_blob_digest_t);
+        memcpy(&digest.meta_idx, entry, sizeof(rmc_uint64_t));
+
+        if (digest.meta_idx == meta_idx)
+            return entry + sizeof(rmc_uint64_t);
+        else if (digest.meta_idx < meta_idx)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return NULL;
+}
+
+/*
+ * find the range of name IDs starting with a prefix, IDs are in the order of names
+ * (in) n           : length of prefix
+ * (out) end        : end of range
+ *
+ * return: first ID in range
+ */
+static rmc_uint32_t find_prefix_ids(rmc_uint8_t *section, rmc_names_header_t *header, const char *prefix,
+        rmc_size_t n, rmc_uint32_t *end) {
+    const rmc_uint8_t *p = (const rmc_uint8_t *)prefix;
+    const rmc_uint8_t *name = NULL;
+    rmc_uint64_t offset = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    rmc_uint64_t first = 0;
+    rmc_size_t i = 0;
+    int cmp = 0;
+    int upper = 0;
+
+    /* lower bound of names not less than prefix, and then of names greater than it */
+    for (upper = 0; upper < 2; upper++) {
+        for (low = first, high = header->name_num; low < high;) {
+            mid = low + (high - low) / 2;
+            memcpy(&offset, section + header->name_idx + mid * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+            name = section + header->string_idx + offset;
+
+            /* prefix has no '\0' in its n bytes, a shorter name differs at its end */
+            for (i = 0, cmp = 0; i < n && !cmp; i++)
+                cmp = name[i] - p[i];
+
+            if (cmp < 0 || (upper && !cmp))
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        if (!upper)
+            first = low;
+    }
+
+    *end = (rmc_uint32_t)low;
+
+    return (rmc_uint32_t)first;
+}
+
+/*
+ * match a name with a glob pattern, '*' matches any string and '?' matches any character
+ *
+ * return: 0 when name matches pattern, non-zero otherwise
+ */
+static int match_glob(const char *pattern, const char *name) {
+    const char *star = NULL;
+    const char *resume = NULL;
+
+    while (*name) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        } else if (star) {
+            /* let the last star eat one more character */
+            pattern = star + 1;
+            name = ++resume;
+        } else
+            return 1;
+    }
+
+    while (*pattern == '*')
+        pattern++;
+
+    return *pattern != '\0';
+}
+
+/* fill policy with the meta at a given offset */
+static void get_policy_in_meta(rmc_uint8_t *rmc_db, rmc_uint64_t meta_idx, rmc_file_t *policy) {
+    rmc_record_iter_t iter;
+
+    /* an iterator over a single meta */
+    iter.rmc_db = rmc_db;
+    iter.names = get_meta_names(rmc_db);
+    iter.meta_idx = meta_idx;
+    iter.record_end = meta_idx + 1;
+    next_policy_in_record(&iter, policy);
+}
+
+int init_match_iter(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx, char *pattern, rmc_match_iter_t *iter) {
+    rmc_names_header_t header;
+    rmc_name_index_t entry;
+    rmc_uint8_t *names = NULL;
+    rmc_uint32_t first = 0;
+
+    if (!pattern || !iter || init_record_iter(rmc_db, record_idx, &iter->record_iter))
+        return 1;
+
+    iter->pattern = pattern;
+    iter->table = NULL;
+
+    for (iter->prefix_len = 0; pattern[iter->prefix_len] &&
+        pattern[iter->prefix_len] != '*' && pattern[iter->prefix_len] != '?'; iter->prefix_len++)
+        ;
+
+    /* IDs of names starting with prefix are a range, slots of record are sorted by IDs */
+    names = iter->record_iter.names;
+
+    if (names) {
+        memcpy(&header, names, sizeof(rmc_names_header_t));
+
+        /* a record out of names section is walked */
+        if (find_name_entry(names, &header, record_idx, &entry))
+            return 0;
+
+        first = find_prefix_ids(names, &header, pattern, iter->prefix_len, &iter->name_end);
+        iter->table = names + entry.table_idx;
+        iter->pos = lower_bound_slot(names, &entry, first);
+        iter->end = entry.meta_num;
+    }
+
+    return 0;
+}
+
+int next_match_in_record(rmc_match_iter_t *iter, rmc_file_t *policy) {
+    rmc_name_slot_t slot;
+    char *name = NULL;
+
+    if (!iter || !policy)
+        return 1;
+
+    if (!iter->table) {
+        while (!next_policy_in_record(&iter->record_iter, policy)) {
+            if (!match_glob(iter->pattern, policy->blob_name))
+                return 0;
+        }
+
+        return 1;
+    }
+
+    while (iter->pos < iter->end) {
+        memcpy(&slot, iter->table + iter->pos * sizeof(rmc_name_slot_t), sizeof(rmc_name_slot_t));
+
+        /* end of range of names starting with prefix */
+        if (slot.name_id >= iter->name_end) {
+            iter->pos = iter->end;
+            break;
+        }
+
+        iter->pos++;
+        name = get_name_by_id(iter->record_iter.names, slot.name_id);
+
+        if (!match_glob(iter->pattern, name)) {
+            get_policy_in_meta(iter->record_iter.rmc_db, slot.meta_idx, policy);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Find the next record matched with a given signature
+ * (in) rmc_db      : rmc database blob which has passed is_rmcdb()
+ * (in) sig         : signature to match
+ * (in) start       : offset to start searching from, must be the beginning of a record
+ *
+ * return: offset of matched record or 0 if there is no more matched record
+ */
+static rmc_uint64_t find_record(rmc_uint8_t *rmc_db, rmc_signature_t *sig, rmc_uint64_t start) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)rmc_db;
+    rmc_record_header_t record_header;
+    rmc_uint64_t record_idx = 0;   /* offset of each reacord in db*/
+
+    for (record_idx = start; record_idx < db_header->length;) {
+        /* record data may not be aligned like db pointer does
+         * We align record header by copying
+         */
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+
+        /* found matched record */
+        if (!match_record(&record_header, sig))
+            return record_idx;
+
+        record_idx += record_header.length;
+    } /* traverse in db */
+
+    return 0;
+}
+
+/*
+ * Walk down trie with values of fingers of a board
+ * (in) section     : start of section RMC_SECTION_TRIE
+ * (out) leaf       : leaf reached by board
+ *
+ * return: 0 when board reaches a leaf, non-zero when no pattern record matches
+ */
+static int walk_trie(rmc_uint8_t *section, rmc_trie_header_t *header, rmc_fingerprint_t *fingerprint,
+        rmc_trie_node_t *leaf) {
+    rmc_trie_edge_t edge;
+    rmc_uint32_t node_id = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    const char *value = NULL;
+    int ret = 0;
+
+    if (!header->node_num)
+        return 1;
+
+    while (1) {
+        memcpy(leaf, section + header->node_idx + node_id * sizeof(rmc_trie_node_t), sizeof(rmc_trie_node_t));
+
+        if (leaf->level >= RMC_FINGER_NUM)
+            return 0;
+
+        value = fingerprint->rmc_fingers[leaf->level].value;
+        node_id = leaf->wildcard;
+
+        if (!value)
+            value = "";
+
+        for (low = 0, high = leaf->item_num; low < high;) {
+            mid = low + (high - low) / 2;
+            memcpy(&edge, section + header->item_idx + leaf->items_idx + mid * sizeof(rmc_trie_edge_t),
+                sizeof(rmc_trie_edge_t));
+            ret = compare_names((const rmc_uint8_t *)value, section + header->string_idx + edge.value_idx);
+
+            if (!ret) {
+                node_id = edge.child;
+                break;
+            } else if (ret > 0)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        if (node_id == RMC_TRIE_NONE)
+            return 1;
+    }
+}
+
+/* check if a record ranks after the last returned one, records are returned from
+ * the most specific one, and then in the order of database.
+ */
+static int is_after(rmc_uint32_t priority, rmc_uint64_t record_idx, rmc_uint32_t last_priority,
+        rmc_uint64_t last_idx) {
+    if (!last_idx)
+        return 1;
+
+    return priority < last_priority || (priority == last_priority && record_idx > last_idx);
+}
+
+/*
+ * Find the next record matching a board with section RMC_SECTION_TRIE. Records
+ * with the signature of board and pattern records in trie are merged by rank.
+ * (in) record_idx  : last record returned, or 0 to find the first one
+ *
+ * return: offset of the next record, or 0 if there is no more matched record
+ */
+static rmc_uint64_t find_record_in_trie(rmc_uint8_t *rmc_db, rmc_uint64_t section_idx,
+        rmc_fingerprint_t *fingerprint, rmc_signature_t *sig, rmc_uint64_t record_idx) {
+    rmc_uint8_t *section = rmc_db + section_idx;
+    rmc_trie_header_t header;
+    rmc_trie_node_t leaf;
+    rmc_trie_record_t record;
+    rmc_sig_entry_t entry;
+    rmc_uint32_t sig_priority = finger_priority(RMC_SIGNATURE_FINGERS);
+    rmc_uint32_t last_priority = sig_priority;
+    rmc_uint32_t priority = 0;
+    rmc_uint64_t found = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    rmc_uint64_t i;
+
+    memcpy(&header, section, sizeof(rmc_trie_header_t));
+
+    /* an empty leaf when board reaches no leaf */
+    if (walk_trie(section, &header, fingerprint, &leaf))
+        memset(&leaf, 0, sizeof(rmc_trie_node_t));
+
+    /* rank of last record, it is a record with signature when not in leaf */
+    for (i = 0; record_idx && i < leaf.item_num; i++) {
+        memcpy(&record, section + header.item_idx + leaf.items_idx + i * sizeof(rmc_trie_record_t),
+            sizeof(rmc_trie_record_t));
+
+        if (record.record_idx == record_idx) {
+            last_priority = finger_priority(record.finger_mask);
+            break;
+        }
+    }
+
+    /* leaf records are sorted by rank, take the first one after last record */
+    for (i = 0; i < leaf.item_num; i++) {
+        memcpy(&record, section + header.item_idx + leaf.items_idx + i * sizeof(rmc_trie_record_t),
+            sizeof(rmc_trie_record_t));
+
+        if (is_after(finger_priority(record.finger_mask), record.record_idx, last_priority, record_idx)) {
+            priority = finger_priority(record.finger_mask);
+            found = record.record_idx;
+            break;
+        }
+    }
+
+    /* records with signature have the same rank, sorted by offset */
+    if (found && priority > sig_priority)
+        return found;
+
+    for (low = 0, high = header.sig_num; low < high;) {
+        mid = low + (high - low) / 2;
+        memcpy(&entry, section + header.sig_idx + mid * sizeof(rmc_sig_entry_t), sizeof(rmc_sig_entry_t));
+
+        if (compare_signatures(&entry.signature, sig) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    for (i = low; i < header.sig_num; i++) {
+        memcpy(&entry, section + header.sig_idx + i * sizeof(rmc_sig_entry_t), sizeof(rmc_sig_entry_t));
+
+        if (compare_signatures(&entry.signature, sig))
+            break;
+
+        if (is_after(sig_priority, entry.record_idx, last_priority, record_idx)) {
+            if (!found || priority < sig_priority || entry.record_idx < found)
+                found = entry.record_idx;
+            break;
+        }
+    }
+
+    return found;
+}
+
+/*
+ * Find the next record matching a board, with section RMC_SECTION_TRIE when
+ * database has it or by scanning records
+ * (in) section_idx : offset of section RMC_SECTION_TRIE, 0 when database has none
+ * (in) record_idx  : last record returned, or 0 to find the first one
+ *
+ * return: offset of the next record, or 0 if there is no more matched record
+ */
+static rmc_uint64_t next_record(rmc_uint8_t *rmc_db, rmc_uint64_t section_idx,
+        rmc_fingerprint_t *fingerprint, rmc_signature_t *sig, rmc_uint64_t record_idx) {
+    rmc_record_header_t record_header;
+
+    if (section_idx)
+        return find_record_in_trie(rmc_db, section_idx, fingerprint, sig, record_idx);
+
+    if (!record_idx)
+        return find_record(rmc_db, sig, sizeof(rmc_db_header_t));
+
+    /* continue after the record found in last call */
+    memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+
+    return find_record(rmc_db, sig, record_idx + record_header.length);
+}
+
+int query_record_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_uint64_t *record_idx) {
+    rmc_signature_t signature;
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t idx = 0;
+
+    if (!fingerprint || !rmc_db || !record_idx)
+        return 1;
+
+    /* sanity check of db */
+    if (is_rmcdb(rmc_db))
+        return 1;
+
+    /* calculate signature of fingerprint */
+    if (generate_signature_from_fingerprint(fingerprint, &signature))
+        return 1;
+
+    if (query_section_from_db(rmc_db, RMC_SECTION_TRIE, &section_idx, &section_len))
+        section_idx = 0;
+
+    idx = next_record(rmc_db, section_idx, fingerprint, &signature, *record_idx);
+
+    if (!idx)
+        return 1;
+
+    *record_idx = idx;
+
+    return 0;
+}
+
+int query_policy_from_record(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx, rmc_uint8_t type, char *blob_name, rmc_file_t *policy) {
+    rmc_record_iter_t iter;
+    rmc_names_header_t header;
+    rmc_uint8_t *names = NULL;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint32_t name_id = 0;
+
+    if (!rmc_db || !policy)
+        return 1;
+
+    if (type != RMC_GENERIC_FILE || blob_name == NULL)
+        return 1;
+
+    /* binary search by name ID in version 2 */
+    if ((names = get_meta_names(rmc_db)) != NULL) {
+        memcpy(&header, names, sizeof(rmc_names_header_t));
+
+        if ((name_id = find_name_id(names, &header, blob_name)) == RMC_NAME_NONE ||
+            (meta_idx = find_meta_by_name_id(names, &header, record_idx, name_id)) == 0)
+            return 1;
+
+        get_policy_in_meta(rmc_db, meta_idx, policy);
+
+        return 0;
+    }
+
+    /* find meta by type and name */
+    init_record_iter(rmc_db, record_idx, &iter);
+
+    while (!next_policy_in_record(&iter, policy)) {
+        if (policy->type == type && !compare_names((rmc_uint8_t *)blob_name, (rmc_uint8_t *)policy->blob_name))
+            return 0;
+    } /* traverse in record */
+
+    return 1;
+}
+
+int init_record_iter(rmc_uint8_t *rmc_db, rmc_uint64_t record_idx, rmc_record_iter_t *iter) {
+    rmc_record_header_t record_header;
+
+    if (!rmc_db || !record_idx || !iter)
+        return 1;
+
+    memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+
+    iter->rmc_db = rmc_db;
+    iter->names = get_meta_names(rmc_db);
+    iter->meta_idx = record_idx + sizeof(rmc_record_header_t);
+    iter->record_end = record_idx + record_header.length;
+
+    return 0;
+}
+
+int next_policy_in_record(rmc_record_iter_t *iter, rmc_file_t *policy) {
+    rmc_meta_header_t meta_header;
+    rmc_uint64_t policy_idx = 0;   /* offset of policy in a meta */
+    rmc_uint32_t name_id = 0;
+    rmc_size_t name_len = 0;
+
+    if (!iter || !policy || iter->meta_idx >= iter->record_end)
+        return 1;
+
+    /* re-align meta header struct by copying*/
+    memcpy(&meta_header, iter->rmc_db + iter->meta_idx, sizeof(rmc_meta_header_t));
+
+    policy_idx = iter->meta_idx + sizeof(rmc_meta_header_t);
+
+    if (iter->names && meta_header.type == RMC_GENERIC_FILE) {
+        memcpy(&name_id, &iter->rmc_db[policy_idx], sizeof(rmc_uint32_t));
+        policy->blob_name = get_name_by_id(iter->names, name_id);
+        name_len = sizeof(rmc_uint32_t);
+    } else {
+        policy->blob_name = (char *)&iter->rmc_db[policy_idx];
+        name_len = strlen(policy->blob_name) + 1;
+    }
+
+    policy->type = meta_header.type;
+    policy->blob = &iter->rmc_db[policy_idx + name_len];
+    policy->blob_len = meta_header.length - sizeof(rmc_meta_header_t) - name_len;
+    policy->next = NULL;
+
+    iter->meta_idx += meta_header.length;
+
+    return 0;
+}
+
+/*
+ * query a RMC_GENERIC_FILE blob in a record, by name ID when names is not NULL
+ * (in) names       : section RMC_SECTION_NAMES, or NULL to query by blob_name
+ * (in) name_id     : ID of blob_name in names
+ *
+ * return: 0 when found, non-zero otherwise
+ */
+static int query_policy_by_name_id(rmc_uint8_t *rmc_db, rmc_uint8_t *names, rmc_names_header_t *header,
+        rmc_uint32_t name_id, rmc_uint64_t record_idx, char *blob_name, rmc_file_t *policy) {
+    rmc_uint64_t meta_idx = 0;
+
+    if (!names)
+        return query_policy_from_record(rmc_db, record_idx, RMC_GENERIC_FILE, blob_name, policy);
+
+    if ((meta_idx = find_meta_by_name_id(names, header, record_idx, name_id)) == 0)
+        return 1;
+
+    get_policy_in_meta(rmc_db, meta_idx, policy);
+
+    return 0;
+}
+
+int query_policy_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_uint8_t type, char *blob_name, rmc_file_t *policy) {
+    rmc_uint64_t record_idx = 0;   /* offset of each reacord in db*/
+    rmc_names_header_t names_header;
+    rmc_uint8_t *names = NULL;
+    rmc_uint32_t name_id = 0;
+
+    if (!fingerprint || !rmc_db || !policy)
+        return 1;
+
+    if (type != RMC_GENERIC_FILE || blob_name == NULL || is_rmcdb(rmc_db))
+        return 1;
+
+    /* name is resolved once, and no record needs to be located for a missing name */
+    if ((names = get_names(rmc_db, &names_header)) != NULL &&
+        (name_id = find_name_id(names, &names_header, blob_name)) == RMC_NAME_NONE)
+        return 1;
+
+    /* more than one record could match the board, keep looking into the
+     * next matched record until we find the meta
+     */
+    while (!query_record_from_db(fingerprint, rmc_db, &record_idx)) {
+        if (!query_policy_by_name_id(rmc_db, names, &names_header, name_id, record_idx, blob_name, policy))
+            return 0;
+    }
+
+    return 1;
+}
+
+int rmcl_open_db(rmc_uint8_t *db_blob, rmc_size_t len, rmc_db_handle_t *handle) {
+    if (!handle || validate_rmcdb(db_blob, len))
+        return 1;
+
+    handle->db = db_blob;
+    handle->len = len;
+
+    return 0;
+}
+
+int query_policy_from_handle(rmc_fingerprint_t *fingerprint, const rmc_db_handle_t *handle,
+        rmc_uint8_t type, char *blob_name, rmc_file_t *policy) {
+    if (!handle)
+        return 1;
+
+    return query_policy_from_db(fingerprint, handle->db, type, blob_name, policy);
+}
+
+int rmcl_init_query_ctx(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_query_ctx_t *ctx) {
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t idx = 0;
+
+    if (!fingerprint || !rmc_db || !ctx || is_rmcdb(rmc_db))
+        return 1;
+
+    if (generate_signature_from_fingerprint(fingerprint, &ctx->signature))
+        return 1;
+
+    if (query_section_from_db(rmc_db, RMC_SECTION_TRIE, &ctx->section_idx, &section_len))
+        ctx->section_idx = 0;
+
+    ctx->rmc_db = rmc_db;
+    ctx->fingerprint = *fingerprint;
+    ctx->record_num = 0;
+    ctx->more = 0;
+
+    while ((idx = next_record(rmc_db, ctx->section_idx, fingerprint, &ctx->signature, idx))) {
+        if (ctx->record_num == RMC_QUERY_CTX_RECORDS) {
+            ctx->more = 1;
+            break;
+        }
+
+        ctx->record_idx[ctx->record_num++] = idx;
+    }
+
+    return 0;
+}
+
+int query_policy_from_ctx(rmc_query_ctx_t *ctx, rmc_uint8_t type, char *blob_name, rmc_file_t *policy) {
+    rmc_names_header_t names_header;
+    rmc_uint8_t *names = NULL;
+    rmc_uint32_t name_id = 0;
+    rmc_uint64_t idx = 0;
+    rmc_uint32_t i;
+
+    if (!ctx || !policy || type != RMC_GENERIC_FILE || blob_name == NULL)
+        return 1;
+
+    if ((names = get_names(ctx->rmc_db, &names_header)) != NULL &&
+        (name_id = find_name_id(names, &names_header, blob_name)) == RMC_NAME_NONE)
+        return 1;
+
+    for (i = 0; i < ctx->record_num; i++) {
+        idx = ctx->record_idx[i];
+
+        if (!query_policy_by_name_id(ctx->rmc_db, names, &names_header, name_id, idx, blob_name, policy))
+            return 0;
+    }
+
+    /* records not kept in context are located again after the last kept one */
+    while (ctx->more &&
+        (idx = next_record(ctx->rmc_db, ctx->section_idx, &ctx->fingerprint, &ctx->signature, idx))) {
+        if (!query_policy_by_name_id(ctx->rmc_db, names, &names_header, name_id, idx, blob_name, policy))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * get section RMC_SECTION_BOARD of a database
+ * (out) header     : header of section
+ *
+ * return: start of section, or NULL when database has none
+ */
+static rmc_uint8_t *get_boards(rmc_uint8_t *rmc_db, rmc_board_header_t *header) {
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+
+    if (query_section_from_db(rmc_db, RMC_SECTION_BOARD, &section_idx, &section_len))
+        return NULL;
+
+    memcpy(header, rmc_db + section_idx, sizeof(rmc_board_header_t));
+
+    return rmc_db + section_idx;
+}
+
+int query_board_id_from_db(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_uint32_t *board_id,
+        rmc_uint32_t *board_num) {
+    rmc_board_header_t header;
+    rmc_signature_t signature;
+    rmc_signature_t sig;
+    rmc_uint8_t *section = NULL;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+
+    if (!fingerprint || !rmc_db || !board_id || is_rmcdb(rmc_db))
+        return 1;
+
+    if ((section = get_boards(rmc_db, &header)) == NULL)
+        return 1;
+
+    if (generate_signature_from_fingerprint(fingerprint, &signature))
+        return 1;
+
+    for (low = 0, high = header.board_num; low < high;) {
+        mid = low + (high - low) / 2;
+        memcpy(&sig, section + header.sig_idx + mid * sizeof(rmc_signature_t), sizeof(rmc_signature_t));
+
+        if (compare_signatures(&sig, &signature) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == header.board_num)
+        return 1;
+
+    memcpy(&sig, section + header.sig_idx + low * sizeof(rmc_signature_t), sizeof(rmc_signature_t));
+
+    if (compare_signatures(&sig, &signature))
+        return 1;
+
+    *board_id = (rmc_uint32_t)low;
+
+    if (board_num)
+        *board_num = (rmc_uint32_t)header.board_num;
+
+    return 0;
+}
+
+/*
+ * query a blob in records of a board in section RMC_SECTION_BOARD
+ * (in) names       : section RMC_SECTION_NAMES to query by name_id, or NULL to
+ *                    query by blob_name
+ */
+static int query_policy_in_board(rmc_uint8_t *rmc_db, rmc_uint32_t board_id, rmc_uint8_t *names,
+        rmc_names_header_t *names_header, rmc_uint32_t name_id, char *blob_name, rmc_file_t *policy) {
+    rmc_board_header_t header;
+    rmc_uint8_t *section = NULL;
+    rmc_uint64_t first = 0;
+    rmc_uint64_t next = 0;
+    rmc_uint64_t record_idx = 0;
+
+    if ((section = get_boards(rmc_db, &header)) == NULL || board_id >= header.board_num)
+        return 1;
+
+    memcpy(&first, section + header.first_idx + board_id * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+    memcpy(&next, section + header.first_idx + (board_id + 1) * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+    for (; first < next; first++) {
+        memcpy(&record_idx, section + header.record_idx + first * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+        if (!query_policy_by_name_id(rmc_db, names, names_header, name_id, record_idx, blob_name, policy))
+            return 0;
+    }
+
+    return 1;
+}
+
+int query_policy_by_board_id(rmc_uint8_t *rmc_db, rmc_uint32_t board_id, rmc_uint8_t type, char *blob_name,
+        rmc_file_t *policy) {
+    rmc_names_header_t names_header;
+    rmc_uint8_t *names = NULL;
+    rmc_uint32_t name_id = 0;
+
+    if (!rmc_db || !policy || type != RMC_GENERIC_FILE || blob_name == NULL)
+        return 1;
+
+    if ((names = get_names(rmc_db, &names_header)) != NULL &&
+        (name_id = find_name_id(names, &names_header, blob_name)) == RMC_NAME_NONE)
+        return 1;
+
+    return query_policy_in_board(rmc_db, board_id, names, &names_header, name_id, blob_name, policy);
+}
+
+int query_name_id_from_db(rmc_uint8_t *rmc_db, char *blob_name, rmc_uint32_t *name_id, rmc_uint32_t *name_num) {
+    rmc_names_header_t header;
+    rmc_uint8_t *section = NULL;
+    rmc_uint32_t id = 0;
+
+    if (!rmc_db || !blob_name || !name_id || is_rmcdb(rmc_db))
+        return 1;
+
+    if ((section = get_names(rmc_db, &header)) == NULL ||
+        (id = find_name_id(section, &header, blob_name)) == RMC_NAME_NONE)
+        return 1;
+
+    *name_id = id;
+
+    if (name_num)
+        *name_num = (rmc_uint32_t)header.name_num;
+
+    return 0;
+}
+
+int query_policy_by_ids(rmc_uint8_t *rmc_db, rmc_uint32_t board_id, rmc_uint32_t name_id, rmc_file_t *policy) {
+    rmc_names_header_t header;
+    rmc_uint8_t *section = NULL;
+
+    if (!rmc_db || !policy)
+        return 1;
+
+    if ((section = get_names(rmc_db, &header)) == NULL || name_id >= header.name_num)
+        return 1;
+
+    return query_policy_in_board(rmc_db, board_id, section, &header, name_id, NULL, policy);
+}
+
+int init_name_iter(rmc_uint8_t *rmc_db, char *blob_name, rmc_name_iter_t *iter) {
+    rmc_db_header_t db_header;
+    rmc_postings_header_t header;
+    rmc_names_header_t names_header;
+    rmc_uint8_t *names = NULL;
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint32_t name_id = 0;
+
+    if (!rmc_db || !blob_name || !iter || is_rmcdb(rmc_db))
+        return 1;
+
+    iter->rmc_db = rmc_db;
+    iter->blob_name = blob_name;
+
+    /* scan records when there is no posting list */
+    if (query_section_from_db(rmc_db, RMC_SECTION_POSTINGS, &section_idx, &section_len) ||
+        (names = get_names(rmc_db, &names_header)) == NULL) {
+        memcpy(&db_header, rmc_db, sizeof(rmc_db_header_t));
+        iter->postings = NULL;
+        iter->pos = sizeof(rmc_db_header_t);
+        iter->end = db_header.length;
+
+        return 0;
+    }
+
+    memcpy(&header, rmc_db + section_idx, sizeof(rmc_postings_header_t));
+    iter->postings = rmc_db + section_idx + header.posting_idx;
+    iter->pos = 0;
+    iter->end = 0;
+
+    if ((name_id = find_name_id(names, &names_header, blob_name)) != RMC_NAME_NONE) {
+        memcpy(&iter->pos, rmc_db + section_idx + header.first_idx + name_id * sizeof(rmc_uint64_t),
+            sizeof(rmc_uint64_t));
+        memcpy(&iter->end, rmc_db + section_idx + header.first_idx + (name_id + 1) * sizeof(rmc_uint64_t),
+            sizeof(rmc_uint64_t));
+    }
+
+    return 0;
+}
+
+int next_record_with_name(rmc_name_iter_t *iter, rmc_uint64_t *record_idx, rmc_file_t *policy) {
+    rmc_record_header_t record_header;
+    rmc_posting_t posting;
+
+    if (!iter || !record_idx || !policy)
+        return 1;
+
+    if (iter->postings) {
+        if (iter->pos >= iter->end)
+            return 1;
+
+        memcpy(&posting, iter->postings + iter->pos * sizeof(rmc_posting_t), sizeof(rmc_posting_t));
+        iter->pos++;
+        *record_idx = posting.record_idx;
+        get_policy_in_meta(iter->rmc_db, posting.meta_idx, policy);
+
+        return 0;
+    }
+
+    while (iter->pos < iter->end) {
+        *record_idx = iter->pos;
+        memcpy(&record_header, iter->rmc_db + iter->pos, sizeof(rmc_record_header_t));
+        iter->pos += record_header.length;
+
+        if (!query_policy_from_record(iter->rmc_db, *record_idx, RMC_GENERIC_FILE, iter->blob_name, policy))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * check if a board matches a rule of pattern record, blob is within bounds
+ * return: rank of record by finger_priority(), or 0 when board doesn't match
+ */
+static rmc_uint32_t match_pattern(rmc_fingerprint_t *fingerprint, rmc_uint8_t *blob, rmc_size_t len) {
+    rmc_uint8_t finger_mask = 0;
+    rmc_size_t pos = 1;
+    rmc_size_t end = 0;
+    const char *value = NULL;
+    int i;
+
+    if (len < 1 || !blob[0] || blob[0] >= RMC_FINGER_BIT(RMC_FINGER_NUM))
+        return 0;
+
+    finger_mask = blob[0];
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if (!(finger_mask & RMC_FINGER_BIT(i)))
+            continue;
+
+        for (end = pos; end < len && blob[end]; end++)
+            ;
+
+        if (end == len)
+            return 0;
+
+        value = fingerprint->rmc_fingers[i].value ? fingerprint->rmc_fingers[i].value : "";
+
+        if (compare_names((const rmc_uint8_t *)value, blob + pos))
+            return 0;
+
+        pos = end + 1;
+    }
+
+    return finger_priority(finger_mask);
+}
+
+/*
+ * compare_names() on name a of at most n bytes
+ * return: same as compare_names(), or positive when a is not terminated in n bytes
+ */
+static int compare_names_within(const rmc_uint8_t *a, rmc_uint64_t n, const rmc_uint8_t *b) {
+    rmc_uint64_t i;
+
+    for (i = 0; i < n; i++) {
+        if (!a[i] || a[i] != b[i])
+            return a[i] - b[i];
+    }
+
+    return 1;
+}
+
+/*
+ * resolve a blob name to its ID in section RMC_SECTION_NAMES of a database not
+ * validated, every access is checked against len
+ * (out) name       : name in section
+ *
+ * return: ID of name, or RMC_NAME_NONE when name is not found or data is malformed
+ */
+static rmc_uint32_t find_name_id_in_buffer(rmc_uint8_t *rmc_db, rmc_size_t len, const char *blob_name,
+        char **name) {
+    rmc_db_header_t db_header;
+    rmc_ext_header_t ext_header;
+    rmc_section_header_t section_header;
+    rmc_names_header_t header;
+    rmc_uint8_t *section = NULL;
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t offset = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    rmc_uint32_t i;
+
+    memcpy(&db_header, rmc_db, sizeof(rmc_db_header_t));
+
+    if (len - db_header.length < sizeof(rmc_ext_header_t))
+        return RMC_NAME_NONE;
+
+    memcpy(&ext_header, rmc_db + db_header.length, sizeof(rmc_ext_header_t));
+
+    if (strncmp((const char *)ext_header.signature, (const char *)rmc_ext_signature, RMC_EXT_SIG_LEN) ||
+        ext_header.section_num > (len - db_header.length - sizeof(rmc_ext_header_t)) / sizeof(rmc_section_header_t))
+        return RMC_NAME_NONE;
+
+    for (i = 0; i < ext_header.section_num && !section; i++) {
+        memcpy(&section_header, rmc_db + db_header.length + sizeof(rmc_ext_header_t) +
+            i * sizeof(rmc_section_header_t), sizeof(rmc_section_header_t));
+
+        if (section_header.type != RMC_SECTION_NAMES)
+            continue;
+
+        /* section data must be in extensions, out of records and extension header */
+        if (section_header.offset < db_header.length + sizeof(rmc_ext_header_t) ||
+            section_header.offset > len || section_header.length > len - section_header.offset ||
+            section_header.length < sizeof(rmc_names_header_t))
+            return RMC_NAME_NONE;
+
+        section = rmc_db + section_header.offset;
+        section_len = section_header.length;
+    }
+
+    if (!section)
+        return RMC_NAME_NONE;
+
+    memcpy(&header, section, sizeof(rmc_names_header_t));
+
+    if (header.name_num > RMC_NAME_NONE || header.name_idx > section_len ||
+        header.name_num > (section_len - header.name_idx) / sizeof(rmc_uint64_t) ||
+        header.string_idx > section_len || header.string_len > section_len - header.string_idx)
+        return RMC_NAME_NONE;
+
+    for (low = 0, high = header.name_num; low < high;) {
+        mid = low + (high - low) / 2;
+        memcpy(&offset, section + header.name_idx + mid * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+        if (offset >= header.string_len)
+            return RMC_NAME_NONE;
+
+        if (compare_names_within(section + header.string_idx + offset, header.string_len - offset,
+            (const rmc_uint8_t *)blob_name) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == header.name_num)
+        return RMC_NAME_NONE;
+
+    memcpy(&offset, section + header.name_idx + low * sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+
+    if (offset >= header.string_len ||
+        compare_names_within(section + header.string_idx + offset, header.string_len - offset,
+        (const rmc_uint8_t *)blob_name))
+        return RMC_NAME_NONE;
+
+    *name = (char *)section + header.string_idx + offset;
+
+    return (rmc_uint32_t)low;
+}
+
+int query_policy_from_buffer(rmc_fingerprint_t *fingerprint, rmc_uint8_t *rmc_db, rmc_size_t len,
+        rmc_uint8_t type, char *blob_name, rmc_file_t *policy) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_meta_header_t meta_header;
+    rmc_signature_t signature;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t record_end = 0;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint64_t name_idx = 0;
+    rmc_uint64_t found_idx = 0;    /* meta of blob in current record */
+    rmc_uint64_t best_idx = 0;     /* meta of blob in the most specific record so far */
+    rmc_uint32_t best = 0;
+    rmc_uint32_t priority = 0;
+    rmc_uint32_t name_id = 0;
+    rmc_uint32_t meta_name_id = 0;
+    rmc_size_t name_len = 0;
+    char *name = NULL;             /* name in section RMC_SECTION_NAMES, NULL in version 1 */
+    int has_rule = 0;
+
+    if (!fingerprint || !rmc_db || !policy || len < sizeof(rmc_db_header_t) || is_rmcdb(rmc_db))
+        return 1;
+
+    if (type != RMC_GENERIC_FILE || blob_name == NULL)
+        return 1;
+
+    if (generate_signature_from_fingerprint(fingerprint, &signature))
+        return 1;
+
+    memcpy(&db_header, rmc_db, sizeof(rmc_db_header_t));
+
+    if (db_header.length > len)
+        return 1;
+
+    name_len = strlen(blob_name) + 1;
+
+    /* metas of a version 2 database have IDs of names, which are compared instead */
+    if (db_header.version >= RMC_DB_VERSION_2) {
+        if ((name_id = find_name_id_in_buffer(rmc_db, len, blob_name, &name)) == RMC_NAME_NONE)
+            return 1;
+
+        name_len = sizeof(rmc_uint32_t);
+    }
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header.length; record_idx = record_end) {
+        if (db_header.length - record_idx < sizeof(rmc_record_header_t))
+            return 1;
+
+        memcpy(&record_header, rmc_db + record_idx, sizeof(rmc_record_header_t));
+
+        if (record_header.length < sizeof(rmc_record_header_t) ||
+            record_header.length > db_header.length - record_idx)
+            return 1;
+
+        record_end = record_idx + record_header.length;
+        priority = match_record(&record_header, &signature) ? 0 : finger_priority(RMC_SIGNATURE_FINGERS);
+        found_idx = 0;
+        has_rule = 0;
+
+        for (meta_idx = record_idx + sizeof(rmc_record_header_t); meta_idx < record_end;
+            meta_idx += meta_header.length) {
+            if (record_end - meta_idx < sizeof(rmc_meta_header_t))
+                return 1;
+
+            memcpy(&meta_header, rmc_db + meta_idx, sizeof(rmc_meta_header_t));
+
+            if (meta_header.length <= sizeof(rmc_meta_header_t) ||
+                meta_header.length > record_end - meta_idx)
+                return 1;
+
+            if (name && meta_header.type == RMC_GENERIC_FILE) {
+                if (meta_header.length - sizeof(rmc_meta_header_t) < sizeof(rmc_uint32_t))
+                    return 1;
+
+                memcpy(&meta_name_id, rmc_db + meta_idx + sizeof(rmc_meta_header_t), sizeof(rmc_uint32_t));
+
+                if (meta_header.type == type && !found_idx && meta_name_id == name_id)
+                    found_idx = meta_idx;
+
+                continue;
+            }
+
+            for (name_idx = meta_idx + sizeof(rmc_meta_header_t);
+                name_idx < meta_idx + meta_header.length && rmc_db[name_idx]; name_idx++)
+                ;
+
+            if (name_idx == meta_idx + meta_header.length)
+                return 1;
+
+            /* rule of a pattern record decides if it matches, not signature */
+            if (meta_header.type == RMC_MATCH_FILE && !has_rule) {
+                has_rule = 1;
+                priority = match_pattern(fingerprint, rmc_db + name_idx + 1,
+                    meta_idx + meta_header.length - name_idx - 1);
+            } else if (meta_header.type == type && !found_idx &&
+                !strncmp(blob_name, (char *)rmc_db + meta_idx + sizeof(rmc_meta_header_t), name_len))
+                found_idx = meta_idx;
+        }
+
+        /* the earlier record wins among records equally specific */
+        if (found_idx && priority > best) {
+            best = priority;
+            best_idx = found_idx;
+        }
+    }
+
+    if (!best_idx)
+        return 1;
+
+    memcpy(&meta_header, rmc_db + best_idx, sizeof(rmc_meta_header_t));
+    policy->type = type;
+    policy->blob_name = name ? name : (char *)rmc_db + best_idx + sizeof(rmc_meta_header_t);
+    policy->blob = rmc_db + best_idx + sizeof(rmc_meta_header_t) + name_len;
+    policy->blob_len = meta_header.length - sizeof(rmc_meta_header_t) - name_len;
+    policy->next = NULL;
+
+    return 0;
+}
+
+int rmcl_fill_handoff(rmc_fingerprint_t *fingerprint, rmc_handoff_t *handoff) {
+    const char *value = NULL;
+    int i;
+
+    if (!fingerprint || !handoff)
+        return 1;
+
+    memset(handoff, 0, sizeof(rmc_handoff_t));
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        value = fingerprint->rmc_fingers[i].value ? fingerprint->rmc_fingers[i].value : "";
+
+        if (strlen(value) >= RMC_FINGER_VALUE_LEN)
+            return 1;
+
+        strncpy(handoff->values[i], value, RMC_FINGER_VALUE_LEN);
+    }
+
+    if (generate_signature_from_fingerprint(fingerprint, &handoff->board_signature))
+        return 1;
+
+    memcpy(handoff->signature, rmc_handoff_signature, RMC_HANDOFF_SIG_LEN);
+    handoff->version = RMC_HANDOFF_VERSION;
+    handoff->length = sizeof(rmc_handoff_t);
+    handoff->crc = rmc_crc32(0, handoff, sizeof(rmc_handoff_t));
+
+    return 0;
+}
+
+int rmcl_check_handoff(rmc_handoff_t *handoff, rmc_size_t len, rmc_fingerprint_t *fingerprint) {
+    rmc_signature_t signature;
+    rmc_uint32_t crc = 0;
+    int i;
+
+    if (!handoff || !fingerprint || len != sizeof(rmc_handoff_t))
+        return 1;
+
+    if (strncmp((const char *)handoff->signature, (const char *)rmc_handoff_signature, RMC_HANDOFF_SIG_LEN) ||
+        handoff->version != RMC_HANDOFF_VERSION || handoff->length != sizeof(rmc_handoff_t))
+        return 1;
+
+    crc = handoff->crc;
+    handoff->crc = 0;
+
+    if (rmc_crc32(0, handoff, sizeof(rmc_handoff_t)) != crc) {
+        handoff->crc = crc;
+        return 1;
+    }
+
+    handoff->crc = crc;
+    initialize_fingerprint(fingerprint);
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if (handoff->values[i][RMC_FINGER_VALUE_LEN - 1])
+            return 1;
+
+        fingerprint->rmc_fingers[i].value = handoff->values[i];
+    }
+
+    /* values must be the ones signature was computed from */
+    if (generate_signature_from_fingerprint(fingerprint, &signature) ||
+        compare_signatures(&signature, &handoff->board_signature))
+        return 1;
+
+    return 0;
+}
+
+/*
+ * compare a null-terminated string at an offset with s, read in chunks
+ * (in) len             : length of s including its terminator
+ * (out) cmp            : same as compare_names() on data and s
+ *
+ * return: 0 when data is read, non-zero when read_at fails
+ */
+static int read_compare(rmc_read_at_t read_at, void *ctx, rmc_uint64_t offset, const char *s,
+        rmc_size_t len, int *cmp) {
+    rmc_uint8_t chunk[64];
+    const rmc_uint8_t *p = (const rmc_uint8_t *)s;
+    rmc_size_t n = 0;
+    rmc_size_t i = 0;
+
+    *cmp = 0;
+
+    for (; len; len -= n, offset += n, p += n) {
+        n = len < sizeof(chunk) ? len : sizeof(chunk);
+
+        if (read_at(ctx, offset, n, chunk))
+            return 1;
+
+        /* s has no terminator before its end, data ends where they differ */
+        for (i = 0; i < n; i++) {
+            if (chunk[i] != p[i]) {
+                *cmp = chunk[i] - p[i];
+                return 0;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * resolve a blob name to its ID in section RMC_SECTION_NAMES of a database read by
+ * read_at, like find_name_id() does
+ * (in) ext_idx         : offset of extensions, the end of records
+ * (out) name_id        : ID of name, RMC_NAME_NONE when it is not found
+ *
+ * return: 0 when data is read, non-zero when read_at fails or data is malformed
+ */
+static int read_name_id(rmc_read_at_t read_at, void *ctx, rmc_uint64_t ext_idx, const char *blob_name,
+        rmc_uint32_t *name_id) {
+    rmc_ext_header_t ext_header;
+    rmc_section_header_t section_header;
+    rmc_names_header_t header;
+    rmc_uint64_t offset = 0;
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = 0;
+    rmc_uint64_t mid = 0;
+    rmc_size_t name_len = strlen(blob_name) + 1;
+    rmc_uint32_t i;
+    int cmp = 0;
+
+    *name_id = RMC_NAME_NONE;
+
+    if (read_at(ctx, ext_idx, sizeof(rmc_ext_header_t), &ext_header) ||
+        strncmp((const char *)ext_header.signature, (const char *)rmc_ext_signature, RMC_EXT_SIG_LEN))
+        return 1;
+
+    for (i = 0; i < ext_header.section_num; i++) {
+        if (read_at(ctx, ext_idx + sizeof(rmc_ext_header_t) + i * sizeof(rmc_section_header_t),
+            sizeof(rmc_section_header_t), &section_header))
+            return 1;
+
+        if (section_header.type == RMC_SECTION_NAMES)
+            break;
+    }
+
+    if (i == ext_header.section_num || section_header.length < sizeof(rmc_names_header_t) ||
+        read_at(ctx, section_header.offset, sizeof(rmc_names_header_t), &header))
+        return 1;
+
+    if (header.name_num > RMC_NAME_NONE || header.name_idx > section_header.length ||
+        header.name_num > (section_header.length - header.name_idx) / sizeof(rmc_uint64_t) ||
+        header.string_idx > section_header.length ||
+        header.string_len > section_header.length - header.string_idx)
+        return 1;
+
+    for (low = 0, high = header.name_num; low < high;) {
+        mid = low + (high - low) / 2;
+
+        if (read_at(ctx, section_header.offset + header.name_idx + mid * sizeof(rmc_uint64_t),
+            sizeof(rmc_uint64_t), &offset) || offset >= header.string_len ||
+            read_compare(read_at, ctx, section_header.offset + header.string_idx + offset,
+            blob_name, name_len, &cmp))
+            return 1;
+
+        if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == header.name_num)
+        return 0;
+
+    if (read_at(ctx, section_header.offset + header.name_idx + low * sizeof(rmc_uint64_t),
+        sizeof(rmc_uint64_t), &offset) || offset >= header.string_len ||
+        read_compare(read_at, ctx, section_header.offset + header.string_idx + offset,
+        blob_name, name_len, &cmp))
+        return 1;
+
+    if (!cmp)
+        *name_id = (rmc_uint32_t)low;
+
+    return 0;
+}
+
+/*
+ * check if a board matches rule of a pattern record read by read_at, like
+ * match_pattern() does
+ * (in) meta_idx        : offset of meta of rule
+ * (in) meta_end        : offset of the end of meta
+ * (out) priority       : rank of record by finger_priority(), 0 when board doesn't match
+ *
+ * return: 0 when rule is read, non-zero when read_at fails
+ */
+static int read_pattern(rmc_read_at_t read_at, void *ctx, rmc_fingerprint_t *fingerprint,
+        rmc_uint64_t meta_idx, rmc_uint64_t meta_end, rmc_uint32_t *priority) {
+    rmc_uint64_t pos = meta_idx + sizeof(rmc_meta_header_t) + sizeof(RMC_MATCH_NAME);
+    rmc_uint8_t finger_mask = 0;
+    const char *value = NULL;
+    rmc_size_t value_len = 0;
+    int cmp = 0;
+    int i;
+
+    *priority = 0;
+
+    if (meta_end <= pos)
+        return 0;
+
+    if (read_compare(read_at, ctx, meta_idx + sizeof(rmc_meta_header_t), RMC_MATCH_NAME,
+        sizeof(RMC_MATCH_NAME), &cmp))
+        return 1;
+
+    if (cmp)
+        return 0;
+
+    if (read_at(ctx, pos++, 1, &finger_mask))
+        return 1;
+
+    if (!finger_mask || finger_mask >= RMC_FINGER_BIT(RMC_FINGER_NUM))
+        return 0;
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if (!(finger_mask & RMC_FINGER_BIT(i)))
+            continue;
+
+        value = fingerprint->rmc_fingers[i].value ? fingerprint->rmc_fingers[i].value : "";
+        value_len = strlen(value) + 1;
+
+        if (meta_end - pos < value_len)
+            return 0;
+
+        if (read_compare(read_at, ctx, pos, value, value_len, &cmp))
+            return 1;
+
+        if (cmp)
+            return 0;
+
+        pos += value_len;
+    }
+
+    *priority = finger_priority(finger_mask);
+
+    return 0;
+}
+
+int query_policy_by_read_at(rmc_fingerprint_t *fingerprint, rmc_read_at_t read_at, void *ctx,
+        rmc_uint8_t type, char *blob_name, void *buf, rmc_size_t buf_len, rmc_size_t *len) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_meta_header_t meta_header;
+    rmc_signature_t signature;
+    rmc_uint8_t heads[sizeof(rmc_record_header_t) + sizeof(rmc_meta_header_t)];
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t record_end = 0;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint64_t best_idx = 0;     /* meta of blob in the most specific record so far */
+    rmc_uint64_t best_len = 0;
+    rmc_uint32_t best = 0;
+    rmc_uint32_t priority = 0;
+    rmc_uint32_t name_id = 0;
+    rmc_uint32_t meta_name_id = 0;
+    rmc_size_t name_len = 0;
+    rmc_size_t head_len = 0;
+    int has_ids = 0;
+    int cmp = 0;
+
+    if (!fingerprint || !read_at || !blob_name || !len || (buf_len && !buf))
+        return 1;
+
+    *len = 0;
+
+    if (type != RMC_GENERIC_FILE)
+        return 1;
+
+    if (generate_signature_from_fingerprint(fingerprint, &signature))
+        return 1;
+
+    if (read_at(ctx, 0, sizeof(rmc_db_header_t), &db_header) || is_rmcdb((rmc_uint8_t *)&db_header))
+        return 1;
+
+    name_len = strlen(blob_name) + 1;
+
+    /* metas of a version 2 database have IDs of names, which are compared instead */
+    if (db_header.version >= RMC_DB_VERSION_2) {
+        if (read_name_id(read_at, ctx, db_header.length, blob_name, &name_id) || name_id == RMC_NAME_NONE)
+            return 1;
+
+        name_len = sizeof(rmc_uint32_t);
+        has_ids = 1;
+    }
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header.length; record_idx = record_end) {
+        if (db_header.length - record_idx < sizeof(rmc_record_header_t))
+            return 1;
+
+        /* record header and the first meta header in one read */
+        head_len = db_header.length - record_idx < sizeof(heads) ?
+            sizeof(rmc_record_header_t) : sizeof(heads);
+
+        if (read_at(ctx, record_idx, head_len, heads))
+            return 1;
+
+        memcpy(&record_header, heads, sizeof(rmc_record_header_t));
+
+        if (record_header.length < sizeof(rmc_record_header_t) ||
+            record_header.length > db_header.length - record_idx)
+            return 1;
+
+        record_end = record_idx + record_header.length;
+        meta_idx = record_idx + sizeof(rmc_record_header_t);
+        priority = match_record(&record_header, &signature) ? 0 : finger_priority(RMC_SIGNATURE_FINGERS);
+
+        if (record_end - meta_idx < sizeof(rmc_meta_header_t))
+            continue;
+
+        memcpy(&meta_header, heads + sizeof(rmc_record_header_t), sizeof(rmc_meta_header_t));
+
+        if (meta_header.length <= sizeof(rmc_meta_header_t) || meta_header.length > record_end - meta_idx)
+            return 1;
+
+        /* rule of a pattern record is its first meta, see rmcl_generate_pattern_record() */
+        if (meta_header.type == RMC_MATCH_FILE &&
+            read_pattern(read_at, ctx, fingerprint, meta_idx, meta_idx + meta_header.length, &priority))
+            return 1;
+
+        /* the earlier record wins among records equally specific, metas of a record
+         * which can't win are never read
+         */
+        if (priority <= best)
+            continue;
+
+        while (1) {
+            if (meta_header.type == type && meta_header.length - sizeof(rmc_meta_header_t) >= name_len) {
+                if (has_ids) {
+                    if (read_at(ctx, meta_idx + sizeof(rmc_meta_header_t), sizeof(rmc_uint32_t), &meta_name_id))
+                        return 1;
+
+                    cmp = meta_name_id != name_id;
+                } else if (read_compare(read_at, ctx, meta_idx + sizeof(rmc_meta_header_t), blob_name,
+                    name_len, &cmp))
+                    return 1;
+
+                if (!cmp) {
+                    best = priority;
+                    best_idx = meta_idx;
+                    best_len = meta_header.length - sizeof(rmc_meta_header_t) - name_len;
+                    break;
+                }
+            }
+
+            meta_idx += meta_header.length;
+
+            if (meta_idx == record_end)
+                break;
+
+            if (record_end - meta_idx < sizeof(rmc_meta_header_t) ||
+                read_at(ctx, meta_idx, sizeof(rmc_meta_header_t), &meta_header))
+                return 1;
+
+            if (meta_header.length <= sizeof(rmc_meta_header_t) || meta_header.length > record_end - meta_idx)
+                return 1;
+        }
+    }
+
+    if (!best_idx)
+        return 1;
+
+    *len = best_len;
+
+    if (best_len > buf_len)
+        return 1;
+
+    if (best_len && read_at(ctx, best_idx + sizeof(rmc_meta_header_t) + name_len, best_len, buf))
+        return 1;
+
+    return 0;
+}
+
+int query_policy_from_static_db(rmc_fingerprint_t *fingerprint, const rmc_static_db_t *db,
+        char *blob_name, rmc_file_t *policy) {
+    rmc_signature_t signature;
+    rmc_record_header_t record_header;
+    rmc_static_slot_t slot;
+    rmc_uint8_t *data = NULL;
+
+    if (!db || !db->bucket_num || !db->slot_num || !blob_name || !policy)
+        return 1;
+
+    if (generate_signature_from_fingerprint(fingerprint, &signature))
+        return 1;
+
+    slot = db->slots[rmcl_static_slot(rmcl_static_hash(db->seed, &signature, blob_name),
+        db->bucket_num, db->displacements, db->slot_num)];
+
+    if (!slot.meta_idx)
+        return 1;
+
+    /* data is never written, rmc_file_t just doesn't have const members */
+    data = (rmc_uint8_t *)db->data;
+
+    /* a key not in table hashes to a slot of another key */
+    memcpy(&record_header, data + slot.record_idx, sizeof(rmc_record_header_t));
+
+    if (match_record(&record_header, &signature))
+        return 1;
+
+    get_policy_in_meta(data, slot.meta_idx, policy);
+
+    return compare_names((rmc_uint8_t *)policy->blob_name, (rmc_uint8_t *)blob_name) ? 1 : 0;
 }
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* SHA-256 (FIPS 180-4) */
+
+#include <rmc_types.h>
+#include <rmcl.h>
+
+#ifdef RMC_EFI
+#include <rmc_util.h>
+#endif
+
+static const rmc_uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define EP0(x)      (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define EP1(x)      (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SIG0(x)     (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SIG1(x)     (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+/* process a 64-byte block */
+static void sha256_block(rmc_uint32_t *state, const rmc_uint8_t *block) {
+    rmc_uint32_t w[64];
+    rmc_uint32_t a, b, c, d, e, f, g, h, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        w[i] = ((rmc_uint32_t)block[i * 4] << 24) | ((rmc_uint32_t)block[i * 4 + 1] << 16) |
+               ((rmc_uint32_t)block[i * 4 + 2] << 8) | (rmc_uint32_t)block[i * 4 + 3];
+
+    for (i = 16; i < 64; i++)
+        w[i] = SIG1(w[i - 2]) + w[i - 7] + SIG0(w[i - 15]) + w[i - 16];
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i++) {
+        t1 = h + EP1(e) + CH(e, f, g) + sha256_k[i] + w[i];
+        t2 = EP0(a) + MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void rmc_sha256(const void *data, rmc_size_t len, rmc_uint8_t digest[RMC_SHA256_LEN]) {
+    rmc_uint32_t state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    const rmc_uint8_t *p = (const rmc_uint8_t *)data;
+    rmc_uint64_t bits = (rmc_uint64_t)len * 8;
+    rmc_uint8_t last[128];
+    rmc_size_t rest = 0;
+    rmc_size_t last_len = 0;
+    int i;
+
+    for (; len >= 64; len -= 64, p += 64)
+        sha256_block(state, p);
+
+    /* pad the rest with 0x80, zeros and length in bits into one or two blocks */
+    rest = len;
+    memset(last, 0, sizeof(last));
+    memcpy(last, p, rest);
+    last[rest] = 0x80;
+    last_len = rest < 56 ? 64 : 128;
+
+    for (i = 0; i < 8; i++)
+        last[last_len - 1 - i] = (rmc_uint8_t)(bits >> (i * 8));
+
+    sha256_block(state, last);
+
+    if (last_len == 128)
+        sha256_block(state, last + 64);
+
+    for (i = 0; i < 8; i++) {
+        digest[i * 4] = (rmc_uint8_t)(state[i] >> 24);
+        digest[i * 4 + 1] = (rmc_uint8_t)(state[i] >> 16);
+        digest[i * 4 + 2] = (rmc_uint8_t)(state[i] >> 8);
+        digest[i * 4 + 3] = (rmc_uint8_t)state[i];
+    }
+}
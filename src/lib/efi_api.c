@@ -97,6 +97,47 @@ int rmc_query_file_by_fp(rmc_fingerprint_t *fp, rmc_uint8_t *db_blob, char *file
     return query_policy_from_db(fp, db_blob, RMC_GENERIC_FILE, file_name, file);
 }
 
+int rmc_query_file_by_handle(rmc_fingerprint_t *fp, const rmc_db_handle_t *handle, char *file_name, rmc_file_t *file) {
+    return query_policy_from_handle(fp, handle, RMC_GENERIC_FILE, file_name, file);
+}
+
+int rmc_query_file_by_buffer(rmc_fingerprint_t *fp, rmc_uint8_t *db_blob, rmc_size_t len, char *file_name, rmc_file_t *file) {
+    return query_policy_from_buffer(fp, db_blob, len, RMC_GENERIC_FILE, file_name, file);
+}
+
+int rmc_query_file_by_static_db(rmc_fingerprint_t *fp, const rmc_static_db_t *db, char *file_name, rmc_file_t *file) {
+    return query_policy_from_static_db(fp, db, file_name, file);
+}
+
+int rmc_init_query_ctx_by_fp(rmc_fingerprint_t *fp, rmc_uint8_t *db_blob, rmc_query_ctx_t *ctx) {
+    return rmcl_init_query_ctx(fp, db_blob, ctx);
+}
+
+int rmc_query_file_by_ctx(rmc_query_ctx_t *ctx, char *file_name, rmc_file_t *file) {
+    return query_policy_from_ctx(ctx, RMC_GENERIC_FILE, file_name, file);
+}
+
+int rmc_query_file_by_read_at(rmc_fingerprint_t *fp, rmc_read_at_t read_at, void *ctx, char *file_name,
+        void *buf, rmc_size_t buf_len, rmc_size_t *len) {
+    return query_policy_by_read_at(fp, read_at, ctx, RMC_GENERIC_FILE, file_name, buf, buf_len, len);
+}
+
+int rmc_get_board_id(rmc_fingerprint_t *fp, rmc_uint8_t *db_blob, rmc_uint32_t *board_id, rmc_uint32_t *board_num) {
+    return query_board_id_from_db(fp, db_blob, board_id, board_num);
+}
+
+int rmc_query_file_by_board_id(rmc_uint8_t *db_blob, rmc_uint32_t board_id, char *file_name, rmc_file_t *file) {
+    return query_policy_by_board_id(db_blob, board_id, RMC_GENERIC_FILE, file_name, file);
+}
+
+int rmc_get_name_id(rmc_uint8_t *db_blob, char *file_name, rmc_uint32_t *name_id, rmc_uint32_t *name_num) {
+    return query_name_id_from_db(db_blob, file_name, name_id, name_num);
+}
+
+int rmc_query_file_by_ids(rmc_uint8_t *db_blob, rmc_uint32_t board_id, rmc_uint32_t name_id, rmc_file_t *file) {
+    return query_policy_by_ids(db_blob, board_id, name_id, file);
+}
+
 int rmc_gimme_file(void *sys_table, rmc_uint8_t *db_blob, char *file_name, rmc_file_t *file) {
     rmc_fingerprint_t fp;
 
@@ -111,3 +152,55 @@ int rmc_gimme_file(void *sys_table, rmc_uint8_t *db_blob, char *file_name, rmc_f
     else
         return 0;
 }
+
+int rmc_gimme_static_file(void *sys_table, const rmc_static_db_t *db, char *file_name, rmc_file_t *file) {
+    rmc_fingerprint_t fp;
+
+    if (!sys_table || !db || !file_name || !file)
+        return 1;
+
+    if (rmc_get_fingerprint(sys_table, &fp))
+        return 1;
+
+    return rmc_query_file_by_static_db(&fp, db, file_name, file);
+}
+
+int rmc_init_query_ctx(void *sys_table, rmc_uint8_t *db_blob, rmc_query_ctx_t *ctx) {
+    rmc_fingerprint_t fp;
+
+    if (!sys_table || !db_blob || !ctx)
+        return 1;
+
+    /* finger values reference SMBIOS structures, they stay while ctx is used */
+    if (rmc_get_fingerprint(sys_table, &fp))
+        return 1;
+
+    return rmc_init_query_ctx_by_fp(&fp, db_blob, ctx);
+}
+
+int rmc_gimme_file_by_read_at(void *sys_table, rmc_read_at_t read_at, void *ctx, char *file_name,
+        void *buf, rmc_size_t buf_len, rmc_size_t *len) {
+    rmc_fingerprint_t fp;
+
+    if (!sys_table || !read_at || !file_name || !len)
+        return 1;
+
+    *len = 0;
+
+    if (rmc_get_fingerprint(sys_table, &fp))
+        return 1;
+
+    return rmc_query_file_by_read_at(&fp, read_at, ctx, file_name, buf, buf_len, len);
+}
+
+int rmc_get_handoff(rmc_fingerprint_t *fp, rmc_handoff_t *handoff) {
+    return rmcl_fill_handoff(fp, handoff);
+}
+
+int rmc_check_db(rmc_uint8_t *db_blob, rmc_size_t len) {
+    return validate_rmcdb(db_blob, len);
+}
+
+int rmc_open_db(rmc_uint8_t *db_blob, rmc_size_t len, rmc_db_handle_t *handle) {
+    return rmcl_open_db(db_blob, len, handle);
+}
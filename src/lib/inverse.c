@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Inverse query of RMC database files for Linux user space
+ *
+ * Find records carrying a blob name, e.g. to know which boards get a config
+ * file before changing it. A version 2 database has a posting list of each
+ * name built with the database, so only records having the name are read.
+ * Records of a version 1 database are scanned. Results reference the database
+ * mapping, nothing is copied but signatures.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rmc_api.h>
+
+/* return: non-zero when record is a pattern record, its first meta is the match rule */
+static int is_pattern_record(rmc_uint8_t *db, rmc_uint64_t record_idx) {
+    rmc_record_iter_t iter;
+    rmc_file_t file;
+
+    init_record_iter(db, record_idx, &iter);
+
+    return !next_policy_in_record(&iter, &file) && file.type == RMC_MATCH_FILE;
+}
+
+int rmc_query_carriers(char *db_pathname, char *file_name, rmc_carrier_report_t *report) {
+    rmc_record_header_t record_header;
+    rmc_name_iter_t iter;
+    rmc_carrier_t *carrier = NULL;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t carrier_num = 0;
+    rmc_file_t policy;
+
+    if (!db_pathname || !file_name || !report)
+        return 1;
+
+    memset(report, 0, sizeof(*report));
+
+    if (map_file(db_pathname, &report->db, &report->db_len))
+        return 1;
+
+    if (validate_rmcdb(report->db, report->db_len)) {
+        fprintf(stderr, "%s is not a valid rmc database\n", db_pathname);
+        goto err;
+    }
+
+    if (init_name_iter(report->db, file_name, &iter))
+        goto err;
+
+    while (!next_record_with_name(&iter, &record_idx, &policy))
+        carrier_num++;
+
+    report->carriers = calloc(carrier_num ? carrier_num : 1, sizeof(rmc_carrier_t));
+
+    if (!report->carriers) {
+        perror("rmc: insufficient memory for inverse query");
+        goto err;
+    }
+
+    init_name_iter(report->db, file_name, &iter);
+
+    while (report->carrier_num < carrier_num && !next_record_with_name(&iter, &record_idx, &policy)) {
+        carrier = &report->carriers[report->carrier_num++];
+        memcpy(&record_header, report->db + record_idx, sizeof(rmc_record_header_t));
+
+        carrier->record_idx = record_idx;
+        carrier->signature = record_header.signature;
+        carrier->pattern = is_pattern_record(report->db, record_idx);
+        carrier->blob = policy.blob;
+        carrier->blob_len = policy.blob_len;
+    }
+
+    return 0;
+
+err:
+    free(report->carriers);
+    unmap_file(report->db, report->db_len);
+    memset(report, 0, sizeof(*report));
+
+    return 1;
+}
+
+void rmc_free_carrier_report(rmc_carrier_report_t *report) {
+    if (!report)
+        return;
+
+    free(report->carriers);
+    unmap_file(report->db, report->db_len);
+    memset(report, 0, sizeof(*report));
+}
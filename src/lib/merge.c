@@ -0,0 +1,684 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Merge of RMC database files for Linux user space
+ *
+ * Input databases are mapped and never copied into memory. Records of the same
+ * board (same signature and the same match rule for pattern records) in all
+ * inputs are merged into a single record, in the order a board first appears
+ * in inputs. Blobs of the same name in a merged record are resolved with a
+ * conflict policy, identical ones are stored once. Merged records are streamed
+ * into output file, so memory used is for an index of records and the metas of
+ * one board at a time. Records are written as version 1, a version 2 output is
+ * converted from records mapped back from output file and written over them.
+ *
+ * Records of a database can also be reordered by population of boards, so that
+ * a linear scan of version 1 readers finds common boards first. Records keep
+ * their metas, only their order changes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <rmc_api.h>
+
+/* a record in inputs */
+typedef struct merge_record {
+    rmc_uint8_t *db;
+    rmc_uint64_t record_idx;
+    rmc_uint8_t *match;         /* blob of match rule for a pattern record, NULL otherwise */
+    rmc_size_t match_len;
+    rmc_uint64_t seq;           /* order in inputs */
+    rmc_uint64_t group;         /* seq of the first record of the same board */
+} merge_record_t;
+
+/* a meta in records of a board */
+typedef struct merge_meta {
+    rmc_file_t policy;
+    int layer;                  /* index of database in inputs */
+    rmc_uint64_t seq;           /* order in records of board */
+    rmc_uint64_t pos;           /* seq of the first meta with the same name */
+} merge_meta_t;
+
+static int compare_board(const merge_record_t *x, const merge_record_t *y) {
+    rmc_record_header_t a;
+    rmc_record_header_t b;
+    int ret;
+
+    memcpy(&a, x->db + x->record_idx, sizeof(rmc_record_header_t));
+    memcpy(&b, y->db + y->record_idx, sizeof(rmc_record_header_t));
+
+    if ((ret = memcmp(a.signature.raw, b.signature.raw, sizeof(a.signature.raw))))
+        return ret;
+
+    if (!x->match || !y->match)
+        return (x->match != NULL) - (y->match != NULL);
+
+    if (x->match_len != y->match_len)
+        return x->match_len < y->match_len ? -1 : 1;
+
+    return memcmp(x->match, y->match, x->match_len);
+}
+
+/* sort by board, then in the order of inputs */
+static int compare_record(const void *a, const void *b) {
+    const merge_record_t *x = a;
+    const merge_record_t *y = b;
+    int ret = compare_board(x, y);
+
+    if (ret)
+        return ret;
+
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/* sort by the first record of board, then in the order of inputs */
+static int compare_group(const void *a, const void *b) {
+    const merge_record_t *x = a;
+    const merge_record_t *y = b;
+
+    if (x->group != y->group)
+        return x->group < y->group ? -1 : 1;
+
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/* sort by name and type, then in the order of records */
+static int compare_meta(const void *a, const void *b) {
+    const merge_meta_t *x = a;
+    const merge_meta_t *y = b;
+    int ret = strcmp(x->policy.blob_name, y->policy.blob_name);
+
+    if (ret)
+        return ret;
+
+    if (x->policy.type != y->policy.type)
+        return x->policy.type - y->policy.type;
+
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/* sort by position of names in the order of records */
+static int compare_pos(const void *a, const void *b) {
+    const merge_meta_t *x = a;
+    const merge_meta_t *y = b;
+
+    return (x->pos > y->pos) - (x->pos < y->pos);
+}
+
+static int is_same_meta(const merge_meta_t *x, const merge_meta_t *y) {
+    return x->policy.type == y->policy.type && !strcmp(x->policy.blob_name, y->policy.blob_name);
+}
+
+static int is_same_blob(const merge_meta_t *x, const merge_meta_t *y) {
+    return x->policy.blob_len == y->policy.blob_len &&
+        !memcmp(x->policy.blob, y->policy.blob, x->policy.blob_len);
+}
+
+/* collect every record of inputs, return number of records */
+static rmc_uint64_t collect_records(rmc_uint8_t **dbs, int db_num, merge_record_t *records) {
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    rmc_uint64_t record_idx;
+    rmc_uint64_t n = 0;
+    int i;
+
+    for (i = 0; i < db_num; i++) {
+        for (record_idx = sizeof(rmc_db_header_t); record_idx < ((rmc_db_header_t *)dbs[i])->length;
+            record_idx += record_header.length) {
+            memcpy(&record_header, dbs[i] + record_idx, sizeof(rmc_record_header_t));
+
+            if (records) {
+                records[n].db = dbs[i];
+                records[n].record_idx = record_idx;
+                records[n].match = NULL;
+                records[n].match_len = 0;
+                records[n].seq = n;
+                init_record_iter(dbs[i], record_idx, &iter);
+
+                while (!next_policy_in_record(&iter, &policy)) {
+                    if (policy.type == RMC_MATCH_FILE) {
+                        records[n].match = policy.blob;
+                        records[n].match_len = policy.blob_len;
+                        break;
+                    }
+                }
+            }
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/*
+ * resolve metas of a board with policy
+ * (in/out) metas   : metas of records of a board, winners are moved to the front
+ *                    in the order of their names first appear
+ * (in) num         : number of metas
+ * (out) out_num    : number of metas to write
+ *
+ * return: 0 for success, non-zero for a conflict with RMC_MERGE_ERROR
+ */
+static int resolve_metas(merge_meta_t *metas, rmc_uint64_t num, int policy, char **db_pathnames,
+        rmc_uint64_t *out_num) {
+    rmc_uint64_t i, j, k;
+    rmc_uint64_t n = 0;
+    rmc_uint64_t pos = 0;
+
+    qsort(metas, num, sizeof(merge_meta_t), compare_meta);
+
+    for (i = 0; i < num; i = j) {
+        k = i;
+
+        for (j = i + 1; j < num && is_same_meta(&metas[i], &metas[j]); j++) {
+            if (is_same_blob(&metas[i], &metas[j]))
+                continue;
+
+            if (policy == RMC_MERGE_ERROR) {
+                fprintf(stderr, "rmc: conflicting blob %s in %s and %s\n", metas[i].policy.blob_name,
+                    db_pathnames[metas[i].layer], db_pathnames[metas[j].layer]);
+                return 1;
+            }
+
+            if (policy == RMC_MERGE_LAST)
+                k = j;
+        }
+
+        /* winner takes the place where its name first appears */
+        pos = metas[i].seq;
+        metas[n] = metas[k];
+        metas[n++].pos = pos;
+    }
+
+    qsort(metas, n, sizeof(merge_meta_t), compare_pos);
+    *out_num = n;
+
+    return 0;
+}
+
+/* write a record of a board with resolved metas */
+static int write_record(FILE *out, rmc_signature_t *signature, merge_meta_t *metas, rmc_uint64_t num,
+        rmc_uint64_t *db_len) {
+    rmc_record_header_t record_header;
+    rmc_meta_header_t meta_header;
+    rmc_uint64_t i;
+    rmc_size_t name_len;
+
+    record_header.signature = *signature;
+    record_header.length = sizeof(rmc_record_header_t);
+
+    for (i = 0; i < num; i++)
+        record_header.length += sizeof(rmc_meta_header_t) + strlen(metas[i].policy.blob_name) + 1 +
+            metas[i].policy.blob_len;
+
+    if (fwrite(&record_header, sizeof(record_header), 1, out) != 1)
+        return 1;
+
+    for (i = 0; i < num; i++) {
+        name_len = strlen(metas[i].policy.blob_name) + 1;
+        meta_header.type = metas[i].policy.type;
+        meta_header.length = sizeof(rmc_meta_header_t) + name_len + metas[i].policy.blob_len;
+
+        if (fwrite(&meta_header, sizeof(meta_header), 1, out) != 1 ||
+            fwrite(metas[i].policy.blob_name, name_len, 1, out) != 1 ||
+            (metas[i].policy.blob_len &&
+            fwrite(metas[i].policy.blob, metas[i].policy.blob_len, 1, out) != 1))
+            return 1;
+    }
+
+    *db_len += record_header.length;
+
+    return 0;
+}
+
+/* add a meta to metas growing as needed */
+static int add_meta(merge_meta_t **metas, rmc_uint64_t *num, rmc_uint64_t *max, rmc_file_t *file, int layer) {
+    merge_meta_t *tmp = NULL;
+
+    if (*num == *max) {
+        *max = *max ? *max * 2 : 16;
+        tmp = realloc(*metas, *max * sizeof(merge_meta_t));
+
+        if (!tmp)
+            return 1;
+
+        *metas = tmp;
+    }
+
+    (*metas)[*num].policy = *file;
+    (*metas)[*num].layer = layer;
+    (*metas)[*num].seq = *num;
+    (*num)++;
+
+    return 0;
+}
+
+/*
+ * merge and write records of a board
+ * (in) group       : records of board in the order of inputs
+ * (in) num         : number of records
+ */
+static int merge_board(FILE *out, merge_record_t *group, rmc_uint64_t num, rmc_uint8_t **dbs,
+        char **db_pathnames, int policy, rmc_uint64_t *db_len) {
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t file;
+    merge_meta_t *metas = NULL;
+    rmc_uint64_t meta_num = 0;
+    rmc_uint64_t out_num = 0;
+    rmc_uint64_t max = 0;
+    rmc_uint64_t i;
+    int layer;
+    int ret = 1;
+
+    for (i = 0; i < num; i++) {
+        for (layer = 0; dbs[layer] != group[i].db; layer++)
+            ;
+
+        init_record_iter(group[i].db, group[i].record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &file)) {
+            if (add_meta(&metas, &meta_num, &max, &file, layer)) {
+                perror("rmc: cannot allocate metas to merge");
+                goto out;
+            }
+        }
+    }
+
+    if (resolve_metas(metas, meta_num, policy, db_pathnames, &out_num))
+        goto out;
+
+    memcpy(&record_header, group[0].db + group[0].record_idx, sizeof(rmc_record_header_t));
+
+    if (write_record(out, &record_header.signature, metas, out_num, db_len)) {
+        perror("rmc: cannot write merged database");
+        goto out;
+    }
+
+    ret = 0;
+out:
+    free(metas);
+
+    return ret;
+}
+
+/* convert version 1 records written in output to a version 2 database in place */
+static int write_db_v2(FILE *out, rmc_uint64_t db_len) {
+    rmc_uint8_t *db = NULL;
+    rmc_uint8_t *v2_db = NULL;
+    rmc_size_t v2_len = 0;
+    int ret = 1;
+
+    db = mmap(NULL, db_len, PROT_READ, MAP_SHARED, fileno(out), 0);
+
+    if (db == MAP_FAILED) {
+        perror("rmc: cannot map output database");
+        return 1;
+    }
+
+    ret = rmcl_convert_db_v2(db, &v2_db, &v2_len);
+    munmap(db, db_len);
+
+    if (ret) {
+        fprintf(stderr, "rmc: cannot generate extensions of output database\n");
+        return 1;
+    }
+
+    /* records get shorter with name IDs, file could as well */
+    if (fseek(out, 0, SEEK_SET) || fwrite(v2_db, v2_len, 1, out) != 1 || fflush(out) ||
+        ftruncate(fileno(out), v2_len)) {
+        perror("rmc: cannot write output database");
+        ret = 1;
+    }
+
+    free(v2_db);
+
+    return ret;
+}
+
+int rmc_merge_db(char **db_pathnames, int db_num, int policy, int version, char *output_pathname) {
+    rmc_db_header_t db_header = {{'R', 'M', 'C', 'D', 'B'}, RMC_DB_VERSION_1, sizeof(rmc_db_header_t)};
+    rmc_uint8_t **dbs = NULL;
+    rmc_size_t *db_lens = NULL;
+    merge_record_t *records = NULL;
+    rmc_uint64_t record_num = 0;
+    rmc_uint64_t db_len = sizeof(rmc_db_header_t);
+    rmc_uint64_t i, j;
+    FILE *out = NULL;
+    struct stat out_stat;
+    struct stat db_stat;
+    int layer;
+    int mapped = 0;
+    int ret = 1;
+
+    if (!db_pathnames || db_num <= 0 || !output_pathname ||
+        policy < RMC_MERGE_LAST || policy > RMC_MERGE_ERROR ||
+        (version != RMC_DB_VERSION_1 && version != RMC_DB_VERSION_2))
+        return 1;
+
+    dbs = calloc(db_num, sizeof(rmc_uint8_t *));
+    db_lens = calloc(db_num, sizeof(rmc_size_t));
+
+    if (!dbs || !db_lens) {
+        perror("rmc: cannot allocate databases to merge");
+        goto out;
+    }
+
+    for (layer = 0; layer < db_num; layer++) {
+        /* output replacing an input would be truncated while it is mapped */
+        if (!stat(output_pathname, &out_stat) && !stat(db_pathnames[layer], &db_stat) &&
+            out_stat.st_dev == db_stat.st_dev && out_stat.st_ino == db_stat.st_ino) {
+            fprintf(stderr, "rmc: output %s is an input database\n", output_pathname);
+            goto out;
+        }
+
+        if (map_file(db_pathnames[layer], &dbs[layer], &db_lens[layer]))
+            goto out;
+
+        mapped++;
+
+        if (validate_rmcdb(dbs[layer], db_lens[layer])) {
+            fprintf(stderr, "%s is not a valid rmc database\n", db_pathnames[layer]);
+            goto out;
+        }
+
+        /* records are read in order */
+        madvise(dbs[layer], db_lens[layer], MADV_SEQUENTIAL);
+    }
+
+    record_num = collect_records(dbs, db_num, NULL);
+    records = calloc(record_num ? record_num : 1, sizeof(merge_record_t));
+
+    if (!records) {
+        perror("rmc: cannot allocate records to merge");
+        goto out;
+    }
+
+    collect_records(dbs, db_num, records);
+
+    /* boards cannot match pattern records without the index in version 2 */
+    for (i = 0; version == RMC_DB_VERSION_1 && i < record_num; i++) {
+        if (records[i].match) {
+            fprintf(stderr, "rmc: pattern records require a version 2 database\n");
+            goto out;
+        }
+    }
+
+    /* each record knows the first record of its board */
+    qsort(records, record_num, sizeof(merge_record_t), compare_record);
+
+    for (i = 0; i < record_num; i = j) {
+        for (j = i; j < record_num && !compare_board(&records[i], &records[j]); j++)
+            records[j].group = records[i].seq;
+    }
+
+    /* boards in the order they first appear, records of a board are adjacent */
+    qsort(records, record_num, sizeof(merge_record_t), compare_group);
+
+    if ((out = fopen(output_pathname, "w+b")) == NULL) {
+        perror("rmc: cannot create merged database");
+        goto out;
+    }
+
+    /* length in header is updated after all records are written */
+    if (fwrite(&db_header, sizeof(db_header), 1, out) != 1) {
+        perror("rmc: cannot write merged database");
+        goto out;
+    }
+
+    for (i = 0; i < record_num; i = j) {
+        for (j = i + 1; j < record_num && records[j].group == records[i].group; j++)
+            ;
+
+        if (merge_board(out, &records[i], j - i, dbs, db_pathnames, policy, &db_len))
+            goto out;
+    }
+
+    db_header.length = db_len;
+
+    if (fseek(out, 0, SEEK_SET) || fwrite(&db_header, sizeof(db_header), 1, out) != 1 ||
+        fflush(out)) {
+        perror("rmc: cannot write merged database");
+        goto out;
+    }
+
+    if (version == RMC_DB_VERSION_2 && write_db_v2(out, db_len))
+        goto out;
+
+    ret = 0;
+out:
+    if (out && fclose(out) && !ret) {
+        perror("rmc: cannot write merged database");
+        ret = 1;
+    }
+
+    if (ret && out)
+        unlink(output_pathname);
+
+    for (layer = 0; layer < mapped; layer++)
+        unmap_file(dbs[layer], db_lens[layer]);
+
+    free(records);
+    free(dbs);
+    free(db_lens);
+
+    return ret;
+}
+
+/* a record to reorder */
+typedef struct order_record {
+    rmc_uint64_t record_idx;
+    rmc_uint64_t count;         /* population of boards matching record */
+    rmc_uint64_t seq;           /* order in input */
+} order_record_t;
+
+/* more common boards first, records with the same count keep their order */
+static int compare_count(const void *a, const void *b) {
+    const order_record_t *x = a;
+    const order_record_t *y = b;
+
+    if (x->count != y->count)
+        return x->count > y->count ? -1 : 1;
+
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/* return: position of record at record_idx in records sorted by offset */
+static rmc_uint64_t find_order_record(order_record_t *records, rmc_uint64_t num, rmc_uint64_t record_idx) {
+    rmc_uint64_t low = 0;
+    rmc_uint64_t high = num;
+    rmc_uint64_t mid = 0;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+
+        if (records[mid].record_idx < record_idx)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/* write a record of a database with metas of version 1
+ * (in/out) metas   : buffer of metas, grown as needed
+ * (in/out) max     : number of metas buffer holds
+ */
+static int copy_record(FILE *out, rmc_uint8_t *db, rmc_uint64_t record_idx, merge_meta_t **metas,
+        rmc_uint64_t *max, rmc_uint64_t *db_len) {
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t file;
+    rmc_uint64_t num = 0;
+
+    memcpy(&record_header, db + record_idx, sizeof(rmc_record_header_t));
+    init_record_iter(db, record_idx, &iter);
+
+    while (!next_policy_in_record(&iter, &file)) {
+        if (add_meta(metas, &num, max, &file, 0))
+            return 1;
+    }
+
+    return write_record(out, &record_header.signature, *metas, num, db_len);
+}
+
+int rmc_reorder_db(char *db_pathname, rmc_fingerprint_t *fps, rmc_uint64_t *counts, int board_num,
+        char *output_pathname) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    order_record_t *records = NULL;
+    merge_meta_t *metas = NULL;
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    rmc_uint64_t record_num = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t out_len = sizeof(rmc_db_header_t);
+    rmc_uint64_t max = 0;
+    rmc_uint64_t i;
+    rmc_uint8_t version = 0;
+    FILE *out = NULL;
+    struct stat out_stat;
+    struct stat db_stat;
+    int board;
+    int ret = 1;
+
+    if (!db_pathname || (board_num && (!fps || !counts)) || board_num < 0 || !output_pathname)
+        return 1;
+
+    /* output replacing input would be truncated while it is mapped */
+    if (!stat(output_pathname, &out_stat) && !stat(db_pathname, &db_stat) &&
+        out_stat.st_dev == db_stat.st_dev && out_stat.st_ino == db_stat.st_ino) {
+        fprintf(stderr, "rmc: output %s is the input database\n", output_pathname);
+        return 1;
+    }
+
+    if (map_file(db_pathname, &db, &db_len))
+        return 1;
+
+    if (validate_rmcdb(db, db_len)) {
+        fprintf(stderr, "%s is not a valid rmc database\n", db_pathname);
+        goto out;
+    }
+
+    memcpy(&db_header, db, sizeof(rmc_db_header_t));
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header.length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, db + record_idx, sizeof(rmc_record_header_t));
+        record_num++;
+    }
+
+    records = calloc(record_num ? record_num : 1, sizeof(order_record_t));
+
+    if (!records) {
+        perror("rmc: cannot allocate records to reorder");
+        goto out;
+    }
+
+    for (i = 0, record_idx = sizeof(rmc_db_header_t); record_idx < db_header.length;
+        i++, record_idx += record_header.length) {
+        memcpy(&record_header, db + record_idx, sizeof(rmc_record_header_t));
+        records[i].record_idx = record_idx;
+        records[i].seq = i;
+
+        /* order of pattern records breaks ties in queries, it must not change */
+        init_record_iter(db, record_idx, &iter);
+
+        if (!next_policy_in_record(&iter, &policy) && policy.type == RMC_MATCH_FILE) {
+            fprintf(stderr, "rmc: cannot reorder a database with pattern records\n");
+            goto out;
+        }
+    }
+
+    /* records are weighted by boards querying them, the same as readers locate them */
+    for (board = 0; board < board_num; board++) {
+        record_idx = 0;
+
+        while (!query_record_from_db(&fps[board], db, &record_idx))
+            records[find_order_record(records, record_num, record_idx)].count += counts[board];
+    }
+
+    qsort(records, record_num, sizeof(order_record_t), compare_count);
+
+    if ((out = fopen(output_pathname, "w+b")) == NULL) {
+        perror("rmc: cannot create reordered database");
+        goto out;
+    }
+
+    /* records are written as version 1 and converted back, length in header is
+     * updated after all records are written
+     */
+    version = db_header.version;
+    db_header.version = RMC_DB_VERSION_1;
+
+    if (fwrite(&db_header, sizeof(rmc_db_header_t), 1, out) != 1) {
+        perror("rmc: cannot write reordered database");
+        goto out;
+    }
+
+    for (i = 0; i < record_num; i++) {
+        if (copy_record(out, db, records[i].record_idx, &metas, &max, &out_len)) {
+            perror("rmc: cannot write reordered database");
+            goto out;
+        }
+    }
+
+    db_header.length = out_len;
+
+    if (fseek(out, 0, SEEK_SET) || fwrite(&db_header, sizeof(db_header), 1, out) != 1 ||
+        fflush(out)) {
+        perror("rmc: cannot write reordered database");
+        goto out;
+    }
+
+    /* extensions refer to offsets of records */
+    if (version >= RMC_DB_VERSION_2 && write_db_v2(out, out_len))
+        goto out;
+
+    ret = 0;
+out:
+    if (out && fclose(out) && !ret) {
+        perror("rmc: cannot write reordered database");
+        ret = 1;
+    }
+
+    if (ret && out)
+        unlink(output_pathname);
+
+    unmap_file(db, db_len);
+    free(records);
+    free(metas);
+
+    return ret;
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * RMC database overlays for Linux user space
+ *
+ * Databases are stacked from the bottom (base) to the top. A blob in a
+ * higher layer overrides a blob with the same name for the same board in
+ * lower layers. Metas of the board in all layers are merged into a single
+ * index sorted by name once, so that a query is one lookup in the index
+ * instead of one scan per layer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <rmc_api.h>
+
+/* an indexed meta with its position in the stack for resolving overrides */
+typedef struct overlay_meta {
+    rmc_overlay_entry_t entry;
+    rmc_uint64_t order;     /* order of meta in its layer */
+} overlay_meta_t;
+
+/* sort by name, then higher layer first, then earlier meta first */
+static int compare_meta(const void *a, const void *b) {
+    const overlay_meta_t *x = a;
+    const overlay_meta_t *y = b;
+    int ret = strcmp(x->entry.name, y->entry.name);
+
+    if (ret)
+        return ret;
+
+    if (x->entry.layer != y->entry.layer)
+        return y->entry.layer - x->entry.layer;
+
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+static int compare_name(const void *key, const void *e) {
+    return strcmp(key, ((const rmc_overlay_entry_t *)e)->name);
+}
+
+/*
+ * append metas of all matched records in a layer to index
+ * (in) fp          : fingerprint of board
+ * (in) layer       : index of database in overlay
+ * (in/out) metas   : array of indexed metas
+ * (in/out) num     : number of indexed metas
+ * (in/out) max     : capacity of metas
+ *
+ * return: 0 for success, non-zero for failures
+ */
+static int index_layer(rmc_fingerprint_t *fp, rmc_overlay_t *overlay, int layer,
+        overlay_meta_t **metas, rmc_size_t *num, rmc_size_t *max) {
+    rmc_uint8_t *db = overlay->dbs[layer];
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t order = 0;
+
+    while (!query_record_from_db(fp, db, &record_idx)) {
+        init_record_iter(db, record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &policy)) {
+            overlay_meta_t *m = NULL;
+
+            if (policy.type != RMC_GENERIC_FILE)
+                continue;
+
+            if (*num == *max) {
+                overlay_meta_t *tmp = NULL;
+
+                *max = *max ? *max * 2 : 16;
+                tmp = realloc(*metas, *max * sizeof(overlay_meta_t));
+
+                if (!tmp) {
+                    perror("rmc: cannot allocate overlay index");
+                    return 1;
+                }
+                *metas = tmp;
+            }
+
+            m = &(*metas)[(*num)++];
+            m->entry.name = policy.blob_name;
+            m->entry.blob = policy.blob;
+            m->entry.blob_len = policy.blob_len;
+            m->entry.layer = layer;
+            m->order = order++;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * open and map a database file of a layer. The file is kept open, so that a
+ * blob can be copied later from the same file as the mapping even when the
+ * path is replaced by another file.
+ * return: 0 for success, non-zero for failures
+ */
+static int map_layer(const char *pathname, int *db_fd, rmc_uint8_t **db, rmc_size_t *db_len) {
+    struct stat s;
+    rmc_uint8_t *map = MAP_FAILED;
+
+    if ((*db_fd = open(pathname, O_RDONLY | O_CLOEXEC)) < 0) {
+        perror("rmc: failed to open database file");
+        return 1;
+    }
+
+    if (fstat(*db_fd, &s) < 0 || s.st_size == 0) {
+        fprintf(stderr, "Failed to read database file\n\n");
+        goto close_db;
+    }
+
+    map = mmap(NULL, s.st_size, PROT_READ, MAP_PRIVATE, *db_fd, 0);
+
+    if (map == MAP_FAILED) {
+        perror("rmc: failed to map database file");
+        goto close_db;
+    }
+
+    *db = map;
+    *db_len = s.st_size;
+
+    return 0;
+
+close_db:
+    close(*db_fd);
+    *db_fd = -1;
+
+    return 1;
+}
+
+int rmc_open_overlay(rmc_fingerprint_t *fp, char **db_pathnames, int db_num, rmc_overlay_t *overlay) {
+    overlay_meta_t *metas = NULL;
+    rmc_size_t num = 0;
+    rmc_size_t max = 0;
+    rmc_size_t i = 0;
+    rmc_size_t j = 0;
+    int layer;
+
+    if (!fp || !db_pathnames || db_num <= 0 || !overlay)
+        return 1;
+
+    memset(overlay, 0, sizeof(*overlay));
+
+    overlay->dbs = calloc(db_num, sizeof(rmc_uint8_t *));
+    overlay->db_lens = calloc(db_num, sizeof(rmc_size_t));
+    overlay->db_fds = calloc(db_num, sizeof(int));
+
+    if (!overlay->dbs || !overlay->db_lens || !overlay->db_fds) {
+        perror("rmc: cannot allocate overlay");
+        goto err;
+    }
+
+    for (layer = 0; layer < db_num; layer++) {
+        if (map_layer(db_pathnames[layer], &overlay->db_fds[layer], &overlay->dbs[layer],
+            &overlay->db_lens[layer])) {
+            fprintf(stderr, "Failed to map database file %s\n", db_pathnames[layer]);
+            goto err;
+        }
+
+        /* count it now so that rmc_close_overlay() can unmap and close it */
+        overlay->db_num++;
+
+        if (validate_rmcdb(overlay->dbs[layer], overlay->db_lens[layer])) {
+            fprintf(stderr, "%s is not a valid rmc database\n", db_pathnames[layer]);
+            goto err;
+        }
+
+        if (index_layer(fp, overlay, layer, &metas, &num, &max))
+            goto err;
+    }
+
+    qsort(metas, num, sizeof(overlay_meta_t), compare_meta);
+
+    /* keep only the winner of each name, which is the first one after sorting */
+    if (num) {
+        overlay->entries = malloc(num * sizeof(rmc_overlay_entry_t));
+
+        if (!overlay->entries) {
+            perror("rmc: cannot allocate overlay index");
+            goto err;
+        }
+    }
+
+    for (i = 0, j = 0; i < num; i++) {
+        if (j && !strcmp(overlay->entries[j - 1].name, metas[i].entry.name))
+            continue;
+        overlay->entries[j++] = metas[i].entry;
+    }
+
+    overlay->entry_num = j;
+    free(metas);
+
+    return 0;
+
+err:
+    free(metas);
+    rmc_close_overlay(overlay);
+
+    return 1;
+}
+
+rmc_overlay_entry_t *rmc_lookup_overlay(rmc_overlay_t *overlay, char *file_name) {
+    if (!overlay || !file_name)
+        return NULL;
+
+    return bsearch(file_name, overlay->entries, overlay->entry_num,
+            sizeof(rmc_overlay_entry_t), compare_name);
+}
+
+int rmc_query_file_by_overlay(rmc_overlay_t *overlay, char *file_name, rmc_file_t *file) {
+    rmc_overlay_entry_t *e = rmc_lookup_overlay(overlay, file_name);
+
+    if (!e || !file)
+        return 1;
+
+    file->type = RMC_GENERIC_FILE;
+    file->blob_name = e->name;
+    file->next = NULL;
+    file->blob = e->blob;
+    file->blob_len = e->blob_len;
+
+    return 0;
+}
+
+void rmc_close_overlay(rmc_overlay_t *overlay) {
+    int i;
+
+    if (!overlay)
+        return;
+
+    for (i = 0; i < overlay->db_num; i++) {
+        unmap_file(overlay->dbs[i], overlay->db_lens[i]);
+        close(overlay->db_fds[i]);
+    }
+
+    free(overlay->dbs);
+    free(overlay->db_lens);
+    free(overlay->db_fds);
+    free(overlay->entries);
+    memset(overlay, 0, sizeof(*overlay));
+}
+
+int rmc_query_file_by_fp_overlay(rmc_fingerprint_t *fp, char **db_pathnames, int db_num, char *file_name, rmc_file_t *file) {
+    rmc_overlay_t overlay;
+    rmc_uint8_t *blob = NULL;
+    int ret = 1;
+
+    if (rmc_open_overlay(fp, db_pathnames, db_num, &overlay))
+        return 1;
+
+    if (rmc_query_file_by_overlay(&overlay, file_name, file))
+        goto done;
+
+    /* copy blob out of the mapped databases, as rmc_query_file_by_fp() does */
+    blob = malloc(file->blob_len);
+
+    if (blob) {
+        memcpy(blob, file->blob, file->blob_len);
+        file->blob = blob;
+        file->blob_name = NULL;
+        ret = 0;
+    } else
+        perror("insufficient memory for the queried file");
+
+done:
+    rmc_close_overlay(&overlay);
+
+    return ret;
+}
+
+int rmc_write_file_by_fp_overlay(rmc_fingerprint_t *fp, char **db_pathnames, int db_num, char *file_name, int fd, rmc_size_t *len) {
+    rmc_overlay_t overlay;
+    rmc_overlay_entry_t *e = NULL;
+    int ret = 1;
+
+    if (!len || fd < 0)
+        return 1;
+
+    *len = 0;
+
+    if (rmc_open_overlay(fp, db_pathnames, db_num, &overlay))
+        return 1;
+
+    e = rmc_lookup_overlay(&overlay, file_name);
+
+    if (!e)
+        goto done;
+
+    /* copy blob by offset from the file its layer is mapped from, not by path which
+     * may have been replaced since
+     */
+    if (!copy_fd(fd, overlay.db_fds[e->layer], e->blob - overlay.dbs[e->layer], e->blob, e->blob_len)) {
+        *len = e->blob_len;
+        ret = 0;
+    }
+
+done:
+    rmc_close_overlay(&overlay);
+
+    return ret;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Client library of rmcd, see rmcd.h and "rmcd client APIs" in rmc_api.h */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+
+#include <rmc_api.h>
+
+/*
+ * connect to rmcd
+ *
+ * return: connected socket, or -1 when rmcd is not reachable
+ */
+static int rmcd_connect(void) {
+    struct sockaddr_un addr;
+    const char *path = getenv(RMCD_SOCKET_ENV);
+    int sock = -1;
+
+    if (!path || !*path)
+        path = RMCD_SOCKET_PATH;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if ((sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0)
+        return -1;
+
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/*
+ * send a request to rmcd and receive its reply
+ * (in) req     : request
+ * (out) reply  : reply from rmcd
+ * (out) fd     : passed file descriptor in reply, -1 if there is none. Can be NULL
+ *                when no descriptor is expected.
+ *
+ * return: 0 when a reply is received, non-zero when rmcd is not reachable
+ */
+static int rmcd_transact(rmcd_request_t *req, rmcd_reply_t *reply, int *fd) {
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg = NULL;
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctrl;
+    rmc_ssize_t len = 0;
+    int sock = -1;
+    int ret = 1;
+
+    if (fd)
+        *fd = -1;
+
+    if ((sock = rmcd_connect()) < 0)
+        return 1;
+
+    if (send(sock, req, sizeof(*req), MSG_NOSIGNAL) != sizeof(*req))
+        goto done;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = reply;
+    iov.iov_len = sizeof(*reply);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    do {
+        len = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (len < 0 && errno == EINTR);
+
+    if (len != sizeof(*reply))
+        goto done;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int passed = -1;
+
+            memcpy(&passed, CMSG_DATA(cmsg), sizeof(int));
+
+            if (fd)
+                *fd = passed;
+            else
+                close(passed);
+        }
+    }
+
+    ret = 0;
+done:
+    close(sock);
+
+    return ret;
+}
+
+int rmcd_query_fd(char *db_pathname, char *file_name, int *fd, rmc_size_t *len) {
+    rmcd_request_t req;
+    rmcd_reply_t reply;
+    struct stat s;
+
+    if (!file_name || !fd || !len)
+        return 1;
+
+    if (strlen(file_name) >= RMCD_NAME_MAX)
+        return 1;
+
+    memset(&req, 0, sizeof(req));
+    req.op = RMCD_OP_QUERY;
+    strcpy(req.name, file_name);
+
+    /* let rmcd tell us if it serves the same database file */
+    if (db_pathname) {
+        if (stat(db_pathname, &s) < 0) {
+            perror("rmc: failed to get database file stat");
+            return 1;
+        }
+        req.db_dev = s.st_dev;
+        req.db_ino = s.st_ino;
+    }
+
+    if (rmcd_transact(&req, &reply, fd) || reply.status == RMCD_STATUS_OTHER_DB) {
+        if (!db_pathname)
+            return 1;
+
+        /* query database file directly when rmcd cannot serve us */
+        return rmc_gimme_fd(db_pathname, file_name, fd, len);
+    }
+
+    if (reply.status != RMCD_STATUS_OK || *fd < 0) {
+        if (*fd >= 0)
+            close(*fd);
+        return 1;
+    }
+
+    *len = reply.blob_len;
+
+    return 0;
+}
+
+int rmcd_gimme_file(char *db_pathname, char *file_name, rmc_file_t *file) {
+    int fd = -1;
+    rmc_size_t len = 0;
+    void *blob = NULL;
+
+    if (!file)
+        return 1;
+
+    if (rmcd_query_fd(db_pathname, file_name, &fd, &len))
+        return 1;
+
+    /* a sealed memfd can only be mapped read-only and shared */
+    if (len) {
+        blob = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+
+        if (blob == MAP_FAILED) {
+            perror("rmc: failed to map blob from rmcd");
+            close(fd);
+            return 1;
+        }
+    }
+
+    close(fd);
+
+    file->type = RMC_GENERIC_FILE;
+    file->blob_name = NULL;
+    file->next = NULL;
+    file->blob = blob;
+    file->blob_len = len;
+
+    return 0;
+}
+
+void rmcd_free_file(rmc_file_t *file) {
+    if (file && file->blob && munmap(file->blob, file->blob_len) < 0)
+        perror("rmc: munmap blob failed, ignore");
+}
+
+int rmcd_get_stats(rmcd_stats_t *stats) {
+    rmcd_request_t req;
+    rmcd_reply_t reply;
+
+    if (!stats)
+        return 1;
+
+    memset(&req, 0, sizeof(req));
+    req.op = RMCD_OP_STATS;
+
+    if (rmcd_transact(&req, &reply, NULL) || reply.status != RMCD_STATUS_OK)
+        return 1;
+
+    *stats = reply.stats;
+
+    return 0;
+}
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Shared database handle for multi-threaded clients in Linux user space
+ *
+ * Readers never take a lock. The current version of database (an overlay) is
+ * published through an atomic pointer. A reader announces the version it is
+ * going to use in its own reader slot (a hazard pointer) and checks if it is
+ * still the current one. A watcher thread reloads database files on changes
+ * reported by inotify, swaps the pointer to the new version, and waits until
+ * no reader slot references the old version before it unmaps old files. So
+ * in-flight readers keep using the old mapping until they are done.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <libgen.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+#include <rmc_api.h>
+
+/* a published version of database */
+typedef struct shared_version {
+    rmc_overlay_t overlay;
+    rmc_uint64_t generation;
+} shared_version_t;
+
+/* one reader slot per cache line, so that readers don't share lines */
+typedef struct reader_slot {
+    _Atomic(shared_version_t *) version;
+    char pad[64 - sizeof(shared_version_t *)];
+} reader_slot_t;
+
+struct rmc_shared_db {
+    _Atomic(shared_version_t *) current;
+    reader_slot_t slots[RMC_SHARED_MAX_READERS];
+    rmc_fingerprint_t fp;           /* private copy of fingerprint */
+    char **db_pathnames;
+    int db_num;
+    int inotify_fd;
+    int quit_fd;                    /* eventfd to stop watcher */
+    pthread_t watcher;
+};
+
+/*
+ * Reader ids are shared by all handles. A thread gets an id at its first
+ * acquire and returns it when it exits.
+ */
+static pthread_mutex_t reader_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t reader_once = PTHREAD_ONCE_INIT;
+static pthread_key_t reader_key;
+static rmc_uint8_t reader_used[RMC_SHARED_MAX_READERS];
+static __thread int reader_id = -1;
+
+static void put_reader_id(void *arg) {
+    int id = (int)(long)arg - 1;
+
+    pthread_mutex_lock(&reader_lock);
+    reader_used[id] = 0;
+    pthread_mutex_unlock(&reader_lock);
+}
+
+static void create_reader_key(void) {
+    pthread_key_create(&reader_key, put_reader_id);
+}
+
+/*
+ * get id of calling thread, which is the index of its slot in handles
+ *
+ * return: id, or -1 if there are too many reader threads
+ */
+static int get_reader_id(void) {
+    int i;
+
+    if (reader_id >= 0)
+        return reader_id;
+
+    pthread_once(&reader_once, create_reader_key);
+    pthread_mutex_lock(&reader_lock);
+
+    for (i = 0; i < RMC_SHARED_MAX_READERS; i++) {
+        if (!reader_used[i]) {
+            reader_used[i] = 1;
+            reader_id = i;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&reader_lock);
+
+    /* key value is id + 1, NULL means no destructor call */
+    if (reader_id >= 0)
+        pthread_setspecific(reader_key, (void *)(long)(reader_id + 1));
+
+    return reader_id;
+}
+
+static shared_version_t *load_version(rmc_shared_db_t *db, rmc_uint64_t generation) {
+    shared_version_t *v = calloc(1, sizeof(shared_version_t));
+
+    if (!v) {
+        perror("rmc: cannot allocate database version");
+        return NULL;
+    }
+
+    if (rmc_open_overlay(&db->fp, db->db_pathnames, db->db_num, &v->overlay)) {
+        free(v);
+        return NULL;
+    }
+
+    v->generation = generation;
+
+    return v;
+}
+
+static void free_version(shared_version_t *v) {
+    if (!v)
+        return;
+
+    rmc_close_overlay(&v->overlay);
+    free(v);
+}
+
+/*
+ * publish a new version and retire the old one once no reader uses it
+ */
+static void publish_version(rmc_shared_db_t *db, shared_version_t *v) {
+    shared_version_t *old = atomic_exchange(&db->current, v);
+    int i;
+
+    for (i = 0; i < RMC_SHARED_MAX_READERS; i++) {
+        while (atomic_load(&db->slots[i].version) == old)
+            sched_yield();
+    }
+
+    free_version(old);
+}
+
+/*
+ * check if an inotify event is about one of database files
+ */
+static int is_db_event(rmc_shared_db_t *db, struct inotify_event *ev) {
+    int i;
+
+    if (!ev->len)
+        return 0;
+
+    for (i = 0; i < db->db_num; i++) {
+        const char *base = strrchr(db->db_pathnames[i], '/');
+
+        base = base ? base + 1 : db->db_pathnames[i];
+
+        if (!strcmp(base, ev->name))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void *watch_db(void *arg) {
+    rmc_shared_db_t *db = arg;
+    struct pollfd fds[2];
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    rmc_ssize_t len = 0;
+    char *p = NULL;
+    int changed = 0;
+
+    fds[0].fd = db->inotify_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = db->quit_fd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("rmc: poll on database files failed");
+            break;
+        }
+
+        if (fds[1].revents)
+            break;
+
+        /* drain all pending events before reloading once */
+        changed = 0;
+
+        while ((len = read(db->inotify_fd, buf, sizeof(buf))) > 0) {
+            for (p = buf; p < buf + len; p += sizeof(struct inotify_event) + ((struct inotify_event *)p)->len)
+                changed |= is_db_event(db, (struct inotify_event *)p);
+        }
+
+        if (changed) {
+            shared_version_t *cur = atomic_load(&db->current);
+            shared_version_t *v = load_version(db, cur->generation + 1);
+
+            /* a broken or half-written database is not published, we keep
+             * serving the current version and wait for the next change
+             */
+            if (v)
+                publish_version(db, v);
+            else
+                fprintf(stderr, "rmc: keep database generation %llu\n",
+                        (unsigned long long)cur->generation);
+        }
+    }
+
+    return NULL;
+}
+
+rmc_shared_db_t *rmc_open_shared_db(rmc_fingerprint_t *fp, char **db_pathnames, int db_num) {
+    rmc_shared_db_t *db = NULL;
+    shared_version_t *v = NULL;
+    int i;
+
+    if (!fp || !db_pathnames || db_num <= 0)
+        return NULL;
+
+    if ((db = calloc(1, sizeof(rmc_shared_db_t))) == NULL) {
+        perror("rmc: cannot allocate shared database");
+        return NULL;
+    }
+
+    db->inotify_fd = -1;
+    db->quit_fd = -1;
+    db->fp = *fp;
+
+    for (i = 0; i < RMC_FINGER_NUM; i++)
+        db->fp.rmc_fingers[i].value = NULL;
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if ((db->fp.rmc_fingers[i].value = strdup(fp->rmc_fingers[i].value)) == NULL) {
+            perror("rmc: cannot allocate fingerprint");
+            goto err;
+        }
+    }
+
+    if ((db->db_pathnames = calloc(db_num, sizeof(char *))) == NULL) {
+        perror("rmc: cannot allocate shared database");
+        goto err;
+    }
+
+    for (db->db_num = 0; db->db_num < db_num; db->db_num++) {
+        if ((db->db_pathnames[db->db_num] = strdup(db_pathnames[db->db_num])) == NULL) {
+            perror("rmc: cannot allocate shared database");
+            goto err;
+        }
+    }
+
+    if ((v = load_version(db, 0)) == NULL)
+        goto err;
+
+    atomic_store(&db->current, v);
+
+    for (i = 0; i < RMC_SHARED_MAX_READERS; i++)
+        atomic_store(&db->slots[i].version, NULL);
+
+    db->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    db->quit_fd = eventfd(0, EFD_CLOEXEC);
+
+    if (db->inotify_fd < 0 || db->quit_fd < 0) {
+        perror("rmc: cannot create inotify");
+        goto err;
+    }
+
+    /* watch directories, database files are usually replaced by renaming
+     * a new file over them.
+     */
+    for (i = 0; i < db_num; i++) {
+        char *path = strdup(db_pathnames[i]);
+
+        if (!path || inotify_add_watch(db->inotify_fd, dirname(path),
+                IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            perror("rmc: cannot watch database file");
+            free(path);
+            goto err;
+        }
+
+        free(path);
+    }
+
+    if (pthread_create(&db->watcher, NULL, watch_db, db)) {
+        fprintf(stderr, "rmc: cannot create watcher thread\n");
+        goto err;
+    }
+
+    return db;
+
+err:
+    free_version(atomic_load(&db->current));
+
+    if (db->inotify_fd >= 0)
+        close(db->inotify_fd);
+    if (db->quit_fd >= 0)
+        close(db->quit_fd);
+
+    for (i = 0; i < db->db_num; i++)
+        free(db->db_pathnames[i]);
+    free(db->db_pathnames);
+
+    for (i = 0; i < RMC_FINGER_NUM; i++)
+        free(db->fp.rmc_fingers[i].value);
+
+    free(db);
+
+    return NULL;
+}
+
+rmc_overlay_t *rmc_acquire_shared_db(rmc_shared_db_t *db) {
+    shared_version_t *v = NULL;
+    int id = get_reader_id();
+
+    if (!db || id < 0)
+        return NULL;
+
+    do {
+        v = atomic_load(&db->current);
+        atomic_store(&db->slots[id].version, v);
+    } while (v != atomic_load(&db->current));
+
+    return &v->overlay;
+}
+
+void rmc_release_shared_db(rmc_shared_db_t *db) {
+    if (db && reader_id >= 0)
+        atomic_store(&db->slots[reader_id].version, NULL);
+}
+
+int rmc_query_file_shared(rmc_shared_db_t *db, char *file_name, rmc_file_t *file) {
+    rmc_overlay_t *overlay = rmc_acquire_shared_db(db);
+    rmc_uint8_t *blob = NULL;
+    int ret = 1;
+
+    if (!overlay)
+        return 1;
+
+    if (rmc_query_file_by_overlay(overlay, file_name, file))
+        goto done;
+
+    /* copy blob out, a mapping can go away after we release it */
+    blob = malloc(file->blob_len);
+
+    if (blob) {
+        memcpy(blob, file->blob, file->blob_len);
+        file->blob = blob;
+        file->blob_name = NULL;
+        ret = 0;
+    } else
+        perror("insufficient memory for the queried file");
+
+done:
+    rmc_release_shared_db(db);
+
+    return ret;
+}
+
+rmc_uint64_t rmc_get_shared_db_generation(rmc_shared_db_t *db) {
+    rmc_overlay_t *overlay = rmc_acquire_shared_db(db);
+    rmc_uint64_t generation = 0;
+
+    /* overlay is the first member of its version */
+    if (overlay) {
+        generation = ((shared_version_t *)overlay)->generation;
+        rmc_release_shared_db(db);
+    }
+
+    return generation;
+}
+
+void rmc_close_shared_db(rmc_shared_db_t *db) {
+    rmc_uint64_t one = 1;
+    int i;
+
+    if (!db)
+        return;
+
+    if (write(db->quit_fd, &one, sizeof(one)) != sizeof(one))
+        perror("rmc: cannot stop watcher thread");
+
+    pthread_join(db->watcher, NULL);
+
+    free_version(atomic_load(&db->current));
+    close(db->inotify_fd);
+    close(db->quit_fd);
+
+    for (i = 0; i < db->db_num; i++)
+        free(db->db_pathnames[i]);
+    free(db->db_pathnames);
+
+    for (i = 0; i < RMC_FINGER_NUM; i++)
+        free(db->fp.rmc_fingers[i].value);
+
+    free(db);
+}
@@ -0,0 +1,500 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compiler of RMC database files into C source for Linux user space
+ *
+ * A database file is written as a const array, with a minimal perfect hash table
+ * of every blob a board gets, keyed by signature of board and name of blob. The
+ * table is built with hash and displace: keys are hashed into buckets of a few
+ * keys, and from the biggest bucket on, a displacement is searched for every
+ * bucket to move all its keys into free slots at once. A program links generated
+ * source and queries a blob with a hash and a few compares, without file I/O.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ctype.h>
+
+#include <rmc_api.h>
+
+#define BUCKET_KEYS         4           /* average number of keys in a bucket */
+#define MAX_DISPLACEMENT    (1 << 20)
+#define MAX_SEEDS           16
+#define BYTES_PER_LINE      12
+
+/* a blob a board gets */
+typedef struct static_key {
+    rmc_signature_t *signature;         /* in record */
+    char *name;                         /* in meta */
+    rmc_uint64_t record_idx;
+    rmc_uint64_t meta_idx;
+    rmc_uint64_t hash;
+} static_key_t;
+
+/* a built table */
+typedef struct static_table {
+    rmc_uint32_t seed;
+    rmc_uint32_t bucket_num;
+    rmc_uint32_t *displacements;
+    rmc_uint32_t slot_num;
+    rmc_static_slot_t *slots;
+} static_table_t;
+
+/* sort by key, then records in order of database */
+static int compare_key(const void *a, const void *b) {
+    const static_key_t *x = a;
+    const static_key_t *y = b;
+    int ret;
+
+    /* the same as signatures are matched */
+    ret = strncmp((const char *)x->signature->raw, (const char *)y->signature->raw,
+        sizeof(x->signature->raw));
+
+    if (!ret)
+        ret = strcmp(x->name, y->name);
+
+    if (!ret)
+        ret = x->record_idx < y->record_idx ? -1 : x->record_idx > y->record_idx;
+
+    return ret;
+}
+
+/*
+ * collect blobs boards get in database, a blob shadowed by another one with the
+ * same name in the same record or an earlier record of the same board is left
+ * out, so that a key refers to the blob a query returns.
+ * return: 0 for success, non-zero for failures
+ */
+static int collect_keys(rmc_uint8_t *db, static_key_t **keys, rmc_uint64_t *num) {
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    rmc_file_t winner;
+    rmc_uint64_t record_idx;
+    rmc_uint64_t meta_idx;
+    rmc_uint64_t n = 0;
+    rmc_uint64_t i;
+    rmc_uint64_t j;
+    int pass;
+
+    *keys = NULL;
+    *num = 0;
+
+    /* count and then fill */
+    for (pass = 0; pass < 2; pass++) {
+        n = 0;
+
+        for (record_idx = sizeof(rmc_db_header_t); record_idx < ((rmc_db_header_t *)db)->length;
+            record_idx += record_header.length) {
+            memcpy(&record_header, db + record_idx, sizeof(rmc_record_header_t));
+            init_record_iter(db, record_idx, &iter);
+
+            for (meta_idx = iter.meta_idx; !next_policy_in_record(&iter, &policy); meta_idx = iter.meta_idx) {
+                if (policy.type == RMC_MATCH_FILE) {
+                    fprintf(stderr, "rmc: pattern records cannot be compiled, they are not "
+                        "indexed by signatures\n");
+                    free(*keys);
+                    *keys = NULL;
+                    return 1;
+                }
+
+                if (policy.type != RMC_GENERIC_FILE ||
+                    query_policy_from_record(db, record_idx, RMC_GENERIC_FILE, policy.blob_name, &winner) ||
+                    winner.blob != policy.blob)
+                    continue;
+
+                if (*keys) {
+                    (*keys)[n].signature = &((rmc_record_header_t *)(db + record_idx))->signature;
+                    (*keys)[n].name = policy.blob_name;
+                    (*keys)[n].record_idx = record_idx;
+                    (*keys)[n].meta_idx = meta_idx;
+                }
+
+                n++;
+            }
+        }
+
+        if (!pass) {
+            /* one more to never allocate 0 byte */
+            *keys = calloc(n + 1, sizeof(static_key_t));
+
+            if (!*keys) {
+                perror("rmc: cannot allocate keys");
+                return 1;
+            }
+        }
+    }
+
+    qsort(*keys, n, sizeof(static_key_t), compare_key);
+
+    /* the first record of a board with a name wins */
+    for (i = 0, j = 0; i < n; i++) {
+        if (j && !strncmp((const char *)(*keys)[j - 1].signature->raw,
+            (const char *)(*keys)[i].signature->raw, sizeof((*keys)[i].signature->raw)) &&
+            !strcmp((*keys)[j - 1].name, (*keys)[i].name))
+            continue;
+
+        (*keys)[j++] = (*keys)[i];
+    }
+
+    *num = j;
+
+    return 0;
+}
+
+/* a bucket with its number of keys, sorted without context by qsort() */
+typedef struct bucket_order {
+    rmc_uint32_t size;
+    rmc_uint32_t bucket;
+} bucket_order_t;
+
+/* bigger bucket first */
+static int compare_bucket(const void *a, const void *b) {
+    const bucket_order_t *x = a;
+    const bucket_order_t *y = b;
+
+    if (x->size != y->size)
+        return x->size > y->size ? -1 : 1;
+
+    return x->bucket < y->bucket ? -1 : x->bucket > y->bucket;
+}
+
+/*
+ * place keys into slots with a seed
+ * return: 0 for success, 1 when a bucket cannot be placed with this seed, -1 for
+ *         other failures
+ */
+static int place_keys(static_key_t *keys, rmc_uint64_t num, static_table_t *table) {
+    bucket_order_t *order = NULL;   /* buckets, bigger first after sorting */
+    rmc_uint32_t *first = NULL;     /* first key of bucket in members */
+    rmc_uint64_t *members = NULL;   /* keys grouped by bucket */
+    rmc_uint32_t *pos = NULL;       /* slots of keys in a bucket being placed */
+    rmc_uint32_t b;
+    rmc_uint32_t bucket;
+    rmc_uint32_t d;
+    rmc_uint32_t k;
+    rmc_uint32_t l;
+    rmc_uint32_t size;
+    rmc_uint64_t i;
+    int ret = -1;
+
+    memset(table->displacements, 0, table->bucket_num * sizeof(rmc_uint32_t));
+    memset(table->slots, 0, table->slot_num * sizeof(rmc_static_slot_t));
+
+    order = calloc(table->bucket_num, sizeof(bucket_order_t));
+    first = calloc(table->bucket_num + 1, sizeof(rmc_uint32_t));
+    members = calloc(num + 1, sizeof(rmc_uint64_t));
+    pos = calloc(num + 1, sizeof(rmc_uint32_t));
+
+    if (!order || !first || !members || !pos) {
+        perror("rmc: cannot allocate buckets");
+        goto done;
+    }
+
+    for (i = 0; i < num; i++) {
+        keys[i].hash = rmcl_static_hash(table->seed, keys[i].signature, keys[i].name);
+        order[(rmc_uint32_t)(keys[i].hash >> 32) % table->bucket_num].size++;
+    }
+
+    for (b = 0; b < table->bucket_num; b++) {
+        first[b + 1] = first[b] + order[b].size;
+        order[b].bucket = b;
+    }
+
+    for (i = 0; i < num; i++) {
+        b = (rmc_uint32_t)(keys[i].hash >> 32) % table->bucket_num;
+        members[first[b]++] = i;
+    }
+
+    /* first[b] is the end of bucket b now */
+    for (b = 0; b < table->bucket_num; b++)
+        first[b] -= order[b].size;
+
+    qsort(order, table->bucket_num, sizeof(bucket_order_t), compare_bucket);
+
+    ret = 0;
+
+    for (b = 0; b < table->bucket_num && order[b].size; b++) {
+        size = order[b].size;
+        bucket = order[b].bucket;
+
+        for (d = 0; d < MAX_DISPLACEMENT; d++) {
+            table->displacements[bucket] = d;
+
+            for (k = 0; k < size; k++) {
+                pos[k] = rmcl_static_slot(keys[members[first[bucket] + k]].hash, table->bucket_num,
+                    table->displacements, table->slot_num);
+
+                if (table->slots[pos[k]].meta_idx)
+                    break;
+
+                for (l = 0; l < k && pos[l] != pos[k]; l++)
+                    ;
+
+                if (l < k)
+                    break;
+            }
+
+            if (k == size)
+                break;
+        }
+
+        if (d == MAX_DISPLACEMENT) {
+            ret = 1;
+            break;
+        }
+
+        for (k = 0; k < size; k++) {
+            i = members[first[bucket] + k];
+            table->slots[pos[k]].record_idx = keys[i].record_idx;
+            table->slots[pos[k]].meta_idx = keys[i].meta_idx;
+        }
+    }
+
+done:
+    free(order);
+    free(first);
+    free(members);
+    free(pos);
+
+    return ret;
+}
+
+/* build table with seeds in turn, and more slots when no seed works */
+static int build_table(static_key_t *keys, rmc_uint64_t num, static_table_t *table) {
+    int ret = 1;
+
+    if (num > 0xffffffffULL / 2) {
+        fprintf(stderr, "rmc: too many blobs to compile\n");
+        return 1;
+    }
+
+    table->bucket_num = num / BUCKET_KEYS + 1;
+    table->slot_num = num + num / 4 + 1;
+
+    while (ret > 0) {
+        table->displacements = calloc(table->bucket_num, sizeof(rmc_uint32_t));
+        table->slots = calloc(table->slot_num, sizeof(rmc_static_slot_t));
+
+        if (!table->displacements || !table->slots) {
+            perror("rmc: cannot allocate hash table");
+            ret = -1;
+            break;
+        }
+
+        for (table->seed = 0; table->seed < MAX_SEEDS; table->seed++) {
+            if ((ret = place_keys(keys, num, table)) <= 0)
+                break;
+        }
+
+        if (ret > 0) {
+            free(table->displacements);
+            free(table->slots);
+            table->slot_num += table->slot_num / 8 + 1;
+        }
+    }
+
+    if (ret) {
+        free(table->displacements);
+        free(table->slots);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* C identifier from base name of output, e.g. "out/rmc-db" to "rmc_db" */
+static char *get_symbol(const char *output_prefix) {
+    const char *base = strrchr(output_prefix, '/');
+    char *symbol = NULL;
+    rmc_size_t i;
+
+    base = base ? base + 1 : output_prefix;
+    symbol = malloc(strlen(base) + 2);
+
+    if (!symbol) {
+        perror("rmc: cannot allocate symbol");
+        return NULL;
+    }
+
+    symbol[0] = '_';
+    strcpy(symbol + 1, base);
+
+    for (i = 1; symbol[i]; i++) {
+        if (!isalnum((unsigned char)symbol[i]))
+            symbol[i] = '_';
+    }
+
+    /* keep '_' only when name starts with a digit or is empty */
+    if (symbol[1] && !isdigit((unsigned char)symbol[1]))
+        memmove(symbol, symbol + 1, strlen(symbol));
+
+    return symbol;
+}
+
+static int write_header(FILE *f, const char *db_name, const char *symbol) {
+    rmc_size_t i;
+
+    fprintf(f, "/* Generated by rmc -C from %s, do not edit */\n\n", db_name);
+    fprintf(f, "#ifndef INC_");
+
+    for (i = 0; symbol[i]; i++)
+        fputc(toupper((unsigned char)symbol[i]), f);
+
+    fprintf(f, "_H_\n#define INC_");
+
+    for (i = 0; symbol[i]; i++)
+        fputc(toupper((unsigned char)symbol[i]), f);
+
+    fprintf(f, "_H_\n\n#include <rmcl.h>\n\n");
+    fprintf(f, "extern const rmc_static_db_t %s;\n\n#endif\n", symbol);
+
+    return ferror(f);
+}
+
+static int write_source(FILE *f, const char *db_name, const char *header_base, const char *symbol,
+        const rmc_uint8_t *db, rmc_size_t db_len, const static_table_t *table) {
+    rmc_size_t i;
+
+    fprintf(f, "/* Generated by rmc -C from %s, do not edit */\n\n", db_name);
+    fprintf(f, "#include \"%s.h\"\n\n", header_base);
+
+    fprintf(f, "static const rmc_uint8_t %s_data[%llu] = {", symbol, (unsigned long long)db_len);
+
+    for (i = 0; i < db_len; i++)
+        fprintf(f, "%s0x%02x,", i % BYTES_PER_LINE ? " " : "\n    ", db[i]);
+
+    fprintf(f, "\n};\n\nstatic const rmc_uint32_t %s_displacements[%u] = {", symbol,
+        table->bucket_num);
+
+    for (i = 0; i < table->bucket_num; i++)
+        fprintf(f, "%s%u,", i % 8 ? " " : "\n    ", table->displacements[i]);
+
+    fprintf(f, "\n};\n\n/* record and meta of a blob in data */\n");
+    fprintf(f, "static const rmc_static_slot_t %s_slots[%u] = {\n", symbol, table->slot_num);
+
+    for (i = 0; i < table->slot_num; i++)
+        fprintf(f, "    { %lluULL, %lluULL },\n", (unsigned long long)table->slots[i].record_idx,
+            (unsigned long long)table->slots[i].meta_idx);
+
+    fprintf(f, "};\n\nconst rmc_static_db_t %s = {\n", symbol);
+    fprintf(f, "    %s_data, sizeof(%s_data), %uU,\n", symbol, symbol, table->seed);
+    fprintf(f, "    %uU, %s_displacements,\n", table->bucket_num, symbol);
+    fprintf(f, "    %uU, %s_slots\n};\n", table->slot_num, symbol);
+
+    return ferror(f);
+}
+
+int rmc_compile_db(char *db_pathname, char *output_prefix) {
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    static_key_t *keys = NULL;
+    rmc_uint64_t key_num = 0;
+    static_table_t table;
+    char *symbol = NULL;
+    char *pathname = NULL;
+    const char *db_name = NULL;
+    const char *base = NULL;
+    FILE *f = NULL;
+    int ret = 1;
+
+    if (!db_pathname || !output_prefix)
+        return 1;
+
+    if (map_file(db_pathname, &db, &db_len))
+        return 1;
+
+    if (validate_rmcdb(db, db_len)) {
+        fprintf(stderr, "rmc: %s is not a valid rmc database\n", db_pathname);
+        goto unmap;
+    }
+
+    if (collect_keys(db, &keys, &key_num) || build_table(keys, key_num, &table))
+        goto unmap;
+
+    symbol = get_symbol(output_prefix);
+    pathname = malloc(strlen(output_prefix) + 3);
+
+    if (!symbol || !pathname) {
+        perror("rmc: cannot allocate output pathname");
+        goto free_table;
+    }
+
+    db_name = strrchr(db_pathname, '/');
+    db_name = db_name ? db_name + 1 : db_pathname;
+
+    /* source includes header by its name in the same directory */
+    base = strrchr(output_prefix, '/');
+    base = base ? base + 1 : output_prefix;
+
+    sprintf(pathname, "%s.h", output_prefix);
+
+    if (!(f = fopen(pathname, "w"))) {
+        perror("rmc: cannot open output header");
+        goto free_table;
+    }
+
+    if (write_header(f, db_name, symbol) | fclose(f)) {
+        fprintf(stderr, "rmc: failed to write %s\n", pathname);
+        unlink(pathname);
+        goto free_table;
+    }
+
+    sprintf(pathname, "%s.c", output_prefix);
+
+    if (!(f = fopen(pathname, "w"))) {
+        perror("rmc: cannot open output source");
+        goto remove_header;
+    }
+
+    if (write_source(f, db_name, base, symbol, db, db_len, &table) | fclose(f)) {
+        fprintf(stderr, "rmc: failed to write %s\n", pathname);
+        unlink(pathname);
+        goto remove_header;
+    }
+
+    ret = 0;
+    goto free_table;
+
+remove_header:
+    sprintf(pathname, "%s.h", output_prefix);
+    unlink(pathname);
+free_table:
+    free(table.displacements);
+    free(table.slots);
+    free(symbol);
+    free(pathname);
+unmap:
+    free(keys);
+    unmap_file(db, db_len);
+
+    return ret;
+}
+
+int rmc_query_file_by_static_db(rmc_fingerprint_t *fp, const rmc_static_db_t *db, char *file_name, rmc_file_t *file) {
+    return query_policy_from_static_db(fp, db, file_name, file);
+}
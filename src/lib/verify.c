@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Verification of RMC database files for Linux user space
+ *
+ * Layout of a database is checked with bounds first, so that it can be walked
+ * safely even when data is corrupted. CRC of each record is checked, then every
+ * blob is hashed by a pool of threads, each taking the next blob from a shared
+ * counter, and checked with its digest stored by the builder, and optionally
+ * with source files. A record failing CRC doesn't decide status of its blobs,
+ * so that the corrupted blob can still be told from intact ones.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include <rmc_api.h>
+#include "workers.h"
+
+typedef struct verify_job {
+    rmc_uint8_t *db;
+    rmc_file_t *sources;
+    rmc_verify_entry_t *entries;
+    rmc_uint64_t *meta_idx;     /* meta of each entry */
+    rmc_uint64_t entry_num;
+} verify_job_t;
+
+static rmc_file_t *find_source(rmc_file_t *sources, const char *name) {
+    for (; sources; sources = sources->next) {
+        if (!strcmp(sources->blob_name, name))
+            return sources;
+    }
+
+    return NULL;
+}
+
+static void verify_entry(void *arg, rmc_uint64_t i) {
+    verify_job_t *job = arg;
+    rmc_verify_entry_t *e = &job->entries[i];
+    rmc_uint8_t digest[RMC_SHA256_LEN];
+    rmc_uint8_t *stored = NULL;
+    rmc_file_t *source = NULL;
+
+    /* blob is checked by its own digest even when CRC of its record failed */
+    rmc_sha256(e->blob, e->blob_len, digest);
+    stored = query_digest_from_db(job->db, job->meta_idx[i]);
+
+    if (!stored)
+        e->status = RMC_VERIFY_NO_DIGEST;
+    else if (memcmp(stored, digest, RMC_SHA256_LEN))
+        e->status = RMC_VERIFY_CORRUPTED;
+
+    source = find_source(job->sources, e->name);
+
+    if (e->status != RMC_VERIFY_CORRUPTED && source &&
+        (source->blob_len != e->blob_len || memcmp(source->blob, e->blob, e->blob_len)))
+        e->status = RMC_VERIFY_SOURCE_MISMATCH;
+}
+
+/* collect every blob into entries, return number of blobs */
+static rmc_uint64_t collect_entries(rmc_uint8_t *db, verify_job_t *job) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)db;
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint64_t n = 0;
+    int record_status = 0;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, db + record_idx, sizeof(rmc_record_header_t));
+        record_status = verify_record_crc(db, record_idx) ? RMC_VERIFY_CORRUPTED : RMC_VERIFY_OK;
+        init_record_iter(db, record_idx, &iter);
+
+        for (meta_idx = iter.meta_idx; !next_policy_in_record(&iter, &policy); meta_idx = iter.meta_idx) {
+            if (job->entries) {
+                job->entries[n].record_idx = record_idx;
+                job->entries[n].name = policy.blob_name;
+                job->entries[n].blob = policy.blob;
+                job->entries[n].blob_len = policy.blob_len;
+                job->entries[n].status = RMC_VERIFY_OK;
+                job->entries[n].record_status = record_status;
+                job->meta_idx[n] = meta_idx;
+            }
+            n++;
+        }
+    }
+
+    return n;
+}
+
+int rmc_verify_db(char *db_pathname, rmc_file_t *sources, int thread_num, rmc_verify_report_t *report) {
+    verify_job_t job;
+    rmc_uint64_t i;
+
+    if (!db_pathname || !report)
+        return 1;
+
+    memset(report, 0, sizeof(*report));
+    memset(&job, 0, sizeof(job));
+
+    if (map_file(db_pathname, &report->db, &report->db_len))
+        return 1;
+
+    /* prefetch the whole file for hashing threads */
+    madvise(report->db, report->db_len, MADV_WILLNEED);
+
+    if (validate_rmcdb_layout(report->db, report->db_len)) {
+        report->db_status = RMC_VERIFY_CORRUPTED;
+        return 0;
+    }
+
+    /* layout is good, so a failure here is CRC of database */
+    if (validate_rmcdb(report->db, report->db_len))
+        report->db_status = RMC_VERIFY_CORRUPTED;
+
+    job.db = report->db;
+    job.sources = sources;
+    job.entry_num = collect_entries(report->db, &job);
+
+    if (job.entry_num) {
+        job.entries = calloc(job.entry_num, sizeof(rmc_verify_entry_t));
+        job.meta_idx = calloc(job.entry_num, sizeof(rmc_uint64_t));
+
+        if (!job.entries || !job.meta_idx)
+            goto err;
+
+        collect_entries(report->db, &job);
+    }
+
+    report->entries = job.entries;
+    report->entry_num = job.entry_num;
+
+    if (run_workers(verify_entry, &job, thread_num, job.entry_num))
+        goto err;
+
+    free(job.meta_idx);
+
+    for (i = 0; i < report->entry_num; i++) {
+        /* blobs of a record are adjacent in entries */
+        if (report->entries[i].record_status != RMC_VERIFY_OK &&
+            (i == 0 || report->entries[i - 1].record_idx != report->entries[i].record_idx))
+            report->bad_record_num++;
+
+        if (report->entries[i].status == RMC_VERIFY_NO_DIGEST)
+            report->unverified_num++;
+        else if (report->entries[i].status != RMC_VERIFY_OK)
+            report->bad_num++;
+    }
+
+    return 0;
+
+err:
+    perror("rmc: insufficient memory to verify database");
+    free(job.entries);
+    free(job.meta_idx);
+    unmap_file(report->db, report->db_len);
+    memset(report, 0, sizeof(*report));
+
+    return 1;
+}
+
+void rmc_free_verify_report(rmc_verify_report_t *report) {
+    if (!report)
+        return;
+
+    free(report->entries);
+    unmap_file(report->db, report->db_len);
+    memset(report, 0, sizeof(*report));
+}
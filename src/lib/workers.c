@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Thread pool for Linux user space, see workers.h
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "workers.h"
+
+typedef struct worker_pool {
+    void (*fn)(void *job, rmc_uint64_t item);
+    void *job;
+    rmc_uint64_t item_num;
+    atomic_ulong next;          /* next item to run */
+} worker_pool_t;
+
+static void *worker(void *arg) {
+    worker_pool_t *pool = arg;
+    rmc_uint64_t item;
+
+    while ((item = atomic_fetch_add(&pool->next, 1)) < pool->item_num)
+        pool->fn(pool->job, item);
+
+    return NULL;
+}
+
+int run_workers(void (*fn)(void *job, rmc_uint64_t item), void *job,
+        int thread_num, rmc_uint64_t item_num) {
+    worker_pool_t pool;
+    pthread_t *threads = NULL;
+    int t;
+    int started = 0;
+
+    if (thread_num <= 0)
+        thread_num = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (thread_num <= 0)
+        thread_num = 1;
+
+    if ((rmc_uint64_t)thread_num > item_num)
+        thread_num = item_num ? item_num : 1;
+
+    threads = calloc(thread_num, sizeof(pthread_t));
+
+    if (!threads)
+        return 1;
+
+    pool.fn = fn;
+    pool.job = job;
+    pool.item_num = item_num;
+    atomic_init(&pool.next, 0);
+
+    /* the calling thread is one of workers */
+    for (t = 1; t < thread_num; t++) {
+        if (pthread_create(&threads[t], NULL, worker, &pool))
+            break;
+        started++;
+    }
+
+    worker(&pool);
+
+    for (t = 1; t <= started; t++)
+        pthread_join(threads[t], NULL);
+
+    free(threads);
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Thread pool for Linux user space
+ *
+ * Batch query and verification split their work into items of the same cost
+ * order. A pool of threads, each taking the next item from a shared counter,
+ * runs a function on all items, and the calling thread is one of workers.
+ *
+ * This header file shall be internally used in rmc.
+ */
+
+#ifndef INC_RMC_WORKERS_H_
+#define INC_RMC_WORKERS_H_
+
+#include <rmc_types.h>
+
+/*
+ * run a function on every item with a pool of threads
+ * (in) fn          : function called with job and index of an item, once per item
+ * (in) job         : data shared by all items, passed to fn
+ * (in) thread_num  : number of threads, 0 or negative for number of online CPUs.
+ *                    It is capped by number of items.
+ * (in) item_num    : number of items
+ *
+ * return           : 0 when all items are done, non-zero for insufficient memory,
+ *                    and no item is done then
+ */
+extern int run_workers(void (*fn)(void *job, rmc_uint64_t item), void *job,
+        int thread_num, rmc_uint64_t item_num);
+
+#endif /* INC_RMC_WORKERS_H_ */
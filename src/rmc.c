@@ -36,14 +36,23 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
 #include <rmc_api.h>
 
 #define USAGE "RMC (Runtime Machine configuration) Tool\n" \
     "NOTE: Most of usages require root permission (sudo)\n\n" \
     "rmc -F [-o output_fingerprint]\n" \
-    "rmc -R [-f <fingerprint file>] -b <blob file list> [-o output_record]\n" \
-    "rmc -D <rmc record file list> [-o output_database]\n" \
-    "rmc -B <name of file blob> -d <rmc database file> -o output_file\n\n" \
+    "rmc -R [-f <fingerprint file>] [-m <finger list>] -b <blob file list> [-o output_record]\n" \
+    "rmc -D <rmc record file list> [-v version] [-o output_database]\n" \
+    "rmc -B <name or pattern of file blob> -d <rmc database file list> -o <output_file or ->\n" \
+    "rmc -B <name list> [-f <fingerprint file list>] -d <rmc database file> -o output_directory\n" \
+    "rmc -L [-f <fingerprint file>] -d <rmc database file list>\n" \
+    "rmc -V -d <rmc database file list> [-b <source file list>]\n" \
+    "rmc -M -d <rmc database file list> [-c policy] [-v version] [-o output_database]\n" \
+    "rmc -C -d <rmc database file> [-o output_prefix]\n" \
+    "rmc -O -d <rmc database file> -p <population file> [-o output_database]\n" \
+    "rmc -W <name of file blob> -d <rmc database file list>\n\n" \
   "-F: manage fingerprint file\n" \
     "\t-o output_file: store RMC fingerprint of current board in output_file\n" \
   "-R: generate board rmc record of board with its fingerprint and file blobs.\n" \
@@ -51,11 +60,61 @@
     "\tNOTE: RMC will create a fingerprint for the board and use it to\n" \
     "\tgenerate record if an input fingerprint file is not provided.\n\n" \
     "\t-b: files to be packed in record\n\n" \
-  "-G: generate rmc database file with records specified in record file list\n\n" \
+    "\t-m: generate a pattern record matching boards with the same values\n" \
+    "\tof fingers in a comma-separated list (e.g. 0 or 0,2), fingers are\n" \
+    "\tnumbered as -E -f shows. A pattern record is a fallback for a family\n" \
+    "\tof boards and requires a version 2 database\n\n" \
+  "-G: generate rmc database file with records specified in record file list\n" \
+    "\t-v: version of database, 1 (default) or 2. A version 2 database has\n" \
+    "\tan index of blob names for pattern queries, an index of boards for\n" \
+    "\tpattern records, dense IDs of boards and names, lists of records having\n" \
+    "\teach name, digests and CRC of data\n\n" \
   "-B: get a file blob with specified name associated to the board rmc is\n" \
   "running on\n" \
-    "\t-d: database file to be queried\n" \
-    "\t-o: path and name of output file of a specific command\n\n" \
+    "\t-d: database file(s) to be queried. With more than one file, blobs\n" \
+    "\tin a later file override ones with the same name in earlier files\n" \
+    "\t-o: path and name of output file of a specific command. A single\n" \
+    "\tblob is copied from database to output in kernel, and written to\n" \
+    "\tstdout with \"-o -\", e.g. to be piped into another program\n" \
+    "\tA name with '*' or '?' is a pattern to get all matched blobs from a\n" \
+    "\tsingle database into directory specified by -o\n" \
+    "\tWith more than one name or with -f, blobs are queried in one pass from\n" \
+    "\ta single database into directory specified by -o\n" \
+    "\t-f: fingerprint files of boards to query offline instead of the board\n" \
+    "\trmc is running on. Blobs of a board are written into a sub-directory\n" \
+    "\tnamed after its fingerprint file\n\n" \
+  "-L: list file blobs associated to the board rmc is running on\n" \
+    "\t-f: list blobs of the board with this fingerprint instead\n" \
+    "\t-d: database file(s) to be listed\n\n" \
+  "-V: verify database files. All blobs are hashed in parallel and checked\n" \
+  "with digests in database (version 2)\n" \
+    "\t-d: database file(s) to be verified\n" \
+    "\t-b: source files to be compared with blobs of the same names\n\n" \
+  "-M: merge database files into one. Records of the same board are merged\n" \
+  "and identical blobs are stored once\n" \
+    "\t-d: database files to be merged\n" \
+    "\t-c: policy for different blobs with the same name for a board: last\n" \
+    "\t(default, blob in a later file wins), first, or error\n" \
+    "\t-v: version of output database, 1 (default) or 2\n\n" \
+  "-C: compile a database file into C source and header, to be linked into\n" \
+  "a program (e.g. a bootloader) which queries blobs without reading files.\n" \
+  "Blobs are located with a perfect hash table computed at compile time.\n" \
+  "Databases with pattern records cannot be compiled\n" \
+    "\t-d: database file to be compiled\n" \
+    "\t-o: output pathname without suffix (default rmc_db), it also names\n" \
+    "\tthe rmc_static_db_t defined in source\n\n" \
+  "-O: reorder records of a database by population of boards, so that\n" \
+  "common boards are found first by readers scanning records (version 1).\n" \
+  "Format and results of queries are not changed. Databases with pattern\n" \
+  "records cannot be reordered\n" \
+    "\t-d: database file to be reordered\n" \
+    "\t-p: population file, each line is a number of machines and a\n" \
+    "\tfingerprint file of a board, e.g. \"1200 NUC6i5SYB_H.fp\"\n" \
+    "\t-o: output database file (default rmc.db)\n\n" \
+  "-W: list records (boards) carrying a file blob with their blob lengths.\n" \
+  "A version 2 database has a list of records for each blob name, a version 1\n" \
+  "database is scanned\n" \
+    "\t-d: database file(s) to be queried\n\n" \
   "-E: Extract data from fingerprint file or database\n" \
     "\t-f: fingerprint file to extract\n" \
     "\t-d: database file to extract\n" \
@@ -70,7 +129,33 @@
     "\trmc -D board1_record board2_record board3_record\n\n" \
     "4. Query a file blob named audio.conf associated to the board rmc is\n" \
     "running on in database my_rmc.db and output to /tmp/new_audio.conf:\n" \
-    "\trmc -B audio.conf -d my_rmc.db -o /tmp/new_audio.conf\n\n"
+    "\trmc -B audio.conf -d my_rmc.db -o /tmp/new_audio.conf\n\n" \
+    "5. Query audio.conf with blobs in oem.db overriding ones in base.db:\n" \
+    "\trmc -B audio.conf -d base.db oem.db -o /tmp/new_audio.conf\n\n" \
+    "6. List file blobs associated to the board rmc is running on:\n" \
+    "\trmc -L -d my_rmc.db\n\n" \
+    "7. Get all file blobs with names starting with audio into /tmp/audio:\n" \
+    "\trmc -B 'audio*' -d my_rmc.db -o /tmp/audio\n\n" \
+    "8. Verify a database and compare blobs with their sources:\n" \
+    "\trmc -V -d my_rmc.db -b file_1 file_2\n\n" \
+    "9. Generate a fallback record for all boards with the same product name\n" \
+    "(finger 0) and a version 2 database with it and a board record:\n" \
+    "\trmc -R -f fingerprint -m 0 -b file_1 -o family.record\n" \
+    "\trmc -D family.record my_board.record -v 2\n\n" \
+    "10. Get audio.conf and bt.conf of two boards into /tmp/images on a build\n" \
+    "server:\n" \
+    "\trmc -B audio.conf bt.conf -f board1.fp board2.fp -d my_rmc.db -o /tmp/images\n\n" \
+    "11. Merge databases from two teams and fail on any conflicting blob:\n" \
+    "\trmc -M -d audio.db video.db -c error -v 2 -o my_rmc.db\n\n" \
+    "12. Stream a firmware blob of the board into another program:\n" \
+    "\trmc -B firmware.bin -d my_rmc.db -o - | sha256sum\n\n" \
+    "13. Compile a database into boot_db.c and boot_db.h to link into a\n" \
+    "bootloader:\n" \
+    "\trmc -C -d my_rmc.db -o boot_db\n\n" \
+    "14. Put boards most machines in the fleet have first in a database:\n" \
+    "\trmc -O -d my_rmc.db -p fleet.txt -o fleet_rmc.db\n\n" \
+    "15. Find which boards get audio.conf and how big their copies are:\n" \
+    "\trmc -W audio.conf -d my_rmc.db\n\n"
 
 
 #define RMC_OPT_CAP_F   (1 << 0)
@@ -82,6 +167,16 @@
 #define RMC_OPT_O       (1 << 6)
 #define RMC_OPT_B       (1 << 7)
 #define RMC_OPT_D       (1 << 8)
+#define RMC_OPT_CAP_L   (1 << 9)
+#define RMC_OPT_V       (1 << 10)
+#define RMC_OPT_CAP_V   (1 << 11)
+#define RMC_OPT_M       (1 << 12)
+#define RMC_OPT_CAP_M   (1 << 13)
+#define RMC_OPT_C       (1 << 14)
+#define RMC_OPT_CAP_C   (1 << 15)
+#define RMC_OPT_CAP_O   (1 << 16)
+#define RMC_OPT_P       (1 << 17)
+#define RMC_OPT_CAP_W   (1 << 18)
 
 static void usage () {
     fprintf(stdout, USAGE);
@@ -127,108 +222,376 @@ static int write_fingerprint_file(const char* pathname, rmc_fingerprint_t *fp) {
     return 0;
 }
 
-typedef enum read_fingerprint_state {
-    TYPE = 1,
-    OFFSET,
-    NAME,
-    VALUE
-} read_fingerprint_state_t;
+/*
+ * get fingerprint from a file, or from the board we are running on
+ * (in) pathname        : path and name of fingerprint file, NULL to fingerprint the board
+ * (out) fp             : pointer of fingerprint structure to hold fingerprint
+ * (out) raw            : raw file blob allocated when reading from file, NULL otherwise.
+ *
+ * return: 0 for success, non-zero for failures. Release fingerprint with put_fingerprint()
+ */
+static int get_fingerprint(const char *pathname, rmc_fingerprint_t *fp, void **raw) {
+    *raw = NULL;
+
+    if (pathname) {
+        if (read_fingerprint_from_file(pathname, fp, raw)) {
+            fprintf(stderr, "Cannot read fingerprint from %s\n\n", pathname);
+            return 1;
+        }
+    } else if (rmc_get_fingerprint(fp)) {
+        fprintf(stderr, "Failed to generate fingerprint for this board\n\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static void put_fingerprint(rmc_fingerprint_t *fp, void *raw) {
+    if (raw)
+        free(raw);
+    else
+        rmc_free_fingerprint(fp);
+}
 
 /*
- * read fingerprint from file
- * (in) pathname        : path and name of file to read
- * (out) fp             : pointer of fingerprint structure to hold read fingerprint
- * (out) raw            : pointer of a pointer which points to raw file blob allocated.
- *                        caller shall use it to free mem. It is NULL for failures.
+ * print type, length and name of file blobs of a board
+ * (in) fp              : fingerprint of board
+ * (in) db_pathnames    : database files, from bottom to top
+ * (in) db_num          : number of database files
  *
  * return: 0 for success, non-zero for failures.
  */
-static int read_fingerprint_from_file(const char* pathname, rmc_fingerprint_t *fp, void **raw) {
-    char *file = NULL;
-    rmc_size_t len = 0;
-    rmc_size_t idx = 0;
-    int i = 0;
-    int ret = 1;
-    read_fingerprint_state_t state = TYPE;
+static int list_files(rmc_fingerprint_t *fp, char **db_pathnames, int db_num) {
+    rmc_uint8_t *db = NULL;
+    rmc_size_t db_len = 0;
+    rmc_uint64_t record_idx = 0;
+    rmc_record_iter_t iter;
+    rmc_overlay_t overlay;
+    rmc_file_t file;
+    rmc_size_t i;
+
+    printf("type      length  name\n");
+
+    /* show the merged view of a stack of databases */
+    if (db_num > 1) {
+        if (rmc_open_overlay(fp, db_pathnames, db_num, &overlay))
+            return 1;
+
+        for (i = 0; i < overlay.entry_num; i++)
+            printf("0x%02x  %10llu  %s\n", RMC_GENERIC_FILE,
+                    (unsigned long long)overlay.entries[i].blob_len, overlay.entries[i].name);
+
+        rmc_close_overlay(&overlay);
+
+        return 0;
+    }
+
+    if (map_file(db_pathnames[0], &db, &db_len))
+        return 1;
 
-    if (read_file(pathname, &file, &len)) {
-        fprintf(stderr, "Failed to read fingerprint file: %s\n", pathname);
+    if (validate_rmcdb(db, db_len)) {
+        fprintf(stderr, "%s is not a valid rmc database\n\n", db_pathnames[0]);
+        unmap_file(db, db_len);
         return 1;
     }
 
-    /* NOTE: We haven't supported "bring your own SMBIOS fields as fingerprint", that means
-     * we still have a hard-coded selected fields when rmc generate a fingerprint for
-     * the board. This will be checked here for consistency, because rsmp always seeks same
-     * fields at run time on target. It simply gets these fields by calling the same function
-     * initialize_fingerprint().
-     *
-     * The rmcl actually doesn't care which fields are in fingerprint.
-     *
-     * In the future, we could release the constraint so that user can specify which five fields
-     * are the best to describe his board. But we should keep it in mind that same value of two
-     * different SMBIOS fields could bring a much higher chance of collision. e.g. a same vendor
-     * name in different SMBIOS tables.
-     *
-     */
-    initialize_fingerprint(fp);
-
-    for (idx = 0; idx < len; idx++) {
-        switch(state) {
-        case TYPE:
-            if (fp->rmc_fingers[i].type != file[idx]) {
-                fprintf(stderr,
-                        "Invalid Finger %d expected type 0x%02x, but got 0x%02x\n\n",
-                        i, fp->rmc_fingers[i].type, file[idx]);
-                goto read_fp_done;
-            }
-            state = OFFSET;
-            break;
-        case OFFSET:
-            if (fp->rmc_fingers[i].offset != file[idx]) {
-                fprintf(stderr, "Invalid Finger %d expected offset 0x%02x, but got 0x%02x\n\n",
-                        i, fp->rmc_fingers[i].offset, file[idx]);
-                goto read_fp_done;
+    while (!query_record_from_db(fp, db, &record_idx)) {
+        init_record_iter(db, record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &file)) {
+            /* skip match rule of pattern records */
+            if (file.type != RMC_GENERIC_FILE)
+                continue;
+
+            printf("0x%02x  %10llu  %s\n", file.type, (unsigned long long)file.blob_len,
+                    file.blob_name);
+        }
+    }
+
+    unmap_file(db, db_len);
+
+    return 0;
+}
+
+/*
+ * List records carrying a file blob in a database
+ * (in) db_pathname     : path and name of database file
+ * (in) blob_name       : name of file blob
+ *
+ * return               : 0 for success, even when no record has the blob.
+ *                        non-zero for failures.
+ */
+static int list_carriers(char *db_pathname, char *blob_name) {
+    rmc_carrier_report_t report;
+    char sig[2 * sizeof(rmc_signature_t) + 1];
+    rmc_uint64_t i;
+    rmc_size_t j;
+
+    if (rmc_query_carriers(db_pathname, blob_name, &report))
+        return 1;
+
+    printf("%s:\n", db_pathname);
+    printf("  record          length  signature\n");
+
+    for (i = 0; i < report.carrier_num; i++) {
+        rmc_carrier_t *c = &report.carriers[i];
+
+        /* signature in hex as -E names directories of records, up to its first '\0' */
+        for (j = 0; j < sizeof(c->signature.raw) && c->signature.raw[j]; j++)
+            sprintf(&sig[2 * j], "%02x", c->signature.raw[j]);
+
+        sig[2 * j] = '\0';
+        printf("  0x%08llx  %10llu  %s%s\n", (unsigned long long)c->record_idx,
+            (unsigned long long)c->blob_len, sig, c->pattern ? " (pattern)" : "");
+    }
+
+    printf("  %llu records have %s\n\n", (unsigned long long)report.carrier_num, blob_name);
+    rmc_free_carrier_report(&report);
+
+    return 0;
+}
+
+/* check if a name of file blob is a pattern */
+static int is_pattern(const char *name) {
+    return strpbrk(name, "*?") != NULL;
+}
+
+/* check if a name of file blob from database can be a file in output directory,
+ * it must not be absolute or climb out of it
+ */
+static int is_safe_name(const char *name) {
+    return *name && !strchr(name, '/') && strcmp(name, ".") && strcmp(name, "..");
+}
+
+/* write all file blobs with names matching pattern into a directory */
+static int write_matched_files(char *db_pathname, char *pattern, char *dir) {
+    rmc_file_t *files = NULL;
+    rmc_file_t *tmp = NULL;
+    char *pathname = NULL;
+    int ret = 1;
+
+    if (rmc_gimme_files(db_pathname, pattern, &files)) {
+        fprintf(stderr, "-B no file blob matches %s\n\n", pattern);
+        return ret;
+    }
+
+    if (mkdir(dir, 0755) && errno != EEXIST) {
+        fprintf(stderr, "-B failed to create directory %s\n\n", dir);
+        goto free_files;
+    }
+
+    for (tmp = files; tmp; tmp = tmp->next) {
+        if (!is_safe_name(tmp->blob_name)) {
+            fprintf(stderr, "-B file blob name %s is not a file name\n\n", tmp->blob_name);
+            goto free_files;
+        }
+
+        pathname = malloc(strlen(dir) + strlen(tmp->blob_name) + 2);
+
+        if (!pathname) {
+            perror("rmc: cannot allocate mem for output pathname");
+            goto free_files;
+        }
+
+        sprintf(pathname, "%s/%s", dir, tmp->blob_name);
+
+        if (write_file(pathname, tmp->blob, tmp->blob_len, 0)) {
+            fprintf(stderr, "-B failed to write file %s to %s\n\n", tmp->blob_name, pathname);
+            free(pathname);
+            goto free_files;
+        }
+
+        free(pathname);
+    }
+
+    ret = 0;
+free_files:
+    rmc_free_file_list(files);
+
+    return ret;
+}
+
+/*
+ * Query blobs with names for many boards in one pass, and write them into a
+ * directory
+ * (in) fp_pathnames    : fingerprint files of boards, NULL to query the board we
+ *                        are running on. Blobs of a board are written into a sub-
+ *                        directory named after its fingerprint file.
+ *
+ * return: 0 when all blobs are written, non-zero for failures or missing blobs
+ */
+static int write_batch_files(char *db_pathname, char **fp_pathnames, int fp_num,
+        char **names, int name_num, char *dir) {
+    rmc_fingerprint_t *fps = NULL;
+    void **raws = NULL;
+    rmc_batch_report_t report;
+    rmc_file_t *result = NULL;
+    char *pathname = NULL;
+    const char *board = NULL;
+    int board_num = fp_pathnames ? fp_num : 1;
+    int read_num = 0;
+    int b;
+    int n;
+    int ret = 1;
+
+    fps = calloc(board_num, sizeof(rmc_fingerprint_t));
+    raws = calloc(board_num, sizeof(void *));
+
+    if (!fps || !raws) {
+        perror("rmc: cannot allocate mem for fingerprints");
+        goto free_fps;
+    }
+
+    for (read_num = 0; read_num < board_num; read_num++) {
+        if (get_fingerprint(fp_pathnames ? fp_pathnames[read_num] : NULL, &fps[read_num], &raws[read_num]))
+            goto free_fps;
+    }
+
+    if (rmc_batch_query(db_pathname, fps, board_num, names, name_num, 0, &report)) {
+        fprintf(stderr, "-B failed to query %s\n\n", db_pathname);
+        goto free_fps;
+    }
+
+    if (mkdir(dir, 0755) && errno != EEXIST) {
+        fprintf(stderr, "-B failed to create directory %s\n\n", dir);
+        goto free_report;
+    }
+
+    for (b = 0; b < board_num; b++) {
+        board = fp_pathnames ? strrchr(fp_pathnames[b], '/') : NULL;
+        board = board ? board + 1 : fp_pathnames ? fp_pathnames[b] : NULL;
+
+        for (n = 0; n < name_num; n++) {
+            result = &report.results[b * name_num + n];
+
+            if (!result->blob) {
+                fprintf(stderr, "-B %s: no file blob %s\n", board ? board : "this board", names[n]);
+                continue;
             }
-            fp->rmc_fingers[i].name = NULL;
-            state = NAME;
-            break;
-        case NAME:
-            if (fp->rmc_fingers[i].name == NULL)
-                fp->rmc_fingers[i].name = &file[idx];
-            if (file[idx] == '\0') {
-                fp->rmc_fingers[i].value = NULL;
-                state = VALUE;
+
+            pathname = malloc(strlen(dir) + (board ? strlen(board) : 0) + strlen(names[n]) + 3);
+
+            if (!pathname) {
+                perror("rmc: cannot allocate mem for output pathname");
+                goto free_report;
             }
-            break;
-        case VALUE:
-            if (fp->rmc_fingers[i].value == NULL)
-                fp->rmc_fingers[i].value = &file[idx];
-            if (file[idx] == '\0') {
-                /* next fingerprint */
-                i++;
-
-                if (!(i < RMC_FINGER_NUM)) {
-                    /* we have got all fingers' data, done */
-                    ret = 0;
-                    goto read_fp_done;
+
+            if (board) {
+                sprintf(pathname, "%s/%s", dir, board);
+
+                if (mkdir(pathname, 0755) && errno != EEXIST) {
+                    fprintf(stderr, "-B failed to create directory %s\n\n", pathname);
+                    free(pathname);
+                    goto free_report;
                 }
-                state = TYPE;
+
+                sprintf(pathname, "%s/%s/%s", dir, board, names[n]);
+            } else
+                sprintf(pathname, "%s/%s", dir, names[n]);
+
+            if (write_file(pathname, result->blob, result->blob_len, 0)) {
+                fprintf(stderr, "-B failed to write file %s to %s\n\n", names[n], pathname);
+                free(pathname);
+                goto free_report;
             }
-            break;
-        default:
-            fprintf(stderr, "Internal error, invalid state when parsing fingerprint\n\n");
-            goto read_fp_done;
+
+            free(pathname);
         }
     }
-read_fp_done:
-    if (ret) {
-        if (i != RMC_FINGER_NUM)
-            fprintf(stderr, "Internal error when parsing finger %d. file could be corrupted\n\n", i);
 
-        free(file);
-        *raw = NULL;
-    } else
-        *raw = file;
+    ret = report.missing_num ? 1 : 0;
+free_report:
+    rmc_free_batch_report(&report);
+free_fps:
+    for (b = 0; b < read_num; b++)
+        put_fingerprint(&fps[b], raws[b]);
+
+    free(fps);
+    free(raws);
+
+    return ret;
+}
+
+#define POPULATION_LINE_LEN 4096
+
+/*
+ * reorder records of a database by a population of boards in a text file. Each
+ * line of file is a number of machines and a fingerprint file separated by
+ * spaces, e.g. "1200 boards/NUC6i5SYB_H.fp". Empty lines and lines starting
+ * with '#' are skipped.
+ * (in) db_pathname     : database file to reorder
+ * (in) population      : population file
+ * (in) output_path     : output database file
+ *
+ * return: 0 for success, non-zero for failures.
+ */
+static int reorder_db(char *db_pathname, char *population, char *output_path) {
+    rmc_fingerprint_t *fps = NULL;
+    rmc_uint64_t *counts = NULL;
+    void **raws = NULL;
+    char line[POPULATION_LINE_LEN];
+    char *pathname = NULL;
+    char *end = NULL;
+    FILE *f = NULL;
+    int board_num = 0;
+    int read_num = 0;
+    int b;
+    int ret = 1;
+
+    if ((f = fopen(population, "r")) == NULL) {
+        perror("rmc: cannot open population file");
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), f))
+        board_num++;
+
+    fps = calloc(board_num ? board_num : 1, sizeof(rmc_fingerprint_t));
+    counts = calloc(board_num ? board_num : 1, sizeof(rmc_uint64_t));
+    raws = calloc(board_num ? board_num : 1, sizeof(void *));
+
+    if (!fps || !counts || !raws) {
+        perror("rmc: cannot allocate mem for population");
+        goto free_fps;
+    }
+
+    rewind(f);
+
+    while (read_num < board_num && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (line[strspn(line, " \t")] == '\0' || line[strspn(line, " \t")] == '#')
+            continue;
+
+        errno = 0;
+        counts[read_num] = strtoull(line, &end, 10);
+        pathname = end + strspn(end, " \t");
+
+        if (errno || end == line || pathname == end || *pathname == '\0') {
+            fprintf(stderr, "-O invalid line in %s: %s\n\n", population, line);
+            goto free_fps;
+        }
+
+        if (get_fingerprint(pathname, &fps[read_num], &raws[read_num]))
+            goto free_fps;
+
+        read_num++;
+    }
+
+    if (rmc_reorder_db(db_pathname, fps, counts, read_num, output_path)) {
+        fprintf(stderr, "-O failed to reorder %s into %s\n\n", db_pathname, output_path);
+        goto free_fps;
+    }
+
+    ret = 0;
+free_fps:
+    for (b = 0; b < read_num; b++)
+        put_fingerprint(&fps[b], raws[b]);
+
+    free(fps);
+    free(counts);
+    free(raws);
+    fclose(f);
 
     return ret;
 }
@@ -283,6 +646,128 @@ static rmc_file_t *read_policy_file(char *pathname, int type) {
     return tmp;
 }
 
+static const char *verify_status_str(int status) {
+    switch (status) {
+    case RMC_VERIFY_OK:
+        return "OK";
+    case RMC_VERIFY_CORRUPTED:
+        return "CORRUPTED";
+    case RMC_VERIFY_NO_DIGEST:
+        return "NO DIGEST";
+    case RMC_VERIFY_SOURCE_MISMATCH:
+        return "SOURCE MISMATCH";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/*
+ * Verify a database file and print blobs not OK
+ * (in) db_pathname     : path and name of database file
+ * (in) source_paths    : null-terminated list of source files, or NULL
+ *
+ * return               : 0 when database and all blobs are good, non-zero otherwise
+ */
+static int verify_db(char *db_pathname, char **source_paths) {
+    rmc_verify_report_t report;
+    rmc_file_t *sources = NULL;
+    rmc_file_t *source = NULL;
+    rmc_uint64_t i;
+    int ret = 1;
+
+    for (i = 0; source_paths && source_paths[i]; i++) {
+        if ((source = read_policy_file(source_paths[i], RMC_GENERIC_FILE)) == NULL)
+            goto free_sources;
+
+        source->next = sources;
+        sources = source;
+    }
+
+    if (rmc_verify_db(db_pathname, sources, 0, &report)) {
+        fprintf(stderr, "Failed to verify %s\n\n", db_pathname);
+        goto free_sources;
+    }
+
+    printf("%s:\n", db_pathname);
+
+    for (i = 0; i < report.entry_num; i++) {
+        rmc_verify_entry_t *e = &report.entries[i];
+
+        /* once for a record, before its first blob */
+        if (e->record_status != RMC_VERIFY_OK &&
+            (i == 0 || report.entries[i - 1].record_idx != e->record_idx))
+            printf("  record 0x%08llx  %-32s %s\n", (unsigned long long)e->record_idx,
+                "(record CRC)", verify_status_str(e->record_status));
+
+        if (e->status != RMC_VERIFY_OK)
+            printf("  record 0x%08llx  %-32s %s\n", (unsigned long long)e->record_idx,
+                e->name, verify_status_str(e->status));
+    }
+
+    printf("  database %s, %llu blobs, %llu bad, %llu without digest, %llu records failing CRC\n\n",
+        verify_status_str(report.db_status), (unsigned long long)report.entry_num,
+        (unsigned long long)report.bad_num, (unsigned long long)report.unverified_num,
+        (unsigned long long)report.bad_record_num);
+
+    if (report.db_status == RMC_VERIFY_OK && report.bad_num == 0 && report.bad_record_num == 0)
+        ret = 0;
+
+    rmc_free_verify_report(&report);
+
+free_sources:
+    rmc_free_file_list(sources);
+
+    return ret;
+}
+
+/*
+ * Parse a comma-separated list of fingers
+ * (in) list            : list of finger numbers, e.g. "0,2"
+ * (out) finger_mask    : RMC_FINGER_BIT() of fingers in list
+ *
+ * return               : 0 for success, non-zero for an invalid list
+ */
+static int parse_finger_list(const char *list, rmc_uint8_t *finger_mask) {
+    char *end = NULL;
+    long finger;
+
+    *finger_mask = 0;
+
+    do {
+        finger = strtol(list, &end, 10);
+
+        if (end == list || finger < 0 || finger >= RMC_FINGER_NUM)
+            return 1;
+
+        *finger_mask |= RMC_FINGER_BIT(finger);
+        list = end + 1;
+    } while (*end == ',');
+
+    return *end != '\0';
+}
+
+/* check if any record in a database is a pattern record */
+static int has_pattern_record(rmc_uint8_t *db) {
+    rmc_db_header_t *db_header = (rmc_db_header_t *)db;
+    rmc_record_header_t record_header;
+    rmc_uint64_t record_idx;
+    rmc_record_iter_t iter;
+    rmc_file_t file;
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header->length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, db + record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(db, record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &file)) {
+            if (file.type == RMC_MATCH_FILE)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
 /*
  * Read a record file into record file structure
  * (in) pathname        : path and name of record file
@@ -314,13 +799,21 @@ static rmc_record_file_t *read_record_file(char *pathname) {
 int main(int argc, char **argv){
 
     int c;
-    rmc_uint16_t options = 0;
+    rmc_uint32_t options = 0;
     char *output_path = NULL;
     char *input_db_path_d = NULL;
+    char **input_db_files = NULL;
+    int input_db_num = 0;
     char **input_file_blobs = NULL;
     char **input_record_files = NULL;
     char *input_fingerprint = NULL;
+    char **input_fingerprints = NULL;
+    int input_fp_num = 0;
     char *input_blob_name = NULL;
+    char *input_population = NULL;
+    char *input_carried_name = NULL;
+    char **input_blob_names = NULL;
+    int input_blob_num = 0;
     rmc_fingerprint_t fingerprint;
     rmc_file_t *policy_files = NULL;
     rmc_record_file_t *record_files = NULL;
@@ -331,6 +824,9 @@ int main(int argc, char **argv){
     int ret = 1;
     int i;
     int arg_num = 0;
+    int db_version = RMC_DB_VERSION_1;
+    rmc_uint8_t finger_mask = 0;
+    int merge_policy = RMC_MERGE_LAST;
 
     if (argc < 2) {
         usage();
@@ -340,7 +836,7 @@ int main(int argc, char **argv){
     /* parse options */
     opterr = 0;
 
-    while ((c = getopt(argc, argv, "FRED:B:b:f:o:d:")) != -1)
+    while ((c = getopt(argc, argv, "FRELVMCOD:B:b:f:o:d:v:m:c:p:W:")) != -1)
         switch (c) {
         case 'F':
             options |= RMC_OPT_CAP_F;
@@ -351,6 +847,44 @@ int main(int argc, char **argv){
         case 'E':
             options |= RMC_OPT_CAP_E;
             break;
+        case 'L':
+            options |= RMC_OPT_CAP_L;
+            break;
+        case 'V':
+            options |= RMC_OPT_CAP_V;
+            break;
+        case 'M':
+            options |= RMC_OPT_CAP_M;
+            break;
+        case 'C':
+            options |= RMC_OPT_CAP_C;
+            break;
+        case 'O':
+            options |= RMC_OPT_CAP_O;
+            break;
+        case 'p':
+            input_population = optarg;
+            options |= RMC_OPT_P;
+            break;
+        case 'W':
+            input_carried_name = optarg;
+            options |= RMC_OPT_CAP_W;
+            break;
+        case 'c':
+            if (!strcmp(optarg, "last"))
+                merge_policy = RMC_MERGE_LAST;
+            else if (!strcmp(optarg, "first"))
+                merge_policy = RMC_MERGE_FIRST;
+            else if (!strcmp(optarg, "error"))
+                merge_policy = RMC_MERGE_ERROR;
+            else {
+                fprintf(stderr, "\nWRONG: invalid policy %s for -c\n\n", optarg);
+                usage();
+                return 1;
+            }
+
+            options |= RMC_OPT_C;
+            break;
         case 'D':
             /* we don't know number of arguments for this option at this point,
              * allocate array with argc which is bigger than needed. But we also
@@ -377,19 +911,77 @@ int main(int argc, char **argv){
             options |= RMC_OPT_CAP_D;
             break;
         case 'B':
-            input_blob_name = optarg;
+            /* names of blobs to query */
+            input_blob_names = calloc(argc, sizeof(char *));
+
+            if (!input_blob_names) {
+                fprintf(stderr, "No enough mem to process `-%c'.\n\n", optopt);
+                /* ! must exit program, memory allocated by other options not freed */
+                exit(1);
+            }
+
+            optind--;
+            input_blob_num = 0;
+
+            while (optind < argc && argv[optind][0] != '-')
+                input_blob_names[input_blob_num++] = argv[optind++];
+
+            input_blob_name = input_blob_names[0];
             options |= RMC_OPT_CAP_B;
             break;
         case 'o':
             output_path = optarg;
             options |= RMC_OPT_O;
             break;
+        case 'v':
+            db_version = atoi(optarg);
+            options |= RMC_OPT_V;
+            break;
+        case 'm':
+            if (parse_finger_list(optarg, &finger_mask)) {
+                fprintf(stderr, "\nWRONG: invalid finger list %s for -m\n\n", optarg);
+                usage();
+                return 1;
+            }
+
+            options |= RMC_OPT_M;
+            break;
         case 'f':
-            input_fingerprint = optarg;
+            /* fingerprint files, more than one only for batch query with -B */
+            input_fingerprints = calloc(argc, sizeof(char *));
+
+            if (!input_fingerprints) {
+                fprintf(stderr, "No enough mem to process `-%c'.\n\n", optopt);
+                /* ! must exit program, memory allocated by other options not freed */
+                exit(1);
+            }
+
+            optind--;
+            input_fp_num = 0;
+
+            while (optind < argc && argv[optind][0] != '-')
+                input_fingerprints[input_fp_num++] = argv[optind++];
+
+            input_fingerprint = input_fingerprints[0];
             options |= RMC_OPT_F;
             break;
         case 'd':
-            input_db_path_d = optarg;
+            /* a stack of database files, from bottom to top */
+            input_db_files = calloc(argc, sizeof(char *));
+
+            if (!input_db_files) {
+                fprintf(stderr, "No enough mem to process `-%c'.\n\n", optopt);
+                /* ! must exit program, memory allocated by other options not freed */
+                exit(1);
+            }
+
+            optind--;
+            input_db_num = 0;
+
+            while (optind < argc && argv[optind][0] != '-')
+                input_db_files[input_db_num++] = argv[optind++];
+
+            input_db_path_d = input_db_files[0];
             options |= RMC_OPT_D;
             break;
         case 'b':
@@ -420,8 +1012,9 @@ int main(int argc, char **argv){
             break;
         case '?':
             if (optopt == 'F' || optopt == 'R' || optopt == 'D' || optopt == 'B' || \
-                    optopt == 'E' ||  optopt == 'b' || optopt == 'f' || \
-                    optopt == 'o' || optopt == 'd')
+                    optopt == 'E' || optopt == 'L' || optopt == 'V' || optopt == 'M' || optopt == 'b' || optopt == 'f' || \
+                    optopt == 'o' || optopt == 'd' || optopt == 'v' || optopt == 'm' || optopt == 'c' || \
+                    optopt == 'O' || optopt == 'p' || optopt == 'W')
                 fprintf(stderr, "\nWRONG USAGE: -%c\n\n", optopt);
             else if (isprint(optopt))
                 fprintf(stderr, "Unknown option `-%c'.\n\n", optopt);
@@ -435,15 +1028,16 @@ int main(int argc, char **argv){
 
     /* sanity check for -o */
     if (options & RMC_OPT_O) {
-        rmc_uint16_t opt_o = options & (RMC_OPT_CAP_D | RMC_OPT_CAP_R |
-            RMC_OPT_CAP_F | RMC_OPT_CAP_B | RMC_OPT_CAP_E);
+        rmc_uint32_t opt_o = options & (RMC_OPT_CAP_D | RMC_OPT_CAP_R | RMC_OPT_CAP_F |
+            RMC_OPT_CAP_B | RMC_OPT_CAP_E | RMC_OPT_CAP_M | RMC_OPT_CAP_C | RMC_OPT_CAP_O);
         if (!(opt_o)) {
-            fprintf(stderr, "\nWRONG: Option -o cannot be applied without -B, -D, -E, -R or -F\n\n");
+            fprintf(stderr, "\nWRONG: Option -o cannot be applied without -B, -C, -D, -E, -M, -O, -R or -F\n\n");
             usage();
             return 1;
         } else if (opt_o != RMC_OPT_CAP_D && opt_o != RMC_OPT_CAP_R &&
-            opt_o != RMC_OPT_CAP_F && opt_o != RMC_OPT_CAP_B  && opt_o != RMC_OPT_CAP_E) {
-            fprintf(stderr, "\nWRONG: Option -o can be applied with only one of -B, -D, -R and -F\n\n");
+            opt_o != RMC_OPT_CAP_F && opt_o != RMC_OPT_CAP_B  && opt_o != RMC_OPT_CAP_E &&
+            opt_o != RMC_OPT_CAP_M && opt_o != RMC_OPT_CAP_C && opt_o != RMC_OPT_CAP_O) {
+            fprintf(stderr, "\nWRONG: Option -o can be applied with only one of -B, -C, -D, -M, -O, -R and -F\n\n");
             usage();
             return 1;
         }
@@ -456,6 +1050,20 @@ int main(int argc, char **argv){
         return 1;
     }
 
+    /* sanity check for -f */
+    if ((options & RMC_OPT_F) && input_fp_num > 1 && !(options & RMC_OPT_CAP_B)) {
+        fprintf(stderr, "\nWRONG: only -B accepts more than one fingerprint file\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -m */
+    if ((options & RMC_OPT_M) && !(options & RMC_OPT_CAP_R)) {
+        fprintf(stderr, "\nWRONG: -m only works with -R\n\n");
+        usage();
+        return 1;
+    }
+
     /* sanity check for -E */
     if ((options & RMC_OPT_CAP_E) && (!(options & RMC_OPT_F) && !(options & RMC_OPT_D))) {
         fprintf(stderr, "\nERROR: -E requires -f <fingerprint file name> or -d <database file name>\n\n");
@@ -463,6 +1071,77 @@ int main(int argc, char **argv){
         return 1;
     }
 
+    /* sanity check for -E */
+    if ((options & RMC_OPT_CAP_E) && input_db_num > 1) {
+        fprintf(stderr, "\nWRONG: -E can extract only one database file\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -L */
+    if ((options & RMC_OPT_CAP_L) && !(options & RMC_OPT_D)) {
+        fprintf(stderr, "\nWRONG: -L requires -d\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -W */
+    if ((options & RMC_OPT_CAP_W) && !(options & RMC_OPT_D)) {
+        fprintf(stderr, "\nWRONG: -W requires -d\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -v */
+    if ((options & RMC_OPT_V) && (!(options & (RMC_OPT_CAP_D | RMC_OPT_CAP_M)) ||
+        (db_version != RMC_DB_VERSION_1 && db_version != RMC_DB_VERSION_2))) {
+        fprintf(stderr, "\nWRONG: -v only works with -D or -M, and version must be 1 or 2\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -M */
+    if ((options & RMC_OPT_CAP_M) && !(options & RMC_OPT_D)) {
+        fprintf(stderr, "\nWRONG: -M requires -d\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -C */
+    if ((options & RMC_OPT_CAP_C) && (!(options & RMC_OPT_D) || input_db_num > 1)) {
+        fprintf(stderr, "\nWRONG: -C requires -d with a single database file\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -O */
+    if ((options & RMC_OPT_CAP_O) && (!(options & RMC_OPT_D) || input_db_num > 1 || !(options & RMC_OPT_P))) {
+        fprintf(stderr, "\nWRONG: -O requires -p and -d with a single database file\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -p */
+    if ((options & RMC_OPT_P) && !(options & RMC_OPT_CAP_O)) {
+        fprintf(stderr, "\nWRONG: -p only works with -O\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -c */
+    if ((options & RMC_OPT_C) && !(options & RMC_OPT_CAP_M)) {
+        fprintf(stderr, "\nWRONG: -c only works with -M\n\n");
+        usage();
+        return 1;
+    }
+
+    /* sanity check for -V */
+    if ((options & RMC_OPT_CAP_V) && !(options & RMC_OPT_D)) {
+        fprintf(stderr, "\nWRONG: -V requires -d\n\n");
+        usage();
+        return 1;
+    }
+
     /* sanity check for -B */
     if ((options & RMC_OPT_CAP_B) && (!(options & RMC_OPT_D) || !(options & RMC_OPT_O))) {
         fprintf(stderr, "\nWRONG: -B requires -d and -o\n\n");
@@ -472,24 +1151,141 @@ int main(int argc, char **argv){
 
     /* get a file blob */
     if (options & RMC_OPT_CAP_B) {
-        rmc_file_t file;
-
         if (!output_path) {
             fprintf(stderr, "-B internal error, with -o but no output \
                 pathname specified\n\n");
             goto main_free;
         }
 
-        if (rmc_gimme_file(input_db_path_d, input_blob_name, &file))
+        if ((input_blob_num > 1 || (options & RMC_OPT_F) || is_pattern(input_blob_name)) &&
+            !strcmp(output_path, "-")) {
+            fprintf(stderr, "-B can write only a single blob to stdout\n\n");
             goto main_free;
+        }
+
+        if (input_blob_num > 1 || (options & RMC_OPT_F)) {
+            if (input_db_num > 1) {
+                fprintf(stderr, "-B batch query only supports a single database\n\n");
+                goto main_free;
+            }
+
+            for (i = 0; i < input_blob_num; i++) {
+                if (is_pattern(input_blob_names[i])) {
+                    fprintf(stderr, "-B batch query doesn't support pattern %s\n\n",
+                        input_blob_names[i]);
+                    goto main_free;
+                }
+            }
+
+            if (write_batch_files(input_db_path_d, (options & RMC_OPT_F) ? input_fingerprints : NULL,
+                input_fp_num, input_blob_names, input_blob_num, output_path))
+                goto main_free;
+        } else if (is_pattern(input_blob_name)) {
+            if (input_db_num > 1) {
+                fprintf(stderr, "-B pattern query only supports a single database\n\n");
+                goto main_free;
+            }
+
+            if (write_matched_files(input_db_path_d, input_blob_name, output_path))
+                goto main_free;
+        } else {
+            rmc_fingerprint_t fp;
+            rmc_size_t blob_len = 0;
+            struct stat out_stat;
+            int out_created = 0;
+            int out_fd = STDOUT_FILENO;
+            int query_ret;
+
+            if (rmc_get_fingerprint(&fp)) {
+                fprintf(stderr, "-B Failed to generate fingerprint for this board\n\n");
+                goto main_free;
+            }
+
+            /* "-" is stdout, which can be a pipe to stream blob into other tools.
+             * An existing file is truncated only after blob is written, so that
+             * it is left intact when board doesn't have the blob.
+             */
+            if (strcmp(output_path, "-")) {
+                out_created = stat(output_path, &out_stat) < 0 && errno == ENOENT;
+
+                if ((out_fd = open(output_path, O_WRONLY | O_CREAT, 0644)) < 0) {
+                    perror("rmc: failed to open output file");
+                    rmc_free_fingerprint(&fp);
+                    goto main_free;
+                }
+            }
+
+            /* blob is copied from database file to output in kernel */
+            if (input_db_num > 1)
+                query_ret = rmc_write_file_by_fp_overlay(&fp, input_db_files, input_db_num,
+                        input_blob_name, out_fd, &blob_len);
+            else
+                query_ret = rmc_write_file_by_fp(&fp, input_db_path_d, input_blob_name,
+                        out_fd, &blob_len);
+
+            rmc_free_fingerprint(&fp);
 
-        if (write_file(output_path, file.blob, file.blob_len, 0)) {
-            fprintf(stderr, "-B failed to write file %s to %s\n\n",
-                input_blob_name, output_path);
-            rmc_free_file(&file);
+            if (out_fd != STDOUT_FILENO) {
+                if (!query_ret && !fstat(out_fd, &out_stat) && S_ISREG(out_stat.st_mode) &&
+                    ftruncate(out_fd, blob_len) < 0) {
+                    perror("rmc: failed to truncate output file");
+                    query_ret = 1;
+                }
+
+                if (close(out_fd) < 0 && !query_ret) {
+                    perror("rmc: failed to close output file");
+                    query_ret = 1;
+                }
+
+                if (query_ret && out_created)
+                    unlink(output_path);
+            }
+
+            if (query_ret) {
+                fprintf(stderr, "-B failed to write file %s to %s\n\n",
+                    input_blob_name, output_path);
+                goto main_free;
+            }
+        }
+    }
+
+    /* list file blobs */
+    if (options & RMC_OPT_CAP_L) {
+        rmc_fingerprint_t fp;
+        void *list_raw_fp = NULL;
+        int list_ret;
+
+        if (get_fingerprint(input_fingerprint, &fp, &list_raw_fp))
+            goto main_free;
+
+        list_ret = list_files(&fp, input_db_files, input_db_num);
+        put_fingerprint(&fp, list_raw_fp);
+
+        if (list_ret) {
+            fprintf(stderr, "-L failed to list file blobs in database\n\n");
             goto main_free;
         }
-        rmc_free_file(&file);
+    }
+
+    /* list records carrying a file blob */
+    if (options & RMC_OPT_CAP_W) {
+        for (i = 0; i < input_db_num; i++) {
+            if (list_carriers(input_db_files[i], input_carried_name)) {
+                fprintf(stderr, "-W failed to query %s\n\n", input_db_files[i]);
+                goto main_free;
+            }
+        }
+    }
+
+    /* verify databases */
+    if (options & RMC_OPT_CAP_V) {
+        int verify_ret = 0;
+
+        for (i = 0; i < input_db_num; i++)
+            verify_ret |= verify_db(input_db_files[i], input_file_blobs);
+
+        if (verify_ret)
+            goto main_free;
     }
 
     if (options & RMC_OPT_CAP_E) {
@@ -516,6 +1312,38 @@ int main(int argc, char **argv){
         }
     }
 
+    /* merge RMC database files */
+    if (options & RMC_OPT_CAP_M) {
+        if (output_path == NULL)
+            output_path = "rmc.db";
+
+        if (rmc_merge_db(input_db_files, input_db_num, merge_policy, db_version, output_path)) {
+            fprintf(stderr, "Failed to merge databases into %s\n\n", output_path);
+            goto main_free;
+        }
+    }
+
+    /* reorder records of RMC database file by population of boards */
+    if (options & RMC_OPT_CAP_O) {
+        if (output_path == NULL)
+            output_path = "rmc.db";
+
+        if (reorder_db(input_db_path_d, input_population, output_path))
+            goto main_free;
+    }
+
+    /* compile RMC database file into C source */
+    if (options & RMC_OPT_CAP_C) {
+        if (output_path == NULL)
+            output_path = "rmc_db";
+
+        if (rmc_compile_db(input_db_path_d, output_path)) {
+            fprintf(stderr, "Failed to compile %s into %s.c and %s.h\n\n", input_db_path_d,
+                output_path, output_path);
+            goto main_free;
+        }
+    }
+
     /* generate RMC database file */
     if (options & RMC_OPT_CAP_D) {
         int record_idx = 0;
@@ -547,11 +1375,18 @@ int main(int argc, char **argv){
         }
 
         /* call rmcl to generate DB blob */
-        if (rmcl_generate_db(record_files, &db, &db_len)) {
+        if ((db_version == RMC_DB_VERSION_2 ? rmcl_generate_db_v2(record_files, &db, &db_len) :
+            rmcl_generate_db(record_files, &db, &db_len))) {
             fprintf(stderr, "Failed to generate database blob\n\n");
             goto main_free;
         }
 
+        /* boards cannot match pattern records without the index in version 2 */
+        if (db_version == RMC_DB_VERSION_1 && has_pattern_record(db)) {
+            fprintf(stderr, "Pattern records require a version 2 database (-v 2)\n\n");
+            goto main_free;
+        }
+
         /* write rmc database file */
         if (write_file(output_path, db, db_len, 0)) {
             fprintf(stderr, "Failed to write RMC database to %s\n\n", output_path);
@@ -614,7 +1449,8 @@ int main(int argc, char **argv){
         }
 
         /* call rmcl to generate record blob */
-        if (rmcl_generate_record(&fp, policy_files, &record)) {
+        if ((finger_mask ? rmcl_generate_pattern_record(&fp, finger_mask, policy_files, &record) :
+            rmcl_generate_record(&fp, policy_files, &record))) {
             fprintf(stderr, "Failed to generate record for this board\n\n");
             rmc_free_fingerprint(free_fp);
             goto main_free;
@@ -694,6 +1530,9 @@ main_free:
         free(t);
     }
 
+    free(input_db_files);
+    free(input_blob_names);
+    free(input_fingerprints);
     free(raw_fp);
     free(db);
 
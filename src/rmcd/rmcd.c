@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * rmcd - RMC query daemon
+ *
+ *  - Obtain fingerprint of the board once at start
+ *  - Map a RMC database file and index blobs of the board once (see
+ *    rmc_open_overlay())
+ *  - Serve queries by blob name over a UNIX socket, blobs are passed
+ *    to clients as sealed memfds, which are created once. Each reply
+ *    opens its own file description of a memfd, so clients never share
+ *    a file offset.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <rmc_api.h>
+
+#define USAGE "RMC Query Daemon\n" \
+    "NOTE: Root permission is required to obtain fingerprint of board\n\n" \
+    "rmcd -d <rmc database file> [-f <fingerprint file>] [-s socket]\n" \
+    "rmcd -S [-s socket]\n\n" \
+  "-d: database file to serve\n" \
+  "-f: use fingerprint in file instead of the board rmcd is running on\n" \
+  "-s: path of socket, default is " RMCD_SOCKET_PATH "\n" \
+  "-S: print counters of a running rmcd\n\n"
+
+#define RMCD_MAX_CLIENTS 64
+
+static rmc_overlay_t overlay;
+static int *memfds = NULL;     /* sealed memfds of indexed blobs, created at the first hit */
+static rmcd_stats_t stats;
+static struct stat db_stat;
+static volatile sig_atomic_t quit = 0;
+
+static void usage () {
+    fprintf(stdout, USAGE);
+}
+
+static void handle_signal(int sig __attribute__ ((__unused__))) {
+    quit = 1;
+}
+
+static rmc_uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (rmc_uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int listen_socket(const char *path) {
+    struct sockaddr_un addr;
+    int sock = -1;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "rmcd: socket path %s is too long\n", path);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if ((sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0)) < 0) {
+        perror("rmcd: cannot create socket");
+        return -1;
+    }
+
+    /* a stale socket left by a previous instance */
+    unlink(path);
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 16) < 0) {
+        perror("rmcd: cannot listen on socket");
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+static int send_reply(int sock, rmcd_reply_t *reply, int fd) {
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg = NULL;
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctrl;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = reply;
+    iov.iov_len = sizeof(*reply);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd >= 0) {
+        msg.msg_control = ctrl.buf;
+        msg.msg_controllen = sizeof(ctrl.buf);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) != sizeof(*reply);
+}
+
+/*
+ * open a new file description of a memfd, read-only as it is sealed
+ *
+ * return: file descriptor, or -1 for failures
+ */
+static int reopen_memfd(int memfd) {
+    char path[32];
+
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", memfd);
+
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+/*
+ * serve one request from a client
+ *
+ * return: 0 when the connection can be kept, non-zero to close it
+ */
+static int serve_client(int sock) {
+    rmcd_request_t req;
+    rmcd_reply_t reply;
+    rmc_overlay_entry_t *e = NULL;
+    rmc_uint64_t start = 0;
+    rmc_uint64_t lat = 0;
+    rmc_ssize_t len = 0;
+    int fd = -1;
+
+    len = recv(sock, &req, sizeof(req), 0);
+
+    if (len <= 0)
+        return 1;
+
+    start = now_ns();
+    memset(&reply, 0, sizeof(reply));
+
+    if (len != sizeof(req)) {
+        reply.status = RMCD_STATUS_ERROR;
+        send_reply(sock, &reply, -1);
+        return 1;
+    }
+
+    switch (req.op) {
+    case RMCD_OP_STATS:
+        reply.status = RMCD_STATUS_OK;
+        reply.stats = stats;
+        return send_reply(sock, &reply, -1);
+    case RMCD_OP_QUERY:
+        break;
+    default:
+        reply.status = RMCD_STATUS_ERROR;
+        return send_reply(sock, &reply, -1);
+    }
+
+    stats.queries++;
+    req.name[RMCD_NAME_MAX - 1] = '\0';
+
+    if ((req.db_dev || req.db_ino) &&
+        (req.db_dev != db_stat.st_dev || req.db_ino != db_stat.st_ino)) {
+        reply.status = RMCD_STATUS_OTHER_DB;
+    } else if ((e = rmc_lookup_overlay(&overlay, req.name)) == NULL) {
+        reply.status = RMCD_STATUS_NOT_FOUND;
+        stats.misses++;
+    } else {
+        int *memfd = &memfds[e - overlay.entries];
+
+        if (*memfd < 0)
+            *memfd = write_memfd(e->name, e->blob, e->blob_len);
+
+        if (*memfd < 0 || (fd = reopen_memfd(*memfd)) < 0) {
+            reply.status = RMCD_STATUS_ERROR;
+            stats.errors++;
+        } else {
+            reply.status = RMCD_STATUS_OK;
+            reply.blob_len = e->blob_len;
+            stats.hits++;
+        }
+    }
+
+    if (send_reply(sock, &reply, fd))
+        stats.errors++;
+
+    /* client has its own reference after sendmsg() */
+    if (fd >= 0)
+        close(fd);
+
+    lat = now_ns() - start;
+    stats.latency_total_ns += lat;
+    if (lat > stats.latency_max_ns)
+        stats.latency_max_ns = lat;
+
+    return 0;
+}
+
+static int print_stats(void) {
+    rmcd_stats_t s;
+
+    if (rmcd_get_stats(&s)) {
+        fprintf(stderr, "rmcd is not running\n");
+        return 1;
+    }
+
+    printf("queries          : %llu\n", (unsigned long long)s.queries);
+    printf("hits             : %llu\n", (unsigned long long)s.hits);
+    printf("misses           : %llu\n", (unsigned long long)s.misses);
+    printf("errors           : %llu\n", (unsigned long long)s.errors);
+    printf("latency avg (ns) : %llu\n",
+        (unsigned long long)(s.queries ? s.latency_total_ns / s.queries : 0));
+    printf("latency max (ns) : %llu\n", (unsigned long long)s.latency_max_ns);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int c;
+    char *db_path = NULL;
+    char *fp_path = NULL;
+    char *sock_path = RMCD_SOCKET_PATH;
+    int show_stats = 0;
+    rmc_fingerprint_t fp;
+    void *raw_fp = NULL;
+    struct pollfd fds[RMCD_MAX_CLIENTS + 1];
+    struct sigaction sa;
+    int nfds = 1;
+    int ret = 1;
+    int i;
+    rmc_size_t entry;
+
+    opterr = 0;
+
+    while ((c = getopt(argc, argv, "Sd:f:s:")) != -1)
+        switch (c) {
+        case 'S':
+            show_stats = 1;
+            break;
+        case 'd':
+            db_path = optarg;
+            break;
+        case 'f':
+            fp_path = optarg;
+            break;
+        case 's':
+            sock_path = optarg;
+            break;
+        case '?':
+            if (isprint(optopt))
+                fprintf(stderr, "Unknown option or missing argument `-%c'.\n\n", optopt);
+            else
+                fprintf(stderr, "Unknown option character `\\x%x'.\n\n", optopt);
+            usage();
+            return 1;
+        default:
+            return 1;
+        }
+
+    if (show_stats) {
+        setenv(RMCD_SOCKET_ENV, sock_path, 1);
+        return print_stats();
+    }
+
+    if (!db_path) {
+        usage();
+        return 1;
+    }
+
+    /* fingerprint once */
+    if (fp_path) {
+        if (read_fingerprint_from_file(fp_path, &fp, &raw_fp)) {
+            fprintf(stderr, "rmcd: cannot read fingerprint from %s\n", fp_path);
+            return 1;
+        }
+    } else if (rmc_get_fingerprint(&fp)) {
+        fprintf(stderr, "rmcd: failed to generate fingerprint for this board\n");
+        return 1;
+    }
+
+    /* map and index database once, a board not in database still gets
+     * served, with misses
+     */
+    if (stat(db_path, &db_stat) < 0 || rmc_open_overlay(&fp, &db_path, 1, &overlay)) {
+        fprintf(stderr, "rmcd: failed to open database file %s\n", db_path);
+        goto free_fp;
+    }
+
+    if (overlay.entry_num) {
+        memfds = malloc(overlay.entry_num * sizeof(int));
+
+        if (!memfds) {
+            perror("rmcd: cannot allocate memfd table");
+            goto close_db;
+        }
+
+        for (entry = 0; entry < overlay.entry_num; entry++)
+            memfds[entry] = -1;
+    }
+
+    fds[0].fd = listen_socket(sock_path);
+    fds[0].events = POLLIN;
+
+    if (fds[0].fd < 0)
+        goto close_db;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    while (!quit) {
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("rmcd: poll failed");
+            break;
+        }
+
+        for (i = 1; i < nfds; i++) {
+            if (!fds[i].revents)
+                continue;
+
+            if ((fds[i].revents & POLLIN) && !serve_client(fds[i].fd))
+                continue;
+
+            /* client is gone */
+            close(fds[i].fd);
+            fds[i--] = fds[--nfds];
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int client = -1;
+
+            while (nfds <= RMCD_MAX_CLIENTS &&
+                (client = accept4(fds[0].fd, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+                fds[nfds].fd = client;
+                fds[nfds].events = POLLIN;
+                fds[nfds].revents = 0;
+                nfds++;
+            }
+        }
+
+        /* leave pending connections in backlog while all slots are taken,
+         * polling the listening socket would return at once
+         */
+        fds[0].events = nfds <= RMCD_MAX_CLIENTS ? POLLIN : 0;
+    }
+
+    ret = 0;
+
+    for (i = 0; i < nfds; i++)
+        close(fds[i].fd);
+
+    unlink(sock_path);
+
+close_db:
+    for (entry = 0; memfds && entry < overlay.entry_num; entry++)
+        if (memfds[entry] >= 0)
+            close(memfds[entry]);
+    free(memfds);
+    rmc_close_overlay(&overlay);
+free_fp:
+    if (raw_fp)
+        free(raw_fp);
+    else
+        rmc_free_fingerprint(&fp);
+
+    return ret;
+}
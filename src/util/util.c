@@ -1,18 +1,76 @@
 #include <rmc_util.h>
 
+/* Routines below work a machine word at a time once addresses are aligned.
+ * Words are accessed through types allowed to alias anything, so that they
+ * are safe with any optimization level, and an aligned word never crosses a
+ * page boundary, so reading a whole word around a terminator is safe.
+ */
+typedef rmc_size_t __attribute__ ((__may_alias__)) rmc_word_t;
+typedef rmc_size_t __attribute__ ((__may_alias__, __aligned__(1))) rmc_uword_t;
+
+#define WORD_SIZE       sizeof(rmc_word_t)
+#define WORD_MASK       (WORD_SIZE - 1)
+#define WORD_ONES       ((rmc_word_t)-1 / 0xff)    /* 0x0101...01 */
+#define WORD_HIGHS      (WORD_ONES * 0x80)         /* 0x8080...80 */
+#define HAS_ZERO(w)     (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+#define IS_ALIGNED(p)   (!((rmc_size_t)(p) & WORD_MASK))
+
 void *memset(void *s, rmc_uint8_t c, rmc_size_t n) {
     rmc_uint8_t *p = (rmc_uint8_t *)s;
+    rmc_word_t w = WORD_ONES * c;
+
+    while (n && !IS_ALIGNED(p)) {
+        *p++ = c;
+        n--;
+    }
+
+    for (; n >= 4 * WORD_SIZE; n -= 4 * WORD_SIZE, p += 4 * WORD_SIZE) {
+        ((rmc_word_t *)p)[0] = w;
+        ((rmc_word_t *)p)[1] = w;
+        ((rmc_word_t *)p)[2] = w;
+        ((rmc_word_t *)p)[3] = w;
+    }
+
+    for (; n >= WORD_SIZE; n -= WORD_SIZE, p += WORD_SIZE)
+        *(rmc_word_t *)p = w;
+
     while (n--)
         *p++ = c;
     return s;
 }
 
 int strncmp(const char *s1, const char *s2, rmc_size_t n) {
+    const rmc_uint8_t *p = (const rmc_uint8_t *)s1;
+    const rmc_uint8_t *q = (const rmc_uint8_t *)s2;
+    rmc_word_t w;
+
+    /* compare words only when both strings can be aligned at the same time */
+    if (!(((rmc_size_t)p ^ (rmc_size_t)q) & WORD_MASK)) {
+        while (n && !IS_ALIGNED(p)) {
+            if (*p == '\0' || *p != *q)
+                return *p - *q;
+            p++;
+            q++;
+            n--;
+        }
+
+        while (n >= WORD_SIZE) {
+            w = *(const rmc_word_t *)p;
+
+            if (w != *(const rmc_word_t *)q || HAS_ZERO(w))
+                break;
+
+            p += WORD_SIZE;
+            q += WORD_SIZE;
+            n -= WORD_SIZE;
+        }
+    }
+
     while (n--) {
-        if (*s1 == '\0' || *s1 != *s2)
-            return *s1 - *s2;
-        s1++;
-        s2++;
+        if (*p == '\0' || *p != *q)
+            return *p - *q;
+        p++;
+        q++;
     }
 
     return 0;
@@ -22,6 +80,24 @@ void *memcpy(void *d, const void *s, rmc_size_t n) {
     rmc_uint8_t *p = d;
     rmc_uint8_t *q = (rmc_uint8_t *)s;
 
+    /* align destination, source could be still unaligned. x86 loads
+     * unaligned words at nearly no cost.
+     */
+    while (n && !IS_ALIGNED(p)) {
+        *p++ = *q++;
+        n--;
+    }
+
+    for (; n >= 4 * WORD_SIZE; n -= 4 * WORD_SIZE, p += 4 * WORD_SIZE, q += 4 * WORD_SIZE) {
+        ((rmc_word_t *)p)[0] = ((const rmc_uword_t *)q)[0];
+        ((rmc_word_t *)p)[1] = ((const rmc_uword_t *)q)[1];
+        ((rmc_word_t *)p)[2] = ((const rmc_uword_t *)q)[2];
+        ((rmc_word_t *)p)[3] = ((const rmc_uword_t *)q)[3];
+    }
+
+    for (; n >= WORD_SIZE; n -= WORD_SIZE, p += WORD_SIZE, q += WORD_SIZE)
+        *(rmc_word_t *)p = *(const rmc_uword_t *)q;
+
     while (n--)
         *p++ = *q++;
 
@@ -29,21 +105,50 @@ void *memcpy(void *d, const void *s, rmc_size_t n) {
 }
 
 rmc_size_t strlen(const char *s) {
-    rmc_size_t ret = 0;
+    const char *p = s;
+
+    while (!IS_ALIGNED(p)) {
+        if (*p == '\0')
+            return p - s;
+        p++;
+    }
 
-    while (*s++ != '\0')
-      ret++;
-    return ret;
+    while (!HAS_ZERO(*(const rmc_word_t *)p))
+        p += WORD_SIZE;
+
+    while (*p != '\0')
+      p++;
+    return p - s;
 }
 
 char *strncpy(char *d, const char *s, rmc_size_t n) {
-    rmc_size_t i;
+    rmc_size_t i = 0;
+    rmc_word_t w;
+
+    while (i < n && !IS_ALIGNED(s + i)) {
+        if ((d[i] = s[i]) == '\0')
+            break;
+        i++;
+    }
+
+    /* copy whole words until one has terminator */
+    if (i < n && s[i] != '\0') {
+        while (n - i >= WORD_SIZE) {
+            w = *(const rmc_word_t *)(s + i);
+
+            if (HAS_ZERO(w))
+                break;
+
+            *(rmc_uword_t *)(d + i) = w;
+            i += WORD_SIZE;
+        }
+    }
 
-    for (i = 0; i < n && s[i] != '\0'; i++)
+    for (; i < n && s[i] != '\0'; i++)
         d[i] = s[i];
 
-    for (; i < n; i++)
-        d[i] = '\0';
+    if (i < n)
+        memset(d + i, '\0', n - i);
 
     return d;
 }
@@ -0,0 +1,38 @@
+#!/bin/sh
+# This script tests queries into a caller buffer in librmc
+# don't allocate any memory. Allocation functions are trapped
+# while blobs are queried from databases of version 1 and 2,
+# and while the running board is fingerprinted.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 \
+    -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $BOARDS_DIR/T100.32.file.1 \
+    -o $TEST_TMP_DIR/T100.rec 1>/dev/null
+../src/rmc -D $TEST_TMP_DIR/T100.rec $TEST_TMP_DIR/NUC6.rec -o $TEST_TMP_DIR/rmc.v1.db
+../src/rmc -D $TEST_TMP_DIR/T100.rec $TEST_TMP_DIR/NUC6.rec -v 2 -o $TEST_TMP_DIR/rmc.v2.db
+
+cc -Wall -I../inc alloc_trap.c ../src/lib/librmc.a -pthread -o $TEST_TMP_DIR/alloc_trap
+
+if $TEST_TMP_DIR/alloc_trap $BOARDS_DIR/NUC6i5SYB_H.fp $BOARDS_DIR/NUC6.file.2 NUC6.file.2 \
+    $TEST_TMP_DIR/rmc.v1.db $TEST_TMP_DIR/rmc.v2.db 2>$TEST_TMP_DIR/log; then
+    echo "RMC allocation-free query test: PASS"
+    rm -rf $TEST_TMP_DIR
+    make -C ../ clean 1>/dev/null
+else
+    echo "RMC allocation-free query test: FAIL"
+    cat $TEST_TMP_DIR/log
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+fi
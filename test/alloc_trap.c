@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Allocation trap test of allocation-free query APIs
+ *
+ * Memory allocation functions are replaced by a bump allocator which counts
+ * calls made while the trap is armed. Queries into a caller buffer and
+ * fingerprinting of the running board shall not touch allocator at all. A
+ * query known to allocate is run in the trap first, to prove it works.
+ *
+ * usage: alloc_trap <fingerprint file> <blob file> <blob name> <db>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+#define ARENA_SIZE      (64 << 20)
+#define ALIGN           16
+
+static unsigned char arena[ARENA_SIZE] __attribute__ ((aligned (ALIGN)));
+static size_t arena_used = 0;
+static int armed = 0;
+static unsigned long trapped = 0;
+
+/* size of block is stored right before it */
+void *malloc(size_t size) {
+    unsigned char *p = NULL;
+
+    if (armed)
+        trapped++;
+
+    size = (size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+
+    if (ARENA_SIZE - arena_used < size + ALIGN)
+        return NULL;
+
+    p = arena + arena_used + ALIGN;
+    *(size_t *)(p - sizeof(size_t)) = size;
+    arena_used += size + ALIGN;
+
+    return p;
+}
+
+void free(void *ptr) {
+    if (armed && ptr)
+        trapped++;
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    void *p = NULL;
+
+    if (size && nmemb > (size_t)-1 / size)
+        return NULL;
+
+    /* arena is zeroed and never reused */
+    p = malloc(nmemb * size);
+
+    return p;
+}
+
+void *realloc(void *ptr, size_t size) {
+    void *p = malloc(size);
+    size_t old;
+
+    if (p && ptr) {
+        old = *(size_t *)((unsigned char *)ptr - sizeof(size_t));
+        memcpy(p, ptr, old < size ? old : size);
+    }
+
+    return p;
+}
+
+static unsigned long disarm(void) {
+    unsigned long n = trapped;
+
+    armed = 0;
+    trapped = 0;
+
+    return n;
+}
+
+static void arm(void) {
+    trapped = 0;
+    armed = 1;
+}
+
+int main(int argc, char **argv) {
+    static unsigned char buf[1 << 16];
+    rmc_fingerprint_t fp;
+    rmc_fingerprint_buf_t board;
+    void *raw = NULL;
+    char *expected = NULL;
+    rmc_size_t expected_len = 0;
+    rmc_size_t len = 0;
+    rmc_file_t file;
+    unsigned long n;
+    int failed = 0;
+    int ret;
+    int i;
+
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s <fingerprint file> <blob file> <blob name> <db>...\n", argv[0]);
+        return 1;
+    }
+
+    if (read_fingerprint_from_file(argv[1], &fp, &raw) ||
+        read_file(argv[2], &expected, &expected_len)) {
+        fprintf(stderr, "Cannot read test data\n");
+        return 1;
+    }
+
+    /* trap must catch a query known to allocate */
+    arm();
+    ret = rmc_query_file_by_fp(&fp, argv[4], argv[3], &file);
+    n = disarm();
+
+    if (ret || !n) {
+        fprintf(stderr, "Allocation trap doesn't work\n");
+        return 1;
+    }
+
+    for (i = 4; i < argc; i++) {
+        /* get size of blob, then blob */
+        arm();
+        ret = rmc_query_file_to_buffer(&fp, argv[i], argv[3], NULL, 0, &len);
+        n = disarm();
+
+        if (!ret || len != expected_len || n) {
+            fprintf(stderr, "%s: size query returns %d, len %lu, %lu allocations\n",
+                argv[i], ret, (unsigned long)len, n);
+            failed = 1;
+        }
+
+        arm();
+        ret = rmc_query_file_to_buffer(&fp, argv[i], argv[3], buf, sizeof(buf), &len);
+        n = disarm();
+
+        if (ret || len != expected_len || memcmp(buf, expected, len) || n) {
+            fprintf(stderr, "%s: query returns %d, len %lu, %lu allocations\n",
+                argv[i], ret, (unsigned long)len, n);
+            failed = 1;
+        }
+
+        /* a missing blob */
+        arm();
+        ret = rmc_query_file_to_buffer(&fp, argv[i], "rmc.no.such.blob", buf, sizeof(buf), &len);
+        n = disarm();
+
+        if (!ret || len || n) {
+            fprintf(stderr, "%s: missing blob query returns %d, len %lu, %lu allocations\n",
+                argv[i], ret, (unsigned long)len, n);
+            failed = 1;
+        }
+    }
+
+    /* fingerprinting fails on a build host without SMBIOS, but still shall
+     * not allocate on the way
+     */
+    arm();
+    ret = rmc_get_fingerprint_buf(&board);
+
+    if (!ret)
+        rmc_query_file_to_buffer(&board.fp, argv[4], argv[3], buf, sizeof(buf), &len);
+
+    n = disarm();
+
+    if (n) {
+        fprintf(stderr, "Fingerprinting board makes %lu allocations\n", n);
+        failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,87 @@
+#!/bin/sh
+# This script tests offline batch query of rmc tool on a
+# build host. Blobs of all sample boards are queried with
+# their fingerprint files in one run, from databases of
+# version 1 and 2, and compared with the sample data.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+# Board #1
+NUC6_FINGERPRINT="NUC6i5SYB_H.fp"
+NUC6_FILES="NUC6.file.1 NUC6.file.2 NUC6.file.3"
+
+# Board #2
+NUC4_FINGERPRINT="NUC4.D54250WYK.fp"
+NUC4_FILES="NUC4.file.1 NUC4.file.2"
+
+# Board #3
+T100_FINGERPRINT="T100TA-32bit.fp"
+T100_FILES="T100.32.file.1 T100.32.file.2"
+
+BOARDS="NUC6 NUC4 T100"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC batch query test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+DB_RECORDS=
+ALL_FINGERPRINTS=
+ALL_FILES=
+
+for board in $BOARDS; do
+    eval FINGERPRINT=\$${board}_FINGERPRINT
+    eval FILES=\$${board}_FILES
+    FILE_BLOBS=
+
+    for each in $FILES; do
+        FILE_BLOBS="$FILE_BLOBS $BOARDS_DIR/$each"
+    done
+
+    ../src/rmc -R -f $BOARDS_DIR/$FINGERPRINT -b $FILE_BLOBS -o $TEST_TMP_DIR/$board.rec 1>/dev/null
+    DB_RECORDS="$DB_RECORDS $TEST_TMP_DIR/$board.rec"
+    ALL_FINGERPRINTS="$ALL_FINGERPRINTS $BOARDS_DIR/$FINGERPRINT"
+    ALL_FILES="$ALL_FILES $FILES"
+done
+
+for version in 1 2; do
+    OUT_DIR=$TEST_TMP_DIR/out.v$version
+
+    ../src/rmc -D $DB_RECORDS -v $version -o $TEST_TMP_DIR/rmc.v$version.db
+
+    # every board misses files of other boards
+    if ../src/rmc -B $ALL_FILES -f $ALL_FINGERPRINTS -d $TEST_TMP_DIR/rmc.v$version.db \
+        -o $OUT_DIR 2>/dev/null; then
+        fail "version $version: missing blobs are not reported"
+    fi
+
+    for board in $BOARDS; do
+        eval FINGERPRINT=\$${board}_FINGERPRINT
+        eval FILES=\$${board}_FILES
+
+        for each in $FILES; do
+            cmp -s $BOARDS_DIR/$each $OUT_DIR/$FINGERPRINT/$each || \
+                fail "version $version: $each of $board is missing or different"
+        done
+
+        if [ $(ls $OUT_DIR/$FINGERPRINT | wc -l) -ne $(echo $FILES | wc -w) ]; then
+            fail "version $version: $board has blobs of other boards"
+        fi
+    done
+done
+
+echo "RMC batch query test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of board and name IDs
+ *
+ * Every board and blob name is resolved to its ID, IDs must be distinct and less
+ * than the number of boards or names, and the match rule of pattern records has
+ * no name ID. Every blob name is queried by board ID and by both IDs, and the
+ * result must be the same blob of the board's own records (not pattern records)
+ * a query on the database walks. A database of version 1 has no ID. At last,
+ * board and name sections and the name ID of a meta are corrupted and the
+ * database must be rejected.
+ *
+ * usage: board_id_test <db> <fingerprint file>... -- <blob name>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+#define MAX_BOARDS 16
+#define MAX_NAMES 32
+
+/* query a blob in records matching a board, skipping pattern records */
+static int query_own_records(rmc_fingerprint_t *fp, rmc_uint8_t *db, char *name, rmc_file_t *file) {
+    rmc_uint64_t record_idx = 0;
+    rmc_record_iter_t iter;
+    rmc_file_t first;
+
+    while (!query_record_from_db(fp, db, &record_idx)) {
+        init_record_iter(db, record_idx, &iter);
+
+        if (!next_policy_in_record(&iter, &first) && first.type == RMC_MATCH_FILE)
+            continue;
+
+        if (!query_policy_from_record(db, record_idx, RMC_GENERIC_FILE, name, file))
+            return 0;
+    }
+
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    rmc_db_header_t db_header;
+    rmc_board_header_t board_header;
+    rmc_names_header_t names_header;
+    rmc_name_index_t entry;
+    rmc_name_slot_t slot;
+    rmc_file_t expected;
+    rmc_file_t file;
+    rmc_uint32_t ids[MAX_BOARDS];
+    rmc_uint32_t name_ids[MAX_NAMES];
+    int has_id[MAX_NAMES];
+    rmc_uint32_t name_num = 0;
+    rmc_uint32_t meta_name_id = 0;
+    rmc_uint32_t board_id = 0;
+    rmc_uint32_t board_num = 0;
+    rmc_uint32_t api_id = 0;
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t zero = 0;
+    rmc_uint64_t first = 0;
+    char *data = NULL;
+    void *raw = NULL;
+    rmc_size_t db_len = 0;
+    int names = 0;
+    int failed = 0;
+    int found = 0;
+    int i;
+    int j;
+
+    if (argc < 4 || read_file(argv[1], &data, &db_len))
+        return 1;
+
+    memcpy(&db_header, data, sizeof(rmc_db_header_t));
+
+    for (names = 2; names < argc && strcmp(argv[names], "--"); names++)
+        ;
+
+    if (names - 2 > MAX_BOARDS || argc - names - 1 > MAX_NAMES)
+        return 1;
+
+    for (j = names + 1; j < argc; j++) {
+        has_id[j - names - 1] = !query_name_id_from_db((rmc_uint8_t *)data, argv[j], &name_ids[j - names - 1],
+            &name_num);
+
+        if (!has_id[j - names - 1])
+            continue;
+
+        if (db_header.version == RMC_DB_VERSION_1 || name_ids[j - names - 1] >= name_num ||
+            !strcmp(argv[j], RMC_MATCH_NAME)) {
+            fprintf(stderr, "%s: unexpected name ID %u of %u\n", argv[j], name_ids[j - names - 1], name_num);
+            return 1;
+        }
+
+        if (rmc_get_name_id(argv[1], argv[j], &api_id, NULL) || api_id != name_ids[j - names - 1]) {
+            fprintf(stderr, "%s: name ID from file is different\n", argv[j]);
+            failed = 1;
+        }
+
+        for (i = names + 1; i < j; i++) {
+            if (has_id[i - names - 1] && name_ids[i - names - 1] == name_ids[j - names - 1]) {
+                fprintf(stderr, "%s: name ID is same as %s\n", argv[j], argv[i]);
+                failed = 1;
+            }
+        }
+    }
+
+    for (i = 2; i < names; i++) {
+        if (read_fingerprint_from_file(argv[i], &fp, &raw))
+            return 1;
+
+        if (query_board_id_from_db(&fp, (rmc_uint8_t *)data, &board_id, &board_num)) {
+            free(raw);
+
+            if (db_header.version == RMC_DB_VERSION_1 &&
+                rmc_get_board_id(&fp, argv[1], &api_id, NULL))
+                continue;
+
+            fprintf(stderr, "%s: failed to get board ID\n", argv[i]);
+            return 1;
+        }
+
+        if (db_header.version == RMC_DB_VERSION_1 || board_id >= board_num) {
+            fprintf(stderr, "%s: unexpected board ID %u of %u\n", argv[i], board_id, board_num);
+            return 1;
+        }
+
+        if (rmc_get_board_id(&fp, argv[1], &api_id, NULL) || api_id != board_id) {
+            fprintf(stderr, "%s: board ID from file is different\n", argv[i]);
+            failed = 1;
+        }
+
+        printf("%s: board %u of %u\n", argv[i], board_id, board_num);
+
+        ids[i - 2] = board_id;
+
+        for (j = 2; j < i; j++) {
+            if (ids[j - 2] == board_id) {
+                fprintf(stderr, "%s: board ID is same as %s\n", argv[i], argv[j]);
+                failed = 1;
+            }
+        }
+
+        for (j = names + 1; j < argc; j++) {
+            found = !query_own_records(&fp, (rmc_uint8_t *)data, argv[j], &expected);
+
+            if (query_policy_by_board_id((rmc_uint8_t *)data, board_id, RMC_GENERIC_FILE, argv[j], &file) == found ||
+                (found && (file.blob != expected.blob || file.blob_len != expected.blob_len))) {
+                fprintf(stderr, "%s: %s is different by board ID\n", argv[i], argv[j]);
+                failed = 1;
+            }
+
+            if (rmc_query_file_by_board_id(argv[1], board_id, argv[j], &file) == found ||
+                (found && (file.blob_len != expected.blob_len ||
+                memcmp(file.blob, expected.blob, file.blob_len)))) {
+                fprintf(stderr, "%s: %s is different by board ID from file\n", argv[i], argv[j]);
+                failed = 1;
+            }
+
+            if (found)
+                rmc_free_file(&file);
+
+            if (!has_id[j - names - 1]) {
+                if (found) {
+                    fprintf(stderr, "%s: %s has no name ID\n", argv[i], argv[j]);
+                    failed = 1;
+                }
+
+                continue;
+            }
+
+            if (query_policy_by_ids((rmc_uint8_t *)data, board_id, name_ids[j - names - 1], &file) == found ||
+                (found && (file.blob != expected.blob || file.blob_len != expected.blob_len))) {
+                fprintf(stderr, "%s: %s is different by IDs\n", argv[i], argv[j]);
+                failed = 1;
+            }
+
+            if (rmc_query_file_by_ids(argv[1], board_id, name_ids[j - names - 1], &file) == found ||
+                (found && (file.blob_len != expected.blob_len ||
+                memcmp(file.blob, expected.blob, file.blob_len)))) {
+                fprintf(stderr, "%s: %s is different by IDs from file\n", argv[i], argv[j]);
+                failed = 1;
+            }
+
+            if (found)
+                rmc_free_file(&file);
+        }
+
+        free(raw);
+    }
+
+    if (db_header.version == RMC_DB_VERSION_1) {
+        free(data);
+        return failed;
+    }
+
+    if (!query_policy_by_board_id((rmc_uint8_t *)data, board_num, RMC_GENERIC_FILE, argv[names + 1], &file)) {
+        fprintf(stderr, "board ID out of range is queried\n");
+        failed = 1;
+    }
+
+    /* first entry of board 1 pointing to board 0, which has no record then */
+    query_section_from_db((rmc_uint8_t *)data, RMC_SECTION_BOARD, &section_idx, &section_len);
+    memcpy(&board_header, data + section_idx, sizeof(rmc_board_header_t));
+    memcpy(&first, data + section_idx + board_header.first_idx + sizeof(rmc_uint64_t), sizeof(rmc_uint64_t));
+    memcpy(data + section_idx + board_header.first_idx + sizeof(rmc_uint64_t), &zero, sizeof(rmc_uint64_t));
+
+    if (!validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "corrupted board section is not detected\n");
+        failed = 1;
+    }
+
+    memcpy(data + section_idx + board_header.first_idx + sizeof(rmc_uint64_t), &first, sizeof(rmc_uint64_t));
+
+    if (validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "restored database is rejected\n");
+        failed = 1;
+    }
+
+    /* the first blob of the first record refers to another name */
+    query_section_from_db((rmc_uint8_t *)data, RMC_SECTION_NAMES, &section_idx, &section_len);
+    memcpy(&names_header, data + section_idx, sizeof(rmc_names_header_t));
+    memcpy(&entry, data + section_idx + names_header.record_idx, sizeof(rmc_name_index_t));
+    memcpy(&slot, data + section_idx + entry.table_idx, sizeof(rmc_name_slot_t));
+    slot.name_id = (slot.name_id + 1) % name_num;
+    memcpy(data + section_idx + entry.table_idx, &slot, sizeof(rmc_name_slot_t));
+
+    if (name_num < 2 || !validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "corrupted name section is not detected\n");
+        failed = 1;
+    }
+
+    slot.name_id = (slot.name_id + name_num - 1) % name_num;
+    memcpy(data + section_idx + entry.table_idx, &slot, sizeof(rmc_name_slot_t));
+
+    /* the first blob of the first record stores another name ID in its meta */
+    memcpy(&meta_name_id, data + slot.meta_idx + sizeof(rmc_meta_header_t), sizeof(rmc_uint32_t));
+    meta_name_id = (meta_name_id + 1) % name_num;
+    memcpy(data + slot.meta_idx + sizeof(rmc_meta_header_t), &meta_name_id, sizeof(rmc_uint32_t));
+
+    if (name_num < 2 || !validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "corrupted name ID of meta is not detected\n");
+        failed = 1;
+    }
+
+    free(data);
+
+    return failed;
+}
@@ -0,0 +1,57 @@
+#!/bin/sh
+# This script tests C++ interfaces in rmc.hpp with sample
+# boards in databases of version 1 and 2. The version 2
+# database also has a pattern record for NUC6, which has a
+# blob overridden by the board's own record.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+NUC6_FILES="$BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 $BOARDS_DIR/NUC6.file.3"
+NUC4_FILES="$BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2"
+T100_FILES="$BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC C++ interface test: FAIL"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $NUC6_FILES -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $NUC4_FILES -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $T100_FILES -o $TEST_TMP_DIR/T100.rec 1>/dev/null
+
+# family of NUC6 by product name of baseboard (finger 1)
+mkdir $TEST_TMP_DIR/family
+cp $BOARDS_DIR/NUC4.file.1 $TEST_TMP_DIR/family/NUC6.file.1
+cp $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/family/family.conf
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -m 1 -b $TEST_TMP_DIR/family/NUC6.file.1 \
+    $TEST_TMP_DIR/family/family.conf -o $TEST_TMP_DIR/family.rec 1>/dev/null
+
+../src/rmc -D $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/T100.rec \
+    -o $TEST_TMP_DIR/rmc.v1.db
+../src/rmc -D $TEST_TMP_DIR/family.rec $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec \
+    $TEST_TMP_DIR/T100.rec -v 2 -o $TEST_TMP_DIR/rmc.v2.db
+
+c++ -std=c++17 -Wall -Wextra -pedantic -I../inc cxx_test.cpp ../src/lib/librmc.a -pthread \
+    -o $TEST_TMP_DIR/cxx_test
+
+$TEST_TMP_DIR/cxx_test $TEST_TMP_DIR/rmc.v1.db $BOARDS_DIR/NUC6i5SYB_H.fp $NUC6_FILES \
+    -- $BOARDS_DIR/NUC4.D54250WYK.fp $NUC4_FILES -- $BOARDS_DIR/T100TA-32bit.fp $T100_FILES || fail
+
+$TEST_TMP_DIR/cxx_test $TEST_TMP_DIR/rmc.v2.db $BOARDS_DIR/NUC6i5SYB_H.fp $NUC6_FILES \
+    $TEST_TMP_DIR/family/family.conf -- $BOARDS_DIR/NUC4.D54250WYK.fp $NUC4_FILES \
+    -- $BOARDS_DIR/T100TA-32bit.fp $T100_FILES || fail
+
+echo "RMC C++ interface test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
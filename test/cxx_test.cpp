@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of C++ interfaces in rmc.hpp
+ *
+ * Blobs of boards are queried one by one, in a batch and by iterating over all
+ * blobs of a board, and compared with their source files. Queries and iteration
+ * on a mapped database shall not allocate memory.
+ *
+ * usage: cxx_test <db> <fingerprint file> <blob file list> [-- <fingerprint file> <blob file list>]...
+ * A blob file list has source files of all blobs the board with the fingerprint
+ * file before it gets, blobs are named after base names of files:
+ *     cxx_test rmc.db a.fp boards/a.file.1 boards/a.file.2 -- b.fp boards/b.file.1
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <rmc.hpp>
+
+static unsigned long allocations = 0;
+
+void *operator new(std::size_t size) {
+    void *p = std::malloc(size ? size : 1);
+
+    allocations++;
+
+    if (!p)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static int failed = 0;
+
+static void check(bool ok, const std::string &what) {
+    if (!ok) {
+        std::fprintf(stderr, "%s\n", what.c_str());
+        failed = 1;
+    }
+}
+
+static bool same(const rmc::Bytes &data, const std::string &pathname) {
+    char *expected = nullptr;
+    rmc_size_t len = 0;
+    bool ret;
+
+    if (read_file(pathname.c_str(), &expected, &len))
+        return false;
+
+    ret = data.size() == len && !std::memcmp(data.data(), expected, len);
+    std::free(expected);
+
+    return ret;
+}
+
+static void test_board(const rmc::Db &db, const std::string &db_pathname, const std::string &fp_pathname,
+        const std::vector<std::string> &files) {
+    rmc::Fingerprint fp = rmc::Fingerprint::from_file(fp_pathname);
+    std::vector<std::string> names;
+    std::vector<rmc::BlobView> listed;
+    unsigned long n;
+
+    for (const std::string &file : files)
+        names.push_back(file.substr(file.rfind('/') + 1));
+
+    /* single queries, on mapped database and by copy */
+    for (std::size_t i = 0; i < names.size(); i++) {
+        auto blob = db.query(fp, names[i]);
+
+        check(blob && blob->name == names[i] && same(blob->data, files[i]),
+            fp_pathname + ": " + names[i] + " is missing or different");
+
+        auto copy = rmc::query_file(fp, db_pathname, names[i]);
+        check(copy && same(copy->data(), files[i]), fp_pathname + ": copy of " + names[i] + " is wrong");
+
+        rmc::Blob moved(std::move(*copy));
+        check(same(moved.data(), files[i]), fp_pathname + ": moved copy of " + names[i] + " is wrong");
+    }
+
+    check(!db.query(fp, "rmc.no.such.blob"), fp_pathname + ": a missing blob is found");
+
+    /* batch query within inline storage */
+    n = allocations;
+    auto results = db.query_all<4>(fp, {names[0].c_str(), "rmc.no.such.blob"});
+    n = allocations - n;
+    check(!n, fp_pathname + ": batch query allocates memory");
+    check(results.size() == 2 && results[0] && results[0]->name == names[0] && !results[1],
+        fp_pathname + ": wrong results of batch query");
+
+    /* batch query beyond inline storage */
+    auto many = db.query_all<1>(fp, names);
+    check(many.size() == names.size(), fp_pathname + ": wrong number of results");
+
+    for (std::size_t i = 0; i < many.size(); i++)
+        check(many[i] && many[i]->data.data() == db.query(fp, names[i])->data.data(),
+            fp_pathname + ": wrong result of " + names[i] + " in batch query");
+
+    /* every blob of board once, the same as a query returns */
+    listed.reserve(names.size() + 1);
+    n = allocations;
+
+    for (const rmc::BlobView &blob : db.blobs(fp))
+        listed.push_back(blob);
+
+    n = allocations - n;
+    check(!n, fp_pathname + ": iteration allocates memory");
+    check(listed.size() == names.size(), fp_pathname + ": wrong number of blobs in iteration");
+
+    for (const rmc::BlobView &blob : listed) {
+        auto queried = db.query(fp, std::string(blob.name));
+
+        check(queried && queried->data.data() == blob.data.data(),
+            fp_pathname + ": " + std::string(blob.name) + " in iteration is not the queried one");
+    }
+}
+
+int main(int argc, char **argv) {
+    int i;
+
+    if (argc < 4) {
+        std::fprintf(stderr, "usage: %s <db> <fingerprint file> <blob file list>...\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        rmc::Db opened(argv[1]);
+        rmc::Db db(std::move(opened));
+
+        for (i = 2; i < argc; i++) {
+            std::string fp_pathname = argv[i];
+            std::vector<std::string> files;
+
+            for (i++; i < argc && std::strcmp(argv[i], "--"); i++)
+                files.push_back(argv[i]);
+
+            test_board(db, argv[1], fp_pathname, files);
+        }
+    } catch (const rmc::Error &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    /* invalid database */
+    try {
+        rmc::Db db(argv[2]);
+        check(false, "a fingerprint file is opened as a database");
+    } catch (const rmc::Error &) {
+    }
+
+    return failed;
+}
@@ -0,0 +1,107 @@
+#!/bin/sh
+# This script runs EFI library on host with a fabricated EFI
+# system table, SMBIOS of sample boards and databases of
+# version 1 and 2, checks queries and rejection of truncated
+# and corrupted databases, and reports latency of EFI APIs and
+# code size of librmcefi.a. It runs for 64-bit and, when the
+# compiler supports it, 32-bit x86.
+
+# To run more iterations in benchmark:
+# $ RMC_TEST_ITERATIONS=100000 ./efi.build.sh
+
+# To fail when code size (text) of librmcefi.a grows beyond a limit:
+# $ RMC_TEST_EFI_TEXT_MAX=40000 ./efi.build.sh
+
+# To build EFI library and harness with other flags than -O2, e.g. to catch reads
+# out of damaged databases:
+# $ RMC_TEST_EFI_CFLAGS="-O1 -fsanitize=address" ./efi.build.sh
+
+set -e
+
+if [ -z ${RMC_TEST_ITERATIONS+x} ]; then
+    RMC_TEST_ITERATIONS=20000
+fi
+
+if [ -z ${RMC_TEST_EFI_CFLAGS+x} ]; then
+    RMC_TEST_EFI_CFLAGS="-O2"
+fi
+
+BOARDS_DIR="./boards"
+
+NUC6_FILES="$BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 $BOARDS_DIR/NUC6.file.3"
+NUC4_FILES="$BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2"
+T100_FILES="$BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# basic C functions of EFI library are renamed so that glibc ones are still there
+RMC_UTIL_RENAME="--redefine-sym memset=rmc_efi_memset --redefine-sym memcpy=rmc_efi_memcpy \
+    --redefine-sym strncmp=rmc_efi_strncmp --redefine-sym strlen=rmc_efi_strlen \
+    --redefine-sym strncpy=rmc_efi_strncpy --redefine-sym strcpy=rmc_efi_strcpy"
+
+# compile rmc tool to generate databases first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC EFI harness test: FAIL"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    make -C ../ -f Makefile.efi clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $NUC6_FILES -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $NUC4_FILES -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $T100_FILES -o $TEST_TMP_DIR/T100.rec 1>/dev/null
+
+../src/rmc -D $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/T100.rec \
+    -o $TEST_TMP_DIR/rmc.v1.db
+../src/rmc -D $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/T100.rec \
+    -v 2 -o $TEST_TMP_DIR/rmc.v2.db
+
+make -C ../ clean 1>/dev/null
+
+for arch in -m64 -m32; do
+    if ! echo "int main(void) { return 0; }" | \
+        cc $arch -x c - -o $TEST_TMP_DIR/probe 2>/dev/null; then
+        echo "Skip $arch, not supported by compiler"
+        continue
+    fi
+
+    make -C ../ -f Makefile.efi clean 1>/dev/null
+    make -C ../ -f Makefile.efi CFLAGS="$arch $RMC_TEST_EFI_CFLAGS" 1>/dev/null
+
+    cp ../src/lib/librmcefi.a $TEST_TMP_DIR/librmcefi$arch.a
+    objcopy $RMC_UTIL_RENAME $TEST_TMP_DIR/librmcefi$arch.a
+
+    cc $arch $RMC_TEST_EFI_CFLAGS -Wall -DRMC_EFI -I../inc -I../src/lib efi_harness.c $TEST_TMP_DIR/librmcefi$arch.a \
+        -o $TEST_TMP_DIR/efi_harness$arch
+
+    echo "== $arch"
+
+    TEXT=$(size -t ../src/lib/librmcefi.a | tail -1 | awk '{print $1}')
+    size -t ../src/lib/librmcefi.a | tail -1 | awk '{print "librmcefi.a: text " $1 ", data " $2 ", bss " $3}'
+
+    if [ -n "$RMC_TEST_EFI_TEXT_MAX" ] && [ "$TEXT" -gt "$RMC_TEST_EFI_TEXT_MAX" ]; then
+        echo "Code size $TEXT is over $RMC_TEST_EFI_TEXT_MAX"
+        fail
+    fi
+
+    for v in 1 2; do
+        echo "== $arch, NUC6 in database version $v"
+        $TEST_TMP_DIR/efi_harness$arch $RMC_TEST_ITERATIONS $TEST_TMP_DIR/rmc.v$v.db \
+            $BOARDS_DIR/NUC6i5SYB_H.fp $NUC6_FILES -- no.such.file || fail
+        echo "== $arch, NUC4 in database version $v"
+        $TEST_TMP_DIR/efi_harness$arch $RMC_TEST_ITERATIONS $TEST_TMP_DIR/rmc.v$v.db \
+            $BOARDS_DIR/NUC4.D54250WYK.fp $NUC4_FILES -- no.such.file || fail
+        echo "== $arch, T100 in database version $v"
+        $TEST_TMP_DIR/efi_harness$arch $RMC_TEST_ITERATIONS $TEST_TMP_DIR/rmc.v$v.db \
+            $BOARDS_DIR/T100TA-32bit.fp $T100_FILES -- no.such.file || fail
+    done
+done
+
+echo "RMC EFI harness test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ -f Makefile.efi clean 1>/dev/null
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Host-side harness of EFI library
+ *
+ * librmcefi.a is linked into a host program with its basic C functions renamed,
+ * so that EFI code runs as it does in firmware. A fabricated EFI system table
+ * has a configuration table with SMBIOS 3.0 entry point, and structures in it
+ * carry values of a fingerprint file. Fingerprint and files queried through EFI
+ * APIs are checked. Every truncation of database, every single-bit flip of a
+ * version 2 database, and a version 2 database with crafted extensions of length 0
+ * must be rejected by EFI APIs validating database, and must not make queries
+ * taking the length of database read out of it. Then latency of each EFI API is
+ * measured.
+ *
+ * usage: efi_harness <iterations> <db> <fingerprint file> <blob file>... [-- <blob name>...]
+ * Blobs are named after base names of files, and must be found for the board.
+ * Names after "--" are only measured, e.g. names not in database.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rmc_api.h>
+#include <rmc_efi.h>
+
+#define CONFIG_TABLE_NUM    8
+#define SMBIOS_MAX          4096
+#define MEMORY_DEVICE_NUM   16      /* filler structures before fingers */
+#define BLOB_MAX            (1 << 20)
+
+/* SMBIOS3_TABLE_GUID */
+static EFI_GUID smbios3_guid = { 0xf2fd1544, 0x9794, 0x4a2c, \
+                               {0x99, 0x2e, 0xe5, 0xbb, 0xcf, 0x20, 0xe3, 0x94}};
+/* ACPI_20_TABLE_GUID, ahead of SMBIOS as in firmware */
+static EFI_GUID acpi20_guid = { 0x8868e871, 0xe4f1, 0x11d3, \
+                              {0xbc, 0x22, 0x00, 0x80, 0xc7, 0x3c, 0x88, 0x81}};
+
+static rmc_uint8_t smbios[SMBIOS_MAX];
+static smbios_ep_t entry;
+static EFI_CONFIGURATION_TABLE config_table[CONFIG_TABLE_NUM];
+static EFI_SYSTEM_TABLE systab;
+static const char *finger_values[RMC_FINGER_NUM];
+
+typedef struct db_file {
+    unsigned char *data;
+    size_t len;
+} db_file_t;
+
+static unsigned char *read_all(const char *pathname, size_t *len) {
+    FILE *f = fopen(pathname, "rb");
+    unsigned char *data = NULL;
+    long size = 0;
+
+    if (!f)
+        return NULL;
+
+    if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) ||
+        !(data = malloc(size + 1)) || fread(data, 1, size, f) != (size_t)size) {
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    *len = size;
+
+    return data;
+}
+
+/* append a structure with formatted area of len bytes and one string at offset */
+static size_t add_struct(size_t pos, rmc_uint8_t type, rmc_uint8_t len, rmc_uint8_t offset,
+        const char *value) {
+    smbios_struct_hdr_t header;
+    size_t value_len = value ? strlen(value) : 0;
+
+    if (pos + len + value_len + 2 > SMBIOS_MAX) {
+        fprintf(stderr, "SMBIOS is too big\n");
+        exit(1);
+    }
+
+    header.type = type;
+    header.len = len;
+    header.handle = (rmc_uint16_t)pos;
+    memset(smbios + pos, 0, len + value_len + 2);
+    memcpy(smbios + pos, &header, sizeof(header));
+
+    if (value_len) {
+        smbios[pos + offset] = 1;
+        memcpy(smbios + pos + len, value, value_len);
+        return pos + len + value_len + 2;
+    }
+
+    return pos + len + 2;
+}
+
+/* fabricate system table with SMBIOS of fingers in a fingerprint file, which is
+ * type, offset, name and value of each finger
+ */
+static int build_systab(const char *fp_pathname) {
+    unsigned char *file = NULL;
+    size_t len = 0;
+    size_t idx = 0;
+    size_t pos = 0;
+    rmc_uint8_t type;
+    rmc_uint8_t offset;
+    const char *value;
+    int i;
+
+    if (!(file = read_all(fp_pathname, &len)))
+        return 1;
+
+    file[len] = '\0';
+
+    pos = add_struct(pos, 0, 0x18, 4, "EFI harness BIOS");
+
+    for (i = 0; i < MEMORY_DEVICE_NUM; i++)
+        pos = add_struct(pos, 17, 0x28, 0x10, "DIMM");
+
+    for (i = 0; i < RMC_FINGER_NUM && idx + 2 < len; i++) {
+        type = file[idx++];
+        offset = file[idx++];
+        idx += strlen((char *)file + idx) + 1;
+        value = (char *)file + idx;
+        idx += strlen(value) + 1;
+        finger_values[i] = strdup(value);
+
+        /* reserved fingers are not in SMBIOS */
+        if (type == END_OF_TABLE_TYPE)
+            continue;
+
+        pos = add_struct(pos, type, offset + 0x10, offset, value);
+    }
+
+    pos = add_struct(pos, END_OF_TABLE_TYPE, 4, 0, NULL);
+    free(file);
+
+    if (i != RMC_FINGER_NUM)
+        return 1;
+
+    memcpy(entry.ep_64.ep_anchor, "_SM3_", 5);
+    entry.ep_64.ep_len = 0x18;
+    entry.ep_64.major_ver = 3;
+    entry.ep_64.max_struct_size = pos;
+    entry.ep_64.struct_tbl_addr = (rmc_uint64_t)(rmc_uintn_t)smbios;
+
+    for (i = 0; i < CONFIG_TABLE_NUM - 1; i++) {
+        config_table[i].VendorGuid = acpi20_guid;
+        config_table[i].VendorGuid.d1 += i;
+    }
+
+    config_table[i].VendorGuid = smbios3_guid;
+    config_table[i].VendorTable = &entry;
+
+    systab.NumberOfTableEntries = CONFIG_TABLE_NUM;
+    systab.ConfigurationTable = config_table;
+
+    return 0;
+}
+
+static int read_at(void *ctx, rmc_uint64_t offset, rmc_size_t len, void *buf) {
+    db_file_t *db = ctx;
+
+    if (offset > db->len || len > db->len - offset)
+        return 1;
+
+    memcpy(buf, db->data + offset, len);
+
+    return 0;
+}
+
+static const char *base_name(const char *pathname) {
+    const char *base = strrchr(pathname, '/');
+
+    return base ? base + 1 : pathname;
+}
+
+/*
+ * check a damaged database of len bytes is rejected by EFI APIs validating database.
+ * Queries taking len only walk records, so they may skip damage in data they don't
+ * use: a truncated database must be rejected or give the intact blob, and a flipped
+ * bit must not make them read out of len.
+ * return: 0 when damage is handled
+ */
+static int check_damaged(rmc_fingerprint_t *fp, rmc_uint8_t *data, rmc_size_t len, const char *name,
+        unsigned char *expected, size_t expected_len, unsigned char *buf, int truncated,
+        const char *damage) {
+    rmc_db_handle_t handle;
+    rmc_file_t file;
+    db_file_t db;
+    rmc_size_t blob_len = 0;
+    int failed = 0;
+
+    db.data = data;
+    db.len = len;
+
+    if (!rmc_check_db(data, len) || !rmc_open_db(data, len, &handle)) {
+        fprintf(stderr, "%s is not rejected\n", damage);
+        failed = 1;
+    }
+
+    if (!rmc_query_file_by_buffer(fp, data, len, (char *)name, &file) && truncated &&
+        (file.blob_len != expected_len || memcmp(file.blob, expected, expected_len))) {
+        fprintf(stderr, "rmc_query_file_by_buffer(): %s gives wrong data\n", damage);
+        failed = 1;
+    }
+
+    if (!rmc_query_file_by_read_at(fp, read_at, &db, (char *)name, buf, BLOB_MAX, &blob_len) &&
+        truncated && (blob_len != expected_len || memcmp(buf, expected, expected_len))) {
+        fprintf(stderr, "rmc_query_file_by_read_at(): %s gives wrong data\n", damage);
+        failed = 1;
+    }
+
+    return failed;
+}
+
+/*
+ * craft extensions of a version 2 database with length 0 and empty sections at
+ * their start. The last section header is out of data, so a count of sections not
+ * bounded by the length of extensions makes validation read out of database.
+ * return: 0 when the crafted database is rejected
+ */
+static int check_crafted_ext(rmc_fingerprint_t *fp, db_file_t *db, const char *name, unsigned char *expected,
+        size_t expected_len, unsigned char *buf) {
+    rmc_db_header_t db_header;
+    rmc_ext_header_t ext_header;
+    rmc_section_header_t section_header;
+    rmc_uint8_t *data = NULL;
+    rmc_size_t len = 0;
+    rmc_uint32_t i;
+    int failed = 0;
+
+    memcpy(&db_header, db->data, sizeof(rmc_db_header_t));
+    memcpy(&ext_header, db->data + db_header.length, sizeof(rmc_ext_header_t));
+
+    len = db_header.length + sizeof(rmc_ext_header_t) + ext_header.section_num * sizeof(rmc_section_header_t);
+
+    if (!(data = malloc(len)))
+        return 1;
+
+    memcpy(data, db->data, db_header.length);
+
+    ext_header.length = 0;
+    ext_header.section_num++;
+    memcpy(data + db_header.length, &ext_header, sizeof(rmc_ext_header_t));
+
+    memset(&section_header, 0, sizeof(rmc_section_header_t));
+    section_header.offset = db_header.length;
+
+    for (i = 0; i < ext_header.section_num - 1; i++)
+        memcpy(data + db_header.length + sizeof(rmc_ext_header_t) + i * sizeof(rmc_section_header_t),
+            &section_header, sizeof(rmc_section_header_t));
+
+    failed = check_damaged(fp, data, len, name, expected, expected_len, buf, 0,
+        "extensions of length 0");
+
+    free(data);
+
+    return failed;
+}
+
+/* truncate database at every length, and flip a bit of each byte and craft extensions
+ * of a version 2 one
+ */
+static int check_damages(rmc_fingerprint_t *fp, db_file_t *db, const char *pathname, unsigned char *buf) {
+    rmc_db_header_t db_header;
+    unsigned char *expected = NULL;
+    size_t expected_len = 0;
+    char damage[64];
+    size_t i;
+    int failed = 0;
+
+    if (!(expected = read_all(pathname, &expected_len)))
+        return 1;
+
+    memcpy(&db_header, db->data, sizeof(rmc_db_header_t));
+
+    for (i = 0; i < db->len && !failed; i++) {
+        snprintf(damage, sizeof(damage), "database truncated to %zu bytes", i);
+        failed |= check_damaged(fp, db->data, i, base_name(pathname), expected, expected_len, buf, 1,
+            damage);
+    }
+
+    /* version 1 has no CRC, a flipped bit in data can't be told */
+    for (i = 0; db_header.version >= RMC_DB_VERSION_2 && i < db->len && !failed; i++) {
+        db->data[i] ^= 1 << (i % 8);
+        snprintf(damage, sizeof(damage), "bit %zu of byte %zu flipped", i % 8, i);
+        failed |= check_damaged(fp, db->data, db->len, base_name(pathname), expected, expected_len, buf, 0,
+            damage);
+        db->data[i] ^= 1 << (i % 8);
+    }
+
+    if (db_header.version >= RMC_DB_VERSION_2 && !failed)
+        failed = check_crafted_ext(fp, db, base_name(pathname), expected, expected_len, buf);
+
+    free(expected);
+
+    return failed;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    rmc_query_ctx_t ctx;
+    rmc_db_handle_t handle;
+    rmc_file_t file;
+    db_file_t db;
+    unsigned char *data = NULL;
+    unsigned char *buf = NULL;
+    rmc_size_t len = 0;
+    size_t data_len = 0;
+    long iterations = 0;
+    long n = 0;
+    double start = 0;
+    int names = 0;
+    int name_num = 0;
+    int failed = 0;
+    int i;
+
+    if (argc < 5 || (iterations = atol(argv[1])) <= 0)
+        return 1;
+
+    if (!(db.data = read_all(argv[2], &db.len)) || !(buf = malloc(BLOB_MAX)))
+        return 1;
+
+    if (build_systab(argv[3])) {
+        fprintf(stderr, "Failed to build system table with %s\n", argv[3]);
+        return 1;
+    }
+
+    for (names = 4; names < argc && strcmp(argv[names], "--"); names++)
+        ;
+
+    name_num = argc - 4 - (names < argc);
+
+    /* check results first */
+    if (rmc_get_fingerprint(&systab, &fp) || rmc_open_db(db.data, db.len, &handle)) {
+        fprintf(stderr, "Failed to get fingerprint or open database\n");
+        return 1;
+    }
+
+    for (i = 0; i < RMC_FINGER_NUM; i++) {
+        if (strcmp(fp.rmc_fingers[i].value, finger_values[i] ? finger_values[i] : "")) {
+            fprintf(stderr, "rmc_get_fingerprint(): finger %d is different\n", i);
+            failed = 1;
+        }
+    }
+
+    if (rmc_init_query_ctx(&systab, db.data, &ctx))
+        return 1;
+
+    for (i = 4; i < names; i++) {
+        if (!(data = read_all(argv[i], &data_len)))
+            return 1;
+
+        if (rmc_gimme_file(&systab, db.data, (char *)base_name(argv[i]), &file) ||
+            file.blob_len != data_len || memcmp(file.blob, data, data_len)) {
+            fprintf(stderr, "rmc_gimme_file(): %s is not found or different\n", base_name(argv[i]));
+            failed = 1;
+        }
+
+        if (rmc_query_file_by_ctx(&ctx, (char *)base_name(argv[i]), &file) ||
+            file.blob_len != data_len || memcmp(file.blob, data, data_len)) {
+            fprintf(stderr, "rmc_query_file_by_ctx(): %s is not found or different\n", base_name(argv[i]));
+            failed = 1;
+        }
+
+        if (rmc_gimme_file_by_read_at(&systab, read_at, &db, (char *)base_name(argv[i]), buf, BLOB_MAX, &len) ||
+            len != data_len || memcmp(buf, data, data_len)) {
+            fprintf(stderr, "rmc_gimme_file_by_read_at(): %s is not found or different\n", base_name(argv[i]));
+            failed = 1;
+        }
+
+        free(data);
+    }
+
+    if (failed || check_damages(&fp, &db, argv[4], buf))
+        return 1;
+
+    /* latency of each API, averaged over all names */
+    printf("%-32s %10s\n", "EFI API", "ns/call");
+
+    start = now_ns();
+    for (n = 0; n < iterations; n++)
+        rmc_get_fingerprint(&systab, &fp);
+    printf("%-32s %10.1f\n", "rmc_get_fingerprint", (now_ns() - start) / iterations);
+
+    start = now_ns();
+    for (n = 0; n < iterations; n++)
+        rmc_init_query_ctx(&systab, db.data, &ctx);
+    printf("%-32s %10.1f\n", "rmc_init_query_ctx", (now_ns() - start) / iterations);
+
+#define MEASURE(api, call) \
+    do { \
+        start = now_ns(); \
+        for (n = 0; n < iterations; n++) { \
+            for (i = 4; i < argc; i++) { \
+                if (i != names) \
+                    call; \
+            } \
+        } \
+        printf("%-32s %10.1f\n", api, (now_ns() - start) / iterations / name_num); \
+    } while (0)
+
+    MEASURE("rmc_gimme_file", rmc_gimme_file(&systab, db.data, (char *)base_name(argv[i]), &file));
+    MEASURE("rmc_query_file_by_fp", rmc_query_file_by_fp(&fp, db.data, (char *)base_name(argv[i]), &file));
+    MEASURE("rmc_query_file_by_buffer", rmc_query_file_by_buffer(&fp, db.data, db.len,
+        (char *)base_name(argv[i]), &file));
+    MEASURE("rmc_query_file_by_handle", rmc_query_file_by_handle(&fp, &handle, (char *)base_name(argv[i]), &file));
+    MEASURE("rmc_query_file_by_ctx", rmc_query_file_by_ctx(&ctx, (char *)base_name(argv[i]), &file));
+    MEASURE("rmc_gimme_file_by_read_at", rmc_gimme_file_by_read_at(&systab, read_at, &db,
+        (char *)base_name(argv[i]), buf, BLOB_MAX, &len));
+    MEASURE("rmc_query_file_by_read_at", rmc_query_file_by_read_at(&fp, read_at, &db,
+        (char *)base_name(argv[i]), buf, BLOB_MAX, &len));
+
+    free(buf);
+    free(db.data);
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+#!/bin/sh
+# This script tests glob and prefix queries with sample boards in
+# databases of version 1 and 2. A second record of NUC6 has a blob
+# with a name of the first record and two blobs with the same name.
+
+set -e
+# patterns are passed to test program as they are
+set -f
+
+BOARDS_DIR="./boards"
+
+NUC6_FILES="$BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 $BOARDS_DIR/NUC6.file.3"
+NUC4_FILES="$BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2 $BOARDS_DIR/NUC6.file.1"
+T100_FILES="$BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2"
+PATTERNS="* NUC6.file.* NUC6.file.? *.2 NUC?.file.1 NUC6.file.2 N NUC6.file.1x \
+    m*.conf *.conf T100* *32* rmc.match no.such.*"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC glob query test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $NUC6_FILES -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $NUC4_FILES -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $T100_FILES -o $TEST_TMP_DIR/T100.rec 1>/dev/null
+
+# a second record of NUC6, NUC6.file.2 of the first record hides its own one
+mkdir $TEST_TMP_DIR/more $TEST_TMP_DIR/dup
+cp $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/more/NUC6.file.2
+cp $BOARDS_DIR/NUC4.file.1 $TEST_TMP_DIR/dup/more.conf
+echo "more" > $TEST_TMP_DIR/more/more.conf
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $TEST_TMP_DIR/more/NUC6.file.2 \
+    $TEST_TMP_DIR/more/more.conf $TEST_TMP_DIR/dup/more.conf -o $TEST_TMP_DIR/more.rec 1>/dev/null
+
+RECORDS="$TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/more.rec $TEST_TMP_DIR/T100.rec"
+
+../src/rmc -D $RECORDS -o $TEST_TMP_DIR/rmc.v1.db
+../src/rmc -D $RECORDS -v 2 -o $TEST_TMP_DIR/rmc.v2.db
+
+cc -Wall -Wextra -I../inc glob_test.c ../src/lib/librmc.a -o $TEST_TMP_DIR/glob_test
+
+for fp in NUC6i5SYB_H NUC4.D54250WYK T100TA-32bit; do
+    $TEST_TMP_DIR/glob_test $TEST_TMP_DIR/rmc.v1.db $TEST_TMP_DIR/rmc.v2.db \
+        $BOARDS_DIR/$fp.fp $PATTERNS 1>/dev/null || fail "$fp: wrong files"
+done
+
+echo "RMC glob query test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
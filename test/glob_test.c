@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of glob and prefix queries
+ *
+ * Blobs matching every pattern are found by walking all metas of records of a
+ * board in a version 1 database with fnmatch(3), where a name in an earlier record
+ * hides the same name in later records. rmc_query_files_by_fp() must return the
+ * same blobs for databases of version 1 and 2, while a version 2 database is
+ * served by ranges of name IDs.
+ *
+ * usage: glob_test <v1 db> <v2 db> <fingerprint file> <pattern>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fnmatch.h>
+
+#include <rmc_api.h>
+
+#define MAX_MATCHES 64
+
+/* find blobs of a board matching a pattern, return: number of blobs */
+static int find_matches(rmc_fingerprint_t *fp, rmc_uint8_t *db, char *pattern, rmc_file_t *matches) {
+    rmc_uint64_t record_idx = 0;
+    rmc_record_iter_t iter;
+    rmc_file_t policy;
+    int num = 0;
+    int i;
+
+    while (!query_record_from_db(fp, db, &record_idx)) {
+        init_record_iter(db, record_idx, &iter);
+
+        while (!next_policy_in_record(&iter, &policy)) {
+            if (policy.type != RMC_GENERIC_FILE || fnmatch(pattern, policy.blob_name, 0))
+                continue;
+
+            for (i = 0; i < num && strcmp(matches[i].blob_name, policy.blob_name); i++)
+                ;
+
+            if (i == num && num < MAX_MATCHES)
+                matches[num++] = policy;
+        }
+    }
+
+    return num;
+}
+
+/* check files of a query are the expected blobs, return: 0 when they are */
+static int check_files(char *db_pathname, char *pattern, rmc_file_t *files, rmc_file_t *matches, int num) {
+    rmc_file_t *file = NULL;
+    int n = 0;
+    int i;
+
+    for (file = files; file; file = file->next, n++) {
+        for (i = 0; i < num && strcmp(matches[i].blob_name, file->blob_name); i++)
+            ;
+
+        if (i == num || file->blob_len != matches[i].blob_len ||
+            memcmp(file->blob, matches[i].blob, file->blob_len)) {
+            fprintf(stderr, "%s: %s of %s is not expected\n", db_pathname, file->blob_name, pattern);
+            return 1;
+        }
+    }
+
+    if (n != num) {
+        fprintf(stderr, "%s: %d files of %s, expected %d\n", db_pathname, n, pattern, num);
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    rmc_file_t matches[MAX_MATCHES];
+    rmc_file_t *files = NULL;
+    char *data = NULL;
+    void *raw = NULL;
+    rmc_size_t db_len = 0;
+    int failed = 0;
+    int num = 0;
+    int i, j;
+
+    if (argc < 5 || read_file(argv[1], &data, &db_len) ||
+        read_fingerprint_from_file(argv[3], &fp, &raw))
+        return 1;
+
+    for (i = 4; i < argc; i++) {
+        num = find_matches(&fp, (rmc_uint8_t *)data, argv[i], matches);
+
+        for (j = 1; j <= 2; j++) {
+            files = NULL;
+
+            if (rmc_query_files_by_fp(&fp, argv[j], argv[i], &files) && num) {
+                fprintf(stderr, "%s: no file of %s\n", argv[j], argv[i]);
+                failed = 1;
+                continue;
+            }
+
+            failed |= check_files(argv[j], argv[i], files, matches, num);
+            rmc_free_file_list(files);
+        }
+
+        printf("%s: %d files\n", argv[i], num);
+    }
+
+    free(raw);
+    free(data);
+
+    return failed;
+}
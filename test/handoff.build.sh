@@ -0,0 +1,30 @@
+#!/bin/sh
+# This script tests fingerprint handoff from bootloader to
+# user space with fingerprints of sample boards.
+
+set -e
+
+BOARDS_DIR="./boards"
+BOARDS="$BOARDS_DIR/NUC6i5SYB_H.fp $BOARDS_DIR/NUC4.D54250WYK.fp $BOARDS_DIR/T100TA-32bit.fp"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC fingerprint handoff test: FAIL"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+cc -Wall -Wextra -I../inc handoff_test.c ../src/lib/librmc.a -o $TEST_TMP_DIR/handoff_test
+
+$TEST_TMP_DIR/handoff_test $TEST_TMP_DIR/RmcHandoff $BOARDS || fail
+
+echo "RMC fingerprint handoff test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of fingerprint handoff from bootloader
+ *
+ * A handoff is filled with a fingerprint as EFI library does, and written as
+ * an EFI variable in efivarfs format (attributes and data). Fingerprint read
+ * from it must be the same. Variables changed in any way that breaks handoff
+ * must be rejected.
+ *
+ * usage: handoff_test <variable file> <fingerprint file>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+#define ATTR_BS_RT      0x6     /* boot service and runtime access */
+#define ATTR_NV_BS_RT   0x7     /* non-volatile as well */
+
+static int write_var(const char *pathname, rmc_uint32_t attributes, rmc_handoff_t *handoff,
+        rmc_size_t len) {
+    FILE *f = fopen(pathname, "wb");
+    int ret = 0;
+
+    if (!f)
+        return 1;
+
+    if (fwrite(&attributes, sizeof(attributes), 1, f) != 1 ||
+        (len && fwrite(handoff, len, 1, f) != 1))
+        ret = 1;
+
+    if (fclose(f))
+        ret = 1;
+
+    return ret;
+}
+
+/* check a variable is rejected */
+static int rejected(const char *pathname, const char *what) {
+    rmc_fingerprint_t fp;
+
+    if (read_fingerprint_from_handoff(pathname, &fp))
+        return 1;
+
+    fprintf(stderr, "handoff %s is not rejected\n", what);
+    rmc_free_fingerprint(&fp);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    rmc_fingerprint_t out;
+    rmc_handoff_t handoff;
+    rmc_handoff_t bad;
+    void *raw = NULL;
+    int failed = 0;
+    int i;
+    int j;
+
+    for (i = 2; i < argc; i++) {
+        if (read_fingerprint_from_file(argv[i], &fp, &raw))
+            return 1;
+
+        if (rmcl_fill_handoff(&fp, &handoff) || write_var(argv[1], ATTR_BS_RT, &handoff, sizeof(handoff)))
+            return 1;
+
+        if (read_fingerprint_from_handoff(argv[1], &out)) {
+            fprintf(stderr, "%s: handoff is rejected\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+
+        for (j = 0; j < RMC_FINGER_NUM; j++) {
+            if (strcmp(fp.rmc_fingers[j].value, out.rmc_fingers[j].value) ||
+                strcmp(fp.rmc_fingers[j].name, out.rmc_fingers[j].name) ||
+                fp.rmc_fingers[j].type != out.rmc_fingers[j].type ||
+                fp.rmc_fingers[j].offset != out.rmc_fingers[j].offset) {
+                fprintf(stderr, "%s: finger %d is different\n", argv[i], j);
+                failed = 1;
+            }
+        }
+
+        rmc_free_fingerprint(&out);
+
+        write_var(argv[1], ATTR_NV_BS_RT, &handoff, sizeof(handoff));
+        failed |= !rejected(argv[1], "in non-volatile variable");
+
+        write_var(argv[1], 0x2, &handoff, sizeof(handoff));
+        failed |= !rejected(argv[1], "without runtime access");
+
+        write_var(argv[1], ATTR_BS_RT, &handoff, sizeof(handoff) - 1);
+        failed |= !rejected(argv[1], "truncated");
+
+        bad = handoff;
+        bad.version++;
+        write_var(argv[1], ATTR_BS_RT, &bad, sizeof(bad));
+        failed |= !rejected(argv[1], "of another version");
+
+        bad = handoff;
+        bad.values[2][0] ^= 1;
+        write_var(argv[1], ATTR_BS_RT, &bad, sizeof(bad));
+        failed |= !rejected(argv[1], "with a bad CRC");
+
+        /* consistent CRC but values are not for signature */
+        bad = handoff;
+        bad.values[0][0] ^= 1;
+        bad.crc = 0;
+        bad.crc = rmc_crc32(0, &bad, sizeof(bad));
+        write_var(argv[1], ATTR_BS_RT, &bad, sizeof(bad));
+        failed |= !rejected(argv[1], "with values of another signature");
+
+        free(raw);
+    }
+
+    remove(argv[1]);
+    failed |= !rejected(argv[1], "not existing");
+
+    return failed;
+}
@@ -0,0 +1,77 @@
+#!/bin/sh
+# This script tests inverse queries (which records have a blob name)
+# with sample boards in databases of version 1 and 2. The version 2
+# database also has a pattern record for NUC6. A second record of NUC6
+# has two blobs with the same name.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+NUC6_FILES="$BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 $BOARDS_DIR/NUC6.file.3"
+NUC4_FILES="$BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2 $BOARDS_DIR/NUC6.file.1"
+T100_FILES="$BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2"
+NAMES="NUC6.file.1 NUC6.file.2 NUC6.file.3 NUC4.file.1 NUC4.file.2 T100.32.file.1 \
+    T100.32.file.2 family.conf more.conf rmc.match no.such.file"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC inverse query test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $NUC6_FILES -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $NUC4_FILES -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $T100_FILES -o $TEST_TMP_DIR/T100.rec 1>/dev/null
+
+# family of NUC6 by product name of baseboard (finger 1)
+mkdir $TEST_TMP_DIR/family
+cp $BOARDS_DIR/NUC4.file.1 $TEST_TMP_DIR/family/NUC6.file.1
+cp $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/family/family.conf
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -m 1 -b $TEST_TMP_DIR/family/NUC6.file.1 \
+    $TEST_TMP_DIR/family/family.conf -o $TEST_TMP_DIR/family.rec 1>/dev/null
+
+# a second record of NUC6, queries return the first of two NUC6.file.2
+mkdir $TEST_TMP_DIR/more $TEST_TMP_DIR/dup
+cp $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/more/NUC6.file.2
+cp $BOARDS_DIR/NUC4.file.1 $TEST_TMP_DIR/dup/NUC6.file.2
+echo "more" > $TEST_TMP_DIR/more/more.conf
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $TEST_TMP_DIR/more/NUC6.file.2 \
+    $TEST_TMP_DIR/more/more.conf $TEST_TMP_DIR/dup/NUC6.file.2 -o $TEST_TMP_DIR/more.rec 1>/dev/null
+
+RECORDS="$TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/more.rec $TEST_TMP_DIR/T100.rec"
+
+../src/rmc -D $RECORDS -o $TEST_TMP_DIR/rmc.v1.db
+../src/rmc -D $RECORDS -v 2 -o $TEST_TMP_DIR/rmc.v2.db
+../src/rmc -D $TEST_TMP_DIR/family.rec $RECORDS -v 2 -o $TEST_TMP_DIR/family.v2.db
+
+cc -Wall -Wextra -I../inc inverse_test.c ../src/lib/librmc.a -o $TEST_TMP_DIR/inverse_test
+
+for db in rmc.v1 rmc.v2 family.v2; do
+    $TEST_TMP_DIR/inverse_test $TEST_TMP_DIR/$db.db $NAMES 1>/dev/null || fail "$db: wrong records"
+done
+
+# rmc tool lists the same records of version 1 and 2 databases with the same records
+# records of version 2 are shorter with name IDs, so offsets are not compared
+for name in $NAMES; do
+    ../src/rmc -W $name -d $TEST_TMP_DIR/rmc.v1.db | tail -n +2 | sed 's/0x[0-9a-f]*//' > $TEST_TMP_DIR/$name.v1.txt
+    ../src/rmc -W $name -d $TEST_TMP_DIR/rmc.v2.db | tail -n +2 | sed 's/0x[0-9a-f]*//' > $TEST_TMP_DIR/$name.v2.txt
+    cmp -s $TEST_TMP_DIR/$name.v1.txt $TEST_TMP_DIR/$name.v2.txt || fail "$name: different lists"
+done
+
+grep -q "2 records have NUC6.file.1" $TEST_TMP_DIR/NUC6.file.1.v1.txt || fail "wrong count of NUC6.file.1"
+../src/rmc -W NUC6.file.1 -d $TEST_TMP_DIR/family.v2.db | grep -q "(pattern)" || \
+    fail "pattern record is not listed"
+
+echo "RMC inverse query test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
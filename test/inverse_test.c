@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of inverse queries
+ *
+ * For every blob name, records having it are found by querying every record of
+ * database, and the iterator of records with the name and rmc_query_carriers()
+ * must return the same records and blobs in the same order. A version 2 database
+ * must have posting lists, and at last they are corrupted and the database must
+ * be rejected.
+ *
+ * usage: inverse_test <db> <blob name>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+/* return: non-zero when record is a pattern record */
+static int is_pattern_record(rmc_uint8_t *db, rmc_uint64_t record_idx) {
+    rmc_record_iter_t iter;
+    rmc_file_t first;
+
+    init_record_iter(db, record_idx, &iter);
+
+    return !next_policy_in_record(&iter, &first) && first.type == RMC_MATCH_FILE;
+}
+
+/* check records with a name, return: 0 when all results are expected */
+static int check_name(char *db_pathname, rmc_uint8_t *db, char *name) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_carrier_report_t report;
+    rmc_name_iter_t iter;
+    rmc_file_t expected;
+    rmc_file_t file;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t found_idx = 0;
+    rmc_uint64_t n = 0;
+    int failed = 0;
+
+    memcpy(&db_header, db, sizeof(rmc_db_header_t));
+
+    if (init_name_iter(db, name, &iter) || rmc_query_carriers(db_pathname, name, &report)) {
+        fprintf(stderr, "%s: failed to query records\n", name);
+        return 1;
+    }
+
+    for (record_idx = sizeof(rmc_db_header_t); record_idx < db_header.length;
+        record_idx += record_header.length) {
+        memcpy(&record_header, db + record_idx, sizeof(rmc_record_header_t));
+
+        if (query_policy_from_record(db, record_idx, RMC_GENERIC_FILE, name, &expected))
+            continue;
+
+        if (next_record_with_name(&iter, &found_idx, &file) || found_idx != record_idx ||
+            file.blob != expected.blob || file.blob_len != expected.blob_len) {
+            fprintf(stderr, "%s: record 0x%llx is not returned by iterator\n", name,
+                (unsigned long long)record_idx);
+            failed = 1;
+        }
+
+        if (n >= report.carrier_num || report.carriers[n].record_idx != record_idx ||
+            report.carriers[n].blob_len != expected.blob_len ||
+            memcmp(report.carriers[n].blob, expected.blob, expected.blob_len) ||
+            memcmp(&report.carriers[n].signature, &record_header.signature, sizeof(rmc_signature_t)) ||
+            !report.carriers[n].pattern != !is_pattern_record(db, record_idx)) {
+            fprintf(stderr, "%s: record 0x%llx is not reported\n", name, (unsigned long long)record_idx);
+            failed = 1;
+        }
+
+        n++;
+    }
+
+    if (!next_record_with_name(&iter, &found_idx, &file) || report.carrier_num != n) {
+        fprintf(stderr, "%s: more records are returned\n", name);
+        failed = 1;
+    }
+
+    printf("%s: %llu records\n", name, (unsigned long long)n);
+    rmc_free_carrier_report(&report);
+
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    rmc_db_header_t db_header;
+    rmc_postings_header_t header;
+    rmc_posting_t posting;
+    rmc_posting_t other;
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t last = 0;
+    rmc_uint64_t fewer = 0;
+    char *data = NULL;
+    rmc_size_t db_len = 0;
+    int failed = 0;
+    int i;
+
+    if (argc < 3 || read_file(argv[1], &data, &db_len))
+        return 1;
+
+    memcpy(&db_header, data, sizeof(rmc_db_header_t));
+
+    for (i = 2; i < argc; i++)
+        failed |= check_name(argv[1], (rmc_uint8_t *)data, argv[i]);
+
+    if (db_header.version == RMC_DB_VERSION_1) {
+        free(data);
+        return failed;
+    }
+
+    if (query_section_from_db((rmc_uint8_t *)data, RMC_SECTION_POSTINGS, &section_idx, &section_len)) {
+        fprintf(stderr, "no posting lists in version 2 database\n");
+        free(data);
+        return 1;
+    }
+
+    memcpy(&header, data + section_idx, sizeof(rmc_postings_header_t));
+
+    if (header.posting_num < 2) {
+        fprintf(stderr, "too few postings to corrupt\n");
+        free(data);
+        return 1;
+    }
+
+    /* the first posting refers to the blob of the second one */
+    memcpy(&posting, data + section_idx + header.posting_idx, sizeof(rmc_posting_t));
+    memcpy(&other, data + section_idx + header.posting_idx + sizeof(rmc_posting_t), sizeof(rmc_posting_t));
+    memcpy(data + section_idx + header.posting_idx, &other, sizeof(rmc_posting_t));
+
+    if (!validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "corrupted posting is not detected\n");
+        failed = 1;
+    }
+
+    memcpy(data + section_idx + header.posting_idx, &posting, sizeof(rmc_posting_t));
+
+    if (validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "restored database is rejected\n");
+        failed = 1;
+    }
+
+    /* the last posting is dropped from its list */
+    memcpy(&last, data + section_idx + header.first_idx + header.name_num * sizeof(rmc_uint64_t),
+        sizeof(rmc_uint64_t));
+    fewer = last - 1;
+    memcpy(data + section_idx + header.first_idx + header.name_num * sizeof(rmc_uint64_t), &fewer,
+        sizeof(rmc_uint64_t));
+    header.posting_num--;
+    memcpy(data + section_idx, &header, sizeof(rmc_postings_header_t));
+
+    if (!validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "incomplete posting lists are not detected\n");
+        failed = 1;
+    }
+
+    free(data);
+
+    return failed;
+}
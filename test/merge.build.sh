@@ -0,0 +1,74 @@
+#!/bin/sh
+# This script tests merging database files with rmc tool.
+# A database merged with itself must be identical to it,
+# and blobs of a board from two databases are resolved with
+# each conflict policy.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC database merge test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+# Database A has sample data of all boards
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 \
+    $BOARDS_DIR/NUC6.file.3 -o $TEST_TMP_DIR/nuc6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2 \
+    -o $TEST_TMP_DIR/nuc4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2 \
+    -o $TEST_TMP_DIR/t100.rec 1>/dev/null
+
+for version in 1 2; do
+    ../src/rmc -D $TEST_TMP_DIR/nuc6.rec $TEST_TMP_DIR/nuc4.rec $TEST_TMP_DIR/t100.rec \
+        -v $version -o $TEST_TMP_DIR/a.v$version.db
+    ../src/rmc -M -d $TEST_TMP_DIR/a.v$version.db $TEST_TMP_DIR/a.v$version.db -c error \
+        -v $version -o $TEST_TMP_DIR/aa.v$version.db
+    cmp -s $TEST_TMP_DIR/a.v$version.db $TEST_TMP_DIR/aa.v$version.db || \
+        fail "version $version: database merged with itself is different"
+done
+
+# Database B replaces NUC4.file.1 with data of NUC4.file.2 under the same name,
+# and adds NUC6.file.1 to NUC4
+mkdir $TEST_TMP_DIR/b
+cp $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/b/NUC4.file.1
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $TEST_TMP_DIR/b/NUC4.file.1 $BOARDS_DIR/NUC6.file.1 \
+    -o $TEST_TMP_DIR/b.rec 1>/dev/null
+../src/rmc -D $TEST_TMP_DIR/b.rec -o $TEST_TMP_DIR/b.db
+
+if ../src/rmc -M -d $TEST_TMP_DIR/a.v1.db $TEST_TMP_DIR/b.db -c error -o $TEST_TMP_DIR/ab.error.db \
+    2>/dev/null || [ -e $TEST_TMP_DIR/ab.error.db ]; then
+    fail "conflicting blobs are not reported with policy error"
+fi
+
+# $1: policy, $2: expected data of NUC4.file.1
+check_policy () {
+    ../src/rmc -M -d $TEST_TMP_DIR/a.v1.db $TEST_TMP_DIR/b.db -c $1 -v 2 -o $TEST_TMP_DIR/ab.$1.db
+    ../src/rmc -B NUC4.file.1 NUC4.file.2 NUC6.file.1 -f $BOARDS_DIR/NUC4.D54250WYK.fp \
+        -d $TEST_TMP_DIR/ab.$1.db -o $TEST_TMP_DIR/ab.$1
+    cmp -s $2 $TEST_TMP_DIR/ab.$1/NUC4.D54250WYK.fp/NUC4.file.1 || fail "policy $1: wrong NUC4.file.1"
+    cmp -s $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/ab.$1/NUC4.D54250WYK.fp/NUC4.file.2 || \
+        fail "policy $1: wrong NUC4.file.2"
+    cmp -s $BOARDS_DIR/NUC6.file.1 $TEST_TMP_DIR/ab.$1/NUC4.D54250WYK.fp/NUC6.file.1 || \
+        fail "policy $1: wrong NUC6.file.1"
+    ../src/rmc -V -d $TEST_TMP_DIR/ab.$1.db 1>/dev/null || fail "policy $1: merged database is corrupted"
+}
+
+check_policy last $TEST_TMP_DIR/b/NUC4.file.1
+check_policy first $BOARDS_DIR/NUC4.file.1
+
+echo "RMC database merge test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
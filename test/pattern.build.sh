@@ -0,0 +1,76 @@
+#!/bin/sh
+# This script tests pattern records with sample boards in version 2
+# databases. NUC6 and NUC4 have the same system product name (finger
+# 0), so a pattern record of it is a family of both. A pattern record
+# of both product names (fingers 0 and 1) only matches NUC6.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+NUC6_FP="$BOARDS_DIR/NUC6i5SYB_H.fp"
+NUC4_FP="$BOARDS_DIR/NUC4.D54250WYK.fp"
+T100_FP="$BOARDS_DIR/T100TA-32bit.fp"
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC pattern record test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $NUC6_FP -b $BOARDS_DIR/NUC6.file.1 -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $NUC4_FP -b $BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2 \
+    -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+
+# family of NUC6 and NUC4
+mkdir $TEST_TMP_DIR/wide
+echo "wide" > $TEST_TMP_DIR/wide/family.conf
+echo "wide" > $TEST_TMP_DIR/wide/NUC6.file.2
+echo "wide" > $TEST_TMP_DIR/wide/NUC4.file.1
+../src/rmc -R -f $NUC6_FP -m 0 -b $TEST_TMP_DIR/wide/family.conf $TEST_TMP_DIR/wide/NUC6.file.2 \
+    $TEST_TMP_DIR/wide/NUC4.file.1 -o $TEST_TMP_DIR/wide.rec 1>/dev/null
+
+# family of NUC6 only
+mkdir $TEST_TMP_DIR/narrow
+echo "narrow" > $TEST_TMP_DIR/narrow/family.conf
+../src/rmc -R -f $NUC6_FP -m 0,1 -b $TEST_TMP_DIR/narrow/family.conf \
+    -o $TEST_TMP_DIR/narrow.rec 1>/dev/null
+
+# order of records in database doesn't decide which record wins
+../src/rmc -D $TEST_TMP_DIR/wide.rec $TEST_TMP_DIR/narrow.rec $TEST_TMP_DIR/NUC6.rec \
+    $TEST_TMP_DIR/NUC4.rec -v 2 -o $TEST_TMP_DIR/wide_first.db
+../src/rmc -D $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/narrow.rec \
+    $TEST_TMP_DIR/wide.rec -v 2 -o $TEST_TMP_DIR/board_first.db
+
+cc -Wall -Wextra -I../inc pattern_test.c ../src/lib/librmc.a -o $TEST_TMP_DIR/pattern_test
+
+for db in wide_first board_first; do
+    $TEST_TMP_DIR/pattern_test $TEST_TMP_DIR/$db.db \
+        $NUC6_FP NUC6.file.1 $BOARDS_DIR/NUC6.file.1 \
+        $NUC6_FP family.conf $TEST_TMP_DIR/narrow/family.conf \
+        $NUC6_FP NUC6.file.2 $TEST_TMP_DIR/wide/NUC6.file.2 \
+        $NUC6_FP NUC4.file.1 $TEST_TMP_DIR/wide/NUC4.file.1 \
+        $NUC4_FP NUC4.file.1 $BOARDS_DIR/NUC4.file.1 \
+        $NUC4_FP NUC4.file.2 $BOARDS_DIR/NUC4.file.2 \
+        $NUC4_FP family.conf $TEST_TMP_DIR/wide/family.conf \
+        $NUC4_FP NUC6.file.1 - \
+        $T100_FP family.conf - || fail "$db: wrong blobs"
+done
+
+# a database of version 1 cannot match pattern records
+if ../src/rmc -D $TEST_TMP_DIR/wide.rec $TEST_TMP_DIR/NUC6.rec -o $TEST_TMP_DIR/rmc.v1.db 2>/dev/null; then
+    fail "pattern record is packed in version 1 database"
+fi
+
+echo "RMC pattern record test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of pattern records
+ *
+ * Blobs are queried for boards from a version 2 database with records of boards
+ * and pattern records of their families, and must be the expected files: a
+ * record of the board wins over its family, and a pattern record matching more
+ * fingers wins over one matching fewer. At last the signature table, an edge and
+ * a leaf of trie are corrupted in turn and the database must be rejected.
+ *
+ * usage: pattern_test <db> [<fingerprint file> <blob name> <expected file or ->]...
+ * "-" expects the blob not to be found for the board.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+/* query a blob for a board, return: 0 when result is expected */
+static int check_blob(rmc_uint8_t *db, rmc_size_t db_len, char *fp_pathname, char *name,
+        char *expected_pathname) {
+    rmc_fingerprint_t fp;
+    rmc_file_t file;
+    void *raw = NULL;
+    char *expected = NULL;
+    rmc_size_t expected_len = 0;
+    int found = 0;
+    int failed = 0;
+
+    if (read_fingerprint_from_file(fp_pathname, &fp, &raw)) {
+        fprintf(stderr, "%s: cannot read fingerprint\n", fp_pathname);
+        return 1;
+    }
+
+    found = !query_policy_from_buffer(&fp, db, db_len, RMC_GENERIC_FILE, name, &file);
+
+    if (strcmp(expected_pathname, "-")) {
+        if (read_file(expected_pathname, &expected, &expected_len))
+            failed = 1;
+        else if (!found || file.blob_len != expected_len || memcmp(file.blob, expected, expected_len)) {
+            fprintf(stderr, "%s: %s is not %s\n", fp_pathname, name, expected_pathname);
+            failed = 1;
+        }
+
+        free(expected);
+    } else if (found) {
+        fprintf(stderr, "%s: %s is found\n", fp_pathname, name);
+        failed = 1;
+    }
+
+    /* values of fp reference raw */
+    free(raw);
+
+    return failed;
+}
+
+/* return: 0 when corrupted database is rejected */
+static int check_rejected(rmc_uint8_t *db, rmc_size_t db_len, const char *what) {
+    if (validate_rmcdb_layout(db, db_len))
+        return 0;
+
+    fprintf(stderr, "corrupted %s is not detected\n", what);
+
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    rmc_trie_header_t header;
+    rmc_sig_entry_t sigs[2];
+    rmc_trie_node_t node;
+    rmc_trie_edge_t edge;
+    rmc_trie_record_t record;
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint8_t *section = NULL;
+    rmc_uint8_t *item = NULL;
+    rmc_uint64_t i;
+    rmc_uint32_t child = 0;
+    char *data = NULL;
+    rmc_size_t db_len = 0;
+    int failed = 0;
+    int n;
+
+    if (argc < 2 || (argc - 2) % 3 || read_file(argv[1], &data, &db_len))
+        return 1;
+
+    for (n = 2; n < argc; n += 3)
+        failed |= check_blob((rmc_uint8_t *)data, db_len, argv[n], argv[n + 1], argv[n + 2]);
+
+    if (query_section_from_db((rmc_uint8_t *)data, RMC_SECTION_TRIE, &section_idx, &section_len)) {
+        fprintf(stderr, "no trie in database\n");
+        free(data);
+        return 1;
+    }
+
+    section = (rmc_uint8_t *)data + section_idx;
+    memcpy(&header, section, sizeof(rmc_trie_header_t));
+
+    if (header.sig_num < 2 || !header.node_num) {
+        fprintf(stderr, "too few signatures or nodes to corrupt\n");
+        free(data);
+        return 1;
+    }
+
+    /* signature table out of order */
+    memcpy(sigs, section + header.sig_idx, sizeof(sigs));
+    memcpy(section + header.sig_idx, &sigs[1], sizeof(rmc_sig_entry_t));
+    memcpy(section + header.sig_idx + sizeof(rmc_sig_entry_t), &sigs[0], sizeof(rmc_sig_entry_t));
+    failed |= check_rejected((rmc_uint8_t *)data, db_len, "signature table");
+    memcpy(section + header.sig_idx, sigs, sizeof(sigs));
+
+    if (validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "restored database is rejected\n");
+        failed = 1;
+    }
+
+    /* an edge of root back to root, a lookup would never reach a leaf */
+    memcpy(&node, section + header.node_idx, sizeof(rmc_trie_node_t));
+
+    if (node.level < RMC_FINGER_NUM && node.item_num) {
+        item = section + header.item_idx + node.items_idx;
+        memcpy(&edge, item, sizeof(rmc_trie_edge_t));
+        child = edge.child;
+        edge.child = 0;
+        memcpy(item, &edge, sizeof(rmc_trie_edge_t));
+        failed |= check_rejected((rmc_uint8_t *)data, db_len, "trie edge");
+        edge.child = child;
+        memcpy(item, &edge, sizeof(rmc_trie_edge_t));
+    } else {
+        fprintf(stderr, "root of trie has no edge\n");
+        failed = 1;
+    }
+
+    /* a record in the first leaf matching no finger */
+    for (i = 0; i < header.node_num; i++) {
+        memcpy(&node, section + header.node_idx + i * sizeof(rmc_trie_node_t), sizeof(rmc_trie_node_t));
+
+        if (node.level == RMC_FINGER_NUM && node.item_num)
+            break;
+    }
+
+    if (i < header.node_num) {
+        item = section + header.item_idx + node.items_idx;
+        memcpy(&record, item, sizeof(rmc_trie_record_t));
+        record.finger_mask = 0;
+        memcpy(item, &record, sizeof(rmc_trie_record_t));
+        failed |= check_rejected((rmc_uint8_t *)data, db_len, "trie leaf");
+    } else {
+        fprintf(stderr, "trie has no leaf\n");
+        failed = 1;
+    }
+
+    free(data);
+
+    return failed;
+}
@@ -0,0 +1,74 @@
+#!/bin/sh
+# This script tests query contexts with sample boards in
+# databases of version 1 and 2. The version 2 database also
+# has a pattern record for NUC6, which has a blob overridden
+# by the board's own record. Another database has more
+# records for NUC6 than a context holds.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+NUC6_FILES="$BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 $BOARDS_DIR/NUC6.file.3"
+NUC4_FILES="$BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2"
+T100_FILES="$BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2"
+BOARDS="$BOARDS_DIR/NUC6i5SYB_H.fp $BOARDS_DIR/NUC4.D54250WYK.fp $BOARDS_DIR/T100TA-32bit.fp"
+NAMES="NUC6.file.1 NUC6.file.2 NUC6.file.3 NUC4.file.1 NUC4.file.2 T100.32.file.1 \
+    T100.32.file.2 family.conf rmc.match no.such.file"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC query context test: FAIL"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $NUC6_FILES -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $NUC4_FILES -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $T100_FILES -o $TEST_TMP_DIR/T100.rec 1>/dev/null
+
+# family of NUC6 by product name of baseboard (finger 1)
+mkdir $TEST_TMP_DIR/family
+cp $BOARDS_DIR/NUC4.file.1 $TEST_TMP_DIR/family/NUC6.file.1
+cp $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/family/family.conf
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -m 1 -b $TEST_TMP_DIR/family/NUC6.file.1 \
+    $TEST_TMP_DIR/family/family.conf -o $TEST_TMP_DIR/family.rec 1>/dev/null
+
+../src/rmc -D $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/T100.rec \
+    -o $TEST_TMP_DIR/rmc.v1.db
+../src/rmc -D $TEST_TMP_DIR/family.rec $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec \
+    $TEST_TMP_DIR/T100.rec -v 2 -o $TEST_TMP_DIR/rmc.v2.db
+
+# a blob of its own in each of 12 more records for NUC6
+MANY_RECS=""
+MANY_NAMES=""
+for i in 0 1 2 3 4 5 6 7 8 9 10 11; do
+    mkdir $TEST_TMP_DIR/many.$i
+    cp $BOARDS_DIR/NUC6.file.1 $TEST_TMP_DIR/many.$i/NUC6.file.1
+    echo "many $i" > $TEST_TMP_DIR/many.$i/many.$i
+    ../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $TEST_TMP_DIR/many.$i/NUC6.file.1 \
+        $TEST_TMP_DIR/many.$i/many.$i -o $TEST_TMP_DIR/many.$i.rec 1>/dev/null
+    MANY_RECS="$MANY_RECS $TEST_TMP_DIR/many.$i.rec"
+    MANY_NAMES="$MANY_NAMES many.$i"
+done
+
+../src/rmc -D $TEST_TMP_DIR/NUC4.rec $MANY_RECS $TEST_TMP_DIR/NUC6.rec -o $TEST_TMP_DIR/many.v1.db
+../src/rmc -D $TEST_TMP_DIR/family.rec $TEST_TMP_DIR/NUC4.rec $MANY_RECS $TEST_TMP_DIR/NUC6.rec \
+    -v 2 -o $TEST_TMP_DIR/many.v2.db
+
+cc -Wall -Wextra -I../inc query_ctx_test.c ../src/lib/librmc.a -o $TEST_TMP_DIR/query_ctx_test
+
+for db in rmc.v1 rmc.v2 many.v1 many.v2; do
+    $TEST_TMP_DIR/query_ctx_test $TEST_TMP_DIR/$db.db $BOARDS -- $NAMES $MANY_NAMES || fail
+done
+
+echo "RMC query context test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of query contexts
+ *
+ * A context is prepared for every board, every blob name is queried with it,
+ * and the result must be the same blob a query on the database returns.
+ *
+ * usage: query_ctx_test <db> <fingerprint file>... -- <blob name>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    rmc_query_ctx_t ctx;
+    rmc_file_t expected;
+    rmc_file_t file;
+    char *data = NULL;
+    void *raw = NULL;
+    rmc_size_t db_len = 0;
+    int names = 0;
+    int failed = 0;
+    int found = 0;
+    int i;
+    int j;
+
+    if (argc < 4 || read_file(argv[1], &data, &db_len))
+        return 1;
+
+    for (names = 2; names < argc && strcmp(argv[names], "--"); names++)
+        ;
+
+    for (i = 2; i < names; i++) {
+        if (read_fingerprint_from_file(argv[i], &fp, &raw))
+            return 1;
+
+        if (rmcl_init_query_ctx(&fp, (rmc_uint8_t *)data, &ctx)) {
+            fprintf(stderr, "%s: failed to prepare context\n", argv[i]);
+            return 1;
+        }
+
+        printf("%s: %u records in context%s\n", argv[i], ctx.record_num, ctx.more ? " and more" : "");
+
+        for (j = names + 1; j < argc; j++) {
+            found = !query_policy_from_db(&fp, (rmc_uint8_t *)data, RMC_GENERIC_FILE, argv[j], &expected);
+
+            if (query_policy_from_ctx(&ctx, RMC_GENERIC_FILE, argv[j], &file) == found ||
+                (found && (file.blob != expected.blob || file.blob_len != expected.blob_len ||
+                strcmp(file.blob_name, argv[j])))) {
+                fprintf(stderr, "%s: %s is different from query on database\n", argv[i], argv[j]);
+                failed = 1;
+            }
+        }
+
+        free(raw);
+    }
+
+    free(data);
+
+    return failed;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of queries on a database read with a callback
+ *
+ * Database file is read into memory, the callback reads it from there and
+ * counts bytes read. Every blob name is queried for every board and results
+ * must be the same as queries on the database in memory. Each query is run
+ * again with the database cut at every offset before the end of data it has
+ * read, and must fail.
+ *
+ * usage: read_at_test <db> <fingerprint file>... -- <blob name>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+typedef struct db_file {
+    unsigned char *data;
+    rmc_size_t len;     /* bytes readable */
+    rmc_size_t read;    /* bytes read so far */
+    rmc_size_t end;     /* end of data read */
+} db_file_t;
+
+static int read_at(void *ctx, rmc_uint64_t offset, rmc_size_t len, void *buf) {
+    db_file_t *db = ctx;
+
+    if (offset > db->len || len > db->len - offset)
+        return 1;
+
+    memcpy(buf, db->data + offset, len);
+    db->read += len;
+
+    if (db->end < offset + len)
+        db->end = offset + len;
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    rmc_file_t expected;
+    db_file_t db;
+    char *data = NULL;
+    void *raw = NULL;
+    unsigned char buf[4096];
+    rmc_size_t db_len = 0;
+    rmc_size_t len = 0;
+    rmc_size_t cut = 0;
+    rmc_size_t end = 0;
+    int names = 0;
+    int failed = 0;
+    int found = 0;
+    int i;
+    int j;
+
+    if (argc < 4 || read_file(argv[1], &data, &db_len))
+        return 1;
+
+    db.data = (unsigned char *)data;
+
+    for (names = 2; names < argc && strcmp(argv[names], "--"); names++)
+        ;
+
+    for (i = 2; i < names; i++) {
+        if (read_fingerprint_from_file(argv[i], &fp, &raw))
+            return 1;
+
+        for (j = names + 1; j < argc; j++) {
+            found = !query_policy_from_buffer(&fp, db.data, db_len, RMC_GENERIC_FILE, argv[j], &expected);
+
+            db.len = db_len;
+            db.read = 0;
+            db.end = 0;
+
+            if (query_policy_by_read_at(&fp, read_at, &db, RMC_GENERIC_FILE, argv[j], buf, sizeof(buf), &len) == found ||
+                (found && (len != expected.blob_len || memcmp(buf, expected.blob, len))) ||
+                (!found && len)) {
+                fprintf(stderr, "%s: %s is different from query in memory\n", argv[i], argv[j]);
+                failed = 1;
+                continue;
+            }
+
+            printf("%s: %s %s, %lu of %lu bytes read\n", argv[i], argv[j], found ? "found" : "not found",
+                (unsigned long)db.read, (unsigned long)db_len);
+
+            if (!found)
+                continue;
+
+            end = db.end;
+
+            /* size of blob without a buffer */
+            if (!query_policy_by_read_at(&fp, read_at, &db, RMC_GENERIC_FILE, argv[j], NULL, 0, &len) ||
+                len != expected.blob_len) {
+                fprintf(stderr, "%s: %s size is not returned\n", argv[i], argv[j]);
+                failed = 1;
+            }
+
+            for (cut = 0; cut < end; cut++) {
+                db.len = cut;
+
+                if (!query_policy_by_read_at(&fp, read_at, &db, RMC_GENERIC_FILE, argv[j], buf, sizeof(buf), &len)) {
+                    fprintf(stderr, "%s: %s is found in database cut at %lu\n", argv[i], argv[j],
+                        (unsigned long)cut);
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+
+        free(raw);
+    }
+
+    free(data);
+
+    return failed;
+}
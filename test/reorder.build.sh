@@ -0,0 +1,73 @@
+#!/bin/sh
+# This script tests reordering records of database files by population
+# of boards with rmc tool. A reordered database must be identical to one
+# generated from the same records in the order of population.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC database reorder test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 \
+    $BOARDS_DIR/NUC6.file.3 -o $TEST_TMP_DIR/nuc6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2 \
+    -o $TEST_TMP_DIR/nuc4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2 \
+    -o $TEST_TMP_DIR/t100.rec 1>/dev/null
+
+# NUC6 is not in population, so it stays behind the other boards
+cat > $TEST_TMP_DIR/population.txt <<POPULATION
+# machines fingerprint
+10 $BOARDS_DIR/NUC4.D54250WYK.fp
+
+100 $BOARDS_DIR/T100TA-32bit.fp
+POPULATION
+
+for version in 1 2; do
+    ../src/rmc -D $TEST_TMP_DIR/nuc6.rec $TEST_TMP_DIR/nuc4.rec $TEST_TMP_DIR/t100.rec \
+        -v $version -o $TEST_TMP_DIR/in.v$version.db
+    ../src/rmc -D $TEST_TMP_DIR/t100.rec $TEST_TMP_DIR/nuc4.rec $TEST_TMP_DIR/nuc6.rec \
+        -v $version -o $TEST_TMP_DIR/expected.v$version.db
+    ../src/rmc -O -d $TEST_TMP_DIR/in.v$version.db -p $TEST_TMP_DIR/population.txt \
+        -o $TEST_TMP_DIR/out.v$version.db
+    cmp -s $TEST_TMP_DIR/expected.v$version.db $TEST_TMP_DIR/out.v$version.db || \
+        fail "version $version: records are not reordered by population"
+    ../src/rmc -V -d $TEST_TMP_DIR/out.v$version.db 1>/dev/null || \
+        fail "version $version: reordered database is corrupted"
+done
+
+# records of boards out of population keep their order
+: > $TEST_TMP_DIR/empty.txt
+../src/rmc -O -d $TEST_TMP_DIR/in.v1.db -p $TEST_TMP_DIR/empty.txt -o $TEST_TMP_DIR/same.db
+cmp -s $TEST_TMP_DIR/in.v1.db $TEST_TMP_DIR/same.db || fail "order of records is changed without population"
+
+if ../src/rmc -O -d $TEST_TMP_DIR/in.v1.db -p $TEST_TMP_DIR/population.txt \
+    -o $TEST_TMP_DIR/in.v1.db 2>/dev/null; then
+    fail "database is reordered into itself"
+fi
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -m 1 -b $BOARDS_DIR/NUC6.file.1 \
+    -o $TEST_TMP_DIR/family.rec 1>/dev/null
+../src/rmc -D $TEST_TMP_DIR/t100.rec $TEST_TMP_DIR/family.rec -v 2 -o $TEST_TMP_DIR/family.db
+if ../src/rmc -O -d $TEST_TMP_DIR/family.db -p $TEST_TMP_DIR/population.txt \
+    -o $TEST_TMP_DIR/family.out.db 2>/dev/null || [ -e $TEST_TMP_DIR/family.out.db ]; then
+    fail "database with pattern records is reordered"
+fi
+
+echo "RMC database reorder test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
@@ -0,0 +1,74 @@
+#!/bin/sh
+# This script tests rmcd and its client library with sample boards.
+# rmcd serves a database on a socket in a temporary directory, with a
+# fingerprint file of NUC6 instead of the board test runs on.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+TEST_TMP_DIR=$(mktemp -d)
+RMCD_PID=""
+
+export RMCD_SOCKET=$TEST_TMP_DIR/rmcd.sock
+
+# compile librmc, rmc tool and rmcd first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC rmcd test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    [ -n "$RMCD_PID" ] && kill $RMCD_PID 2>/dev/null
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+# user and system time of rmcd in clock ticks
+cpu_ticks () {
+    awk '{ print $14 + $15 }' /proc/$RMCD_PID/stat
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 \
+    -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $BOARDS_DIR/NUC4.file.1 \
+    -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+../src/rmc -D $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec -o $TEST_TMP_DIR/rmc.db
+cp $TEST_TMP_DIR/rmc.db $TEST_TMP_DIR/copy.db
+
+cc -Wall -Wextra -I../inc rmcd_test.c ../src/lib/librmc.a -o $TEST_TMP_DIR/rmcd_test
+
+../src/rmcd/rmcd -d $TEST_TMP_DIR/rmc.db -f $BOARDS_DIR/NUC6i5SYB_H.fp -s $RMCD_SOCKET &
+RMCD_PID=$!
+
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    [ -S $RMCD_SOCKET ] && break
+    sleep 0.1
+done
+
+$TEST_TMP_DIR/rmcd_test serve $TEST_TMP_DIR/rmc.db $TEST_TMP_DIR/copy.db NUC6.file.2 \
+    $BOARDS_DIR/NUC6.file.2 NUC4.file.1 || fail "rmcd failed to serve clients"
+
+# rmcd must not spin while all its slots for clients are taken
+before=$(cpu_ticks)
+$TEST_TMP_DIR/rmcd_test hold $RMCD_SOCKET 80 || fail "failed to connect to rmcd"
+after=$(cpu_ticks)
+[ $((after - before)) -lt 20 ] || fail "rmcd is busy with all slots taken: $((after - before)) ticks"
+
+$TEST_TMP_DIR/rmcd_test serve $TEST_TMP_DIR/rmc.db $TEST_TMP_DIR/copy.db NUC6.file.1 \
+    $BOARDS_DIR/NUC6.file.1 NUC4.file.1 || fail "rmcd failed to serve clients after slots are freed"
+
+../src/rmcd/rmcd -S -s $RMCD_SOCKET 1>/dev/null || fail "rmcd -S failed"
+
+kill $RMCD_PID
+wait $RMCD_PID || true
+RMCD_PID=""
+
+$TEST_TMP_DIR/rmcd_test absent $TEST_TMP_DIR/rmc.db NUC6.file.2 $BOARDS_DIR/NUC6.file.2 || \
+    fail "client failed without rmcd"
+
+echo "RMC rmcd test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
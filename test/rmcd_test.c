@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of rmcd and its client library
+ *
+ * usage:
+ * rmcd_test serve <db> <copy of db> <blob name> <blob file> <missing name>
+ *   rmcd serves db. Blob is queried twice and both clients read their fds to the
+ *   end, a missing blob is not found, and a query on the copy (another file) is
+ *   answered from the file by client. Counters of rmcd must count all of them.
+ *
+ * A client falling back to a database file fingerprints the board it runs on,
+ * so its result must be the same as rmc_gimme_fd() on the file, which fails on
+ * a machine without SMBIOS or a handoff.
+ * rmcd_test hold <socket> <number>
+ *   Keep number of connections to rmcd open for a second.
+ * rmcd_test absent <db> <blob name> <blob file>
+ *   rmcd is not running, client falls back to db and fails without db.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <rmc_api.h>
+
+/* read fd from its current offset to the end, return: 0 when data is the same as file */
+static int check_fd(int fd, char *pathname) {
+    char *expected = NULL;
+    char *data = NULL;
+    rmc_size_t len = 0;
+    rmc_size_t pos = 0;
+    ssize_t n = 0;
+    int ret = 1;
+
+    if (read_file(pathname, &expected, &len))
+        return 1;
+
+    data = malloc(len + 1);
+
+    if (!data)
+        goto out;
+
+    /* one more byte to see the end of blob */
+    while (pos <= len && (n = read(fd, data + pos, len + 1 - pos)) > 0)
+        pos += n;
+
+    ret = n < 0 || pos != len || memcmp(data, expected, len);
+out:
+    free(data);
+    free(expected);
+
+    return ret;
+}
+
+/*
+ * query a blob with a client falling back to database file, and check the result
+ * is the same as querying the file directly. Messages of failures to fingerprint
+ * the board are not shown.
+ * return: 0 when result is expected
+ */
+static int check_fallback(char *db_pathname, char *name, char *pathname) {
+    rmc_size_t len = 0;
+    int null_fd = open("/dev/null", O_WRONLY);
+    int err_fd = dup(STDERR_FILENO);
+    int direct_fd = -1;
+    int fd = -1;
+    int direct = 0;
+    int client = 0;
+    int ret = 0;
+
+    if (null_fd < 0 || err_fd < 0)
+        return 1;
+
+    dup2(null_fd, STDERR_FILENO);
+    direct = rmc_gimme_fd(db_pathname, name, &direct_fd, &len);
+    client = rmcd_query_fd(db_pathname, name, &fd, &len);
+    dup2(err_fd, STDERR_FILENO);
+    close(err_fd);
+    close(null_fd);
+
+    if (!direct != !client) {
+        fprintf(stderr, "%s: client returns %d, but file query returns %d\n", name, client, direct);
+        ret = 1;
+    } else if (!client && check_fd(fd, pathname)) {
+        fprintf(stderr, "%s: wrong data from %s\n", name, db_pathname);
+        ret = 1;
+    }
+
+    if (direct_fd >= 0)
+        close(direct_fd);
+
+    if (fd >= 0)
+        close(fd);
+
+    return ret;
+}
+
+static int test_serve(char **argv) {
+    rmcd_stats_t before;
+    rmcd_stats_t after;
+    int fds[2];
+    rmc_size_t len = 0;
+    int failed = 0;
+    int i;
+
+    if (rmcd_get_stats(&before)) {
+        fprintf(stderr, "rmcd is not reachable\n");
+        return 1;
+    }
+
+    /* both fds are open before either is read */
+    for (i = 0; i < 2; i++) {
+        if (rmcd_query_fd(argv[2], argv[4], &fds[i], &len)) {
+            fprintf(stderr, "client %d: failed to query %s\n", i, argv[4]);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < 2; i++) {
+        if (check_fd(fds[i], argv[5])) {
+            fprintf(stderr, "client %d: wrong data of %s\n", i, argv[4]);
+            failed = 1;
+        }
+
+        close(fds[i]);
+    }
+
+    if (!rmcd_query_fd(argv[2], argv[6], &fds[0], &len)) {
+        fprintf(stderr, "missing blob %s is found\n", argv[6]);
+        close(fds[0]);
+        failed = 1;
+    }
+
+    /* rmcd serves another file, client reads the copy itself */
+    failed |= check_fallback(argv[3], argv[4], argv[5]);
+
+    if (rmcd_get_stats(&after)) {
+        fprintf(stderr, "rmcd is not reachable\n");
+        return 1;
+    }
+
+    if (after.queries - before.queries != 4 || after.hits - before.hits != 2 ||
+        after.misses - before.misses != 1 || after.errors != before.errors) {
+        fprintf(stderr, "wrong counters: %llu queries, %llu hits, %llu misses, %llu errors\n",
+            (unsigned long long)(after.queries - before.queries),
+            (unsigned long long)(after.hits - before.hits),
+            (unsigned long long)(after.misses - before.misses),
+            (unsigned long long)(after.errors - before.errors));
+        failed = 1;
+    }
+
+    return failed;
+}
+
+static int test_hold(char **argv) {
+    struct sockaddr_un addr;
+    int num = atoi(argv[3]);
+    int *socks = NULL;
+    int i;
+
+    if (num <= 0 || strlen(argv[2]) >= sizeof(addr.sun_path) || (socks = calloc(num, sizeof(int))) == NULL)
+        return 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, argv[2]);
+
+    /* connections beyond backlog of rmcd could block, don't care if they fail */
+    for (i = 0; i < num; i++) {
+        socks[i] = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
+
+        if (socks[i] >= 0)
+            connect(socks[i], (struct sockaddr *)&addr, sizeof(addr));
+    }
+
+    sleep(1);
+
+    for (i = 0; i < num; i++) {
+        if (socks[i] >= 0)
+            close(socks[i]);
+    }
+
+    free(socks);
+
+    return 0;
+}
+
+static int test_absent(char **argv) {
+    rmcd_stats_t stats;
+    rmc_size_t len = 0;
+    int fd = -1;
+    int failed = 0;
+
+    if (!rmcd_get_stats(&stats)) {
+        fprintf(stderr, "rmcd is still running\n");
+        return 1;
+    }
+
+    failed |= check_fallback(argv[2], argv[3], argv[4]);
+
+    if (!rmcd_query_fd(NULL, argv[3], &fd, &len)) {
+        fprintf(stderr, "query without rmcd and database succeeds\n");
+        close(fd);
+        failed = 1;
+    }
+
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 7 && !strcmp(argv[1], "serve"))
+        return test_serve(argv);
+
+    if (argc == 4 && !strcmp(argv[1], "hold"))
+        return test_hold(argv);
+
+    if (argc == 5 && !strcmp(argv[1], "absent"))
+        return test_absent(argv);
+
+    return 1;
+}
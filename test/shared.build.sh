@@ -0,0 +1,50 @@
+#!/bin/sh
+# This script stresses a shared database handle in librmc
+# with reader threads while the database file is replaced
+# over and over. It reports throughput with different numbers
+# of reader threads.
+
+# To run more reader threads (power of 2 up to this number):
+
+# $ RMC_TEST_THREADS=32 ./shared.build.sh
+
+set -e
+
+if [ -z ${RMC_TEST_THREADS+x} ]; then
+    RMC_TEST_THREADS=$(nproc)
+fi
+
+BOARDS_DIR="./boards"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+# Database A has original sample data of NUC6, database B
+# replaces NUC6.file.1 with data of NUC6.file.2 under the same name.
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $BOARDS_DIR/NUC6.file.1 \
+    -o $TEST_TMP_DIR/a.rec 1>/dev/null
+../src/rmc -D $TEST_TMP_DIR/a.rec -o $TEST_TMP_DIR/a.db
+
+mkdir $TEST_TMP_DIR/b
+cp $BOARDS_DIR/NUC6.file.2 $TEST_TMP_DIR/b/NUC6.file.1
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $TEST_TMP_DIR/b/NUC6.file.1 \
+    -o $TEST_TMP_DIR/b.rec 1>/dev/null
+../src/rmc -D $TEST_TMP_DIR/b.rec -o $TEST_TMP_DIR/b.db
+
+cc -Wall -I../inc shared_stress.c ../src/lib/librmc.a -pthread -o $TEST_TMP_DIR/shared_stress
+
+if $TEST_TMP_DIR/shared_stress $BOARDS_DIR/NUC6i5SYB_H.fp $TEST_TMP_DIR/a.db \
+    $TEST_TMP_DIR/b.db NUC6.file.1 $TEST_TMP_DIR/rmc.db $RMC_TEST_THREADS; then
+    echo "RMC shared database stress test: PASS"
+    rm -rf $TEST_TMP_DIR
+    make -C ../ clean 1>/dev/null
+else
+    echo "RMC shared database stress test: FAIL"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+fi
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Stress test of shared database handle
+ *
+ * Reader threads query a blob through a shared database as fast as they can,
+ * while the main thread keeps replacing the database file with one of two
+ * versions. Every blob read must be identical to the blob in either version.
+ * Throughput is reported for each number of reader threads.
+ *
+ * usage: shared_stress <fingerprint file> <db A> <db B> <blob name> <target db> [max threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include <rmc_api.h>
+
+#define RUN_MS          500
+#define REPLACE_MS      5
+
+static rmc_shared_db_t *shared = NULL;
+static char *blob_name = NULL;
+static rmc_file_t expected[2];
+static atomic_int stop;
+static atomic_ulong errors;
+
+static void *reader(void *arg) {
+    unsigned long *ops = arg;
+    rmc_overlay_t *overlay = NULL;
+    rmc_file_t file;
+
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        int i;
+        int ok = 0;
+
+        overlay = rmc_acquire_shared_db(shared);
+
+        if (overlay && !rmc_query_file_by_overlay(overlay, blob_name, &file)) {
+            for (i = 0; i < 2; i++)
+                if (file.blob_len == expected[i].blob_len &&
+                    !memcmp(file.blob, expected[i].blob, file.blob_len))
+                    ok = 1;
+        }
+
+        rmc_release_shared_db(shared);
+
+        if (!ok)
+            atomic_fetch_add(&errors, 1);
+
+        (*ops)++;
+    }
+
+    return NULL;
+}
+
+static int copy_db(const char *from, const char *to) {
+    char tmp[4096];
+    char *data = NULL;
+    rmc_size_t len = 0;
+    int ret = 1;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", to);
+
+    if (read_file(from, &data, &len))
+        return 1;
+
+    /* replace atomically, like an OTA update should do */
+    if (!write_file(tmp, data, len, 0) && !rename(tmp, to))
+        ret = 0;
+
+    free(data);
+
+    return ret;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+
+    nanosleep(&ts, NULL);
+}
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    void *raw_fp = NULL;
+    rmc_overlay_t overlays[2];
+    pthread_t threads[RMC_SHARED_MAX_READERS];
+    unsigned long ops[RMC_SHARED_MAX_READERS][8];
+    int max_threads = 8;
+    int n, i, t;
+    int ret = 1;
+
+    if (argc < 6) {
+        fprintf(stderr, "usage: %s <fingerprint file> <db A> <db B> <blob name> <target db> [max threads]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 6)
+        max_threads = atoi(argv[6]);
+
+    if (max_threads < 1 || max_threads > RMC_SHARED_MAX_READERS - 1)
+        max_threads = 8;
+
+    blob_name = argv[4];
+
+    if (read_fingerprint_from_file(argv[1], &fp, &raw_fp))
+        return 1;
+
+    for (i = 0; i < 2; i++) {
+        if (rmc_open_overlay(&fp, &argv[2 + i], 1, &overlays[i]) ||
+            rmc_query_file_by_overlay(&overlays[i], blob_name, &expected[i])) {
+            fprintf(stderr, "cannot query %s in %s\n", blob_name, argv[2 + i]);
+            return 1;
+        }
+    }
+
+    if (copy_db(argv[2], argv[5]))
+        return 1;
+
+    if ((shared = rmc_open_shared_db(&fp, &argv[5], 1)) == NULL)
+        return 1;
+
+    printf("threads      ops/s    ops/s/thread  reloads\n");
+
+    for (n = 1; n <= max_threads; n *= 2) {
+        rmc_uint64_t gen = rmc_get_shared_db_generation(shared);
+        unsigned long total = 0;
+
+        atomic_store(&stop, 0);
+
+        for (t = 0; t < n; t++) {
+            ops[t][0] = 0;
+            pthread_create(&threads[t], NULL, reader, ops[t]);
+        }
+
+        for (i = 0; i < RUN_MS / REPLACE_MS; i++) {
+            sleep_ms(REPLACE_MS);
+            copy_db(argv[2 + (i & 1)], argv[5]);
+        }
+
+        atomic_store(&stop, 1);
+
+        for (t = 0; t < n; t++) {
+            pthread_join(threads[t], NULL);
+            total += ops[t][0];
+        }
+
+        printf("%7d %10lu %15lu %8llu\n", n, total * 1000 / RUN_MS, total * 1000 / RUN_MS / n,
+                (unsigned long long)(rmc_get_shared_db_generation(shared) - gen));
+    }
+
+    if (atomic_load(&errors))
+        fprintf(stderr, "%lu reads returned wrong data\n", atomic_load(&errors));
+    else if (rmc_get_shared_db_generation(shared) == 0)
+        fprintf(stderr, "database was never reloaded\n");
+    else
+        ret = 0;
+
+    rmc_close_shared_db(shared);
+
+    for (i = 0; i < 2; i++)
+        rmc_close_overlay(&overlays[i]);
+
+    free(raw_fp);
+
+    return ret;
+}
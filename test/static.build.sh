@@ -0,0 +1,66 @@
+#!/bin/sh
+# This script tests databases compiled into C source by rmc
+# tool with sample boards in databases of version 1 and 2.
+# NUC6 has a second record with a blob shadowed by the first
+# one and a blob of its own.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+NUC6_FILES="$BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 $BOARDS_DIR/NUC6.file.3"
+NUC4_FILES="$BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2"
+T100_FILES="$BOARDS_DIR/T100.32.file.1 $BOARDS_DIR/T100.32.file.2"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC static database test: FAIL"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $NUC6_FILES -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $NUC4_FILES -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/T100TA-32bit.fp -b $T100_FILES -o $TEST_TMP_DIR/T100.rec 1>/dev/null
+
+mkdir $TEST_TMP_DIR/extra
+cp $BOARDS_DIR/NUC4.file.1 $TEST_TMP_DIR/extra/NUC6.file.1
+cp $BOARDS_DIR/NUC4.file.2 $TEST_TMP_DIR/extra/extra.conf
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $TEST_TMP_DIR/extra/NUC6.file.1 \
+    $TEST_TMP_DIR/extra/extra.conf -o $TEST_TMP_DIR/extra.rec 1>/dev/null
+
+# pattern records are not keyed by signature and cannot be compiled
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -m 1 -b $TEST_TMP_DIR/extra/extra.conf \
+    -o $TEST_TMP_DIR/family.rec 1>/dev/null
+../src/rmc -D $TEST_TMP_DIR/family.rec $TEST_TMP_DIR/NUC4.rec -v 2 -o $TEST_TMP_DIR/family.db
+if ../src/rmc -C -d $TEST_TMP_DIR/family.db -o $TEST_TMP_DIR/family 2>/dev/null; then
+    fail
+fi
+if [ -e $TEST_TMP_DIR/family.c ] || [ -e $TEST_TMP_DIR/family.h ]; then
+    fail
+fi
+
+for v in 1 2; do
+    ../src/rmc -D $TEST_TMP_DIR/NUC6.rec $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/T100.rec \
+        $TEST_TMP_DIR/extra.rec -v $v -o $TEST_TMP_DIR/rmc.v$v.db
+    mkdir $TEST_TMP_DIR/v$v
+    ../src/rmc -C -d $TEST_TMP_DIR/rmc.v$v.db -o $TEST_TMP_DIR/v$v/rmc_static
+
+    cc -Wall -Wextra -I$TEST_TMP_DIR/v$v -I../inc static_test.c $TEST_TMP_DIR/v$v/rmc_static.c \
+        ../src/lib/librmc.a -o $TEST_TMP_DIR/v$v/static_test
+
+    $TEST_TMP_DIR/v$v/static_test $BOARDS_DIR/NUC6i5SYB_H.fp $NUC6_FILES \
+        $TEST_TMP_DIR/extra/extra.conf -- $BOARDS_DIR/NUC4.D54250WYK.fp $NUC4_FILES \
+        -- $BOARDS_DIR/T100TA-32bit.fp $T100_FILES || fail
+done
+
+echo "RMC static database test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of databases compiled into C source by rmc -C
+ *
+ * Generated source of a database named rmc_static is linked into this program.
+ * Every blob name is queried for every board, a board must get exactly blobs
+ * in its list, identical to their source files, and the same blobs a query on
+ * the database in data returns.
+ *
+ * usage: static_test <fingerprint file> <blob file list> [-- <fingerprint file> <blob file list>]...
+ * Blobs are named after base names of files.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+#include "rmc_static.h"
+
+static const char *base_name(const char *pathname) {
+    const char *base = strrchr(pathname, '/');
+
+    return base ? base + 1 : pathname;
+}
+
+int main(int argc, char **argv) {
+    rmc_fingerprint_t fp;
+    void *raw = NULL;
+    rmc_file_t file;
+    rmc_file_t expected;
+    char *data = NULL;
+    rmc_size_t len = 0;
+    int failed = 0;
+    int own;
+    int start;
+    int end;
+    int i;
+    int j;
+    int k;
+
+    for (start = 0; start < argc - 1; start = end) {
+        for (end = start + 2; end < argc && strcmp(argv[end], "--"); end++)
+            ;
+
+        if (read_fingerprint_from_file(argv[start + 1], &fp, &raw))
+            return 1;
+
+        /* every blob name of every board */
+        for (i = 2; i < argc; i++) {
+            if (!strcmp(argv[i], "--") || !strcmp(argv[i - 1], "--"))
+                continue;
+
+            own = -1;
+
+            for (j = start + 2; j < end; j++) {
+                if (!strcmp(base_name(argv[i]), base_name(argv[j])))
+                    own = j;
+            }
+
+            /* a name in more than one list is checked once for its own board */
+            for (k = 2; k < i && own < 0; k++) {
+                if (strcmp(argv[k], "--") && strcmp(argv[k - 1], "--") &&
+                    !strcmp(base_name(argv[i]), base_name(argv[k])))
+                    break;
+            }
+
+            if (own < 0 && k < i)
+                continue;
+
+            if (rmc_query_file_by_static_db(&fp, &rmc_static, (char *)base_name(argv[i]), &file)) {
+                if (own >= 0) {
+                    fprintf(stderr, "%s: %s is not found\n", argv[start + 1], base_name(argv[i]));
+                    failed = 1;
+                }
+
+                continue;
+            }
+
+            if (own < 0) {
+                fprintf(stderr, "%s: %s of another board is found\n", argv[start + 1], base_name(argv[i]));
+                failed = 1;
+                continue;
+            }
+
+            if (read_file(argv[own], &data, &len))
+                return 1;
+
+            if (file.blob_len != len || memcmp(file.blob, data, len) ||
+                strcmp(file.blob_name, base_name(argv[own]))) {
+                fprintf(stderr, "%s: %s is different\n", argv[start + 1], base_name(argv[own]));
+                failed = 1;
+            }
+
+            if (query_policy_from_db(&fp, (rmc_uint8_t *)rmc_static.data, RMC_GENERIC_FILE,
+                (char *)base_name(argv[own]), &expected) || expected.blob != file.blob) {
+                fprintf(stderr, "%s: %s is not the one database returns\n", argv[start + 1],
+                    base_name(argv[own]));
+                failed = 1;
+            }
+
+            free(data);
+        }
+
+        if (rmc_query_file_by_static_db(&fp, &rmc_static, "rmc.no.such.blob", &file) == 0) {
+            fprintf(stderr, "%s: a missing blob is found\n", argv[start + 1]);
+            failed = 1;
+        }
+
+        free(raw);
+    }
+
+    return failed;
+}
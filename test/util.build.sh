@@ -0,0 +1,52 @@
+#!/bin/sh
+# This script checks basic C functions in util.c, which
+# are only linked in EFI build, against glibc on host and
+# reports their speed. It runs for 64-bit and, when the
+# compiler supports it, 32-bit x86.
+
+# To run more iterations in benchmark:
+
+# $ RMC_TEST_ITERATIONS=100000 ./util.build.sh
+
+set -e
+
+if [ -z ${RMC_TEST_ITERATIONS+x} ]; then
+    RMC_TEST_ITERATIONS=20000
+fi
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# rename functions in util.c so that glibc ones are still there
+RMC_UTIL_RENAME="-Dmemset=rmc_memset -Dmemcpy=rmc_memcpy -Dstrncmp=rmc_strncmp \
+    -Dstrlen=rmc_strlen -Dstrncpy=rmc_strncpy -Dstrcpy=rmc_strcpy"
+
+RESULT=PASS
+
+for arch in -m64 -m32; do
+    if ! echo "int main(void) { return 0; }" | \
+        cc $arch -x c - -o $TEST_TMP_DIR/probe 2>/dev/null; then
+        echo "Skip $arch, not supported by compiler"
+        continue
+    fi
+
+    # same flags as in Makefile.efi
+    cc $arch -O2 -DRMC_EFI -Wall -I../inc -nostdinc -nostdlib -fno-builtin -std=gnu90 \
+        $RMC_UTIL_RENAME \
+        -c ../src/util/util.c -o $TEST_TMP_DIR/util$arch.o
+    cc $arch -O2 -Wall -Wno-stringop-truncation util_test.c $TEST_TMP_DIR/util$arch.o -o $TEST_TMP_DIR/util_test$arch
+
+    echo "== $arch"
+
+    if ! $TEST_TMP_DIR/util_test$arch $RMC_TEST_ITERATIONS; then
+        RESULT=FAIL
+    fi
+done
+
+if [ "$RESULT" = "PASS" ]; then
+    echo "RMC util test: PASS"
+    rm -rf $TEST_TMP_DIR
+else
+    echo "RMC util test: FAIL"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    exit 1
+fi
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of basic C functions in util.c for EFI build
+ *
+ * util.c is compiled with its functions renamed to rmc_* so that they can be
+ * compared with glibc in the same program. Every function is checked against
+ * glibc with all combinations of alignment and a range of lengths, and then
+ * timed with multi-KB buffers.
+ *
+ * usage: util_test [benchmark iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void *rmc_memset(void *s, unsigned char c, size_t n);
+char *rmc_strncpy(char *dest, const char *src, size_t n);
+size_t rmc_strlen(const char *s);
+void *rmc_memcpy(void *dest, const void *src, size_t n);
+int rmc_strncmp(const char *s1, const char *s2, size_t n);
+
+#define MAX_ALIGN   16
+#define MAX_LEN     300
+#define BUF_LEN     (MAX_ALIGN + MAX_LEN + MAX_ALIGN)
+#define BENCH_LEN   8192
+
+static int sign(int v) {
+    return (v > 0) - (v < 0);
+}
+
+static void fill(unsigned char *buf, size_t len, unsigned int seed) {
+    size_t i;
+
+    /* non-zero bytes, including ones with high bit set */
+    for (i = 0; i < len; i++)
+        buf[i] = (unsigned char)((seed + i * 131) % 255 + 1);
+}
+
+static int test_memset(void) {
+    unsigned char a[BUF_LEN], b[BUF_LEN];
+    size_t align, len;
+
+    for (align = 0; align < MAX_ALIGN; align++) {
+        for (len = 0; len < MAX_LEN; len++) {
+            fill(a, BUF_LEN, len);
+            fill(b, BUF_LEN, len);
+            memset(a + align, 0xa5, len);
+
+            if (rmc_memset(b + align, 0xa5, len) != b + align || memcmp(a, b, BUF_LEN)) {
+                fprintf(stderr, "memset failed: align %zu len %zu\n", align, len);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int test_memcpy(void) {
+    unsigned char src[BUF_LEN], a[BUF_LEN], b[BUF_LEN];
+    size_t d, s, len;
+
+    fill(src, BUF_LEN, 7);
+
+    for (d = 0; d < MAX_ALIGN; d++) {
+        for (s = 0; s < MAX_ALIGN; s++) {
+            for (len = 0; len < MAX_LEN; len++) {
+                memset(a, 0, BUF_LEN);
+                memset(b, 0, BUF_LEN);
+                memcpy(a + d, src + s, len);
+
+                if (rmc_memcpy(b + d, src + s, len) != b + d || memcmp(a, b, BUF_LEN)) {
+                    fprintf(stderr, "memcpy failed: dst %zu src %zu len %zu\n", d, s, len);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int test_strlen(void) {
+    char buf[BUF_LEN];
+    size_t align, len;
+
+    for (align = 0; align < MAX_ALIGN; align++) {
+        for (len = 0; len < MAX_LEN; len++) {
+            fill((unsigned char *)buf, BUF_LEN, len);
+            buf[align + len] = '\0';
+
+            if (rmc_strlen(buf + align) != strlen(buf + align)) {
+                fprintf(stderr, "strlen failed: align %zu len %zu\n", align, len);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int test_strncmp(void) {
+    char a[BUF_LEN], b[BUF_LEN];
+    size_t i, j, len, diff, n;
+
+    for (i = 0; i < MAX_ALIGN; i++) {
+        for (j = 0; j < MAX_ALIGN; j++) {
+            for (len = 0; len < 80; len++) {
+                /* diff == len means strings are equal */
+                for (diff = 0; diff <= len; diff++) {
+                    fill((unsigned char *)a, BUF_LEN, 3);
+                    fill((unsigned char *)b, BUF_LEN, 3);
+                    memmove(b + j, a + i, len);
+                    a[i + len] = '\0';
+                    b[j + len] = '\0';
+
+                    if (diff < len)
+                        b[j + diff] = (char)(b[j + diff] ^ 0x81);
+
+                    for (n = 0; n < len + 2; n += (len > 20 ? 7 : 1)) {
+                        if (sign(rmc_strncmp(a + i, b + j, n)) != sign(strncmp(a + i, b + j, n))) {
+                            fprintf(stderr, "strncmp failed: align %zu %zu len %zu diff %zu n %zu\n",
+                                i, j, len, diff, n);
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int test_strncpy(void) {
+    char src[BUF_LEN], a[BUF_LEN], b[BUF_LEN];
+    size_t d, s, len, n;
+
+    for (d = 0; d < MAX_ALIGN; d++) {
+        for (s = 0; s < MAX_ALIGN; s++) {
+            for (len = 0; len < 100; len++) {
+                fill((unsigned char *)src, BUF_LEN, len);
+                src[s + len] = '\0';
+
+                for (n = 0; n < 120; n += 3) {
+                    memset(a, 'x', BUF_LEN);
+                    memset(b, 'x', BUF_LEN);
+                    strncpy(a + d, src + s, n);
+
+                    if (rmc_strncpy(b + d, src + s, n) != b + d || memcmp(a, b, BUF_LEN)) {
+                        fprintf(stderr, "strncpy failed: dst %zu src %zu len %zu n %zu\n", d, s, len, n);
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* results are accumulated here, so that calls are not optimized out */
+static volatile size_t sink;
+
+/* print MB/s of util.c and glibc, buffers are volatile to keep calls */
+static void benchmark(long iterations) {
+    static unsigned char src[BENCH_LEN + 1], dst[BENCH_LEN + 1];
+    char *volatile s = (char *)src;
+    char *volatile d = (char *)dst;
+    double t, mb = (double)BENCH_LEN * iterations / (1024 * 1024);
+    long i;
+
+    fill(src, BENCH_LEN, 1);
+    src[BENCH_LEN] = '\0';
+    memcpy(dst, src, BENCH_LEN + 1);
+
+    printf("%-8s %12s %12s  (MB/s, %d bytes)\n", "", "util.c", "glibc", BENCH_LEN);
+
+#define BENCH(name, rmc_call, libc_call) do { \
+        double r, l; \
+        t = now(); \
+        for (i = 0; i < iterations; i++) \
+            sink += (size_t)rmc_call; \
+        r = mb / (now() - t); \
+        t = now(); \
+        for (i = 0; i < iterations; i++) \
+            sink += (size_t)libc_call; \
+        l = mb / (now() - t); \
+        printf("%-8s %12.0f %12.0f\n", name, r, l); \
+    } while (0)
+
+    BENCH("memcpy", rmc_memcpy(d, s, BENCH_LEN), memcpy(d, s, BENCH_LEN));
+    BENCH("memset", rmc_memset(d, 0x5a, BENCH_LEN), memset(d, 0x5a, BENCH_LEN));
+    memcpy(dst, src, BENCH_LEN + 1);
+    BENCH("strlen", rmc_strlen(s), strlen(s));
+    BENCH("strncmp", rmc_strncmp(s, d, BENCH_LEN), strncmp(s, d, BENCH_LEN));
+    BENCH("strncpy", rmc_strncpy(d, s, BENCH_LEN), strncpy(d, s, BENCH_LEN));
+#undef BENCH
+}
+
+int main(int argc, char **argv) {
+    long iterations = 20000;
+
+    if (argc > 1)
+        iterations = atol(argv[1]);
+
+    if (test_memset() || test_memcpy() || test_strlen() || test_strncmp() || test_strncpy())
+        return 1;
+
+    if (iterations > 0)
+        benchmark(iterations);
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#!/bin/sh
+# This script tests verification of databases with rmc tool and
+# librmc. Copies of a version 2 database with a blob, a digest and
+# the CRC section corrupted are verified, and blobs are compared
+# with source files of different content.
+
+set -e
+
+BOARDS_DIR="./boards"
+
+NUC6_FILES="$BOARDS_DIR/NUC6.file.1 $BOARDS_DIR/NUC6.file.2 $BOARDS_DIR/NUC6.file.3"
+NUC4_FILES="$BOARDS_DIR/NUC4.file.1 $BOARDS_DIR/NUC4.file.2"
+
+TEST_TMP_DIR=$(mktemp -d)
+
+# compile librmc and rmc tool first
+
+make -C ../ clean 1>/dev/null
+make -C ../ 1>/dev/null
+
+fail () {
+    echo "RMC verification test: FAIL"
+    echo "$1"
+    echo "Artifacts in test are in $TEST_TMP_DIR"
+    make -C ../ clean 1>/dev/null
+    exit 1
+}
+
+../src/rmc -R -f $BOARDS_DIR/NUC6i5SYB_H.fp -b $NUC6_FILES -o $TEST_TMP_DIR/NUC6.rec 1>/dev/null
+../src/rmc -R -f $BOARDS_DIR/NUC4.D54250WYK.fp -b $NUC4_FILES -o $TEST_TMP_DIR/NUC4.rec 1>/dev/null
+
+../src/rmc -D $TEST_TMP_DIR/NUC4.rec $TEST_TMP_DIR/NUC6.rec -v 2 -o $TEST_TMP_DIR/rmc.v2.db
+
+cc -Wall -Wextra -I../inc verify_test.c ../src/lib/librmc.a -pthread -o $TEST_TMP_DIR/verify_test
+
+mkdir $TEST_TMP_DIR/copies
+$TEST_TMP_DIR/verify_test $TEST_TMP_DIR/rmc.v2.db $TEST_TMP_DIR/copies NUC6.file.2 || \
+    fail "wrong report of corrupted database"
+
+# rmc tool must report corruption, not crash
+verify () {
+    RET=0
+    ../src/rmc -V -d $TEST_TMP_DIR/$1 $2 > $TEST_TMP_DIR/$1.txt 2>&1 || RET=$?
+    [ $RET -eq $3 ] || fail "$1: rmc returned $RET, expected $3"
+}
+
+verify copies/intact.db "-b $NUC6_FILES" 0
+verify copies/blob.db "" 1
+grep -q "NUC6.file.2 *CORRUPTED" $TEST_TMP_DIR/copies/blob.db.txt || fail "corrupted blob is not reported"
+grep -q "(record CRC) *CORRUPTED" $TEST_TMP_DIR/copies/blob.db.txt || fail "record CRC is not reported"
+[ $(grep -c "CORRUPTED" $TEST_TMP_DIR/copies/blob.db.txt) -eq 3 ] || fail "intact blobs are reported"
+verify copies/digest.db "" 1
+verify copies/crc.db "" 1
+grep -q "database CORRUPTED, 0 blobs" $TEST_TMP_DIR/copies/crc.db.txt || fail "CRC section is not rejected"
+
+# a source with the same name but other content
+mkdir $TEST_TMP_DIR/sources
+cp $BOARDS_DIR/NUC4.file.1 $TEST_TMP_DIR/sources/NUC6.file.3
+verify rmc.v2.db "-b $TEST_TMP_DIR/sources/NUC6.file.3 $BOARDS_DIR/NUC6.file.1" 1
+grep -q "NUC6.file.3 *SOURCE MISMATCH" $TEST_TMP_DIR/rmc.v2.db.txt || fail "source mismatch is not reported"
+[ $(grep -c "record 0x" $TEST_TMP_DIR/rmc.v2.db.txt) -eq 1 ] || fail "matching source is reported"
+
+echo "RMC verification test: PASS"
+rm -rf $TEST_TMP_DIR
+make -C ../ clean 1>/dev/null
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2016 - 2017 Intel Corporation.
+ *
+ * Author: Jianxun Zhang <jianxun.zhang@intel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Test of database verification
+ *
+ * A version 2 database is verified intact, and then copies of it are verified
+ * with one byte of a blob flipped, with the digest of the blob flipped, and
+ * with record count of CRC section changed. Only the blob hit must be reported
+ * corrupted, and a record failing CRC is reported on its own. Copies are left
+ * in a directory for rmc tool to be checked with them.
+ *
+ * usage: verify_test <db> <directory of copies> <blob name>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmc_api.h>
+
+/* find blob of name in the first record having it, return: 0 when found */
+static int find_blob(rmc_uint8_t *db, char *name, rmc_uint64_t *record_idx, rmc_uint64_t *meta_idx,
+        rmc_file_t *file) {
+    rmc_db_header_t db_header;
+    rmc_record_header_t record_header;
+    rmc_record_iter_t iter;
+
+    memcpy(&db_header, db, sizeof(rmc_db_header_t));
+
+    for (*record_idx = sizeof(rmc_db_header_t); *record_idx < db_header.length;
+        *record_idx += record_header.length) {
+        memcpy(&record_header, db + *record_idx, sizeof(rmc_record_header_t));
+        init_record_iter(db, *record_idx, &iter);
+
+        for (*meta_idx = iter.meta_idx; !next_policy_in_record(&iter, file); *meta_idx = iter.meta_idx) {
+            if (!strcmp(file->blob_name, name))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * write a copy of database and verify it, only blob of name in record_idx may
+ * have status other than OK, and only record_idx may fail CRC
+ * return: 0 when report is expected
+ */
+static int check_copy(char *pathname, char *data, rmc_size_t db_len, rmc_uint64_t record_idx,
+        char *name, int status, int record_status, int db_status) {
+    rmc_verify_report_t report;
+    rmc_uint64_t i;
+    int failed = 0;
+
+    if (write_file(pathname, data, db_len, 0) || rmc_verify_db(pathname, NULL, 2, &report)) {
+        fprintf(stderr, "%s: failed to verify\n", pathname);
+        return 1;
+    }
+
+    if (report.db_status != db_status) {
+        fprintf(stderr, "%s: database is %d, expected %d\n", pathname, report.db_status, db_status);
+        failed = 1;
+    }
+
+    for (i = 0; i < report.entry_num; i++) {
+        rmc_verify_entry_t *e = &report.entries[i];
+        int hit = e->record_idx == record_idx && !strcmp(e->name, name);
+
+        if (e->status != (hit ? status : RMC_VERIFY_OK) ||
+            e->record_status != (e->record_idx == record_idx ? record_status : RMC_VERIFY_OK)) {
+            fprintf(stderr, "%s: %s in record 0x%llx is %d, record %d\n", pathname, e->name,
+                (unsigned long long)e->record_idx, e->status, e->record_status);
+            failed = 1;
+        }
+    }
+
+    if (report.bad_num != (status != RMC_VERIFY_OK) ||
+        report.bad_record_num != (record_status != RMC_VERIFY_OK)) {
+        fprintf(stderr, "%s: %llu bad blobs, %llu bad records\n", pathname,
+            (unsigned long long)report.bad_num, (unsigned long long)report.bad_record_num);
+        failed = 1;
+    }
+
+    rmc_free_verify_report(&report);
+
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    rmc_file_t file;
+    rmc_uint64_t record_idx = 0;
+    rmc_uint64_t meta_idx = 0;
+    rmc_uint64_t section_idx = 0;
+    rmc_uint64_t section_len = 0;
+    rmc_uint64_t record_num = 0;
+    rmc_uint64_t bad_num = 0;
+    rmc_uint8_t *digest = NULL;
+    char pathname[4096];
+    char *data = NULL;
+    rmc_size_t db_len = 0;
+    int failed = 0;
+
+    if (argc < 4 || read_file(argv[1], &data, &db_len))
+        return 1;
+
+    if (find_blob((rmc_uint8_t *)data, argv[3], &record_idx, &meta_idx, &file) ||
+        !file.blob_len || !(digest = query_digest_from_db((rmc_uint8_t *)data, meta_idx)) ||
+        query_section_from_db((rmc_uint8_t *)data, RMC_SECTION_CRC32, &section_idx, &section_len)) {
+        fprintf(stderr, "%s: no blob with digest and CRC to corrupt\n", argv[3]);
+        free(data);
+        return 1;
+    }
+
+    snprintf(pathname, sizeof(pathname), "%s/intact.db", argv[2]);
+    failed |= check_copy(pathname, data, db_len, record_idx, argv[3], RMC_VERIFY_OK,
+        RMC_VERIFY_OK, RMC_VERIFY_OK);
+
+    /* other blobs in the record are still intact */
+    file.blob[file.blob_len - 1] ^= 0x01;
+    snprintf(pathname, sizeof(pathname), "%s/blob.db", argv[2]);
+    failed |= check_copy(pathname, data, db_len, record_idx, argv[3], RMC_VERIFY_CORRUPTED,
+        RMC_VERIFY_CORRUPTED, RMC_VERIFY_CORRUPTED);
+    file.blob[file.blob_len - 1] ^= 0x01;
+
+    /* record is intact but its blob doesn't match the digest */
+    digest[0] ^= 0x01;
+    snprintf(pathname, sizeof(pathname), "%s/digest.db", argv[2]);
+    failed |= check_copy(pathname, data, db_len, record_idx, argv[3], RMC_VERIFY_CORRUPTED,
+        RMC_VERIFY_OK, RMC_VERIFY_CORRUPTED);
+    digest[0] ^= 0x01;
+
+    /* record CRCs can't be searched with a wrong count, layout is rejected */
+    memcpy(&record_num, data + section_idx, sizeof(rmc_uint64_t));
+    bad_num = record_num + 0x100000000ULL;
+    memcpy(data + section_idx, &bad_num, sizeof(rmc_uint64_t));
+
+    if (!validate_rmcdb_layout((rmc_uint8_t *)data, db_len)) {
+        fprintf(stderr, "wrong record count of CRC section is not detected\n");
+        failed = 1;
+    }
+
+    snprintf(pathname, sizeof(pathname), "%s/crc.db", argv[2]);
+    failed |= check_copy(pathname, data, db_len, record_idx, argv[3], RMC_VERIFY_OK,
+        RMC_VERIFY_OK, RMC_VERIFY_CORRUPTED);
+
+    free(data);
+
+    return failed;
+}